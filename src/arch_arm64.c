@@ -9,8 +9,11 @@
 
 #include  <assert.h>
 #include  <limits.h>
+#include  <stdlib.h>
 #include  <string.h>
 #include  "arch_common.h"
+#include  "isel.h"
+#include  "peephole.h"
 #include  "symtab.h"
 #include  "util.h"
 
@@ -62,9 +65,19 @@ const char SECTION_TEXT[] =  "\t.text\n\t.p2align 2\n";
 const char CALL_OP[]      =  "bl";
 
 
-char reg_name[][10] = {"w8", "w9", "w10"};
+/* 呼び出し元退避、呼び出し先退避、引数の順。x16-x18は使わない
+   Caller-saved ones first, then callee-saved, then the arguments.
+   x16-x18 are not used. */
+char reg_name[][10] = {"w8", "w9", "w10", "w11", "w12", "w13", "w14", "w15",
+                       "w19", "w20", "w21", "w22", "w23", "w24", "w25", "w26",
+                       "w27", "w28",
+                       "w0", "w1", "w2", "w3", "w4", "w5", "w6", "w7"};
+const int NUM_REGS = 18;
+const int FIRST_CALLEE_SAVED = 8;
+const int RET_REG = -1;		/* w0は引数用 / w0 is for arguments */
 char param_reg_name[][10] = {"NULL", "w0", "w1", "w2", "w3", "w4", "w5",
                              "w6", "w7" };
+const int NUM_PARAM_REGS = 8;
 
 /* tlcにおけるARM (64bit)スタックレイアウトメモ
    note for ARM(64bit) stack layout in tlc
@@ -167,16 +180,20 @@ To make the situation above:
 void
 arch_assign_memory(SymTab *symtab)
 {
-    int id_arg, id_var, poffset, voffset;
+    int id_arg, id_var, id_rarg, poffset, voffset;
     SymTab *t;
 
-    id_arg = 0; id_var = 0;
+    /* レジスタに昇格した変数・レジスタ渡しの引数には領域を置かない
+       スタック渡しの引数は呼び出し側が書いた位置に残る
+       No slots for variables and register parameters promoted to
+       registers.  Stack parameters stay where the caller stored them. */
+    id_arg = 0; id_var = 0; id_rarg = 0;
     for (t = symtab; t != NULL; t = t->next) {
         /* 変数のサイズはint 4byteで固定 */
         if (t->kind == SYM_ARG) {
             t->argid = ++id_arg;
         } else if (t->kind == SYM_AUTOVAR) {
-            t->offset = ++id_var;
+            t->offset = t->promoted ? 0 : ++id_var;
             t->argid = 0;
         }
     }
@@ -184,26 +201,66 @@ arch_assign_memory(SymTab *symtab)
     voffset = (id_var > 0) ? id_var*(-4) : 0;
     for (t = symtab; t != NULL; t = t->next) {
         if (t->kind == SYM_ARG) {
-            if (t->argid < 9) {
-                t->offset = poffset+voffset+t->argid*(-4);
-            } else {
+            if (t->argid >= 9) {
                 t->offset = (id_arg-t->argid+1)*(-8);
+            } else if (t->promoted) {
+                t->offset = 0;
+            } else {
+                t->offset = poffset+voffset+(++id_rarg)*(-4);
             }
-        } else if (t->kind == SYM_AUTOVAR) {
+        } else if (t->kind == SYM_AUTOVAR && !t->promoted) {
             t->offset = poffset+(id_var-t->offset+1)*(-4);
         }
     }
 }
 
 static int current_frame_size;
+static int saved_regs;		/* 関数で退避した呼び出し先退避レジスタ / callee-saved registers saved */
+static int saved_base;		/* 退避領域のspからの位置 / offset of the save slots from sp */
+static int call_area_base;	/* 呼び出し列の領域のspからの位置 / offset of the call area from sp */
+static int frame_mode;		/* FRAME_KEEP, FRAME_OMIT, FRAME_LEAF */
+static int sp_shift;		/* 呼び出し列でspをずらした大きさ / sp moved by call sequences */
+
+/*
+  x29からの位置offsetのオペランド。x29を使わない関数ではsp基準に直す
+  Operand for offset from x29.  Rewritten relative to sp in functions
+  without x29.
+*/
+static char*
+frame_operand(int offset)
+{
+    static char buf[32];
+
+    if (frame_mode != FRAME_KEEP) {
+        /* x29は入口のsp / x29 would be the entry sp */
+        snprintf(buf, sizeof(buf), "[sp, %d]",
+                 offset+current_frame_size+sp_shift);
+    } else {
+        snprintf(buf, sizeof(buf), "[x29, %d]", offset);
+    }
+    return buf;
+}
 
+/*
+  savedは使う呼び出し先退避レジスタの集合（ビットが番号）。x29, x30の
+  直上に8byteずつ保存する。call_areaは呼び出し列が使う領域で、
+  その上に一度だけ確保する。
+  frame_modeがFRAME_OMITならx30だけを保存してx29は設定せず、
+  FRAME_LEAFならどちらも保存しない（必要なければspも動かさない）
+  saved is the set of callee-saved registers used (a bit per number).
+  They are stored 8 bytes each just above x29 and x30.  call_area is
+  the space used by the call sequences, reserved once above them.
+  With FRAME_OMIT only x30 is saved and x29 is not set up; with
+  FRAME_LEAF neither is saved, and sp is not moved unless needed.
+*/
 void
-gen_func_header(FILE *out, char *name, int frame_size, AST_List *arg_list)
+gen_func_header(FILE *out, char *name, int frame_size,
+                SymTab **params, int nparams, int saved, int call_area,
+                int mode)
 {
     const char *targetn = name;
-    AST_List *l;
-    int i;
-    int pad;
+    int i, k;
+    int pad, nsaved;
 
     /* 整列補正用のpad計算。上記のスタックに関するメモを参照
        frame_sizeはメモ中の(Nv+Na1)*4に等しい
@@ -215,84 +272,157 @@ gen_func_header(FILE *out, char *name, int frame_size, AST_List *arg_list)
     if (pad == 16) {
         pad = 0;
     }
-    current_frame_size = frame_size+pad+16;
+    saved_regs = saved;
+    frame_mode = mode;
+    sp_shift = 0;
+    nsaved = 0;
+    for (i = FIRST_CALLEE_SAVED; i < NUM_REGS; i++) {
+        nsaved += (saved >> i) & 1;
+    }
+    saved_base = mode == FRAME_LEAF ? 0 : 16;
+    call_area_base = saved_base+(nsaved*8+15)/16*16;
+    current_frame_size = frame_size+pad+call_area_base+(call_area+15)/16*16;
     if (strcmp(name, "main") == 0) {
         targetn = MAIN_LABEL;
     }
     fprintf(out,
             "\t.global\t%s\n"
             "%s:\n", targetn, targetn);
-    fprintf(out, "\tstp\tx29, x30, [sp, -%d]!\n", current_frame_size);
-    fprintf(out, "\tadd\tx29, sp, %d\n", current_frame_size);
-    i = 0;
-    TRAVERSE_AST_LIST(l, arg_list, gen_store_params(out, l->elem, ++i));
+    if (mode == FRAME_KEEP) {
+        fprintf(out, "\tstp\tx29, x30, [sp, -%d]!\n", current_frame_size);
+        fprintf(out, "\tadd\tx29, sp, %d\n", current_frame_size);
+    } else if (mode == FRAME_OMIT && current_frame_size < 256) {
+        fprintf(out, "\tstr\tx30, [sp, -%d]!\n", current_frame_size);
+    } else if (current_frame_size > 0) {
+        fprintf(out, "\tsub\tsp, sp, #%d\n", current_frame_size);
+        if (mode == FRAME_OMIT) {
+            fputs("\tstr\tx30, [sp]\n", out);
+        }
+    }
+    for (i = FIRST_CALLEE_SAVED, k = 0; i < NUM_REGS; i++) {
+        if ((saved >> i) & 1) {
+            fprintf(out, "\tstr\tx%s, [sp, %d]\n",
+                    reg_name[i]+1, saved_base+8*k++);
+        }
+    }
+    for (i = 0; i < nparams; i++) {
+        gen_store_params(out, params[i], i+1);
+    }
 }
 
 void
-gen_store_params(FILE *out, AST_Node *param, int nump)
+gen_store_params(FILE *out, SymTab *param, int nump)
 {
-    if (nump < 9) {
-        AST_Node *pid = param->child[0];
-        assert(pid != NULL && pid->symtab != NULL);
-        fprintf(out, "\tstr\t%s, [x29, %d]\n",
-                param_reg_name[nump], pid->symtab->offset);
+    if (nump < 9 && !param->promoted) {
+        assert(param != NULL);
+        fprintf(out, "\tstr\t%s, %s\n",
+                param_reg_name[nump], frame_operand(param->offset));
+    }
+}
+
+/* 呼び出し先退避レジスタを戻してフレームを捨てる
+   Restore the callee-saved registers and discard the frame */
+static void
+gen_leave(FILE *out)
+{
+    int i, k;
+
+    for (i = FIRST_CALLEE_SAVED, k = 0; i < NUM_REGS; i++) {
+        if ((saved_regs >> i) & 1) {
+            fprintf(out, "\tldr\tx%s, [sp, %d]\n",
+                    reg_name[i]+1, saved_base+8*k++);
+        }
+    }
+    if (frame_mode == FRAME_KEEP) {
+        fprintf(out, "\tldp\tx29, x30, [sp], %d\n", current_frame_size);
+    } else if (frame_mode == FRAME_OMIT && current_frame_size < 256) {
+        fprintf(out, "\tldr\tx30, [sp], %d\n", current_frame_size);
+    } else {
+        if (frame_mode == FRAME_OMIT) {
+            fputs("\tldr\tx30, [sp]\n", out);
+        }
+        if (current_frame_size > 0) {
+            fprintf(out, "\tadd\tsp, sp, %d\n", current_frame_size);
+        }
     }
 }
 
 void
 gen_func_footer(FILE *out, const char *func_end_label)
 {
-    fprintf(out, "%s:\n"
-            "\tldp\tx29, x30, [sp], %d\n"
-            "\tret\n\n", func_end_label, current_frame_size);
+    fprintf(out, "%s:\n", func_end_label);
+    gen_leave(out);
+    fputs("\tret\n\n", out);
 }
 
-void
-gen_exp_cnst(FILE *out, AST_Node *c)
+/*
+  saveの中でiより番号の大きいレジスタの数。番号の小さいものほど上に置く
+  Number of registers in save numbered above i; lower numbers go higher
+*/
+static int
+save_slot(unsigned int save, int i)
 {
-    if (c->val > SHRT_MAX || c->val < SHRT_MIN) { /* over 16bits */
-        fprintf(out,
-                "\tmov\t%s, %x\n"
-                "\tmovk\t%s, %x, lsl 16\n",
-                reg_name[c->reg], 0xffff & c->val,
-                reg_name[c->reg], (0xffff0000 & c->val) >> 16);
-    } else {
-        fprintf(out, "\tmov\t%s, %d\n", reg_name[c->reg], c->val);
+    int n;
+
+    for (n = 0, i++; i < NUM_REGS; i++) {
+        n += (save >> i) & 1;
     }
+    return n;
 }
 
-void
-gen_exp_ident(FILE *out, AST_Node *idnt)
+/*
+  呼び出し列がフレーム内で使う大きさ。スタック渡しの実引数はspの下に
+  置くので退避領域だけ
+  Size used in the frame by a call sequence.  Only the save slots,
+  since the arguments passed in the stack are placed below sp.
+*/
+int
+gen_call_area(int nargs, unsigned int save)
 {
-    fprintf(out, "\tldr\t%s, [x29, %d]\n",
-            reg_name[idnt->reg], idnt->symtab->offset);
+    return save_slot(save, -1)*4;
 }
 
+/*
+  regには戻り値を受け取るレジスタを渡す（このレジスタは退避しない）
+  saveは呼び出しの前後で退避するレジスタの集合。in_frameが真なら
+  関数の入口で確保済みの領域を使う。いずれの場合も退避するものが
+  なければspを動かさない
+  reg is the register receiving the return value, which is not saved.
+  save is the set of registers saved around the call.  If in_frame is
+  true the area reserved at the function entry is used.  In either
+  case sp is left alone when nothing is saved.
+*/
 int
-gen_call_prologue(FILE *out, AST_Node *e, int *padsize, int *framesize)
+gen_call_prologue(FILE *out, int nargs, int reg, unsigned int save,
+                  int in_frame, int *padsize, int *framesize)
 {
-    int i, psize, fsize, pad, sparams;
-    AST_List *l;
-    
-    sparams = 0;
-    TRAVERSE_AST_LIST(l, e->list, ++sparams);
+    int i, fsize, sparams, base;
+
+    sparams = nargs;
     /* spの整列補正。上記のスタックに関するメモを参照
        Adjust sp for alignment. See the note about stack above. */
     sparams = (sparams > 8) ? sparams - 8 : 0;
-    pad = 4; /* pad is always 4 for arm64 */
-    psize = sparams * 8;
-    fsize = pad+3*4; /* w0, w1, and w2 are all int(4byte). */
+    fsize = (save_slot(save, -1)*4+15)/16*16; /* w8, w9, ... are all int(4byte). */
+    base = 0;
+    if (in_frame) {
+        fsize = 0;
+        base = call_area_base;
+    }
 
     /* padと待避するレジスタの分だけspをずらす
        Adjust sp by pad and saved registers */
-    fprintf(out, "\tsub\tsp, sp, #%d\n", fsize);
-    for (i = 0; i < 3; i++) {
-        if (e->reg != i) {
-            fprintf(out, "\tstr\t%s, [sp, %d]\n", reg_name[i], 8-4*i);
+    if (fsize > 0) {
+        fprintf(out, "\tsub\tsp, sp, #%d\n", fsize);
+        sp_shift += fsize;
+    }
+    for (i = 0; i < NUM_REGS; i++) {
+        if ((save >> i) & 1 && reg != i) {
+            fprintf(out, "\tstr\t%s, [sp, %d]\n",
+                    reg_name[i], base+4*save_slot(save, i));
         }
     }
 
-    *padsize = psize;
+    *padsize = in_frame ? base : 0;
     *framesize = fsize;
     return sparams;
 }
@@ -311,24 +441,41 @@ gen_call_set_param(FILE *out, int reg, int nump, int sparams)
     }
 }
 
+/* useが0なら戻り値は使わない / The return value is not used if use is 0. */
 void
-gen_call_epilogue(FILE *out, AST_Node *e, int padsize, int framesize)
+gen_call_epilogue(FILE *out, const char *name, int reg, int use,
+                  unsigned int save, int padsize, int framesize)
 {
     int i;
-    fprintf(out, "\tbl\t%s\n", e->child[0]->str);
+    fprintf(out, "\tbl\t%s\n", name);
     /* 戻り値の格納 / copy return value*/
-    if (e->parent != NULL && e->parent->kind == AST_KIND_EXP) {
-        fprintf(out, "\tmov\t%s, w0\n", reg_name[e->reg]);
+    if (use && strcmp(reg_name[reg], "w0") != 0) {
+        fprintf(out, "\tmov\t%s, w0\n", reg_name[reg]);
     }
     /* %rspを戻す / pop %rsp */
-    for (i = 0; i < 3; i++) {
-        if (e->reg != i) {
-            fprintf(out, "\tldr\t%s, [sp, %d]\n", reg_name[i], 8-4*i);
-            /* padsize is not used for arm64. */
+    for (i = 0; i < NUM_REGS; i++) {
+        if ((save >> i) & 1 && reg != i) {
+            /* padsizeは退避領域の位置 / padsize is the offset of the save slots */
+            fprintf(out, "\tldr\t%s, [sp, %d]\n",
+                    reg_name[i], padsize+4*save_slot(save, i));
         }
     }
-    fprintf(out, "\tadd\tsp, sp, %d\n", framesize);
-    /* framesize is 16 for arm64. */
+    if (framesize > 0) {
+        fprintf(out, "\tadd\tsp, sp, %d\n", framesize);
+        sp_shift -= framesize;
+    }
+}
+
+/*
+  フレームを捨ててnameへ飛ぶ。引数はレジスタに設定済み
+  Discard the frame and jump to name, whose arguments are already in
+  the registers.
+*/
+void
+gen_tail_call(FILE *out, const char *name)
+{
+    gen_leave(out);
+    fprintf(out, "\tb\t%s\n", name);
 }
 
 /*
@@ -338,13 +485,64 @@ gen_call_epilogue(FILE *out, AST_Node *e, int padsize, int framesize)
   must be same for the x86-style assembly language (two-operands).
 */
 
+/* 定数valをレジスタnameに置く / put constant val in register name */
+static void
+load_cnst(FILE* out, const char *name, int val)
+{
+    if (val > SHRT_MAX || val < SHRT_MIN) { /* over 16bits */
+        fprintf(out,
+                "\tmov\t%s, 0x%x\n"
+                "\tmovk\t%s, 0x%x, lsl 16\n",
+                name, 0xffff & val,
+                name, (0xffff0000 & val) >> 16);
+    } else {
+        fprintf(out, "\tmov\t%s, %d\n", name, val);
+    }
+}
+
+void
+gen_insn_load_cnst(FILE* out, int reg, int val)
+{
+    load_cnst(out, reg_name[reg], val);
+}
+
+/*
+  load local variable
+*/
+void
+gen_insn_load_lvar(FILE* out, int reg, int offset)
+{
+    fprintf(out, "\tldr\t%s, %s\n", reg_name[reg], frame_operand(offset));
+}
+
 /*
   store local variable
 */
 void
 gen_insn_store_lvar(FILE* out, int reg, int offset)
 {
-    fprintf(out, "\tstr\t%s, [x29, %d]\n", reg_name[reg], offset);
+    fprintf(out, "\tstr\t%s, %s\n", reg_name[reg], frame_operand(offset));
+}
+
+/*
+  load the incoming parameter #nump (from 1)
+*/
+void
+gen_insn_load_param(FILE* out, int reg, int nump, int offset)
+{
+    if (nump < 9) {
+        if (strcmp(param_reg_name[nump], reg_name[reg]) != 0) {
+            fprintf(out, "\tmov\t%s, %s\n", reg_name[reg], param_reg_name[nump]);
+        }
+    } else {
+        gen_insn_load_lvar(out, reg, offset);
+    }
+}
+
+void
+gen_insn_mov(FILE* out, int dst, int src)
+{
+    fprintf(out, "\tmov\t%s, %s\n", reg_name[dst], reg_name[src]);
 }
 
 void
@@ -374,11 +572,19 @@ gen_insn_mul(FILE* out, int dst, int src1, int src2)
             reg_name[dst], reg_name[src1], reg_name[src2]);
 }
 
+void
+gen_insn_shr(FILE* out, int dst, int src, int shift)
+{
+    fprintf(out, "\tlsr\t%s, %s, #%d\n", reg_name[dst], reg_name[src], shift);
+}
+
 /* return value is passed through "w0" register. */
 void
 gen_insn_ret_asgn(FILE *out, int src)
 {
-    fprintf(out, "\tmov\tw0, %s\n", reg_name[src]);
+    if (strcmp(reg_name[src], "w0") != 0) {
+        fprintf(out, "\tmov\tw0, %s\n", reg_name[src]);
+    }
 }
 
 void
@@ -448,3 +654,822 @@ gen_insn_cond_set(FILE* out, int dst, int cond)
         errexit("Invalid relation instruction.", __FILE__, __LINE__);
     }
 }
+
+/*
+  命令選択の規則 / rules for instruction selection
+
+  add, sub, cmpは12ビットの即値(imm12)を取り、負の値は逆の命令
+  (nimm12)にする。2のべき乗倍や右シフトは第2被演算子のシフト
+  (shift)に含める。メモリを被演算子にする命令はないので、変数は
+  引数と戻り値のレジスタに直接読む。費用はおおよその命令数
+  add, sub and cmp take a 12-bit immediate (imm12), and a negative one
+  flips the instruction (nimm12).  Multiplication by a power of two and
+  a right shift fold into the shifted second operand (shift).  As no
+  instruction takes a memory operand, variables are only loaded
+  straight into the argument and return registers.  Costs are roughly
+  the number of instructions.
+*/
+
+enum { NT_IMM = ISEL_REG+1, NT_IMM12, NT_NIMM12, NT_MEM, NT_SHIFT };
+
+/* 節の値のオペランド / operand for the value of a node */
+static const char*
+isel_opd(const Isel_Node *n)
+{
+    static char buf[4][32];
+    static int  k;
+    int c;
+
+    k = (k+1)%4;
+    switch (n->nt) {
+    case  NT_IMM:
+    case  NT_IMM12:
+        snprintf(buf[k], sizeof(buf[k]), "%d", n->insn->imm);
+        break;
+    case  NT_NIMM12:
+        snprintf(buf[k], sizeof(buf[k]), "%d", -n->insn->imm);
+        break;
+    case  NT_SHIFT:
+        if (n->insn->op == IR_SHR) {
+            snprintf(buf[k], sizeof(buf[k]), "%s, lsr %d",
+                     reg_name[n->kid[0]->reg], n->insn->imm);
+        } else {
+            for (c = 0; (1 << c) != n->kid[1]->insn->imm; c++) {
+                ;
+            }
+            snprintf(buf[k], sizeof(buf[k]), "%s, lsl %d",
+                     reg_name[n->kid[0]->reg], c);
+        }
+        break;
+    default:
+        snprintf(buf[k], sizeof(buf[k]), "%s", reg_name[n->reg]);
+    }
+    return buf[k];
+}
+
+static int
+isel_is_imm12(const Isel_Node *n)
+{
+    return n->insn->imm >= 0 && n->insn->imm < 4096;
+}
+
+static int
+isel_is_nimm12(const Isel_Node *n)
+{
+    return n->insn->imm < 0 && n->insn->imm > -4096;
+}
+
+static int
+isel_is_pow2(const Isel_Node *n)
+{
+    int c = n->kid[1]->insn->imm;
+
+    return c > 1 && (c & (c-1)) == 0;
+}
+
+static int
+isel_is_lsr(const Isel_Node *n)
+{
+    return n->insn->imm > 0 && n->insn->imm < 32;
+}
+
+static int
+isel_is_cond(const Isel_Node *n)
+{
+    return n->insn->cond != 0;
+}
+
+static int
+isel_is_zero(const Isel_Node *n)
+{
+    return n->kid[0]->insn->imm == 0;
+}
+
+static int
+isel_is_reg_arg(const Isel_Node *n)
+{
+    return n->insn->imm < 9;
+}
+
+static void
+isel_emit_const(FILE *out, Isel_Node *n)
+{
+    load_cnst(out, reg_name[n->reg], n->insn->imm);
+}
+
+static void
+isel_emit_load(FILE *out, Isel_Node *n)
+{
+    gen_insn_load_lvar(out, n->reg, n->insn->sym->offset);
+}
+
+static void
+isel_emit_store(FILE *out, Isel_Node *n)
+{
+    fprintf(out, "\tstr\t%s, %s\n",
+            n->kid[0]->nt == NT_IMM ? "wzr" : reg_name[n->kid[0]->reg],
+            frame_operand(n->insn->sym->offset));
+}
+
+static void
+isel_emit_mov(FILE *out, Isel_Node *n)
+{
+    if (n->kid[0]->nt == NT_IMM) {
+        load_cnst(out, reg_name[n->reg], n->kid[0]->insn->imm);
+    } else if (n->kid[0]->reg != n->reg) {
+        gen_insn_mov(out, n->reg, n->kid[0]->reg);
+    }
+}
+
+static void
+isel_emit_neg(FILE *out, Isel_Node *n)
+{
+    fprintf(out, "\tneg\t%s, %s\n", reg_name[n->reg], isel_opd(n->kid[0]));
+}
+
+static void
+isel_emit_addsub(FILE *out, Isel_Node *n)
+{
+    Isel_Node *a = n->kid[0], *b = n->kid[1];
+    int add = n->insn->op == IR_ADD;
+
+    if (a->nt == NT_SHIFT) {
+        a = n->kid[1]; b = n->kid[0];	/* 加算だけ / addition only */
+    }
+    if (b->nt == NT_NIMM12) {
+        add = !add;
+    }
+    fprintf(out, "\t%s\t%s, %s, %s\n", add ? "add" : "sub",
+            reg_name[n->reg], reg_name[a->reg], isel_opd(b));
+}
+
+static void
+isel_emit_mul(FILE *out, Isel_Node *n)
+{
+    gen_insn_mul(out, n->reg, n->kid[0]->reg, n->kid[1]->reg);
+}
+
+/*
+  定数倍の強さの軽減 / strength reduction of multiplication by a constant
+
+  x*cを第2被演算子をシフトしたadd, subとlsl, negの列にする。列は
+  深さ優先で探し、遅延の表(mul_latency)で和がmulより小さい（同じなら
+  命令数が少ない）ものを選ぶ。mulは定数をレジスタに置く命令も数える。
+  出力先が被乗数と同じレジスタなら、最初の命令の後は被乗数を読めない。
+  1命令で済む形は探す前に調べ、求めた列は定数ごとに覚えておく
+  x*c becomes a sequence of add and sub with a shifted second operand,
+  lsl and neg, found depth first.  The one whose total latency by the
+  table (mul_latency) is less than that of mul, or equal with fewer
+  instructions, is chosen; mul also counts the instructions putting the
+  constant in a register.  When the destination is the register of the
+  multiplicand, the multiplicand can't be read after the first
+  instruction.  Forms of a single instruction are checked before the
+  search, and the sequence found is remembered for each constant.
+*/
+
+#define  MUL_MAX_STEPS  3
+#define  MUL_CACHE_SIZE 256
+
+enum { MS_ADD, MS_SUB, MS_LSL, MS_NEG, MS_MUL };
+
+/* 遅延（サイクル）。シフトした被演算子は1サイクル増える
+   Latency in cycles; a shifted operand adds one */
+static const int mul_latency[] = {
+    1,	/* MS_ADD */
+    1,	/* MS_SUB */
+    1,	/* MS_LSL */
+    1,	/* MS_NEG */
+    3,	/* MS_MUL */
+};
+
+/* 列の1命令a op (b lsl s)。a, bは0なら被乗数、1なら途中の値、-1ならなし
+   An instruction a op (b lsl s) of a sequence; a and b are 0 for the
+   multiplicand, 1 for the value so far and -1 for none */
+typedef struct {
+    int  kind;
+    int  a, b;
+    int  s;
+} Mul_Step;
+
+typedef struct {
+    int  n;
+    int  lat, ninsn;
+    Mul_Step step[MUL_MAX_STEPS];
+} Mul_Plan;
+
+/* 求めた列 / sequences found */
+static struct {
+    int  valid;
+    int  c, in_place;
+    int  found;
+    Mul_Plan plan;
+} mul_cache[MUL_CACHE_SIZE];
+
+/*
+  値fからcへの列をcurに続けて探す。シフトはsmaxまで
+  Search for a sequence from f to c following cur, shifting by up to
+  smax
+*/
+static void
+mul_search(unsigned f, unsigned c, int in_place, int smax,
+           Mul_Plan *cur, Mul_Plan *best)
+{
+    Mul_Step *p;
+    unsigned v, val[2];
+    int  lat;
+
+    if (f == c) {
+        if (cur->lat < best->lat
+            || (cur->lat == best->lat && cur->ninsn < best->ninsn)) {
+            *best = *cur;
+        }
+        return;
+    }
+    if (cur->n == MUL_MAX_STEPS) {
+        return;
+    }
+    val[0] = 1; val[1] = f;
+    p = &cur->step[cur->n++];
+    cur->ninsn++;
+    for (p->kind = MS_ADD; p->kind < MS_MUL; p->kind++) {
+        for (p->a = -1; p->a <= 1; p->a++) {
+            if ((p->a < 0) != (p->kind == MS_LSL || p->kind == MS_NEG)) {
+                continue;
+            }
+            for (p->b = 0; p->b <= 1; p->b++) {
+                /* 被乗数を上書きした後は読めない / the multiplicand is gone once overwritten */
+                if (in_place && cur->n > 1 && (p->a == 0 || p->b == 0)) {
+                    continue;
+                }
+                for (p->s = p->kind == MS_LSL; p->s <= smax; p->s++) {
+                    lat = mul_latency[p->kind] + (p->s != 0 && p->kind != MS_LSL);
+                    if (cur->lat+lat > best->lat
+                        || (cur->lat+lat == best->lat && cur->ninsn >= best->ninsn)) {
+                        if (p->s == 0) {
+                            continue;
+                        }
+                        break;		/* 他のシフト数も同じ / so are other shifts */
+                    }
+                    v = val[p->b] << p->s;
+                    switch (p->kind) {
+                    case  MS_ADD:
+                        v = val[p->a]+v;
+                        break;
+                    case  MS_SUB:
+                        v = val[p->a]-v;
+                        break;
+                    case  MS_NEG:
+                        v = -v;
+                        break;
+                    }
+                    cur->lat += lat;
+                    mul_search(v, c, in_place, smax, cur, best);
+                    cur->lat -= lat;
+                }
+            }
+        }
+    }
+    cur->ninsn--;
+    cur->n--;
+}
+
+/*
+  cが1命令の形（lsl, neg, 被乗数同士のadd, sub）ならplanに置いて1
+  1 with the plan if c takes a single instruction: lsl, neg, or add or
+  sub of the multiplicand and itself shifted
+*/
+static int
+mul_single(unsigned c, Mul_Plan *plan)
+{
+    static const struct { int kind, a; unsigned base; int sign; } forms[] = {
+        {MS_LSL, -1, 0,  1},		/* 2^s */
+        {MS_NEG, -1, 0, -1},		/* -(2^s) */
+        {MS_ADD,  0, 1,  1},		/* 1+2^s */
+        {MS_SUB,  0, 1, -1},		/* 1-2^s */
+    };
+    Mul_Step *p = &plan->step[0];
+    int  k, s;
+
+    for (s = 0; s < 32; s++) {
+        for (k = 0; k < 4; k++) {
+            if ((s == 0 && forms[k].kind == MS_LSL)
+                || c != forms[k].base + forms[k].sign*(1u << s)) {
+                continue;
+            }
+            p->kind = forms[k].kind;
+            p->a = forms[k].a;
+            p->b = 0;
+            p->s = s;
+            plan->n = 1;
+            plan->ninsn = 1;
+            plan->lat = mul_latency[p->kind] + (s != 0 && p->kind != MS_LSL);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* x*cの列をplanに求め、mulより良いものがあれば1
+   Find the sequence for x*c in plan; 1 if one better than mul */
+static int
+mul_plan(const Isel_Node *n, Mul_Plan *plan)
+{
+    Mul_Plan cur;
+    int  c = n->kid[1]->insn->imm;
+    int  in_place = n->reg == n->kid[0]->reg;
+    int  h, smax;
+    unsigned m;
+
+    h = ((unsigned)c*2654435761u >> 24 ^ in_place) % MUL_CACHE_SIZE;
+    if (mul_cache[h].valid && mul_cache[h].c == c
+        && mul_cache[h].in_place == in_place) {
+        *plan = mul_cache[h].plan;
+        return mul_cache[h].found;
+    }
+
+    plan->n = 0;
+    plan->lat = mul_latency[MS_MUL];
+    plan->ninsn = (c > SHRT_MAX || c < SHRT_MIN) ? 3 : 2;
+    if (c == 1) {
+        plan->lat = plan->ninsn = 0;
+    } else if (!mul_single(c, plan)) {
+        /* 2^sが|c|の2倍を超えるシフトは役に立たない
+           Shifts with 2^s over twice |c| are of no use */
+        m = c < 0 ? -(unsigned)c : (unsigned)c;
+        for (smax = 1; smax < 31 && (m >> smax) != 0; smax++) {
+            ;
+        }
+        memset(&cur, 0, sizeof(cur));
+        mul_search(1, c, in_place, smax, &cur, plan);
+    }
+
+    mul_cache[h].valid = 1;
+    mul_cache[h].c = c;
+    mul_cache[h].in_place = in_place;
+    mul_cache[h].found = plan->n > 0 || plan->lat < mul_latency[MS_MUL];
+    mul_cache[h].plan = *plan;
+    return mul_cache[h].found;
+}
+
+static int
+isel_mul_cost(const Isel_Node *n)
+{
+    Mul_Plan plan;
+
+    return mul_plan(n, &plan) ? plan.lat : ISEL_INF;
+}
+
+static void
+isel_emit_mul_reduce(FILE *out, Isel_Node *n)
+{
+    static const char *op[] = {"add", "sub", "lsl", "neg"};
+    Mul_Plan plan;
+    Mul_Step *p;
+    const char *r[2];
+    int  k;
+
+    mul_plan(n, &plan);
+    r[0] = reg_name[n->kid[0]->reg];
+    if (plan.n == 0 && n->reg != n->kid[0]->reg) {
+        gen_insn_mov(out, n->reg, n->kid[0]->reg);
+    }
+    for (k = 0; k < plan.n; k++) {
+        p = &plan.step[k];
+        r[1] = k == 0 ? r[0] : reg_name[n->reg];
+        fprintf(out, "\t%s\t%s, ", op[p->kind], reg_name[n->reg]);
+        if (p->a >= 0) {
+            fprintf(out, "%s, ", r[p->a]);
+        }
+        if (p->kind == MS_LSL) {
+            fprintf(out, "%s, %d\n", r[p->b], p->s);
+        } else if (p->s != 0) {
+            fprintf(out, "%s, lsl %d\n", r[p->b], p->s);
+        } else {
+            fprintf(out, "%s\n", r[p->b]);
+        }
+    }
+}
+
+static void
+isel_emit_shr(FILE *out, Isel_Node *n)
+{
+    gen_insn_shr(out, n->reg, n->kid[0]->reg, n->insn->imm);
+}
+
+static void
+isel_emit_cmp(FILE *out, Isel_Node *n)
+{
+    fprintf(out, "\t%s\t%s, %s\n", n->kid[1]->nt == NT_NIMM12 ? "cmn" : "cmp",
+            reg_name[n->kid[0]->reg], isel_opd(n->kid[1]));
+}
+
+static void
+isel_emit_setcc(FILE *out, Isel_Node *n)
+{
+    isel_emit_cmp(out, n);
+    gen_insn_cond_set(out, n->reg, n->insn->cond);
+}
+
+/* 引数や戻り値のレジスタnameに値を置く / put the value in the argument or return register */
+static void
+isel_emit_to(FILE *out, const char *name, Isel_Node *n)
+{
+    if (n->nt == NT_IMM) {
+        load_cnst(out, name, n->insn->imm);
+    } else {
+        fprintf(out, "\tldr\t%s, %s\n",
+                name, frame_operand(n->insn->sym->offset));
+    }
+}
+
+static void
+isel_emit_arg(FILE *out, Isel_Node *n)
+{
+    if (n->kid[0]->nt == ISEL_REG) {
+        gen_call_set_param(out, n->kid[0]->reg, n->insn->imm, n->aux);
+    } else {
+        isel_emit_to(out, param_reg_name[n->insn->imm], n->kid[0]);
+    }
+}
+
+static void
+isel_emit_ret(FILE *out, Isel_Node *n)
+{
+    if (n->kid[0]->nt == ISEL_REG) {
+        gen_insn_ret_asgn(out, n->kid[0]->reg);
+    } else {
+        isel_emit_to(out, "w0", n->kid[0]);
+    }
+}
+
+#define  R  ISEL_REG
+const Isel_Rule isel_rules[] = {
+    {"const",         R,         IR_CONST, {-1, -1},           1, NULL, isel_emit_const, NULL},
+    {"imm",           NT_IMM,    IR_CONST, {-1, -1},           0, NULL, NULL, NULL},
+    {"imm12",         NT_IMM12,  IR_CONST, {-1, -1},           0, isel_is_imm12, NULL, NULL},
+    {"nimm12",        NT_NIMM12, IR_CONST, {-1, -1},           0, isel_is_nimm12, NULL, NULL},
+    {"load",          R,         IR_LOAD,  {-1, -1},           1, NULL, isel_emit_load, NULL},
+    {"mem",           NT_MEM,    IR_LOAD,  {-1, -1},           0, NULL, NULL, NULL},
+    {"store",         ISEL_STMT, IR_STORE, {R, -1},            1, NULL, isel_emit_store, NULL},
+    {"store-zero",    ISEL_STMT, IR_STORE, {NT_IMM, -1},       1, isel_is_zero, isel_emit_store, NULL},
+    {"mov",           R,         IR_MOV,   {R, -1},            1, NULL, isel_emit_mov, NULL},
+    {"mov-imm",       R,         IR_MOV,   {NT_IMM, -1},       1, NULL, isel_emit_mov, NULL},
+    {"neg",           R,         IR_NEG,   {R, -1},            1, NULL, isel_emit_neg, NULL},
+    {"neg-shift",     R,         IR_NEG,   {NT_SHIFT, -1},     1, NULL, isel_emit_neg, NULL},
+    {"lsl",           NT_SHIFT,  IR_MUL,   {R, NT_IMM},        0, isel_is_pow2, NULL, NULL},
+    {"lsr",           NT_SHIFT,  IR_SHR,   {R, -1},            0, isel_is_lsr, NULL, NULL},
+    {"add",           R,         IR_ADD,   {R, R},             1, NULL, isel_emit_addsub, NULL},
+    {"add-imm",       R,         IR_ADD,   {R, NT_IMM12},      1, NULL, isel_emit_addsub, NULL},
+    {"add-nimm",      R,         IR_ADD,   {R, NT_NIMM12},     1, NULL, isel_emit_addsub, NULL},
+    {"add-shift",     R,         IR_ADD,   {R, NT_SHIFT},      1, NULL, isel_emit_addsub, NULL},
+    {"add-shift-rev", R,         IR_ADD,   {NT_SHIFT, R},      1, NULL, isel_emit_addsub, NULL},
+    {"sub",           R,         IR_SUB,   {R, R},             1, NULL, isel_emit_addsub, NULL},
+    {"sub-imm",       R,         IR_SUB,   {R, NT_IMM12},      1, NULL, isel_emit_addsub, NULL},
+    {"sub-nimm",      R,         IR_SUB,   {R, NT_NIMM12},     1, NULL, isel_emit_addsub, NULL},
+    {"sub-shift",     R,         IR_SUB,   {R, NT_SHIFT},      1, NULL, isel_emit_addsub, NULL},
+    {"mul",           R,         IR_MUL,   {R, R},             3, NULL, isel_emit_mul, NULL},
+    {"mul-reduce",    R,         IR_MUL,   {R, NT_IMM},        3, NULL, isel_emit_mul_reduce,
+     isel_mul_cost},
+    {"shr",           R,         IR_SHR,   {R, -1},            1, NULL, isel_emit_shr, NULL},
+    {"setcc",         R,         IR_SETCC, {R, R},             2, NULL, isel_emit_setcc, NULL},
+    {"setcc-imm",     R,         IR_SETCC, {R, NT_IMM12},      2, NULL, isel_emit_setcc, NULL},
+    {"setcc-nimm",    R,         IR_SETCC, {R, NT_NIMM12},     2, NULL, isel_emit_setcc, NULL},
+    {"setcc-shift",   R,         IR_SETCC, {R, NT_SHIFT},      2, NULL, isel_emit_setcc, NULL},
+    {"cmp",           ISEL_STMT, IR_BR,    {R, R},             1, isel_is_cond, isel_emit_cmp, NULL},
+    {"cmp-imm",       ISEL_STMT, IR_BR,    {R, NT_IMM12},      1, isel_is_cond, isel_emit_cmp, NULL},
+    {"cmp-nimm",      ISEL_STMT, IR_BR,    {R, NT_NIMM12},     1, isel_is_cond, isel_emit_cmp, NULL},
+    {"cmp-shift",     ISEL_STMT, IR_BR,    {R, NT_SHIFT},      1, isel_is_cond, isel_emit_cmp, NULL},
+    {"arg",           ISEL_STMT, IR_ARG,   {R, -1},            1, NULL, isel_emit_arg, NULL},
+    {"arg-imm",       ISEL_STMT, IR_ARG,   {NT_IMM, -1},       1, isel_is_reg_arg, isel_emit_arg, NULL},
+    {"arg-mem",       ISEL_STMT, IR_ARG,   {NT_MEM, -1},       1, isel_is_reg_arg, isel_emit_arg, NULL},
+    {"ret",           ISEL_STMT, IR_RET,   {R, -1},            1, NULL, isel_emit_ret, NULL},
+    {"ret-imm",       ISEL_STMT, IR_RET,   {NT_IMM, -1},       1, NULL, isel_emit_ret, NULL},
+    {"ret-mem",       ISEL_STMT, IR_RET,   {NT_MEM, -1},       1, NULL, isel_emit_ret, NULL},
+    {NULL}
+};
+#undef  R
+
+/*
+  覗き穴最適化の規則 / rules for the peephole optimizer
+
+  生成するコードはフラグをラベルや分岐を越えて使わない。レジスタの
+  生死は次の分岐までの命令だけを見て（ラベルは素通りする）、分からな
+  ければ生きているとみなす。
+  The generated code never uses the flags across labels or branches.
+  Registers are considered dead only if the instructions up to the next
+  branch tell so (labels are passed through); otherwise they are taken
+  as live.
+*/
+
+#define  PEEP_SP  31		/* spの番号 / number for sp */
+
+/* wN, xN, spならその番号、でなければ-1 / the register number, or -1 */
+static int
+peep_reg(const char *opd)
+{
+    char *end;
+    long r;
+
+    if (strcmp(opd, "sp") == 0) {
+        return PEEP_SP;
+    }
+    if (opd[0] != 'w' && opd[0] != 'x') {
+        return -1;
+    }
+    r = strtol(opd+1, &end, 10);
+    return end != opd+1 && *end == '\0' && r < 31 ? (int)r : -1;
+}
+
+/* オペランドがレジスタrを含めば1 / 1 if the operand contains register r */
+static int
+peep_mentions(const char *opd, int r)
+{
+    char buf[PEEP_OPD_LEN];
+    char *s;
+
+    if (opd[0] != '[') {
+        return peep_reg(opd) == r;
+    }
+    snprintf(buf, sizeof(buf), "%s", opd+1);
+    for (s = strtok(buf, "[], "); s != NULL; s = strtok(NULL, "[], ")) {
+        if (peep_reg(s) == r) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* 第1オペランドに書き込むだけの命令 / write the first operand without reading it */
+static int
+peep_writes_first(const Peep_Insn *p)
+{
+    static const char *ops[] = {"mov", "add", "sub", "mul", "neg", "lsr",
+                                "lsl", "cset", "ldr", NULL};
+    const char **op;
+
+    for (op = ops; *op != NULL; op++) {
+        if (strcmp(p->op, *op) == 0) {
+            return p->nopd >= 2;
+        }
+    }
+    return 0;
+}
+
+/* w[k]の後でレジスタrが使われなければ1 / 1 if register r is dead after w[k] */
+static int
+peep_reg_dead(Peep_Insn *w, int n, int k, int r)
+{
+    int i;
+    Peep_Insn *p;
+
+    for (k++; k < n; k++) {
+        p = &w[k];
+        if (p->label != NULL) {
+            continue;	/* 合流しても生死は変わらない / joins don't change liveness */
+        }
+        if (!peep_is_insn(p) || (p->op[0] == 'b' && strcmp(p->op, "bl") != 0)
+            || strncmp(p->op, "cb", 2) == 0) {
+            return 0;
+        }
+        if (strcmp(p->op, "bl") == 0) {
+            /* 引数を読み、呼び出し元退避レジスタを壊す
+               Reads the arguments and clobbers the caller-saved registers */
+            if (r < 8) {
+                return 0;
+            }
+            if (r < 19) {
+                return 1;
+            }
+            continue;
+        }
+        if (strcmp(p->op, "ret") == 0) {
+            /* w0と呼び出し先退避レジスタは呼び出し元で使う
+               w0 and the callee-saved registers are used by the caller */
+            return r != 0 && r < 19;
+        }
+        for (i = peep_writes_first(p) ? 1 : 0; i < p->nopd; i++) {
+            if (peep_mentions(p->opd[i], r)) {
+                return 0;
+            }
+        }
+        if (peep_writes_first(p) && peep_reg(p->opd[0]) == r) {
+            return 1;
+        }
+        if (!peep_writes_first(p) && strcmp(p->op, "str") != 0
+            && strcmp(p->op, "cmp") != 0 && strcmp(p->op, "cmn") != 0
+            && strcmp(p->op, "stp") != 0
+            && strcmp(p->op, "ldp") != 0) {
+            return 0;		/* 分からない / unknown */
+        }
+    }
+    return 0;
+}
+
+/* w[k]の後でフラグが使われなければ1 / 1 if the flags are dead after w[k] */
+static int
+peep_flags_dead(Peep_Insn *w, int n, int k)
+{
+    Peep_Insn *p;
+
+    for (k++; k < n; k++) {
+        p = &w[k];
+        if (p->label != NULL) {
+            return 1;
+        }
+        if (!peep_is_insn(p) || strncmp(p->op, "b.", 2) == 0
+            || strcmp(p->op, "cset") == 0) {
+            return 0;
+        }
+        if (strcmp(p->op, "cmp") == 0 || strcmp(p->op, "cmn") == 0
+            || strcmp(p->op, "b") == 0
+            || strcmp(p->op, "bl") == 0 || strcmp(p->op, "ret") == 0) {
+            return 1;
+        }
+    }
+    return 1;
+}
+
+/* str wA, M; ldr wB, M -> str wA, M; mov wB, wA */
+static int
+peep_store_reload(Peep_Insn *w, int n)
+{
+    if (n < 2 || !peep_is(&w[0], "str", 2) || !peep_is(&w[1], "ldr", 2)
+        || w[0].opd[0][0] != w[1].opd[0][0]
+        || peep_reg(w[0].opd[0]) < 0 || peep_reg(w[1].opd[0]) < 0
+        || strcmp(w[0].opd[1], w[1].opd[1]) != 0) {
+        return 0;
+    }
+    if (strcmp(w[0].opd[0], w[1].opd[0]) == 0) {
+        peep_delete(&w[1]);
+    } else {
+        peep_rewrite(&w[1], "mov", 2, w[1].opd[0], w[0].opd[0], NULL);
+    }
+    return 1;
+}
+
+/* [sp, N]や[sp]ならN、でなければ-1 / N for [sp, N] or [sp], or -1 */
+static int
+peep_sp_offset(const char *opd)
+{
+    char *end;
+    long off;
+
+    if (strcmp(opd, "[sp]") == 0) {
+        return 0;
+    }
+    if (strncmp(opd, "[sp, ", 5) != 0) {
+        return -1;
+    }
+    off = strtol(opd+5, &end, 10);
+    return end != opd+5 && strcmp(end, "]") == 0 && off >= 0 ? (int)off : -1;
+}
+
+/*
+  ldr wA, M; ...; str wA, M -> ldr wA, M; ...
+  続く呼び出しの前後の退避で、読み戻した値をそのまま書き戻す。間にあるのが
+  wAにもMにも触れないldrとstrだけのときに限る
+  Between consecutive calls, a value reloaded after one call is stored
+  back unchanged before the next.  Only ldr and str touching neither wA
+  nor M may come in between.
+*/
+static int
+peep_reload_store(Peep_Insn *w, int n)
+{
+    int r, k, t, off, o;
+
+    if (!peep_is(&w[0], "ldr", 2) || w[0].opd[0][0] != 'w'
+        || (r = peep_reg(w[0].opd[0])) < 0
+        || (off = peep_sp_offset(w[0].opd[1])) < 0) {
+        return 0;
+    }
+    for (k = 1; k < n; k++) {
+        if (peep_is(&w[k], "str", 2)
+            && strcmp(w[k].opd[0], w[0].opd[0]) == 0
+            && strcmp(w[k].opd[1], w[0].opd[1]) == 0) {
+            peep_delete(&w[k]);
+            return 1;
+        }
+        if (peep_is(&w[k], "ldr", 2)) {
+            if ((t = peep_reg(w[k].opd[0])) < 0 || t == r || t == PEEP_SP
+                || w[k].opd[1][strlen(w[k].opd[1])-1] == '!') {
+                break;
+            }
+        } else if (!peep_is(&w[k], "str", 2) || w[k].opd[0][0] != 'w'
+                   || (o = peep_sp_offset(w[k].opd[1])) < 0
+                   || (o < off+4 && off < o+4)) {
+            break;
+        }
+    }
+    return 0;
+}
+
+/* 直後のラベルへのb / b to the label just after */
+static int
+peep_jmp_next(Peep_Insn *w, int n)
+{
+    if (peep_is(&w[0], "b", 1) && peep_label_follows(w, n, 0, w[0].opd[0])) {
+        peep_delete(&w[0]);
+        return 1;
+    }
+    return 0;
+}
+
+/* mov wA, wA */
+static int
+peep_self_move(Peep_Insn *w, int n)
+{
+    if (peep_is(&w[0], "mov", 2) && peep_reg(w[0].opd[0]) >= 0
+        && strcmp(w[0].opd[0], w[0].opd[1]) == 0) {
+        peep_delete(&w[0]);
+        return 1;
+    }
+    return 0;
+}
+
+/* mov wA, wB; mov wB, wA -> mov wA, wB */
+static int
+peep_copy_back(Peep_Insn *w, int n)
+{
+    if (n >= 2 && peep_is(&w[0], "mov", 2) && peep_is(&w[1], "mov", 2)
+        && peep_reg(w[0].opd[0]) >= 0 && peep_reg(w[0].opd[1]) >= 0
+        && strcmp(w[0].opd[0], w[1].opd[1]) == 0
+        && strcmp(w[0].opd[1], w[1].opd[0]) == 0) {
+        peep_delete(&w[1]);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+  op wT, ...; mov wD, wT -> op wD, ... （wTがその後使われない）
+  3オペランドなので演算の結果も直接置ける。gen_insn_ret_asgnや
+  引数の設定の前の転送を省く
+  ... if wT is dead afterwards.  With three operands the result of an
+  operation can go there directly as well.  Removes the copies before
+  gen_insn_ret_asgn and the argument setup.
+*/
+static int
+peep_copy_forward(Peep_Insn *w, int n)
+{
+    int t;
+
+    if (n < 2 || !peep_is_insn(&w[0]) || !peep_writes_first(&w[0])
+        || !peep_is(&w[1], "mov", 2)
+        || (t = peep_reg(w[0].opd[0])) < 0 || t == PEEP_SP
+        || w[0].opd[0][0] != 'w' || strcmp(w[1].opd[1], w[0].opd[0]) != 0
+        || peep_reg(w[1].opd[0]) < 0 || peep_reg(w[1].opd[0]) == PEEP_SP
+        || w[1].opd[0][0] != 'w'
+        || !peep_reg_dead(w, n, 1, t)) {
+        return 0;
+    }
+    peep_rewrite(&w[0], w[0].op, w[0].nopd, w[1].opd[0], w[0].opd[1],
+                 w[0].opd[2]);
+    peep_delete(&w[1]);
+    return 1;
+}
+
+/* mov wT, 0; str wT, M -> str wzr, M （wTがその後使われない / if wT is dead） */
+static int
+peep_zero_store(Peep_Insn *w, int n)
+{
+    int t;
+
+    if (n < 2 || !peep_is(&w[0], "mov", 2) || strcmp(w[0].opd[1], "0") != 0
+        || !peep_is(&w[1], "str", 2)
+        || (t = peep_reg(w[0].opd[0])) < 0 || w[0].opd[0][0] != 'w'
+        || strcmp(w[1].opd[0], w[0].opd[0]) != 0
+        || peep_mentions(w[1].opd[1], t) || !peep_reg_dead(w, n, 1, t)) {
+        return 0;
+    }
+    peep_rewrite(&w[1], "str", 2, "wzr", w[1].opd[1], NULL);
+    peep_delete(&w[0]);
+    return 1;
+}
+
+/* cmp wN, 0; b.eq L -> cbz wN, L */
+static int
+peep_cmp_branch(Peep_Insn *w, int n)
+{
+    if (n < 2 || !peep_is(&w[0], "cmp", 2) || strcmp(w[0].opd[1], "0") != 0
+        || peep_reg(w[0].opd[0]) < 0
+        || !(peep_is(&w[1], "b.eq", 1) || peep_is(&w[1], "b.ne", 1))
+        || !peep_flags_dead(w, n, 1)) {
+        return 0;
+    }
+    peep_rewrite(&w[1], strcmp(w[1].op, "b.eq") == 0 ? "cbz" : "cbnz", 2,
+                 w[0].opd[0], w[1].opd[0], NULL);
+    peep_delete(&w[0]);
+    return 1;
+}
+
+const Peep_Rule peep_rules[] = {
+    {"store-reload", peep_store_reload},
+    {"reload-store", peep_reload_store},
+    {"jmp-next", peep_jmp_next},
+    {"self-move", peep_self_move},
+    {"copy-back", peep_copy_back},
+    {"copy-forward", peep_copy_forward},
+    {"zero-store", peep_zero_store},
+    {"cmp-branch", peep_cmp_branch},
+    {NULL, NULL}
+};
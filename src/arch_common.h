@@ -19,28 +19,46 @@ extern const char PUTINT_CODE[];
 extern const char SECTION_TEXT[];
 extern const char CALL_OP[];
 
+/* NUM_REGS番以降は引数レジスタで、呼び出しをまたがない値にだけ使う
+   (color.c, regalloc.c) / Argument registers follow from number NUM_REGS
+   on, used only for values not live across a call (color.c, regalloc.c) */
 extern char reg_name[][10];
+extern const int NUM_REGS;		/* 割り付けに使うレジスタの数 / number of allocatable registers */
+extern const int FIRST_CALLEE_SAVED;	/* これ以降は呼び出し先退避 / callee-saved from this number on */
+extern const int RET_REG;		/* 戻り値のレジスタ (-1: 割り付け対象外で1番目の引数と同じ) / return value (-1: not allocatable, same as argument 1) */
 extern char param_reg_name[][10];
+extern const int NUM_PARAM_REGS;	/* レジスタで渡す引数の数 / arguments passed in registers */
 
 extern void arch_assign_memory(SymTab *symtab);
 
-extern void gen_func_header(FILE *out, char *name,
-                            int frame_size, AST_List *arg_list);
-extern void gen_store_params(FILE *out, AST_Node *param, int nump);
+/* gen_func_header()に渡すフレームの形 / frame kinds for gen_func_header() */
+#define  FRAME_KEEP  0	/* フレームポインタを使う / use the frame pointer */
+#define  FRAME_OMIT  1	/* フレームポインタを省略する / omit the frame pointer */
+#define  FRAME_LEAF  2	/* 省略し、他の関数も呼ばない / omitted, and no calls either */
+
+extern void gen_func_header(FILE *out, char *name, int frame_size,
+                            SymTab **params, int nparams, int saved,
+                            int call_area, int frame_mode);
+extern void gen_store_params(FILE *out, SymTab *param, int nump);
 extern void gen_func_footer(FILE *out, const char *func_end_label);
-extern void gen_exp_ident(FILE *out, AST_Node *idnt);
-extern void gen_exp_cnst(FILE *out, AST_Node *c);
-extern int  gen_call_prologue(FILE *out, AST_Node *e,
-                              int *padsize, int *framesize);
+extern int  gen_call_area(int nargs, unsigned int save);
+extern int  gen_call_prologue(FILE *out, int nargs, int reg, unsigned int save,
+                              int in_frame, int *padsize, int *framesize);
 extern void gen_call_set_param(FILE *out, int reg, int nump, int sparams);
-extern void gen_call_epilogue(FILE *out, AST_Node *e,
-                              int padsize, int framesize);
+extern void gen_call_epilogue(FILE *out, const char *name, int reg, int use,
+                              unsigned int save, int padsize, int framesize);
+extern void gen_tail_call(FILE *out, const char *name);
 
+extern void gen_insn_load_cnst(FILE* out, int reg, int val);
+extern void gen_insn_load_lvar(FILE* out, int reg, int offset);
 extern void gen_insn_store_lvar(FILE* out, int reg, int offset);
+extern void gen_insn_load_param(FILE* out, int reg, int nump, int offset);
+extern void gen_insn_mov(FILE* out, int dst, int src);
 extern void gen_insn_neg(FILE* out, int dst, int src);
 extern void gen_insn_add(FILE* out, int dst, int src1, int src2);
 extern void gen_insn_sub(FILE* out, int dst, int src1, int src2);
 extern void gen_insn_mul(FILE* out, int dst, int src1, int src2);
+extern void gen_insn_shr(FILE* out, int dst, int src, int shift);
 extern void gen_insn_ret_asgn(FILE *out, int src);
 extern void gen_insn_jmp(FILE *out, const char *label);
 extern void gen_insn_cmp(FILE* out, int src1, int src2);
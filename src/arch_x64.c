@@ -8,8 +8,13 @@
 */
 
 #include  <assert.h>
+#include  <ctype.h>
+#include  <limits.h>
+#include  <stdlib.h>
 #include  <string.h>
 #include  "arch_common.h"
+#include  "isel.h"
+#include  "peephole.h"
 #include  "symtab.h"
 #include  "util.h"
 
@@ -85,7 +90,32 @@ const char PUTINT_CODE[]  =
 #elif defined(TARGET_CYGWIN)
 #endif
 
-char reg_name[][10] = {"%eax", "%r10d", "%r11d"};
+/* 呼び出し元退避、呼び出し先退避、引数の順
+   Caller-saved ones first, then callee-saved, then the arguments */
+#ifdef  TARGET_CYGWIN
+char reg_name[][10] = {"%eax", "%r10d", "%r11d",
+                       "%ebx", "%r12d", "%r13d", "%r14d", "%r15d",
+                       "%ecx", "%edx", "%r8d", "%r9d", "%edi", "%esi"};
+static const char reg_name8[][8] = {"%al", "%r10b", "%r11b",
+                                    "%bl", "%r12b", "%r13b", "%r14b", "%r15b",
+                                    "%cl", "%dl", "%r8b", "%r9b", "%dil", "%sil"};
+static const char reg_name64[][8] = {"%rax", "%r10", "%r11",
+                                     "%rbx", "%r12", "%r13", "%r14", "%r15",
+                                     "%rcx", "%rdx", "%r8", "%r9", "%rdi", "%rsi"};
+#else
+char reg_name[][10] = {"%eax", "%r10d", "%r11d",
+                       "%ebx", "%r12d", "%r13d", "%r14d", "%r15d",
+                       "%edi", "%esi", "%edx", "%ecx", "%r8d", "%r9d"};
+static const char reg_name8[][8] = {"%al", "%r10b", "%r11b",
+                                    "%bl", "%r12b", "%r13b", "%r14b", "%r15b",
+                                    "%dil", "%sil", "%dl", "%cl", "%r8b", "%r9b"};
+static const char reg_name64[][8] = {"%rax", "%r10", "%r11",
+                                     "%rbx", "%r12", "%r13", "%r14", "%r15",
+                                     "%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+#endif
+const int NUM_REGS = 8;
+const int FIRST_CALLEE_SAVED = 3;
+const int RET_REG = 0;
 #ifdef  TARGET_CYGWIN
 char param_reg_name[][10] = {"NULL", "%ecx", "%edx", "%r8d", "%r9d",
 				    "%edi", "%esi" };
@@ -93,6 +123,7 @@ char param_reg_name[][10] = {"NULL", "%ecx", "%edx", "%r8d", "%r9d",
 char param_reg_name[][10] = {"NULL", "%edi", "%esi", "%edx", "%ecx",
 				    "%r8d", "%r9d" };
 #endif
+const int NUM_PARAM_REGS = 6;
 
 /* tlcにおけるx86 (64bit)スタックレイアウトメモ
    note for x86(64bit) stack layout in tlc
@@ -187,23 +218,25 @@ To make the situation above:
 void
 arch_assign_memory(SymTab *symtab)
 {
-    int id_arg, id_var;
+    int id_arg, id_var, id_rarg;
     SymTab *t;
 
-    id_arg = 0; id_var = 0;
+    /* レジスタに昇格した変数・レジスタ渡しの引数には領域を置かない
+       No slots for variables and register parameters promoted to registers */
+    id_arg = 0; id_var = 0; id_rarg = 0;
     for (t = symtab; t != NULL; t = t->next) {
         /* 変数のサイズはint 4byteで固定 */
         if (t->kind == SYM_ARG) {
             t->argid = ++id_arg;
         } else if (t->kind == SYM_AUTOVAR) {
-            t->offset = (++id_var)*(-4);
+            t->offset = t->promoted ? 0 : (++id_var)*(-4);
             t->argid = 0;
         }
     }
     for (t = symtab; t != NULL; t = t->next) {
         if (t->kind == SYM_ARG) {
             if (t->argid < 7) {
-                t->offset = (id_var+t->argid)*(-4);
+                t->offset = t->promoted ? 0 : (id_var+(++id_rarg))*(-4);
             } else {
                 t->offset = 16+(t->argid-7)*8;
             }
@@ -211,97 +244,234 @@ arch_assign_memory(SymTab *symtab)
     }
 }
 
+#ifdef  TARGET_CYGWIN
+#define  RED_ZONE_SIZE 0	/* Windowsにはred zoneがない / no red zone on Windows */
+#else
+#define  RED_ZONE_SIZE 128	/* %rspの下で使ってよい大きさ / usable bytes below %rsp */
+#endif
+
+static int saved_regs;		/* 関数で退避した呼び出し先退避レジスタ / callee-saved registers saved */
+static int saved_base;		/* 退避領域の%rbpからの距離 / distance of the save slots from %rbp */
+static int omit_fp;		/* %rbpを使わない / %rbp is not used */
+static int frame_bytes;		/* 入口で%rspから引いた大きさ / bytes subtracted from %rsp at the entry */
+static int sp_shift;		/* 呼び出し列で%rspをずらした大きさ / %rsp moved by call sequences */
+
+/*
+  %rbpからの位置offsetのオペランド。%rbpを使わない関数では%rsp基準に直す
+  Operand for offset from %rbp.  Rewritten relative to %rsp in functions
+  without %rbp.
+*/
+static char*
+frame_operand(int offset)
+{
+    static char buf[32];
+
+    if (omit_fp) {
+        /* 入口の%rspを%rbpの代わりにする。old %rbpを積まないので
+           スタック渡しの引数（正のoffset）は8byte近い
+           The entry %rsp takes the place of %rbp.  The stack arguments
+           (positive offsets) are 8 bytes closer as old %rbp is not pushed */
+        if (offset > 0) {
+            offset -= 8;
+        }
+        snprintf(buf, sizeof(buf), "%d(%%rsp)", offset+frame_bytes+sp_shift);
+    } else {
+        snprintf(buf, sizeof(buf), "%d(%%rbp)", offset);
+    }
+    return buf;
+}
+
+/*
+  savedは使う呼び出し先退避レジスタの集合（ビットが番号）。局所変数の
+  直下に8byteずつ保存し、関数末尾で戻す。call_areaは呼び出し列が
+  使う領域で、フレームの底（%rspの直上）に一度だけ確保する。
+  frame_modeがFRAME_KEEPでなければ%rbpを積まずに%rsp基準で
+  アクセスし、FRAME_LEAFで収まるならred zoneを使って%rspも動かさない
+  saved is the set of callee-saved registers used (a bit per number).
+  They are stored 8 bytes each just below the local variables and
+  restored at the end.  call_area is the space used by the call
+  sequences, reserved once at the bottom of the frame (just above %rsp).
+  Unless frame_mode is FRAME_KEEP, %rbp is not pushed and the frame is
+  accessed relative to %rsp; with FRAME_LEAF the red zone is used when
+  the frame fits, and %rsp is not moved either.
+*/
 void
-gen_func_header(FILE *out, char *name, int frame_size, AST_List *arg_list)
+gen_func_header(FILE *out, char *name, int frame_size,
+                SymTab **params, int nparams, int saved, int call_area,
+                int frame_mode)
 {
     const char *targetn = name;
-    AST_List *l;
-    int i;
-    int pad;
+    int i, k;
+    int size, npush;
 
-    /* 整列補正用のpad計算。上記のスタックに関するメモを参照
+    /* 整列補正。上記のスタックに関するメモを参照
        frame_sizeはメモ中の(Nv+Na1)*4に等しい
-       Calculate pad for memory alignment.
-       Please look at the note in symtab.c
+       Align the frame.  Please look at the note in symtab.c
        frame_size is equal to (Nv+Na1)*4 in the note.
     */
-    pad = 16 - frame_size%16;
-    if (pad == 16) {
-        pad = 0;
+    saved_regs = saved;
+    saved_base = (frame_size+7)/8*8;
+    npush = 0;
+    for (i = FIRST_CALLEE_SAVED; i < NUM_REGS; i++) {
+        npush += (saved >> i) & 1;
+    }
+    size = saved_base+npush*8+call_area;
+    omit_fp = frame_mode != FRAME_KEEP;
+    sp_shift = 0;
+    if (!omit_fp) {
+        size = (size+15)/16*16;
+    } else if (frame_mode == FRAME_LEAF && size <= RED_ZONE_SIZE) {
+        size = 0;
+    } else if (size > 0 || frame_mode != FRAME_LEAF) {
+        /* 戻り番地の分を合わせて16byte境界にする
+           Keep 16-byte alignment together with the return address */
+        size = (size+8+15)/16*16-8;
     }
+    frame_bytes = size;
     if (strcmp(name, "main") == 0) {
         targetn = MAIN_LABEL;
     }
     fprintf(out,
             "\t.globl\t%s\n"
             "%s:\n", targetn, targetn);
-    fputs("\tpushq\t%rbp\n"
-          "\tmovq\t%rsp, %rbp\n", out);
-    i = 0;
-    TRAVERSE_AST_LIST(l, arg_list, gen_store_params(out, l->elem, ++i));
-    if (frame_size+pad > 0) {
-        fprintf(out, "\tsubq\t$%d, %%rsp\n", frame_size+pad);
+    if (!omit_fp) {
+        fputs("\tpushq\t%rbp\n"
+              "\tmovq\t%rsp, %rbp\n", out);
+        for (i = 0; i < nparams; i++) {
+            gen_store_params(out, params[i], i+1);
+        }
+    }
+    if (size > 0) {
+        fprintf(out, "\tsubq\t$%d, %%rsp\n", size);
+    }
+    if (omit_fp) {
+        /* %rsp基準なのでフレームを確保してから / after the frame, as %rsp is the base */
+        for (i = 0; i < nparams; i++) {
+            gen_store_params(out, params[i], i+1);
+        }
+    }
+    for (i = FIRST_CALLEE_SAVED, k = 0; i < NUM_REGS; i++) {
+        if ((saved >> i) & 1) {
+            fprintf(out, "\tmovq\t%s, %s\n",
+                    reg_name64[i], frame_operand(-(saved_base+8*++k)));
+        }
+    }
+}
+
+/* 呼び出し先退避レジスタを戻す / restore the callee-saved registers */
+static void
+gen_restore_saved(FILE *out)
+{
+    int i, k;
+
+    for (i = FIRST_CALLEE_SAVED, k = 0; i < NUM_REGS; i++) {
+        if ((saved_regs >> i) & 1) {
+            fprintf(out, "\tmovq\t%s, %s\n",
+                    frame_operand(-(saved_base+8*++k)), reg_name64[i]);
+        }
+    }
+}
+
+/* フレームを捨てる / discard the frame */
+static void
+gen_leave(FILE *out)
+{
+    gen_restore_saved(out);
+    if (!omit_fp) {
+        fputs("\tleave\n", out);
+    } else if (frame_bytes > 0) {
+        fprintf(out, "\taddq\t$%d, %%rsp\n", frame_bytes);
     }
 }
 
 void
-gen_store_params(FILE *out, AST_Node *param, int nump)
+gen_store_params(FILE *out, SymTab *param, int nump)
 {
-    if (nump < 7) {
-        AST_Node *pid = param->child[0];
-        assert(pid != NULL && pid->symtab != NULL);
-        fprintf(out, "\tmovl\t%s, %d(%%rbp)\n",
-                param_reg_name[nump], pid->symtab->offset);
+    if (nump < 7 && !param->promoted) {
+        assert(param != NULL);
+        fprintf(out, "\tmovl\t%s, %s\n",
+                param_reg_name[nump], frame_operand(param->offset));
     }
 }
 
 void
 gen_func_footer(FILE *out, const char *func_end_label)
 {
-    fprintf(out, "%s:\n"
-            "\tleave\n"
-            "\tret\n\n", func_end_label);
+    fprintf(out, "%s:\n", func_end_label);
+    gen_leave(out);
+    fputs("\tret\n\n", out);
 }
 
-void
-gen_exp_cnst(FILE *out, AST_Node *c)
+/*
+  saveの中でiより番号の大きいレジスタの数。番号の小さいものほど上に置く
+  Number of registers in save numbered above i; lower numbers go higher
+*/
+static int
+save_slot(unsigned int save, int i)
 {
-    fprintf(out, "\tmovl\t$%d, %s\n", c->val, reg_name[c->reg]);
+    int n;
+
+    for (n = 0, i++; i < NUM_REGS; i++) {
+        n += (save >> i) & 1;
+    }
+    return n;
 }
 
-void
-gen_exp_ident(FILE *out, AST_Node *idnt)
+/*
+  呼び出し列がスタック上で使う大きさ（スタック渡しの実引数と退避領域）
+  Size used on the stack by a call sequence: the arguments passed in
+  the stack and the save slots
+*/
+int
+gen_call_area(int nargs, unsigned int save)
 {
-    fprintf(out, "\tmovl\t%d(%%rbp), %s\n",
-            idnt->symtab->offset, reg_name[idnt->reg]);
+    int sparams = (nargs > 6) ? nargs - 6 : 0;
+
+    return sparams*8+save_slot(save, -1)*4;
 }
 
+/*
+  regには戻り値を受け取るレジスタを渡す（このレジスタは退避しない）
+  saveは呼び出しの前後で退避するレジスタの集合。in_frameが真なら
+  関数の入口で確保済みの領域を使い、%rspを動かさない。退避も
+  スタック渡しの実引数もないときも同じ
+  reg is the register receiving the return value, which is not saved.
+  save is the set of registers saved around the call.  If in_frame is
+  true the area reserved at the function entry is used and %rsp is left
+  alone, as it is when nothing is saved or passed in the stack.
+*/
 int
-gen_call_prologue(FILE *out, AST_Node *e, int *padsize, int *framesize)
+gen_call_prologue(FILE *out, int nargs, int reg, unsigned int save,
+                  int in_frame, int *padsize, int *framesize)
 {
-    int i, psize, fsize, pad, sparams;
-    AST_List *l;
-    
-    sparams = 0;
-    TRAVERSE_AST_LIST(l, e->list, ++sparams);
+    int i, psize, fsize, pad, sparams, nslots;
+
+    sparams = nargs;
+    nslots = save_slot(save, -1);
     /* %rspの整列補正。上記のスタックに関するメモを参照
        Adjust %rsp for alignment. See the note about stack above. */
     sparams = (sparams > 6) ? sparams - 6 : 0;
-    pad = 4-(sparams*2+3)%4; /* sparams*2はスタック上で2要素分占めるため / for 2elemnts */
+    pad = 4-(sparams*2+nslots)%4; /* sparams*2はスタック上で2要素分占めるため / for 2elemnts */
     if (pad == 4) {
         pad = 0;
     }
     pad *= 4; psize = sparams * 8;
-    fsize = pad+psize+3*4; /* %eax, %ecx, and %edx are all int(4byte)
+    fsize = pad+psize+nslots*4; /* %eax, %r10d, and %r11d are all int(4byte)
 			      The size of a parameters passed through stack is 8byte. */
+    if (in_frame) {
+        fsize = 0;
+    }
 
     /* 実引数とpadと待避するレジスタの分だけ%rspをずらす
        Adjust %rsp by total size of the actual parameters, pad, and saved registers */
-    fprintf(out, "\tsubq\t$%d, %%rsp\n", fsize);
-    for (i = 0; i < 3; i++) {
-        if (e->reg != i) {
+    if (fsize > 0) {
+        fprintf(out, "\tsubq\t$%d, %%rsp\n", fsize);
+        sp_shift += fsize;
+    }
+    for (i = 0; i < NUM_REGS; i++) {
+        if ((save >> i) & 1 && reg != i) {
             fprintf(out, "\tmovl\t%s, %d(%%rsp)\n",
-                    reg_name[i], psize+12-4*(i+1));
+                    reg_name[i], psize+4*save_slot(save, i));
         }
     }
 
@@ -315,30 +485,48 @@ gen_call_set_param(FILE *out, int reg, int nump, int sparams)
 {
     /* sparms is not used for x64. */
     if (nump < 7) {
-        fprintf(out, "\tmovl\t%s, %s\n",
-                reg_name[reg], param_reg_name[nump]);
+        if (strcmp(param_reg_name[nump], reg_name[reg]) != 0) {
+            fprintf(out, "\tmovl\t%s, %s\n",
+                    reg_name[reg], param_reg_name[nump]);
+        }
     } else {
         fprintf(out, "\tmovl\t%s, %d(%%rsp)\n",	reg_name[reg], (nump-7)*8);
     }
 }
 
 void
-gen_call_epilogue(FILE *out, AST_Node *e, int padsize, int framesize)
+gen_call_epilogue(FILE *out, const char *name, int reg, int use,
+                  unsigned int save, int padsize, int framesize)
 {
     int i;
-    fprintf(out, "\tcall\t%s\n", e->child[0]->str);
+    fprintf(out, "\tcall\t%s\n", name);
     /* 戻り値の格納 / copy return value*/
-    if (e->reg != 0) {
-        fprintf(out, "\tmovl\t%s, %s\n", reg_name[0], reg_name[e->reg]);
+    if (reg != 0) {
+        fprintf(out, "\tmovl\t%s, %s\n", reg_name[0], reg_name[reg]);
     }
     /* %rspを戻す / pop %rsp */
-    for (i = 0; i < 3; i++) {
-        if (e->reg != i) {
+    for (i = 0; i < NUM_REGS; i++) {
+        if ((save >> i) & 1 && reg != i) {
             fprintf(out, "\tmovl\t%d(%%rsp), %s\n",
-                    padsize+12-4*(i+1), reg_name[i]);
+                    padsize+4*save_slot(save, i), reg_name[i]);
         }
     }
-    fprintf(out, "\taddq\t$%d, %%rsp\n", framesize);
+    if (framesize > 0) {
+        fprintf(out, "\taddq\t$%d, %%rsp\n", framesize);
+        sp_shift -= framesize;
+    }
+}
+
+/*
+  フレームを捨ててnameへ飛ぶ。引数はレジスタに設定済み
+  Discard the frame and jump to name, whose arguments are already in
+  the registers.
+*/
+void
+gen_tail_call(FILE *out, const char *name)
+{
+    gen_leave(out);
+    fprintf(out, "\tjmp\t%s\n", name);
 }
 
 /*
@@ -348,41 +536,108 @@ gen_call_epilogue(FILE *out, AST_Node *e, int padsize, int framesize)
   must be same for the x86-style assembly language (two-operands).
 */
 
+void
+gen_insn_load_cnst(FILE* out, int reg, int val)
+{
+    fprintf(out, "\tmovl\t$%d, %s\n", val, reg_name[reg]);
+}
+
+/*
+  load local variable
+*/
+void
+gen_insn_load_lvar(FILE* out, int reg, int offset)
+{
+    fprintf(out, "\tmovl\t%s, %s\n", frame_operand(offset), reg_name[reg]);
+}
+
 /*
   store local variable
 */
 void
 gen_insn_store_lvar(FILE* out, int reg, int offset)
 {
-    fprintf(out, "\tmovl\t%s, %d(%%rbp)\n", reg_name[reg], offset);
+    fprintf(out, "\tmovl\t%s, %s\n", reg_name[reg], frame_operand(offset));
+}
+
+/*
+  load the incoming parameter #nump (from 1)
+*/
+void
+gen_insn_load_param(FILE* out, int reg, int nump, int offset)
+{
+    if (nump < 7) {
+        if (strcmp(param_reg_name[nump], reg_name[reg]) != 0) {
+            fprintf(out, "\tmovl\t%s, %s\n", param_reg_name[nump], reg_name[reg]);
+        }
+    } else {
+        gen_insn_load_lvar(out, reg, offset);
+    }
+}
+
+void
+gen_insn_mov(FILE* out, int dst, int src)
+{
+    fprintf(out, "\tmovl\t%s, %s\n", reg_name[src], reg_name[dst]);
 }
 
 void
 gen_insn_neg(FILE* out, int dst, int src)
 {
-    assert(dst == src);
+    if (dst != src) {
+        gen_insn_mov(out, dst, src);
+    }
     fprintf(out, "\tnegl\t%s\n", reg_name[dst]);
 }
 
+/*
+  dst = src1 op src2 for the two-operand form.
+  If dst is src2, a commutative op swaps the sources; sub negates dst
+  then adds src1.
+*/
+static void
+gen_insn_binop(FILE* out, const char *op, int commutative,
+               int dst, int src1, int src2)
+{
+    if (dst != src1 && dst == src2) {
+        if (commutative) {
+            src2 = src1;
+        } else {
+            fprintf(out, "\tnegl\t%s\n", reg_name[dst]);
+            fprintf(out, "\taddl\t%s, %s\n", reg_name[src1], reg_name[dst]);
+            return;
+        }
+    } else if (dst != src1) {
+        gen_insn_mov(out, dst, src1);
+    }
+    fprintf(out, "\t%s\t%s, %s\n", op, reg_name[src2], reg_name[dst]);
+}
+
 void
 gen_insn_add(FILE* out, int dst, int src1, int src2)
 {
-    assert(dst == src1);
-    fprintf(out, "\taddl\t%s, %s\n", reg_name[src2], reg_name[dst]);
+    gen_insn_binop(out, "addl", 1, dst, src1, src2);
 }
 
 void
 gen_insn_sub(FILE* out, int dst, int src1, int src2)
 {
-    assert(dst == src1);
-    fprintf(out, "\tsubl\t%s, %s\n", reg_name[src2], reg_name[dst]);
+    gen_insn_binop(out, "subl", 0, dst, src1, src2);
 }
 
 void
 gen_insn_mul(FILE* out, int dst, int src1, int src2)
 {
-    assert(dst == src1);
-    fprintf(out, "\timull\t%s, %s\n", reg_name[src2], reg_name[dst]);
+    gen_insn_binop(out, "imull", 1, dst, src1, src2);
+}
+
+void
+gen_insn_shr(FILE* out, int dst, int src, int shift)
+{
+    if (dst != src) {
+        gen_insn_mov(out, dst, src);
+    }
+    fprintf(out, "\tshrl\t$%d, %s\n", shift, reg_name[dst]);
 }
 
 void
@@ -439,25 +694,829 @@ gen_insn_cond_set(FILE* out, int dst, int cond)
 {
     switch (cond) {
     case  AST_EXP_LT:
-        fputs("\tsetl\t%al\n", out);
+        fprintf(out, "\tsetl\t%s\n", reg_name8[dst]);
         break;
     case  AST_EXP_GT:
-        fputs("\tsetg\t%al\n", out);
+        fprintf(out, "\tsetg\t%s\n", reg_name8[dst]);
         break;
     case  AST_EXP_LTE:
-        fputs("\tsetle\t%al\n", out);
+        fprintf(out, "\tsetle\t%s\n", reg_name8[dst]);
         break;
     case  AST_EXP_GTE:
-        fputs("\tsetge\t%al\n", out);
+        fprintf(out, "\tsetge\t%s\n", reg_name8[dst]);
         break;
     case  AST_EXP_EQ:
-        fputs("\tsete\t%al\n", out);
+        fprintf(out, "\tsete\t%s\n", reg_name8[dst]);
         break;
     case  AST_EXP_NE:
-        fputs("\tsetne\t%al\n", out);
+        fprintf(out, "\tsetne\t%s\n", reg_name8[dst]);
         break;
     default:
         errexit("Invalid relation instruction.", __FILE__, __LINE__);
     }
-    fprintf(out, "\tmovzbl\t%%al, %s\n", reg_name[dst]);
+    fprintf(out, "\tmovzbl\t%s, %s\n", reg_name8[dst], reg_name[dst]);
+}
+
+/*
+  命令選択の規則 / rules for instruction selection
+
+  即値(imm)と局所変数(mem)をそのまま被演算子にし、変数の読み書きを
+  一度で済む形(rmw)はaddl $1, -4(%rbp)のようにする。出力先がどの
+  被演算子とも違う加算はleaを使い、2, 4, 8倍の加算(index)もleaの
+  添字にする。費用はおおよその命令数
+  Immediates (imm) and local variables (mem) are used as operands as
+  they are, and a read-modify-write of a variable (rmw) becomes a form
+  such as addl $1, -4(%rbp).  An addition whose destination differs
+  from both operands uses lea, which also takes an operand scaled by 2,
+  4 or 8 (index).  Costs are roughly the number of instructions.
+*/
+
+enum { NT_IMM = ISEL_REG+1, NT_MEM, NT_RMW, NT_INDEX };
+
+/* 節の値のオペランド / operand for the value of a node */
+static const char*
+isel_opd(const Isel_Node *n)
+{
+    static char buf[4][32];
+    static int  k;
+
+    k = (k+1)%4;
+    switch (n->nt) {
+    case  NT_IMM:
+        snprintf(buf[k], sizeof(buf[k]), "$%d", n->insn->imm);
+        break;
+    case  NT_MEM:
+        snprintf(buf[k], sizeof(buf[k]), "%s",
+                 frame_operand(n->insn->sym->offset));
+        break;
+    default:
+        snprintf(buf[k], sizeof(buf[k]), "%s", reg_name[n->reg]);
+    }
+    return buf[k];
+}
+
+static int
+isel_is_cond(const Isel_Node *n)
+{
+    return n->insn->cond != 0;
+}
+
+static int
+isel_is_scale(const Isel_Node *n)
+{
+    int c = n->kid[1]->insn->imm;
+
+    return c == 2 || c == 4 || c == 8;
+}
+
+static int
+isel_is_reg_arg(const Isel_Node *n)
+{
+    return n->insn->imm < 7;
+}
+
+/* 格納先と読み書きする変数が同じ / the variable read is the one stored to */
+static int
+isel_same_var(const Isel_Node *n)
+{
+    const Isel_Node *a = n->kid[0];
+    const Isel_Rule *r = &isel_rules[a->rule[NT_RMW]];
+
+    return a->kid[r->kid[0] == NT_MEM ? 0 : 1]->insn->sym == n->insn->sym;
+}
+
+static void
+isel_emit_const(FILE *out, Isel_Node *n)
+{
+    gen_insn_load_cnst(out, n->reg, n->insn->imm);
+}
+
+static void
+isel_emit_load(FILE *out, Isel_Node *n)
+{
+    gen_insn_load_lvar(out, n->reg, n->insn->sym->offset);
+}
+
+static void
+isel_emit_store(FILE *out, Isel_Node *n)
+{
+    fprintf(out, "\tmovl\t%s, %s\n",
+            isel_opd(n->kid[0]), frame_operand(n->insn->sym->offset));
+}
+
+static void
+isel_emit_rmw(FILE *out, Isel_Node *n)
+{
+    Isel_Node *a = n->kid[0];
+
+    fprintf(out, "\t%s\t%s, %s\n", a->insn->op == IR_ADD ? "addl" : "subl",
+            isel_opd(a->kid[a->kid[0]->nt == NT_MEM ? 1 : 0]),
+            frame_operand(n->insn->sym->offset));
+}
+
+static void
+isel_emit_mov(FILE *out, Isel_Node *n)
+{
+    if (n->kid[0]->nt != ISEL_REG || n->kid[0]->reg != n->reg) {
+        fprintf(out, "\tmovl\t%s, %s\n", isel_opd(n->kid[0]), reg_name[n->reg]);
+    }
+}
+
+static void
+isel_emit_neg(FILE *out, Isel_Node *n)
+{
+    gen_insn_neg(out, n->reg, n->kid[0]->reg);
+}
+
+static void
+isel_emit_shr(FILE *out, Isel_Node *n)
+{
+    gen_insn_shr(out, n->reg, n->kid[0]->reg, n->insn->imm);
+}
+
+/* 出力先がaならop b, a、でなければmovしてから / op b, a if a is the destination, or after a mov */
+static void
+isel_emit_binop(FILE *out, const char *op, Isel_Node *n, Isel_Node *a, Isel_Node *b)
+{
+    if (a->reg != n->reg) {
+        gen_insn_mov(out, n->reg, a->reg);
+    }
+    fprintf(out, "\t%s\t%s, %s\n", op, isel_opd(b), reg_name[n->reg]);
+}
+
+static void
+isel_emit_add(FILE *out, Isel_Node *n)
+{
+    Isel_Node *a = n->kid[0], *b = n->kid[1];
+
+    if (a->nt != ISEL_REG || (b->nt == ISEL_REG && b->reg == n->reg)) {
+        a = n->kid[1]; b = n->kid[0];
+    }
+    if (a->reg == n->reg || b->nt == NT_MEM) {
+        isel_emit_binop(out, "addl", n, a, b);
+    } else if (b->nt == NT_IMM) {
+        fprintf(out, "\tleal\t%d(%s), %s\n",
+                b->insn->imm, reg_name64[a->reg], reg_name[n->reg]);
+    } else {
+        fprintf(out, "\tleal\t(%s,%s), %s\n",
+                reg_name64[a->reg], reg_name64[b->reg], reg_name[n->reg]);
+    }
+}
+
+/* a+b*s, b*s+c */
+static void
+isel_emit_lea_index(FILE *out, Isel_Node *n)
+{
+    Isel_Node *a = n->kid[0], *x = n->kid[1];
+
+    if (a->nt == NT_INDEX) {
+        a = n->kid[1]; x = n->kid[0];
+    }
+    if (a->nt == NT_IMM) {
+        fprintf(out, "\tleal\t%d(,%s,%d), %s\n", a->insn->imm,
+                reg_name64[x->kid[0]->reg], x->kid[1]->insn->imm,
+                reg_name[n->reg]);
+    } else {
+        fprintf(out, "\tleal\t(%s,%s,%d), %s\n", reg_name64[a->reg],
+                reg_name64[x->kid[0]->reg], x->kid[1]->insn->imm,
+                reg_name[n->reg]);
+    }
 }
+
+static void
+isel_emit_sub(FILE *out, Isel_Node *n)
+{
+    Isel_Node *a = n->kid[0], *b = n->kid[1];
+
+    if (a->nt == NT_IMM) {
+        /* c-b */
+        if (b->reg == n->reg) {
+            fprintf(out, "\tnegl\t%s\n", reg_name[n->reg]);
+            fprintf(out, "\taddl\t%s, %s\n", isel_opd(a), reg_name[n->reg]);
+        } else {
+            fprintf(out, "\tmovl\t%s, %s\n", isel_opd(a), reg_name[n->reg]);
+            fprintf(out, "\tsubl\t%s, %s\n", reg_name[b->reg], reg_name[n->reg]);
+        }
+    } else if (a->reg == n->reg || b->nt == NT_MEM
+               || (b->nt == NT_IMM && b->insn->imm == INT_MIN)) {
+        isel_emit_binop(out, "subl", n, a, b);
+    } else if (b->nt == NT_IMM) {
+        fprintf(out, "\tleal\t%d(%s), %s\n",
+                -b->insn->imm, reg_name64[a->reg], reg_name[n->reg]);
+    } else {
+        gen_insn_sub(out, n->reg, a->reg, b->reg);
+    }
+}
+
+static void
+isel_emit_mul(FILE *out, Isel_Node *n)
+{
+    Isel_Node *a = n->kid[0], *b = n->kid[1];
+
+    if (a->nt != ISEL_REG || (b->nt == ISEL_REG && b->reg == n->reg)) {
+        a = n->kid[1]; b = n->kid[0];
+    }
+    if (b->nt == NT_IMM) {
+        fprintf(out, "\timull\t%s, %s, %s\n",
+                isel_opd(b), reg_name[a->reg], reg_name[n->reg]);
+    } else {
+        isel_emit_binop(out, "imull", n, a, b);
+    }
+}
+
+/*
+  定数倍の強さの軽減 / strength reduction of multiplication by a constant
+
+  x*cをlea、シフト、減算、符号反転の列にする。列は深さ優先で探し、
+  遅延の表(mul_latency)で和がimullより小さい（同じなら命令数が少ない）
+  ものを選ぶ。出力先が被乗数と同じレジスタなら、最初の命令の後は
+  被乗数を読めない
+  x*c becomes a sequence of lea, shift, sub and neg, found depth first.
+  The one whose total latency by the table (mul_latency) is less than
+  that of imull, or equal with fewer instructions, is chosen.  When the
+  destination is the register of the multiplicand, the multiplicand
+  can't be read after the first instruction.
+*/
+
+#define  MUL_MAX_STEPS  3
+
+enum { MS_LEA, MS_SHL, MS_SUB, MS_NEG, MS_MUL };
+
+/* 遅延（サイクル）/ latency in cycles */
+static const int mul_latency[] = {
+    1,	/* MS_LEA: leal (a,b,s) */
+    1,	/* MS_SHL: sall $k */
+    1,	/* MS_SUB: subl x */
+    1,	/* MS_NEG: negl */
+    3,	/* MS_MUL: imull $c */
+};
+
+/* 列の1命令。a, bは0なら被乗数、1なら途中の値、-1ならなし
+   An instruction of a sequence; a and b are 0 for the multiplicand, 1
+   for the value so far and -1 for none */
+typedef struct {
+    int  kind;
+    int  a, b;
+    int  s;			/* leaの倍率かシフト数 / scale of lea or shift count */
+} Mul_Step;
+
+typedef struct {
+    int  n;
+    int  lat, ninsn;
+    Mul_Step step[MUL_MAX_STEPS];
+} Mul_Plan;
+
+/* 値fからcへの列をcurに続けて探す / search for a sequence from f to c following cur */
+static void
+mul_search(unsigned f, unsigned c, int in_place, Mul_Plan *cur, Mul_Plan *best)
+{
+    static const int scale[] = {1, 2, 4, 8};
+    Mul_Step *p;
+    unsigned v, val[2];
+    int  j, k, lat, ninsn;
+
+    if (f == c) {
+        if (cur->lat < best->lat
+            || (cur->lat == best->lat && cur->ninsn < best->ninsn)) {
+            *best = *cur;
+        }
+        return;
+    }
+    if (cur->n == MUL_MAX_STEPS) {
+        return;
+    }
+    val[0] = 1; val[1] = f;
+    p = &cur->step[cur->n++];
+    for (p->kind = MS_LEA; p->kind < MS_MUL; p->kind++) {
+        lat = cur->lat; ninsn = cur->ninsn;
+        cur->lat += mul_latency[p->kind];
+        cur->ninsn += 1 + (p->kind != MS_LEA && cur->n == 1 && !in_place);
+        if (cur->lat > best->lat
+            || (cur->lat == best->lat && cur->ninsn >= best->ninsn)) {
+            cur->lat = lat; cur->ninsn = ninsn;
+            continue;
+        }
+        /* 基底のないleaは変位が要るので最後に試す
+           lea without a base needs a displacement, so it is tried last */
+        for (j = 0; j < 3; j++) {
+            p->a = (j+1)%3-1;
+            for (p->b = 0; p->b <= 1; p->b++) {
+                for (k = 0; k < 32; k++) {
+                    p->s = k;
+                    switch (p->kind) {
+                    case  MS_LEA:
+                        if (k >= 4 || (p->a < 0 && k == 0)) {
+                            continue;
+                        }
+                        p->s = scale[k];
+                        v = (p->a < 0 ? 0 : val[p->a]) + val[p->b]*p->s;
+                        break;
+                    case  MS_SHL:
+                        if (p->a >= 0 || p->b != 1 || k == 0) {
+                            continue;
+                        }
+                        v = f << k;
+                        break;
+                    case  MS_SUB:
+                        if (p->a != 1 || p->b != 0 || k != 0) {
+                            continue;
+                        }
+                        v = f-1;
+                        break;
+                    default:
+                        if (p->a >= 0 || p->b != 1 || k != 0) {
+                            continue;
+                        }
+                        v = -f;
+                    }
+                    /* 被乗数を上書きした後は読めない / the multiplicand is gone once overwritten */
+                    if (in_place && cur->n > 1 && (p->a == 0 || p->b == 0)) {
+                        continue;
+                    }
+                    mul_search(v, c, in_place, cur, best);
+                }
+            }
+        }
+        cur->lat = lat; cur->ninsn = ninsn;
+    }
+    cur->n--;
+}
+
+/* x*cの列をplanに求め、imullより良いものがあれば1
+   Find the sequence for x*c in plan; 1 if one better than imull */
+static int
+mul_plan(const Isel_Node *n, Mul_Plan *plan)
+{
+    Mul_Plan cur;
+
+    memset(&cur, 0, sizeof(cur));
+    plan->n = 0;
+    plan->lat = mul_latency[MS_MUL];
+    plan->ninsn = 1;
+    mul_search(1, n->kid[1]->insn->imm, n->reg == n->kid[0]->reg, &cur, plan);
+    return plan->n > 0 || plan->lat < mul_latency[MS_MUL];
+}
+
+static int
+isel_mul_cost(const Isel_Node *n)
+{
+    Mul_Plan plan;
+
+    return mul_plan(n, &plan) ? plan.lat : ISEL_INF;
+}
+
+static void
+isel_emit_mul_reduce(FILE *out, Isel_Node *n)
+{
+    Mul_Plan plan;
+    Mul_Step *p;
+    const char *r[2];
+    int  k;
+
+    mul_plan(n, &plan);
+    r[0] = reg_name64[n->kid[0]->reg];
+    if (plan.n == 0 && n->reg != n->kid[0]->reg) {
+        gen_insn_mov(out, n->reg, n->kid[0]->reg);
+    }
+    for (k = 0; k < plan.n; k++) {
+        p = &plan.step[k];
+        r[1] = k == 0 ? r[0] : reg_name64[n->reg];
+        if (p->kind == MS_LEA) {
+            fprintf(out, "\tleal\t%s(%s,%s,%d), %s\n", p->a < 0 ? "0" : "",
+                    p->a < 0 ? "" : r[p->a], r[p->b], p->s, reg_name[n->reg]);
+            continue;
+        }
+        if (k == 0 && n->reg != n->kid[0]->reg) {
+            gen_insn_mov(out, n->reg, n->kid[0]->reg);
+        }
+        switch (p->kind) {
+        case  MS_SHL:
+            fprintf(out, "\tsall\t$%d, %s\n", p->s, reg_name[n->reg]);
+            break;
+        case  MS_SUB:
+            fprintf(out, "\tsubl\t%s, %s\n",
+                    reg_name[n->kid[0]->reg], reg_name[n->reg]);
+            break;
+        default:
+            fprintf(out, "\tnegl\t%s\n", reg_name[n->reg]);
+        }
+    }
+}
+
+static void
+isel_emit_cmp(FILE *out, Isel_Node *n)
+{
+    fprintf(out, "\tcmpl\t%s, %s\n", isel_opd(n->kid[1]), isel_opd(n->kid[0]));
+}
+
+static void
+isel_emit_setcc(FILE *out, Isel_Node *n)
+{
+    isel_emit_cmp(out, n);
+    gen_insn_cond_set(out, n->reg, n->insn->cond);
+}
+
+static void
+isel_emit_arg(FILE *out, Isel_Node *n)
+{
+    if (n->insn->imm < 7) {
+        if (strcmp(isel_opd(n->kid[0]), param_reg_name[n->insn->imm]) != 0) {
+            fprintf(out, "\tmovl\t%s, %s\n",
+                    isel_opd(n->kid[0]), param_reg_name[n->insn->imm]);
+        }
+    } else {
+        fprintf(out, "\tmovl\t%s, %d(%%rsp)\n",
+                isel_opd(n->kid[0]), (n->insn->imm-7)*8);
+    }
+}
+
+static void
+isel_emit_ret(FILE *out, Isel_Node *n)
+{
+    if (n->kid[0]->nt != ISEL_REG || n->kid[0]->reg != 0) {
+        fprintf(out, "\tmovl\t%s, %s\n", isel_opd(n->kid[0]), reg_name[0]);
+    }
+}
+
+#define  R  ISEL_REG
+const Isel_Rule isel_rules[] = {
+    {"const",         R,         IR_CONST, {-1, -1},         1, NULL, isel_emit_const, NULL},
+    {"imm",           NT_IMM,    IR_CONST, {-1, -1},         0, NULL, NULL, NULL},
+    {"load",          R,         IR_LOAD,  {-1, -1},         1, NULL, isel_emit_load, NULL},
+    {"mem",           NT_MEM,    IR_LOAD,  {-1, -1},         0, NULL, NULL, NULL},
+    {"store",         ISEL_STMT, IR_STORE, {R, -1},          1, NULL, isel_emit_store, NULL},
+    {"store-imm",     ISEL_STMT, IR_STORE, {NT_IMM, -1},     1, NULL, isel_emit_store, NULL},
+    {"store-rmw",     ISEL_STMT, IR_STORE, {NT_RMW, -1},     1, isel_same_var, isel_emit_rmw, NULL},
+    {"rmw-add-imm",   NT_RMW,    IR_ADD,   {NT_MEM, NT_IMM}, 0, NULL, NULL, NULL},
+    {"rmw-add",       NT_RMW,    IR_ADD,   {NT_MEM, R},      0, NULL, NULL, NULL},
+    {"rmw-add-rev",   NT_RMW,    IR_ADD,   {R, NT_MEM},      0, NULL, NULL, NULL},
+    {"rmw-sub-imm",   NT_RMW,    IR_SUB,   {NT_MEM, NT_IMM}, 0, NULL, NULL, NULL},
+    {"rmw-sub",       NT_RMW,    IR_SUB,   {NT_MEM, R},      0, NULL, NULL, NULL},
+    {"mov",           R,         IR_MOV,   {R, -1},          1, NULL, isel_emit_mov, NULL},
+    {"mov-imm",       R,         IR_MOV,   {NT_IMM, -1},     1, NULL, isel_emit_mov, NULL},
+    {"mov-mem",       R,         IR_MOV,   {NT_MEM, -1},     1, NULL, isel_emit_mov, NULL},
+    {"neg",           R,         IR_NEG,   {R, -1},          1, NULL, isel_emit_neg, NULL},
+    {"add",           R,         IR_ADD,   {R, R},           1, NULL, isel_emit_add, NULL},
+    {"add-imm",       R,         IR_ADD,   {R, NT_IMM},      1, NULL, isel_emit_add, NULL},
+    {"add-mem",       R,         IR_ADD,   {R, NT_MEM},      1, NULL, isel_emit_add, NULL},
+    {"add-mem-rev",   R,         IR_ADD,   {NT_MEM, R},      1, NULL, isel_emit_add, NULL},
+    {"index",         NT_INDEX,  IR_MUL,   {R, NT_IMM},      0, isel_is_scale, NULL, NULL},
+    {"lea-index",     R,         IR_ADD,   {R, NT_INDEX},    1, NULL, isel_emit_lea_index, NULL},
+    {"lea-index-rev", R,         IR_ADD,   {NT_INDEX, R},    1, NULL, isel_emit_lea_index, NULL},
+    {"lea-index-imm", R,         IR_ADD,   {NT_INDEX, NT_IMM}, 1, NULL, isel_emit_lea_index, NULL},
+    {"sub",           R,         IR_SUB,   {R, R},           1, NULL, isel_emit_sub, NULL},
+    {"sub-imm",       R,         IR_SUB,   {R, NT_IMM},      1, NULL, isel_emit_sub, NULL},
+    {"sub-mem",       R,         IR_SUB,   {R, NT_MEM},      1, NULL, isel_emit_sub, NULL},
+    {"sub-from-imm",  R,         IR_SUB,   {NT_IMM, R},      2, NULL, isel_emit_sub, NULL},
+    {"mul",           R,         IR_MUL,   {R, R},           3, NULL, isel_emit_mul, NULL},
+    {"mul-imm",       R,         IR_MUL,   {R, NT_IMM},      3, NULL, isel_emit_mul, NULL},
+    {"mul-reduce",    R,         IR_MUL,   {R, NT_IMM},      3, NULL, isel_emit_mul_reduce,
+     isel_mul_cost},
+    {"mul-mem",       R,         IR_MUL,   {R, NT_MEM},      3, NULL, isel_emit_mul, NULL},
+    {"mul-mem-rev",   R,         IR_MUL,   {NT_MEM, R},      3, NULL, isel_emit_mul, NULL},
+    {"shr",           R,         IR_SHR,   {R, -1},          1, NULL, isel_emit_shr, NULL},
+    {"setcc",         R,         IR_SETCC, {R, R},           3, NULL, isel_emit_setcc, NULL},
+    {"setcc-imm",     R,         IR_SETCC, {R, NT_IMM},      3, NULL, isel_emit_setcc, NULL},
+    {"setcc-mem",     R,         IR_SETCC, {R, NT_MEM},      3, NULL, isel_emit_setcc, NULL},
+    {"setcc-mem-rev", R,         IR_SETCC, {NT_MEM, R},      3, NULL, isel_emit_setcc, NULL},
+    {"setcc-mem-imm", R,         IR_SETCC, {NT_MEM, NT_IMM}, 3, NULL, isel_emit_setcc, NULL},
+    {"cmp",           ISEL_STMT, IR_BR,    {R, R},           1, isel_is_cond, isel_emit_cmp, NULL},
+    {"cmp-imm",       ISEL_STMT, IR_BR,    {R, NT_IMM},      1, isel_is_cond, isel_emit_cmp, NULL},
+    {"cmp-mem",       ISEL_STMT, IR_BR,    {R, NT_MEM},      1, isel_is_cond, isel_emit_cmp, NULL},
+    {"cmp-mem-rev",   ISEL_STMT, IR_BR,    {NT_MEM, R},      1, isel_is_cond, isel_emit_cmp, NULL},
+    {"cmp-mem-imm",   ISEL_STMT, IR_BR,    {NT_MEM, NT_IMM}, 1, isel_is_cond, isel_emit_cmp, NULL},
+    {"arg",           ISEL_STMT, IR_ARG,   {R, -1},          1, NULL, isel_emit_arg, NULL},
+    {"arg-imm",       ISEL_STMT, IR_ARG,   {NT_IMM, -1},     1, NULL, isel_emit_arg, NULL},
+    {"arg-mem",       ISEL_STMT, IR_ARG,   {NT_MEM, -1},     1, isel_is_reg_arg, isel_emit_arg, NULL},
+    {"ret",           ISEL_STMT, IR_RET,   {R, -1},          1, NULL, isel_emit_ret, NULL},
+    {"ret-imm",       ISEL_STMT, IR_RET,   {NT_IMM, -1},     1, NULL, isel_emit_ret, NULL},
+    {"ret-mem",       ISEL_STMT, IR_RET,   {NT_MEM, -1},     1, NULL, isel_emit_ret, NULL},
+    {NULL}
+};
+#undef  R
+
+/*
+  覗き穴最適化の規則 / rules for the peephole optimizer
+
+  生成するコードはフラグをラベルや分岐を越えて使わない。レジスタの
+  生死は次の分岐までの命令だけを見て（ラベルは素通りする）、分からな
+  ければ生きているとみなす。
+  The generated code never uses the flags across labels or branches.
+  Registers are considered dead only if the instructions up to the next
+  branch tell so (labels are passed through); otherwise they are taken
+  as live.
+*/
+
+/* 同じ行は同じレジスタ / names in a row are the same register */
+static const char peep_regs[][3][8] = {
+    {"%eax", "%rax", "%al"}, {"%ebx", "%rbx", "%bl"},
+    {"%ecx", "%rcx", "%cl"}, {"%edx", "%rdx", "%dl"},
+    {"%esi", "%rsi", "%sil"}, {"%edi", "%rdi", "%dil"},
+    {"%ebp", "%rbp", "%bpl"}, {"%esp", "%rsp", "%spl"},
+    {"%r8d", "%r8", "%r8b"}, {"%r9d", "%r9", "%r9b"},
+    {"%r10d", "%r10", "%r10b"}, {"%r11d", "%r11", "%r11b"},
+    {"%r12d", "%r12", "%r12b"}, {"%r13d", "%r13", "%r13b"},
+    {"%r14d", "%r14", "%r14b"}, {"%r15d", "%r15", "%r15b"},
+};
+#define  PEEP_NUM_REGS  ((int)(sizeof(peep_regs)/sizeof(peep_regs[0])))
+enum { PR_AX, PR_BX, PR_CX, PR_DX, PR_SI, PR_DI, PR_BP, PR_SP,
+       PR_R8, PR_R9, PR_R10, PR_R11, PR_R12 };
+
+/* レジスタそのものならその番号、でなければ-1 / the register number, or -1 */
+static int
+peep_reg(const char *opd)
+{
+    int r, k;
+
+    for (r = 0; r < PEEP_NUM_REGS; r++) {
+        for (k = 0; k < 3; k++) {
+            if (strcmp(opd, peep_regs[r][k]) == 0) {
+                return r;
+            }
+        }
+    }
+    return -1;
+}
+
+/* オペランドがレジスタrを含めば1 / 1 if the operand contains register r */
+static int
+peep_mentions(const char *opd, int r)
+{
+    int k;
+    const char *s;
+    size_t len;
+
+    for (k = 0; k < 3; k++) {
+        len = strlen(peep_regs[r][k]);
+        for (s = strstr(opd, peep_regs[r][k]); s != NULL;
+             s = strstr(s+1, peep_regs[r][k])) {
+            /* %r8は%r8dの一部でもある / %r8 is also part of %r8d */
+            if (!isalnum((unsigned char)s[len])) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* 書き込むだけでデスティネーションを読まない命令 / write the destination without reading it */
+static int
+peep_writes_only(const Peep_Insn *p)
+{
+    return strcmp(p->op, "movl") == 0 || strcmp(p->op, "movq") == 0
+        || strcmp(p->op, "movzbl") == 0 || strcmp(p->op, "leaq") == 0
+        || strcmp(p->op, "leal") == 0
+        || (strcmp(p->op, "xorl") == 0 && strcmp(p->opd[0], p->opd[1]) == 0);
+}
+
+/* w[k]の後でレジスタrが使われなければ1 / 1 if register r is dead after w[k] */
+static int
+peep_reg_dead(Peep_Insn *w, int n, int k, int r)
+{
+    int i;
+    Peep_Insn *p;
+
+    for (k++; k < n; k++) {
+        p = &w[k];
+        if (p->label != NULL) {
+            continue;	/* 合流しても生死は変わらない / joins don't change liveness */
+        }
+        if (!peep_is_insn(p) || p->op[0] == 'j') {
+            return 0;
+        }
+        if (strcmp(p->op, "call") == 0 || strcmp(p->op, "calll") == 0) {
+            /* 引数を読み、呼び出し元退避レジスタを壊す
+               Reads the arguments and clobbers the caller-saved registers */
+            if (r == PR_DI || r == PR_SI || r == PR_DX || r == PR_CX
+                || r == PR_R8 || r == PR_R9) {
+                return 0;
+            }
+            if (r == PR_AX || r == PR_R10 || r == PR_R11) {
+                return 1;
+            }
+            continue;
+        }
+        if (strcmp(p->op, "ret") == 0 || strcmp(p->op, "retq") == 0) {
+            return r != PR_AX && r != PR_BX && r != PR_BP && r != PR_SP
+                && r < PR_R12;
+        }
+        if (strcmp(p->op, "leave") == 0) {
+            if (r == PR_BP || r == PR_SP) {
+                return 0;
+            }
+            continue;
+        }
+        if (p->nopd == 2 && peep_reg(p->opd[1]) == r) {
+            if (peep_mentions(p->opd[0], r) || !peep_writes_only(p)) {
+                return 0;
+            }
+            return 1;
+        }
+        for (i = 0; i < p->nopd; i++) {
+            if (peep_mentions(p->opd[i], r)) {
+                return 0;
+            }
+        }
+        if (p->nopd == 0) {
+            return 0;		/* 分からない / unknown */
+        }
+    }
+    return 0;
+}
+
+/* w[k]の後でフラグが使われなければ1 / 1 if the flags are dead after w[k] */
+static int
+peep_flags_dead(Peep_Insn *w, int n, int k)
+{
+    static const char *writers[] = {"addl", "subl", "imull", "negl", "cmpl",
+                                    "testl", "xorl", "andl", "orl", "shrl",
+                                    "shll", "sarl", "call", "calll", "jmp",
+                                    "ret", "retq", NULL};
+    const char **op;
+    Peep_Insn *p;
+
+    for (k++; k < n; k++) {
+        p = &w[k];
+        if (p->label != NULL) {
+            return 1;
+        }
+        if (!peep_is_insn(p)) {
+            return 0;
+        }
+        for (op = writers; *op != NULL; op++) {
+            if (strcmp(p->op, *op) == 0) {
+                return 1;
+            }
+        }
+        if (p->op[0] == 'j' || strncmp(p->op, "set", 3) == 0
+            || strncmp(p->op, "cmov", 4) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* movl %r, M; movl M, %r2 -> movl %r, M; movl %r, %r2 */
+static int
+peep_store_reload(Peep_Insn *w, int n)
+{
+    int r, r2;
+
+    if (n < 2 || !(peep_is(&w[0], "movl", 2) || peep_is(&w[0], "movq", 2))
+        || !peep_is(&w[1], w[0].op, 2)
+        || (r = peep_reg(w[0].opd[0])) < 0 || peep_reg(w[0].opd[1]) >= 0
+        || strcmp(w[0].opd[1], w[1].opd[0]) != 0
+        || (r2 = peep_reg(w[1].opd[1])) < 0) {
+        return 0;
+    }
+    if (r2 == r) {
+        peep_delete(&w[1]);
+    } else {
+        peep_rewrite(&w[1], w[0].op, 2, w[0].opd[0], w[1].opd[1], NULL);
+    }
+    return 1;
+}
+
+/* N(%rsp)ならN、でなければ-1 / N for N(%rsp), or -1 */
+static int
+peep_sp_offset(const char *opd)
+{
+    char *end;
+    long off;
+
+    off = strtol(opd, &end, 10);
+    return end != opd && strcmp(end, "(%rsp)") == 0 && off >= 0 ? (int)off : -1;
+}
+
+/*
+  movl M, %r; ...; movl %r, M -> movl M, %r; ...
+  続く呼び出しの前後の退避で、読み戻した値をそのまま書き戻す。間にあるのが
+  %rにもMにも触れないmovlだけのときに限る
+  Between consecutive calls, a value reloaded after one call is stored
+  back unchanged before the next.  Only movl touching neither %r nor M
+  may come in between.
+*/
+static int
+peep_reload_store(Peep_Insn *w, int n)
+{
+    int r, k, t, off, o;
+
+    if (!peep_is(&w[0], "movl", 2) || (r = peep_reg(w[0].opd[1])) < 0
+        || (off = peep_sp_offset(w[0].opd[0])) < 0) {
+        return 0;
+    }
+    for (k = 1; k < n && peep_is(&w[k], "movl", 2); k++) {
+        if (strcmp(w[k].opd[0], w[0].opd[1]) == 0
+            && strcmp(w[k].opd[1], w[0].opd[0]) == 0) {
+            peep_delete(&w[k]);
+            return 1;
+        }
+        if ((t = peep_reg(w[k].opd[1])) >= 0) {
+            if (t == r || t == PR_SP) {
+                break;
+            }
+        } else if ((o = peep_sp_offset(w[k].opd[1])) < 0
+                   || (o < off+4 && off < o+4)) {
+            break;
+        }
+    }
+    return 0;
+}
+
+/* 直後のラベルへのjmp / jmp to the label just after */
+static int
+peep_jmp_next(Peep_Insn *w, int n)
+{
+    if (peep_is(&w[0], "jmp", 1) && peep_label_follows(w, n, 0, w[0].opd[0])) {
+        peep_delete(&w[0]);
+        return 1;
+    }
+    return 0;
+}
+
+/* movl %r, %r */
+static int
+peep_self_move(Peep_Insn *w, int n)
+{
+    if ((peep_is(&w[0], "movl", 2) || peep_is(&w[0], "movq", 2))
+        && peep_reg(w[0].opd[0]) >= 0
+        && strcmp(w[0].opd[0], w[0].opd[1]) == 0) {
+        peep_delete(&w[0]);
+        return 1;
+    }
+    return 0;
+}
+
+/* movl %a, %b; movl %b, %a -> movl %a, %b */
+static int
+peep_copy_back(Peep_Insn *w, int n)
+{
+    if (n >= 2 && peep_is(&w[0], "movl", 2) && peep_is(&w[1], "movl", 2)
+        && peep_reg(w[0].opd[0]) >= 0 && peep_reg(w[0].opd[1]) >= 0
+        && strcmp(w[0].opd[0], w[1].opd[1]) == 0
+        && strcmp(w[0].opd[1], w[1].opd[0]) == 0) {
+        peep_delete(&w[1]);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+  movl X, %t; movl %t, D -> movl X, D （%tがその後使われない）
+  gen_insn_ret_asgnや引数の設定の前の転送を省く
+  ... if %t is dead afterwards.  Removes the copies before
+  gen_insn_ret_asgn and the argument setup.
+*/
+static int
+peep_copy_forward(Peep_Insn *w, int n)
+{
+    int t;
+
+    if (n < 2 || !peep_is(&w[0], "movl", 2) || !peep_is(&w[1], "movl", 2)
+        || (t = peep_reg(w[0].opd[1])) < 0 || peep_reg(w[1].opd[0]) != t
+        || peep_reg(w[1].opd[1]) == t || peep_mentions(w[1].opd[1], t)
+        || (peep_reg(w[0].opd[0]) < 0 && w[0].opd[0][0] != '$'
+            && peep_reg(w[1].opd[1]) < 0)	/* メモリ同士は不可 / no memory to memory */
+        || !peep_reg_dead(w, n, 1, t)) {
+        return 0;
+    }
+    peep_rewrite(&w[1], "movl", 2, w[0].opd[0], w[1].opd[1], NULL);
+    peep_delete(&w[0]);
+    return 1;
+}
+
+/* movl $0, %r -> xorl %r, %r */
+static int
+peep_zero_xor(Peep_Insn *w, int n)
+{
+    if (peep_is(&w[0], "movl", 2) && strcmp(w[0].opd[0], "$0") == 0
+        && peep_reg(w[0].opd[1]) >= 0 && peep_flags_dead(w, n, 0)) {
+        peep_rewrite(&w[0], "xorl", 2, w[0].opd[1], w[0].opd[1], NULL);
+        return 1;
+    }
+    return 0;
+}
+
+/* cmpl $0, %r -> testl %r, %r */
+static int
+peep_cmp_test(Peep_Insn *w, int n)
+{
+    if (peep_is(&w[0], "cmpl", 2) && strcmp(w[0].opd[0], "$0") == 0
+        && peep_reg(w[0].opd[1]) >= 0) {
+        peep_rewrite(&w[0], "testl", 2, w[0].opd[1], w[0].opd[1], NULL);
+        return 1;
+    }
+    return 0;
+}
+
+const Peep_Rule peep_rules[] = {
+    {"store-reload", peep_store_reload},
+    {"reload-store", peep_reload_store},
+    {"jmp-next", peep_jmp_next},
+    {"self-move", peep_self_move},
+    {"copy-back", peep_copy_back},
+    {"copy-forward", peep_copy_forward},
+    {"zero-xor", peep_zero_xor},
+    {"cmp-test", peep_cmp_test},
+    {NULL, NULL}
+};
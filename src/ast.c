@@ -65,6 +65,28 @@ append_AST_List(AST_List *l, AST_Node *n)
     return p;
 }
 
+int
+ast_has_call(AST_Node *e)
+{
+    int  k, found;
+    AST_List *l;
+
+    if (e == NULL) {
+        return 0;
+    }
+    if (e->sub_kind == AST_EXP_CALL) {
+        return 1;
+    }
+    for (k = 0; k < AST_NUM_CHILDLEN; k++) {
+        if (ast_has_call(e->child[k])) {
+            return 1;
+        }
+    }
+    found = 0;
+    TRAVERSE_AST_LIST(l, e->list, found |= ast_has_call(l->elem));
+    return found;
+}
+
 const char kind_name[][20] = {
     "kind_none",  /* AST_KIND_NONE */
     "func",       /* AST_KIND_FUNC */
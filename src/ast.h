@@ -110,6 +110,9 @@ extern AST_Node *create_AST_Stm(int sub_kind, int line);
  */
 extern AST_List *append_AST_List(AST_List *l, AST_Node *n);
 
+/* 式eが関数呼び出しを含めば1 / 1 if expression e contains a function call */
+extern int  ast_has_call(AST_Node *e);
+
 extern void dump_ast();
 
 #endif	/* AST_H */
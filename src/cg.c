@@ -15,6 +15,12 @@
 #include  "ast.h"
 #include  "arch_common.h"
 #include  "cg.h"
+#include  "ir.h"
+#include  "isel.h"
+#include  "opt.h"
+#include  "option.h"
+#include  "peephole.h"
+#include  "regalloc.h"
 #include  "symtab.h"
 #include  "util.h"
 
@@ -61,21 +67,102 @@
 
 #define  MAX_REG_NUM 3
 
+static char *used_ast_funcs(void);
+static void mark_ast_calls(AST_Node *e, char *used);
+static int  is_root_func(const char *name, int has_main);
 static void traverse_ast_func(AST_Node *f, int pass);
 static void traverse_ast_stm(AST_Node *s, int pass);
 static void traverse_ast_exp(AST_Node *e, int pass);
 static int  ranking_ast_exp(AST_Node *e);
 static void assign_ast_exp(AST_Node *e);
-static void assign_ast_call(AST_Node *e);
+static void assign_ast_call(AST_Node *e, int regs[], int nested);
 static void assign_ast_exp_body(AST_Node *e, int regs[]);
 
+/*
+ * 後でremove_unused_funcsが外す関数には割り付けない
+ * Functions that remove_unused_funcs takes out later are not assigned
+ */
 void
 assign_regs(void)
 {
+    int  k;
+    char *used;
+    AST_List *l;
+
+    used = used_ast_funcs();
+    k = 0;
+    TRAVERSE_AST_LIST(l, AST_root, if (used[k++]) traverse_ast_func(l->elem, 1));
+    k = 0;
+    TRAVERSE_AST_LIST(l, AST_root, if (used[k++]) traverse_ast_func(l->elem, 2));
+    free(used);
+}
+
+/*
+ * AST_rootの並び順に、mainと-fexportの関数から呼び出しをたどれるものに
+ * 1を付けた表を返す。規則はremove_unused_funcsと同じ
+ * Return a table in the order of AST_root that has 1 for the functions
+ * reachable through calls from main and the -fexport functions, by the
+ * same rule as remove_unused_funcs.
+ */
+char*
+used_ast_funcs(void)
+{
+    int  n, k, has_main, changed;
+    char *used, *done;
+    AST_List *l;
+
+    n = 0;
+    has_main = 0;
+    TRAVERSE_AST_LIST(l, AST_root, {
+        has_main |= strcmp(l->elem->child[0]->str, "main") == 0;
+        n++;
+    });
+    used = xcalloc(n+1, 1);
+    done = xcalloc(n+1, 1);
+    k = 0;
+    TRAVERSE_AST_LIST(l, AST_root, {
+        used[k] = flag_keep_unused || is_root_func(l->elem->child[0]->str, has_main);
+        k++;
+    });
+    do {
+        changed = 0;
+        k = 0;
+        TRAVERSE_AST_LIST(l, AST_root, {
+            if (used[k] && !done[k]) {
+                done[k] = 1;
+                changed = 1;
+                mark_ast_calls(l->elem->child[1], used);
+            }
+            k++;
+        });
+    } while (changed);
+    free(done);
+    return used;
+}
+
+/* eの中で呼ばれる関数に印を付ける / mark the functions called in e */
+void
+mark_ast_calls(AST_Node *e, char *used)
+{
+    int  k;
     AST_List *l;
 
-    TRAVERSE_AST_LIST(l, AST_root, traverse_ast_func(l->elem, 1));
-    TRAVERSE_AST_LIST(l, AST_root, traverse_ast_func(l->elem, 2));
+    if (e == NULL) {
+        return;
+    }
+    if (e->sub_kind == AST_EXP_CALL) {
+        k = 0;
+        TRAVERSE_AST_LIST(l, AST_root, {
+            if (strcmp(l->elem->child[0]->str, e->child[0]->str) == 0) {
+                used[k] = 1;
+            }
+            k++;
+        });
+    }
+    for (k = 0; k < AST_NUM_CHILDLEN; k++) {
+        mark_ast_calls(e->child[k], used);
+    }
+    TRAVERSE_AST_LIST(l, e->list, mark_ast_calls(l->elem, used));
 }
 
 void
@@ -176,26 +263,41 @@ ranking_ast_exp(AST_Node *e)
 void
 assign_ast_exp(AST_Node *e)
 {
-    if (e->sub_kind == AST_EXP_CALL) {
-        assign_ast_call(e);
-    } else {
-        int regs[MAX_REG_NUM];	/* 利用可能レジスタのフラグ / flags for available registers */
-        memset(regs, 0, sizeof(regs));
-        assign_ast_exp_body(e, regs);
-    }
+    int regs[MAX_REG_NUM];	/* 利用可能レジスタのフラグ / flags for available registers */
+
+    memset(regs, 0, sizeof(regs));
+    assign_ast_exp_body(e, regs);
 }
 
 /*
- * 関数呼び出し前にREGISTERをスタックに保存するのでレジスタ使用状況はリセット
- * Flags for available registers are reset before function call
- * since they are all stored in the stack.
+ * 呼び出しを含む実引数は呼び出し列の前に評価してすぐ一時変数に格納する
+ * (ir_build.c)。評価中は周りの式のレジスタを避け、格納後は解放する。
+ * それ以外の実引数は関数呼び出し前にREGISTERをスタックに保存するので
+ * レジスタ使用状況はリセット
+ * Arguments containing calls are evaluated before the call sequence
+ * and stored into temporaries right away (ir_build.c); they avoid
+ * the registers of the surrounding expression and release theirs
+ * after the store. For the other arguments flags for available
+ * registers are reset since they are all stored in the stack
+ * before the function call.
  */
 void
-assign_ast_call(AST_Node *e)
+assign_ast_call(AST_Node *e, int regs[], int nested)
 {
     AST_List *l;
     /* 引き数列の処理 / process parameters */
-    TRAVERSE_AST_LIST(l, e->list, assign_ast_exp(l->elem));
+    TRAVERSE_AST_LIST(l, e->list, {
+        if (ast_has_call(l->elem) == nested) {
+            if (nested) {
+                assign_ast_exp_body(l->elem, regs);
+                if (l->elem->reg >= 0) {
+                    regs[l->elem->reg] = 0;
+                }
+            } else {
+                assign_ast_exp(l->elem);
+            }
+        }
+    });
 }
 
 void
@@ -225,10 +327,13 @@ assign_ast_exp_body(AST_Node *e, int regs[])
 	if (e->child[0] != NULL) {
             e->reg = e->child[0]->reg;
 	}
-	if (e->child[1] != NULL) {
+	if (e->child[1] != NULL && e->child[1]->reg >= 0) {
             regs[e->child[1]->reg] = 0;
 	}
     } else {
+        if (e->sub_kind == AST_EXP_CALL) {
+            assign_ast_call(e, regs, 1);
+        }
         for (i = 0; i < MAX_REG_NUM; i++) {
             if (regs[i] == 0) {
                 e->reg = i;
@@ -237,49 +342,55 @@ assign_ast_exp_body(AST_Node *e, int regs[])
             }
 	}
 	if (i == MAX_REG_NUM) {
-            fputs("Number of registers is not sufficient.\n", stderr);
-            abort();
+            /* 足りなければIRの上で割り付け直す (regalloc.c)
+               Reallocated on the IR if they run out (regalloc.c) */
+            e->reg = -1;
+        }
+        if (e->sub_kind == AST_EXP_CALL) {
+            assign_ast_call(e, regs, 0);
         }
     }
 }
 
 /*
  * コード生成系
+ * IRの命令をアーキテクチャ依存部の関数に対応付ける
  * Code generation
+ * IR instructions are mapped onto the functions of
+ * the architecture dependent part.
  */
 
-static void init_label(void);
-static void make_func_last_label(AST_Node *f);
-static int  get_label(void);
+/* 入れ子になった関数呼び出し列の情報 / state of nested call sequences */
+typedef struct CallFrame {
+    int  sparams;		/* スタックで渡す引数の数 / params in the stack */
+    int  psize;
+    int  fsize;
+} CallFrame;
+
+static void make_func_last_label(IR_Func *f);
 static char *gen_label(int label);
+static const char *block_label(IR_Block *b);
 static void gen_label_stm(FILE *out, int label);
 static void gen_header(FILE *out);
-static void gen_func(FILE *out, AST_Node *f);
+static void remove_unused_funcs(void);
+static void set_labels(IR_Func *f);
+static void gen_func(FILE *out, IR_Func *f);
+static void gen_func_body(FILE *out, IR_Func *f);
+static void trim_saves(IR_Func *f);
+static int  func_call_area(IR_Func *f);
+static int  func_frame_mode(IR_Func *f);
 static void gen_put_int(FILE *out);
-static void gen_stm(FILE *out, AST_Node *s);
-static void gen_stm_asign(FILE *out, AST_Node *s);
-static void gen_stm_rel(FILE *out, AST_Node *e, int l_cmp);
-static void gen_stm_if(FILE *out, AST_Node *s);
-static void gen_stm_while(FILE *out, AST_Node *s);
-static void gen_stm_for(FILE *out, AST_Node *s);
-static void gen_stm_dowhile(FILE *out, AST_Node *s);
-static void gen_stm_return(FILE *out, AST_Node *s);
-static void gen_exp(FILE *out, AST_Node *e);
-static void gen_exp_asgn(FILE *out, AST_Node *e);
-static void gen_exp_rel(FILE *out, AST_Node *rel);
-extern void gen_exp_call(FILE *out, AST_Node *e);
-extern void gen_exp_call_param(FILE *out, AST_Node *p, int nump, int sparams);
-static void gen_exp_n2(FILE *out, AST_Node *e);
-
-static int local_label;		/* 関数内ラベルの番号 / label number in a func */
-static char *func_end_label;	/* 関数末尾のラベル / End-label for a func */
+static void gen_insn(FILE *out, IR_Func *f, IR_Insn *i);
+static void gen_insn_call_begin(FILE *out, IR_Func *f, IR_Insn *i);
+static void gen_insn_call(FILE *out, IR_Func *f, IR_Insn *i);
+static void gen_insn_br(FILE *out, IR_Func *f, IR_Insn *i);
 
+static char *func_end_label;	/* 関数末尾のラベル / End-label for a func */
+static CallFrame *call_stack;
+static int call_depth, call_stack_size;
+static int calls_in_frame;	/* 呼び出し列の領域をフレームに確保した / call area is in the frame */
 
-void
-init_label(void)
-{
-    local_label = 0;
-}
+#define  PHYS(f, v)  ((f)->phys[(v)])
 
 /*
  * 関数末尾のラベル
@@ -288,33 +399,33 @@ init_label(void)
  * ex) The label for func1() is END_func1
  */
 void
-make_func_last_label(AST_Node *f)
+make_func_last_label(IR_Func *f)
 {
-    char *name;
     int len;
 
-    assert(f->child[0]->sub_kind == AST_EXP_IDENT);
-    name = f->child[0]->str;
-    len = strlen(name)+6;
+    len = strlen(f->name)+6;
     func_end_label = xmalloc(len);
-    snprintf(func_end_label, len, "_END_%s", name);
-}
-
-int
-get_label(void)
-{
-    return local_label++;
+    snprintf(func_end_label, len, "_END_%s", f->name);
 }
 
 char*
 gen_label(int label)
 {
-    static char buf[10];
+    static char buf[16];
 
     snprintf(buf, sizeof(buf), ".L%d", label);
     return buf;
 }
 
+const char*
+block_label(IR_Block *b)
+{
+    if (b->label < 0) {
+        errexit("Jump to a block without label.", __FILE__, __LINE__);
+    }
+    return gen_label(b->label);
+}
+
 void
 gen_label_stm(FILE *out, int label)
 {
@@ -324,11 +435,24 @@ gen_label_stm(FILE *out, int label)
 void
 gen_code(FILE *out)
 {
-    AST_List *l;
-    
+    IR_Func *f;
+
+    build_ir();
+    if (!flag_keep_unused) {
+        remove_unused_funcs();
+    }
+    optimize();
+    if (!flag_keep_unused) {
+        remove_unused_funcs();	/* 展開で呼ばれなくなったもの / left uncalled by inlining */
+    }
     gen_header(out);
-    init_label();
-    TRAVERSE_AST_LIST(l, AST_root, gen_func(out, l->elem));
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        regalloc(f);
+        if (flag_dump_ir) {
+            dump_ir(f);
+        }
+        gen_func(out, f);
+    }
     gen_put_int(out);
 }
 
@@ -338,212 +462,354 @@ gen_header(FILE *out)
     fprintf(out, "%s", SECTION_TEXT);
 }
 
+/*
+ * mainと-fexportで指定した関数から呼び出しをたどれない関数をIR_funcsから
+ * 外し、レジスタ割り付けもコード生成もしない。mainがなく-fexportもなければ
+ * （ライブラリとして翻訳するとき）すべての関数を残す
+ * Take the functions not reachable through calls from main and the
+ * functions given by -fexport out of IR_funcs, so that they are neither
+ * register-allocated nor generated.  Without main or -fexport (when
+ * compiling a library), all functions are kept.
+ */
 void
-gen_func(FILE *out, AST_Node *f)
+remove_unused_funcs(void)
 {
-    AST_List *l;
+    int  n, k, has_main;
+    IR_Func *f, *g, **work, **p;
+    IR_Block *b;
+    IR_Insn *i;
+
+    n = 0;
+    has_main = 0;
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        f->reachable = 0;
+        has_main |= strcmp(f->name, "main") == 0;
+        n++;
+    }
+    work = xmalloc((n+1)*sizeof(IR_Func*));
+    k = 0;
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        if (is_root_func(f->name, has_main)) {
+            f->reachable = 1;
+            work[k++] = f;
+        }
+    }
+    while (k > 0) {
+        f = work[--k];
+        FOR_EACH_BLOCK(b, f) {
+            FOR_EACH_INSN(i, b) {
+                if ((i->op == IR_CALL || i->op == IR_TAILCALL)
+                    && (g = ir_find_func(i->name)) != NULL && !g->reachable) {
+                    g->reachable = 1;
+                    work[k++] = g;
+                }
+            }
+        }
+    }
+    free(work);
 
-    assert(f->child[0]->sub_kind == AST_EXP_IDENT);
-    make_func_last_label(f);
-    gen_func_header(out, f->child[0]->str, get_frame_size(f->id), f->list);
-    TRAVERSE_AST_LIST(l, f->child[1]->list, gen_stm(out, l->elem));
-    gen_func_footer(out, func_end_label);
-    free(func_end_label);
-    func_end_label = NULL;
+    for (p = &IR_funcs; *p != NULL; ) {
+        if ((*p)->reachable) {
+            p = &(*p)->next;
+        } else {
+            *p = (*p)->next;
+        }
+    }
 }
 
-void
-gen_put_int(FILE *out)
+int
+is_root_func(const char *name, int has_main)
 {
-    fprintf(out, "%s", PUTINT_CODE);
-}
+    int  k;
 
-void
-gen_stm(FILE *out, AST_Node *s)
-{
-    AST_List *l;
-    
-    if (s == NULL) {
-        return;
+    if (!has_main && nexports == 0) {
+        return 1;
     }
-    switch (s->sub_kind) {
-    case  AST_STM_LIST:
-        TRAVERSE_AST_LIST(l, s->list, gen_stm(out, l->elem));
-        break;
-    case  AST_STM_DEC:
-        /* Nothing to do */
-        break;
-    case  AST_STM_ASIGN:
-        gen_stm_asign(out, s);
-        break;
-    case  AST_STM_IF:
-        gen_stm_if(out, s);
-        break;
-    case  AST_STM_WHILE:
-        gen_stm_while(out, s);
-        break;
-    case  AST_STM_FOR:
-        gen_stm_for(out, s);
-        break;
-    case  AST_STM_DOWHILE:
-        gen_stm_dowhile(out, s);
-        break;
-    case  AST_STM_RETURN:
-        gen_stm_return(out, s);
-        break;
-    default:
-        errexit("Invalid statement kind", __FILE__, __LINE__);
+    for (k = 0; k < nexports; k++) {
+        if (strcmp(name, exports[k]) == 0) {
+            return 1;
+        }
     }
-}
-
-void
-gen_stm_asign(FILE *out, AST_Node *s)
-{
-    gen_exp(out, s->child[0]);
+    return strcmp(name, "main") == 0;
 }
 
 /*
- * if文やwhile文等の条件式のための適切な条件分岐コードを生成する
- * eは条件式
- * l_cmpは条件が偽だった場合の飛び先ラベル
- * Generate appropriate code for if-statement and while-statement.
- * e is condition expression.
- * l_cmp is the target label for the false condition.
+ * 直後に配置されていない分岐先にはラベルを付ける
+ * Give labels to the branch targets not placed just after the branch
  */
 void
-gen_stm_rel(FILE *out, AST_Node *e, int l_cmp)
+set_labels(IR_Func *f)
 {
-    gen_insn_rel(out, e->sub_kind, gen_label(l_cmp), e->reg);
+    IR_Block *b;
+    IR_Insn *t;
+
+    FOR_EACH_BLOCK(b, f) {
+        if ((t = ir_terminator(b)) == NULL) {
+            continue;
+        }
+        if ((t->op == IR_JMP || t->op == IR_BR)
+            && t->target[0] != b->next && t->target[0] != f->exit
+            && t->target[0]->label < 0) {
+            t->target[0]->label = ir_new_label();
+        }
+        if (t->op == IR_BR && t->target[1]->label < 0) {
+            t->target[1]->label = ir_new_label();
+        }
+    }
 }
 
+/* -O1以上では関数の出力を溜めて覗き穴最適化にかける
+   At -O1 and above the output of a function is buffered and passed
+   through the peephole optimizer */
 void
-gen_stm_if(FILE *out, AST_Node *s)
+gen_func(FILE *out, IR_Func *f)
 {
-    int  l_else = -1, l_end, l_cmp;
+    char *text;
+    size_t len;
+    FILE *buf;
 
-    l_cmp = l_end = get_label();
-    if (s->child[2] != NULL) { /* else */
-        l_cmp = l_else = get_label();
+    if (opt_level == 0 || !flag_peephole) {
+        gen_func_body(out, f);
+        return;
     }
-
-    gen_exp(out, s->child[0]);
-    gen_stm_rel(out, s->child[0], l_cmp);
-    gen_stm(out, s->child[1]);
-    if (s->child[2] != NULL) {
-        gen_insn_jmp(out, gen_label(l_end));
-        gen_label_stm(out, l_else);
-        gen_stm(out, s->child[2]);
+    if ((buf = open_memstream(&text, &len)) == NULL) {
+        perror("open_memstream");
+        exit(-1);
     }
-    gen_label_stm(out, l_end);
+    gen_func_body(buf, f);
+    fclose(buf);
+    peephole(out, text, f);
+    free(text);
 }
 
 void
-gen_stm_while(FILE *out, AST_Node *s)
+gen_func_body(FILE *out, IR_Func *f)
 {
-    int  l_begin, l_exit;
-
-    l_begin = get_label();
-    l_exit = get_label();
-    gen_label_stm(out, l_begin);
-    gen_exp(out, s->child[0]);
-    gen_stm_rel(out, s->child[0], l_exit);
-    gen_stm(out, s->child[1]);
-    gen_insn_jmp(out, gen_label(l_begin));
-    gen_label_stm(out, l_exit);
-}
+    IR_Block *b;
+    IR_Insn *i;
 
-void
-gen_stm_for(FILE *out, AST_Node *s)
-{
-    int  l_begin, l_exit;
-
-    l_begin = get_label();
-    l_exit = get_label();
-    gen_exp(out, s->child[0]);
-    gen_label_stm(out, l_begin);
-    gen_exp(out, s->child[1]);
-    gen_stm_rel(out, s->child[1], l_exit);
-    gen_stm(out, s->child[3]);
-    gen_exp(out, s->child[2]);
-    gen_insn_jmp(out, gen_label(l_begin));
-    gen_label_stm(out, l_exit);
+    make_func_last_label(f);
+    set_labels(f);
+    isel_select(f);
+    trim_saves(f);
+    /* -O0では従来どおり呼び出しごとに%rspを動かす
+       At -O0 the stack pointer is still moved for each call */
+    calls_in_frame = opt_level > 0;
+    gen_func_header(out, f->name, get_frame_size(f->id),
+                    f->params, f->nparams, f->callee_saved,
+                    calls_in_frame ? func_call_area(f) : 0,
+                    func_frame_mode(f));
+    FOR_EACH_BLOCK(b, f) {
+        if (b == f->exit) {
+            continue;
+        }
+        if (b->label >= 0) {
+            gen_label_stm(out, b->label);
+        }
+        FOR_EACH_INSN(i, b) {
+            gen_insn(out, f, i);
+        }
+    }
+    gen_func_footer(out, func_end_label);
+    isel_end(f);
+    free(func_end_label);
+    func_end_label = NULL;
 }
 
+/*
+  命令選択の後で実際にレジスタに書かれる値だけを退避する。即値として
+  取り込んだ定数などはレジスタに置かれないので、同じレジスタを他の値が
+  使っていても呼び出しの前後で退避しない。-O0では従来どおり
+  Save only the values still put in a register after instruction
+  selection.  Constants taken in as immediates and the like never live
+  in their register, so they are not saved around calls even when
+  another value shares that register.  At -O0 the saves are left as
+  they are.
+*/
 void
-gen_stm_dowhile(FILE *out, AST_Node *s)
+trim_saves(IR_Func *f)
 {
-    /* REPORT3
-       ここにdo-while文のコード生成処理を追加する
-       Add code-generation code for do-while
-    */
-
-    int  l_begin, l_exit;
-
-    l_begin = get_label();
-    l_exit = get_label();
-    gen_label_stm(out, l_begin);
-    gen_stm(out, s->child[0]);
-    gen_exp(out, s->child[1]);
-    gen_stm_rel(out, s->child[1], l_exit);
-    gen_insn_jmp(out, gen_label(l_begin));
-    gen_label_stm(out, l_exit);
+    unsigned int used;
+    char *written;
+    IR_Block *b;
+    IR_Insn *i;
+
+    if (opt_level == 0) {
+        return;
+    }
+    used = 0;
+    written = xcalloc(f->nvregs+1, 1);
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->dst != 0 && isel_writes(i)) {
+                written[i->dst] = 1;
+                if (PHYS(f, i->dst) >= 0) {
+                    used |= 1u << PHYS(f, i->dst);
+                }
+            }
+        }
+    }
+    f->callee_saved &= used;
+    set_call_saves(f, written);
+    free(written);
 }
 
-void
-gen_stm_return(FILE *out, AST_Node *s)
+/*
+  呼び出し列が使う領域の最大値。関数の入口で一度だけ確保し、
+  各呼び出しでスタックポインタを動かさずに済ませる
+  The largest area used by a call sequence.  It is reserved once at
+  the function entry so that no call has to move the stack pointer.
+*/
+int
+func_call_area(IR_Func *f)
 {
-    gen_exp(out, s->child[0]);
-    gen_insn_ret_asgn(out, s->reg);
-    gen_insn_jmp(out, func_end_label);
+    int  n, area;
+    IR_Block *b;
+    IR_Insn *i;
+
+    area = 0;
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->op == IR_CALL
+                && (n = gen_call_area(i->imm, i->save)) > area) {
+                area = n;
+            }
+        }
+    }
+    return area;
 }
 
-void
-gen_exp(FILE *out, AST_Node *e)
+/*
+  フレームの形。他の関数を呼ばない末端関数は-O1から、
+  それ以外は-O2からフレームポインタを省略する
+  The kind of frame.  The frame pointer is omitted for leaf functions,
+  which call no other function, from -O1 and for the others from -O2.
+*/
+int
+func_frame_mode(IR_Func *f)
 {
-    if (e == NULL) {
-        return;
+    int  leaf;
+    IR_Block *b;
+    IR_Insn *i;
+
+    leaf = 1;
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->op == IR_CALL || i->op == IR_TAILCALL) {
+                leaf = 0;
+            }
+        }
     }
-    if (e->sub_kind == AST_EXP_ASGN) {
-        gen_exp_asgn(out, e);
-    } else if (e->sub_kind == AST_EXP_IDENT) {
-        gen_exp_ident(out, e);
-    } else if (e->sub_kind == AST_EXP_CNST_INT) {
-        gen_exp_cnst(out, e);
-    } else if (e->sub_kind == AST_EXP_CALL) {
-        gen_exp_call(out, e);
-    } else {
-        gen_exp_n2(out, e);
+    if (flag_omit_frame_pointer > 0
+        || (flag_omit_frame_pointer < 0 && opt_level >= 2)) {
+        return leaf ? FRAME_LEAF : FRAME_OMIT;
+    }
+    if (flag_omit_frame_pointer < 0 && opt_level >= 1 && leaf) {
+        return FRAME_LEAF;
     }
+    return FRAME_KEEP;
 }
 
 void
-gen_exp_asgn(FILE *out, AST_Node *e)
+gen_put_int(FILE *out)
 {
-    gen_exp(out, e->child[1]);
-    if (e->child[0]->sub_kind != AST_EXP_IDENT) {
-        errexit("Invalid destination operand for assign.", __FILE__, __LINE__);
-    }
-    gen_insn_store_lvar(out, e->child[1]->reg, e->child[0]->symtab->offset);
+    fprintf(out, "%s", PUTINT_CODE);
 }
 
 void
-gen_exp_rel(FILE *out, AST_Node *e)
+gen_insn(FILE *out, IR_Func *f, IR_Insn *i)
 {
-    gen_insn_cmp(out, e->child[0]->reg, e->child[1]->reg);
-    if (e->parent->kind == AST_KIND_STM
-        /* REPORT3
-           このあたりも修正が必要？
-           It seems to add some modification.
-        */
-        && (e->parent->sub_kind == AST_STM_IF
-            || e->parent->sub_kind == AST_STM_WHILE
-            || e->parent->sub_kind == AST_STM_FOR
-            ||e->parent->sub_kind == AST_STM_DOWHILE)) {
-        /* The parent statement generates a branch operation. */
-    } else {
-        /* AST_EXP_LT, AST_EXP_GT, AST_EXP_LTE,
-           AST_EXP_GTE, AST_EXP_EQ, or AST_EXP_NE */
-        gen_insn_cond_set(out, e->reg, e->sub_kind);
+    /* 命令選択で出力できたもの。IR_BR, IR_RET, IR_ARGは一部だけなので下で
+       Emitted by the instruction selector; IR_BR, IR_RET and IR_ARG are
+       only partly covered and handled below */
+    if (i->op != IR_BR && i->op != IR_RET && i->op != IR_ARG
+        && isel_gen(out, i, 0)) {
+        return;
+    }
+    switch (i->op) {
+    case  IR_NOP:
+        break;
+    case  IR_CONST:
+        gen_insn_load_cnst(out, PHYS(f, i->dst), i->imm);
+        break;
+    case  IR_LOAD:
+        gen_insn_load_lvar(out, PHYS(f, i->dst), i->sym->offset);
+        break;
+    case  IR_STORE:
+        gen_insn_store_lvar(out, PHYS(f, i->src[0]), i->sym->offset);
+        break;
+    case  IR_MOV:
+        if (PHYS(f, i->dst) != PHYS(f, i->src[0])) {
+            gen_insn_mov(out, PHYS(f, i->dst), PHYS(f, i->src[0]));
+        }
+        break;
+    case  IR_NEG:
+        gen_insn_neg(out, PHYS(f, i->dst), PHYS(f, i->src[0]));
+        break;
+    case  IR_ADD:
+        gen_insn_add(out, PHYS(f, i->dst),
+                     PHYS(f, i->src[0]), PHYS(f, i->src[1]));
+        break;
+    case  IR_SUB:
+        gen_insn_sub(out, PHYS(f, i->dst),
+                     PHYS(f, i->src[0]), PHYS(f, i->src[1]));
+        break;
+    case  IR_MUL:
+        gen_insn_mul(out, PHYS(f, i->dst),
+                     PHYS(f, i->src[0]), PHYS(f, i->src[1]));
+        break;
+    case  IR_DIV:
+        /* "div" is not supported now because of its register restriction. */
+        fputs("Sorry, div is not suppoted.\n", stderr);
+        exit(-1);
+        break;
+    case  IR_SHR:
+        gen_insn_shr(out, PHYS(f, i->dst), PHYS(f, i->src[0]), i->imm);
+        break;
+    case  IR_SETCC:
+        gen_insn_cmp(out, PHYS(f, i->src[0]), PHYS(f, i->src[1]));
+        gen_insn_cond_set(out, PHYS(f, i->dst), i->cond);
+        break;
+    case  IR_PARAM:
+        gen_insn_load_param(out, PHYS(f, i->dst), i->imm, i->sym->offset);
+        break;
+    case  IR_CALL_BEGIN:
+        gen_insn_call_begin(out, f, i);
+        break;
+    case  IR_ARG:
+        if (!isel_gen(out, i, call_stack[call_depth-1].sparams)) {
+            gen_call_set_param(out, PHYS(f, i->src[0]), i->imm,
+                               call_stack[call_depth-1].sparams);
+        }
+        break;
+    case  IR_CALL:
+        gen_insn_call(out, f, i);
+        break;
+    case  IR_TAILCALL:
+        assert(call_depth > 0);
+        call_depth--;
+        gen_tail_call(out, i->name);
+        break;
+    case  IR_JMP:
+        /* 出口へは関数末尾のラベルに飛ぶ / the exit is the end-label */
+        if (i->target[0] == f->exit && i->block->next != f->exit) {
+            gen_insn_jmp(out, func_end_label);
+        } else if (i->target[0] != i->block->next) {
+            gen_insn_jmp(out, block_label(i->target[0]));
+        }
+        break;
+    case  IR_BR:
+        gen_insn_br(out, f, i);
+        break;
+    case  IR_RET:
+        if (i->src[0] != 0 && !isel_gen(out, i, 0)) {
+            gen_insn_ret_asgn(out, PHYS(f, i->src[0]));
+        }
+        gen_insn_jmp(out, func_end_label);
+        break;
+    default:
+        fprintf(stderr, "Unsupported IR instruction %s\n", ir_op_name(i->op));
+        abort();
     }
 }
 
@@ -551,7 +817,7 @@ gen_exp_rel(FILE *out, AST_Node *e)
    関数呼び出し手順：
    - スタックポインタの移動
    - 必要なレジスタの退避
-   - 実引数の評価・スタックに格納
+   - 実引数の評価・スタックに格納 (IR_ARG)
    - call
    - 戻り値をノードに割り当てられたレジスタに移動
    - スタックポインタを戻す
@@ -559,90 +825,78 @@ gen_exp_rel(FILE *out, AST_Node *e)
    Steps for function call
    - adjust the stack-pointer
    - save registers if needed
-   - evaluate actual parameters and save them into the stack
+   - evaluate actual parameters and save them into the stack (IR_ARG)
    - call
    - copy the return value to the assigned register
 */
 void
-gen_exp_call(FILE *out, AST_Node *e)
+gen_insn_call_begin(FILE *out, IR_Func *f, IR_Insn *i)
 {
-    int i;
-    int sparams, psize, fsize;
-    AST_List *l;
-    
-    sparams = gen_call_prologue(out, e, &psize, &fsize);
-    i = 0;
-    TRAVERSE_AST_LIST(l, e->list,
-                      gen_exp_call_param(out, l->elem, ++i, sparams));
-    assert(e->child[0]->sub_kind == AST_EXP_IDENT);
-    gen_call_epilogue(out, e, psize, fsize);
+    int depth, reg;
+    IR_Insn *c;
+
+    /* 対応するIR_CALLを探す / find the corresponding IR_CALL */
+    depth = 0;
+    for (c = i->next; c != NULL; c = c->next) {
+        if (c->op == IR_CALL_BEGIN) {
+            depth++;
+        } else if ((c->op == IR_CALL || c->op == IR_TAILCALL) && depth-- == 0) {
+            break;
+        }
+    }
+    if (c == NULL) {
+        errexit("Unterminated call sequence.", __FILE__, __LINE__);
+    }
+    reg = c->dst != 0 ? PHYS(f, c->dst) : 0;
+    if (call_depth == call_stack_size) {
+        call_stack_size += 4;
+        call_stack = xrealloc(call_stack, call_stack_size*sizeof(CallFrame));
+    }
+    if (c->op == IR_TAILCALL) {
+        /* 引数はすべてレジスタで渡し、戻ってこない
+           All arguments are in registers and the call never returns */
+        call_stack[call_depth].sparams = 0;
+        call_depth++;
+        return;
+    }
+    /* 入れ子の呼び出し列は領域を共有できないので呼び出しごとに確保する
+       A nested call sequence can't share the area and gets its own */
+    call_stack[call_depth].sparams
+        = gen_call_prologue(out, i->imm, reg, c->save,
+                            calls_in_frame && call_depth == 0,
+                            &call_stack[call_depth].psize,
+                            &call_stack[call_depth].fsize);
+    call_depth++;
 }
 
 void
-gen_exp_call_param(FILE *out, AST_Node *p, int nump, int sparams)
+gen_insn_call(FILE *out, IR_Func *f, IR_Insn *i)
 {
-    gen_exp(out, p);
-    gen_call_set_param(out, p->reg, nump, sparams);
+    CallFrame *cf;
+
+    assert(call_depth > 0);
+    cf = &call_stack[--call_depth];
+    gen_call_epilogue(out, i->name, i->dst != 0 ? PHYS(f, i->dst) : 0,
+                      i->dst != 0, i->save, cf->psize, cf->fsize);
 }
 
+/*
+ * 条件が偽なら偽側の分岐先へ飛ぶ。真側が直後に配置されていなければjmpを足す
+ * Jump to the false target if the condition does not hold.
+ * A jmp is added unless the true target is placed just after.
+ */
 void
-gen_exp_n2(FILE *out, AST_Node *e)
+gen_insn_br(FILE *out, IR_Func *f, IR_Insn *i)
 {
-    int  i0, i1, r0, r1, src;
-
-    /* レジスタ割り付けと同じ順番で巡回する必要がある
-       Traverse order must be same as that of register assignment */
-    r0 = r1 = 0;
-    src = e->reg;
-    if (e->child[0] != NULL) {
-        r0 = e->child[0]->rank;
-    }
-    if (e->child[1] != NULL) {
-        r1 = e->child[1]->rank;
-        src = e->child[1]->reg;
-    }
-    if (r0 >= r1) {
-        i0 = 0; i1 = 1;
-    } else {
-        i0 = 1; i1 = 0;
-    }
-    if (r0 != 0 || r1 != 0) {
-        if (e->child[i0] != NULL) {
-            gen_exp(out, e->child[i0]);
-	}
-        if (e->child[i1] != NULL) {
-            gen_exp(out, e->child[i1]);
+    if (i->cond != 0) {
+        if (!isel_gen(out, i, 0)) {
+            gen_insn_cmp(out, PHYS(f, i->src[0]), PHYS(f, i->src[1]));
         }
+        gen_insn_rel(out, i->cond, block_label(i->target[1]), 0);
+    } else {
+        gen_insn_rel(out, 0, block_label(i->target[1]), PHYS(f, i->src[0]));
     }
-    switch (e->sub_kind) {
-    case  AST_EXP_UNARY_PLUS:
-        break;			/* nothing to do */
-    case  AST_EXP_UNARY_MINUS:
-        gen_insn_neg(out, e->reg, e->reg);
-        break;
-    case  AST_EXP_MUL:
-        gen_insn_mul(out, e->reg, e->reg, src);
-        break;
-    case  AST_EXP_DIV:
-        /* "div" is not supported now because of its register restriction. */
-        fputs("Sorry, div is not suppoted.\n", stderr);
-        exit(-1);
-        break;
-    case  AST_EXP_ADD:
-        gen_insn_add(out, e->reg, e->reg, src);
-        break;
-    case  AST_EXP_SUB:
-        gen_insn_sub(out, e->reg, e->reg, src);
-        break;
-    case  AST_EXP_LT:
-    case  AST_EXP_GT:
-    case  AST_EXP_LTE:
-    case  AST_EXP_GTE:
-    case  AST_EXP_EQ:
-    case  AST_EXP_NE:
-        gen_exp_rel(out, e);
-        break;
-    default:
-        fprintf(stderr, "Unsupported sub_kind %d\n", e->sub_kind);
+    if (i->target[0] != i->block->next) {
+        gen_insn_jmp(out, block_label(i->target[0]));
     }
 }
@@ -0,0 +1,1002 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    グラフ彩色によるレジスタ割り付け / register allocation by graph coloring
+
+    Chaitin-Briggsの方式に反復合併を加えたもの (George and Appel)。
+    干渉グラフを作り、次数の小さいノードの除去、転送命令の保守的な合併
+    (Briggsの判定)、転送命令の凍結、スピル候補の選択を繰り返す。候補も
+    楽観的にスタックに積み、色が付かなかったものだけを実際にスピルして
+    最初からやり直す。スピルの費用は参照と定義の数で、ループの深さ1段
+    ごとに10倍に数える。
+    呼び出しをまたぐ値の制約は線形走査法(regalloc.c)と同じで、ノード
+    ごとに使えないレジスタとして持つ。戻り値のレジスタ(RET_REG)が割り
+    付け対象なら、戻り値と呼び出しの結果にはまずその色を試し、転送命令を
+    省く。合併できなかった転送命令も、相手と同じ色を優先する。
+    引数レジスタ(RET_REGが-1なら戻り値のレジスタも兼ねる)は色の決まった
+    ノードにし、実引数、仮引数、戻り値と呼び出しの結果をそれとの転送
+    命令とみなす。呼び出しはこれらのレジスタを壊す。普通のノードはこの
+    色を選ばず、干渉しなければ合併だけでこの色になる。彩色の対象から
+    外れるだけなので合併はいつでも安全である。
+
+    Chaitin-Briggs allocation with iterated coalescing (George and Appel).
+    An interference graph is built, then simplifying low-degree nodes,
+    conservatively coalescing moves (Briggs' test), freezing moves and
+    choosing spill candidates are repeated.  Spill candidates are pushed
+    optimistically as well, and only the nodes left without a color are
+    actually spilled before starting over.  The spill cost counts uses
+    and defs, ten times as much for each level of loop nesting.
+    The constraints on values live across calls are the same as in
+    linear scan (regalloc.c) and kept as registers a node must not use.
+    If the return value register (RET_REG) is allocatable, return values
+    and call results try it first, which saves the moves.  A move that
+    could not be coalesced still prefers the color of its other end.
+    The argument registers (also the return register if RET_REG is -1)
+    are precolored nodes, and arguments, parameters, return values and
+    call results are taken as moves to or from them; calls clobber them.
+    Ordinary nodes never choose these colors but get them by coalescing
+    with a node they do not interfere with, which is always safe since
+    the merged node simply leaves the registers being colored.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  "arch_common.h"
+#include  "ir.h"
+#include  "opt.h"
+#include  "regalloc.h"
+#include  "symtab.h"
+#include  "util.h"
+
+#define  MAX_DEPTH   6		/* 費用を重くするループの深さの上限 / deepest level weighted */
+#define  NO_SPILL    1e30	/* スピル用の一時の費用 / cost of spill temporaries */
+
+/* ノードの状態 / states of nodes */
+enum {
+    N_NONE,			/* 現れない / does not occur */
+    N_SIMPLIFY,			/* 次数が小さく転送命令と無関係 / low degree, not move-related */
+    N_FREEZE,			/* 次数が小さく転送命令に関係 / low degree, move-related */
+    N_SPILL,			/* 次数が大きい / high degree */
+    N_COALESCED,		/* 他のノードに合併 / merged into another node */
+    N_SELECTED,			/* スタック上 / on the stack */
+    N_COLORED,
+    N_PRECOLORED		/* 引数レジスタ / argument registers */
+};
+
+/* 転送命令の状態 / states of moves */
+enum {
+    M_WORKLIST,			/* 合併を試す / to be tried */
+    M_ACTIVE,			/* まだ合併できない / not ready yet */
+    M_COALESCED,
+    M_CONSTRAINED,		/* 両端が干渉する / both ends interfere */
+    M_FROZEN			/* 合併をあきらめた / given up */
+};
+
+typedef struct IntList {
+    int  n;
+    int  size;
+    int  *elem;
+} IntList;
+
+typedef struct Graph {
+    IR_Func *f;
+    int  nv;			/* 仮想レジスタの数+1 / number of registers + 1 */
+    int  orig_nv;		/* これより大きいのはスピル用の一時 / temporaries above this */
+    int  pre;			/* ここから引数レジスタのノード / precolored nodes from here on */
+    int  use_pre;		/* 引数レジスタを割り付けに使える / argument registers may be used */
+    unsigned int *adj;		/* 隣接行列 / adjacency matrix */
+    IntList *adj_list;
+    int  *degree;
+    char *state;
+    int  *alias;		/* 合併先 / node merged into */
+    int  *color;
+    unsigned int *forbid;	/* 使えない物理レジスタ / physical registers not allowed */
+    char *crosses;		/* 呼び出しをまたぐ / live across a call */
+    int  *hint;			/* 望ましい色 (-1: なし) / preferred color (-1: none) */
+    double *cost;
+    double *save_cost;		/* 呼び出しの前後で退避する費用 / cost of saving around calls */
+    char *remat;		/* 定数だけで定義される / defined by constants only */
+    IntList *move_list;		/* ノードに関係する転送命令 / moves related to a node */
+    int  nmoves;
+    int  *mv_dst, *mv_src;
+    char *mv_state;
+    int  *stack;
+    int  nstack;
+} Graph;
+
+static void list_add(IntList *l, int x);
+static int  *loop_depths(IR_Func *f);
+static void new_graph(Graph *g, IR_Func *f, int orig_nv);
+static void free_graph(Graph *g);
+static void add_edge(Graph *g, int u, int v);
+static int  adjacent(Graph *g, int u, int v);
+static void add_move(Graph *g, int dst, int src);
+static int  pre_ok(IR_Func *f);
+static int  pre_def(Graph *g, IR_Insn *i);
+static void find_remat(Graph *g);
+static void build_graph(Graph *g);
+static int  ncolors(Graph *g, int v);
+static int  move_related(Graph *g, int v);
+static void make_worklist(Graph *g);
+static void simplify(Graph *g, int v);
+static void decrement_degree(Graph *g, int v);
+static void enable_moves(Graph *g, int v);
+static int  get_alias(Graph *g, int v);
+static void add_worklist(Graph *g, int v);
+static int  conservative(Graph *g, int u, int v);
+static void combine(Graph *g, int u, int v);
+static void coalesce(Graph *g, int m);
+static void freeze_moves(Graph *g, int u);
+static int  select_spill(Graph *g);
+static int  assign_colors(Graph *g);
+static int  choose_color(Graph *g, int v, unsigned int taken);
+static int  pick_color(Graph *g, int v, unsigned int taken);
+
+void
+color_regs(IR_Func *f)
+{
+    int  v, m, orig_nv, slots, nspill, *reg;
+    SymTab *slot;
+    Graph g;
+
+    orig_nv = f->nvregs;
+    slots = 0;
+    for (;;) {
+        ir_build_cfg(f);
+        new_graph(&g, f, orig_nv);
+        build_graph(&g);
+        make_worklist(&g);
+        for (;;) {
+            for (v = 1; v < g.nv && g.state[v] != N_SIMPLIFY; v++)
+                ;
+            if (v < g.nv) {
+                simplify(&g, v);
+                continue;
+            }
+            for (m = 0; m < g.nmoves && g.mv_state[m] != M_WORKLIST; m++)
+                ;
+            if (m < g.nmoves) {
+                coalesce(&g, m);
+                continue;
+            }
+            for (v = 1; v < g.nv && g.state[v] != N_FREEZE; v++)
+                ;
+            if (v < g.nv) {
+                g.state[v] = N_SIMPLIFY;
+                freeze_moves(&g, v);
+                continue;
+            }
+            if ((v = select_spill(&g)) > 0) {
+                g.state[v] = N_SIMPLIFY;
+                freeze_moves(&g, v);
+                continue;
+            }
+            break;
+        }
+        nspill = assign_colors(&g);
+        if (nspill == 0) {
+            break;
+        }
+        for (v = 1; v < g.nv; v++) {
+            if (g.state[v] == N_SPILL) {
+                if (v > orig_nv) {
+                    errexit("Number of registers is not sufficient.",
+                            __FILE__, __LINE__);
+                }
+                slot = NULL;
+                spill_vreg(f, v, &slot);
+                slots += slot != NULL;
+            }
+        }
+        free_graph(&g);
+    }
+
+    reg = xmalloc(g.pre*sizeof(int));
+    for (v = 1; v < g.pre; v++) {
+        reg[v] = g.state[v] == N_NONE ? -1 : g.color[get_alias(&g, v)];
+    }
+    set_phys_regs(f, reg, g.pre);
+    free(reg);
+    free_graph(&g);
+    if (slots > 0) {
+        reassign_memory(f->id);
+    }
+}
+
+void
+list_add(IntList *l, int x)
+{
+    if (l->n == l->size) {
+        l->size = l->size*2+4;
+        l->elem = xrealloc(l->elem, l->size*sizeof(int));
+    }
+    l->elem[l->n++] = x;
+}
+
+/*
+  ブロックごとのループの深さ。戻り辺ごとに自然ループの本体を数える
+  Loop depth of each block, counting the natural loop body of every
+  back edge
+*/
+int*
+loop_depths(IR_Func *f)
+{
+    int  k, n, sp;
+    int  *depth;
+    char *seen;
+    IR_Block *b, *h, *x, **work;
+
+    compute_dominators(f);
+    depth = xcalloc(f->nblocks, sizeof(int));
+    seen = xmalloc(f->nblocks);
+    work = xmalloc(f->nblocks*sizeof(IR_Block*));
+    FOR_EACH_BLOCK(b, f) {
+        if (b->rpo < 0) {
+            continue;
+        }
+        for (k = 0; k < b->nsucc; k++) {
+            h = b->succ[k];
+            if (!dominates(h, b)) {
+                continue;
+            }
+            memset(seen, 0, f->nblocks);
+            seen[h->id] = 1;
+            depth[h->id]++;
+            sp = 0;
+            if (!seen[b->id]) {
+                seen[b->id] = 1;
+                work[sp++] = b;
+            }
+            while (sp > 0) {
+                x = work[--sp];
+                depth[x->id]++;
+                for (n = 0; n < x->npred; n++) {
+                    if (!seen[x->pred[n]->id] && x->pred[n]->rpo >= 0) {
+                        seen[x->pred[n]->id] = 1;
+                        work[sp++] = x->pred[n];
+                    }
+                }
+            }
+        }
+    }
+    free(seen);
+    free(work);
+    return depth;
+}
+
+void
+new_graph(Graph *g, IR_Func *f, int orig_nv)
+{
+    int  v, nv;
+
+    nv = f->nvregs+1+NUM_PARAM_REGS;
+    g->f = f;
+    g->nv = nv;
+    g->orig_nv = orig_nv;
+    g->pre = f->nvregs+1;
+    g->adj = xcalloc(((size_t)nv*nv+BITS-1)/BITS, sizeof(unsigned int));
+    g->adj_list = xcalloc(nv, sizeof(IntList));
+    g->degree = xcalloc(nv, sizeof(int));
+    g->state = xcalloc(nv, 1);
+    g->alias = xmalloc(nv*sizeof(int));
+    g->color = xmalloc(nv*sizeof(int));
+    g->forbid = xcalloc(nv, sizeof(unsigned int));
+    g->crosses = xcalloc(nv, 1);
+    g->hint = xmalloc(nv*sizeof(int));
+    g->cost = xcalloc(nv, sizeof(double));
+    g->save_cost = xcalloc(nv, sizeof(double));
+    g->remat = xcalloc(nv, 1);
+    g->move_list = xcalloc(nv, sizeof(IntList));
+    g->nmoves = 0;
+    g->mv_dst = g->mv_src = NULL;
+    g->mv_state = NULL;
+    g->stack = xmalloc(nv*sizeof(int));
+    g->nstack = 0;
+    for (v = 0; v < nv; v++) {
+        g->alias[v] = v;
+        g->color[v] = -1;
+        g->hint[v] = -1;
+    }
+    for (v = g->pre; v < nv; v++) {
+        g->state[v] = N_PRECOLORED;
+        g->color[v] = NUM_REGS+v-g->pre;
+    }
+}
+
+void
+free_graph(Graph *g)
+{
+    int  v;
+
+    for (v = 0; v < g->nv; v++) {
+        free(g->adj_list[v].elem);
+        free(g->move_list[v].elem);
+    }
+    free(g->adj); free(g->adj_list); free(g->degree); free(g->state);
+    free(g->alias); free(g->color); free(g->forbid); free(g->crosses);
+    free(g->hint); free(g->cost); free(g->save_cost);
+    free(g->remat); free(g->move_list);
+    free(g->mv_dst); free(g->mv_src); free(g->mv_state); free(g->stack);
+}
+
+/*
+  引数レジスタの色は彩色に使わないので、そのノードとの辺は次数に数えない
+  Edges to precolored nodes do not count in the degree, since their
+  colors are not used in coloring.
+*/
+void
+add_edge(Graph *g, int u, int v)
+{
+    if (u == v || adjacent(g, u, v)) {
+        return;
+    }
+    SET_BIT(g->adj, (size_t)u*g->nv+v);
+    SET_BIT(g->adj, (size_t)v*g->nv+u);
+    if (u >= g->pre || v >= g->pre) {
+        return;
+    }
+    list_add(&g->adj_list[u], v);
+    list_add(&g->adj_list[v], u);
+    g->degree[u]++;
+    g->degree[v]++;
+}
+
+int
+adjacent(Graph *g, int u, int v)
+{
+    return TEST_BIT(g->adj, (size_t)u*g->nv+v);
+}
+
+void
+add_move(Graph *g, int dst, int src)
+{
+    int  m = g->nmoves++;
+
+    g->mv_dst = xrealloc(g->mv_dst, g->nmoves*sizeof(int));
+    g->mv_src = xrealloc(g->mv_src, g->nmoves*sizeof(int));
+    g->mv_state = xrealloc(g->mv_state, g->nmoves);
+    g->mv_dst[m] = dst;
+    g->mv_src[m] = src;
+    g->mv_state[m] = M_WORKLIST;
+    list_add(&g->move_list[dst], m);
+    list_add(&g->move_list[src], m);
+}
+
+/*
+  引数レジスタをノードにできれば1。実引数は呼び出しと同じブロックに
+  入れ子なしで並び、仮引数は戻ってこない入口のブロックにあること
+  1 if the argument registers can be nodes: the arguments must be in
+  the block of their call with no call nested, and the parameters in
+  the entry block, which nothing jumps back to.
+*/
+int
+pre_ok(IR_Func *f)
+{
+    int  open;
+    IR_Block *b;
+    IR_Insn *i;
+
+    FOR_EACH_BLOCK(b, f) {
+        open = 0;
+        FOR_EACH_INSN(i, b) {
+            switch (i->op) {
+            case  IR_PARAM:
+                if (b != f->first || b->npred > 0) {
+                    return 0;
+                }
+                break;
+            case  IR_CALL_BEGIN:
+                if (open) {
+                    return 0;
+                }
+                break;
+            case  IR_ARG:
+                open = 1;
+                break;
+            case  IR_CALL:
+            case  IR_TAILCALL:
+                open = 0;
+                break;
+            default:
+                break;
+            }
+        }
+        if (open) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* iが値を置く引数レジスタのノード (0: なし) / precolored node i puts a value in (0: none) */
+int
+pre_def(Graph *g, IR_Insn *i)
+{
+    if (i->op == IR_ARG && i->imm <= NUM_PARAM_REGS) {
+        return g->pre+i->imm-1;
+    }
+    if (i->op == IR_RET && i->src[0] != 0 && RET_REG < 0) {
+        return g->pre;
+    }
+    return 0;
+}
+
+/*
+  すべての定義が同じ定数である値に印を付ける。spill_vregは参照の直前で
+  作り直すので、レジスタに置いたまま呼び出しをまたがせる必要がない
+  Mark the values whose defs are all the same constant.  spill_vreg
+  recreates them just before each use, so they need not be kept in a
+  register across calls.
+*/
+void
+find_remat(Graph *g)
+{
+    int  v, *imm;
+    IR_Block *b;
+    IR_Insn *i;
+
+    imm = xmalloc(g->pre*sizeof(int));
+    FOR_EACH_BLOCK(b, g->f) {
+        FOR_EACH_INSN(i, b) {
+            if ((v = i->dst) == 0 || g->remat[v] == 2) {
+                continue;
+            }
+            if (i->op != IR_CONST || (g->remat[v] == 1 && imm[v] != i->imm)) {
+                g->remat[v] = 2;
+            } else {
+                g->remat[v] = 1;
+                imm[v] = i->imm;
+            }
+        }
+    }
+    for (v = 1; v < g->pre; v++) {
+        g->remat[v] = g->remat[v] == 1;
+    }
+    free(imm);
+}
+
+/*
+  ブロックを後ろから辿って干渉辺を張る。転送命令の両端は干渉させない。
+  開いている呼び出し列（呼び出しから開始へ遡る途中）の中で定義され、
+  その呼び出しをまたぐ値には呼び出し元退避レジスタを使わせない。
+  呼び出しをまたぐ値は引数レジスタとも干渉する
+  Walk each block backwards adding interference edges; the two ends of
+  a move do not interfere.  A value defined inside an open call sequence
+  (between a call and its start, walking backwards) and live across the
+  call must not use caller-saved registers.  Values live across a call
+  interfere with the argument registers as well.
+*/
+void
+build_graph(Graph *g)
+{
+    int  k, j, v, u, words, ncall, maxcall, use_pre;
+    int  *depth;
+    double weight;
+    unsigned int caller, **in, **out, *live, **cross;
+    IR_Func *f = g->f;
+    IR_Block *b;
+    IR_Insn *i;
+
+    caller = 0;
+    for (k = 0; k < FIRST_CALLEE_SAVED; k++) {
+        caller |= 1u << k;
+    }
+    use_pre = g->use_pre = pre_ok(f);
+    find_remat(g);
+    depth = loop_depths(f);
+    compute_liveness(f, g->nv, &in, &out);
+    words = (g->nv+BITS-1)/BITS;
+    live = xmalloc(words*sizeof(unsigned int));
+    maxcall = 0;
+    cross = NULL;
+    FOR_EACH_BLOCK(b, f) {
+        memcpy(live, out[b->id], words*sizeof(unsigned int));
+        for (weight = 1, k = 0; k < depth[b->id] && k < MAX_DEPTH; k++) {
+            weight *= 10;
+        }
+        ncall = 0;
+        for (i = b->tail; i != NULL; i = i->prev) {
+            if (i->op == IR_CALL) {
+                if (ncall == maxcall) {
+                    maxcall++;
+                    cross = xrealloc(cross, maxcall*sizeof(unsigned int*));
+                    cross[ncall] = xmalloc(words*sizeof(unsigned int));
+                }
+                memcpy(cross[ncall], live, words*sizeof(unsigned int));
+                if (i->dst != 0) {
+                    CLEAR_BIT(cross[ncall], i->dst);
+                }
+                for (v = g->pre; v < g->nv; v++) {
+                    CLEAR_BIT(cross[ncall], v);
+                }
+                for (v = 1; v < g->pre; v++) {
+                    if (TEST_BIT(cross[ncall], v)) {
+                        g->crosses[v] = 1;
+                        g->save_cost[v] += 2*weight;
+                        if (i->dst == 0) {
+                            g->forbid[v] |= 1u;
+                        }
+                        for (u = g->pre; u < g->nv; u++) {
+                            add_edge(g, v, u);
+                        }
+                    }
+                }
+                if (use_pre && i->dst != 0 && RET_REG < 0) {
+                    add_move(g, i->dst, g->pre);
+                }
+                ncall++;
+            }
+            if (i->op == IR_MOV && i->dst != i->src[0]) {
+                CLEAR_BIT(live, i->src[0]);
+                add_move(g, i->dst, i->src[0]);
+            }
+            if (use_pre && i->op == IR_PARAM && i->imm <= NUM_PARAM_REGS) {
+                CLEAR_BIT(live, g->pre+i->imm-1);
+                add_move(g, i->dst, g->pre+i->imm-1);
+            }
+            if (use_pre && (u = pre_def(g, i)) > 0) {
+                CLEAR_BIT(live, i->src[0]);
+                add_move(g, u, i->src[0]);
+                for (v = 1; v < g->nv; v++) {
+                    if (TEST_BIT(live, v)) {
+                        add_edge(g, u, v);
+                    }
+                }
+                CLEAR_BIT(live, u);
+            }
+            if (i->dst != 0) {
+                v = i->dst;
+                for (u = 1; u < g->nv; u++) {
+                    if (TEST_BIT(live, u)) {
+                        add_edge(g, v, u);
+                    }
+                }
+                for (j = 0; j < ncall; j++) {
+                    if (TEST_BIT(cross[j], v)) {
+                        g->forbid[v] |= caller;
+                    }
+                }
+                if (i->op == IR_CALL && RET_REG >= 0) {
+                    g->hint[v] = RET_REG;
+                }
+                g->state[v] = N_SIMPLIFY;
+                g->cost[v] += weight;
+                CLEAR_BIT(live, v);
+            }
+            for (k = 0; k < ir_num_uses(i); k++) {
+                v = *ir_use(i, k);
+                SET_BIT(live, v);
+                g->state[v] = N_SIMPLIFY;
+                g->cost[v] += weight;
+            }
+            if (use_pre && i->op == IR_PARAM && i->imm <= NUM_PARAM_REGS) {
+                SET_BIT(live, g->pre+i->imm-1);
+            }
+            if (use_pre && (i->op == IR_CALL || i->op == IR_TAILCALL)) {
+                for (k = 0; k < i->imm && k < NUM_PARAM_REGS; k++) {
+                    SET_BIT(live, g->pre+k);
+                }
+            }
+            if (i->op == IR_RET && i->src[0] != 0 && RET_REG >= 0) {
+                g->hint[i->src[0]] = RET_REG;
+            }
+            if (i->op == IR_CALL_BEGIN && ncall > 0) {
+                ncall--;
+            }
+        }
+        /* 開始がブロック内にない呼び出し / calls starting in another block */
+        for (j = 0; j < ncall; j++) {
+            for (v = 1; v < g->pre; v++) {
+                if (TEST_BIT(cross[j], v)) {
+                    g->forbid[v] |= caller;
+                }
+            }
+        }
+    }
+    for (v = g->orig_nv+1; v < g->pre; v++) {
+        g->cost[v] = NO_SPILL;
+    }
+    for (j = 0; j < maxcall; j++) {
+        free(cross[j]);
+    }
+    free(cross);
+    free(live);
+    free_liveness(f, in, out);
+    free(depth);
+}
+
+/* vが使えるレジスタの数 / number of registers v may use */
+int
+ncolors(Graph *g, int v)
+{
+    int  r, n;
+
+    n = 0;
+    for (r = 0; r < NUM_REGS; r++) {
+        n += ((g->forbid[v] >> r) & 1) == 0;
+    }
+    return n;
+}
+
+int
+move_related(Graph *g, int v)
+{
+    int  k, s;
+
+    for (k = 0; k < g->move_list[v].n; k++) {
+        s = g->mv_state[g->move_list[v].elem[k]];
+        if (s == M_WORKLIST || s == M_ACTIVE) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void
+make_worklist(Graph *g)
+{
+    int  v;
+
+    for (v = 1; v < g->nv; v++) {
+        if (g->state[v] == N_NONE || g->state[v] == N_PRECOLORED) {
+            continue;
+        }
+        if (g->degree[v] >= ncolors(g, v)) {
+            g->state[v] = N_SPILL;
+        } else if (move_related(g, v)) {
+            g->state[v] = N_FREEZE;
+        } else {
+            g->state[v] = N_SIMPLIFY;
+        }
+    }
+}
+
+/* グラフに残っている隣接ノード / neighbors still in the graph */
+#define  FOR_EACH_ADJ(G, V, K, W) \
+    for ((K) = 0; (K) < (G)->adj_list[V].n; (K)++) \
+        if (((W) = (G)->adj_list[V].elem[K]), \
+            (G)->state[W] != N_SELECTED && (G)->state[W] != N_COALESCED)
+
+void
+simplify(Graph *g, int v)
+{
+    int  k, w;
+
+    g->state[v] = N_SELECTED;
+    g->stack[g->nstack++] = v;
+    FOR_EACH_ADJ(g, v, k, w) {
+        decrement_degree(g, w);
+    }
+}
+
+void
+decrement_degree(Graph *g, int v)
+{
+    int  k, w;
+
+    if (g->degree[v]-- != ncolors(g, v)) {
+        return;
+    }
+    enable_moves(g, v);
+    FOR_EACH_ADJ(g, v, k, w) {
+        enable_moves(g, w);
+    }
+    if (g->state[v] == N_SPILL) {
+        g->state[v] = move_related(g, v) ? N_FREEZE : N_SIMPLIFY;
+    }
+}
+
+void
+enable_moves(Graph *g, int v)
+{
+    int  k, m;
+
+    for (k = 0; k < g->move_list[v].n; k++) {
+        m = g->move_list[v].elem[k];
+        if (g->mv_state[m] == M_ACTIVE) {
+            g->mv_state[m] = M_WORKLIST;
+        }
+    }
+}
+
+int
+get_alias(Graph *g, int v)
+{
+    while (g->state[v] == N_COALESCED) {
+        v = g->alias[v];
+    }
+    return v;
+}
+
+void
+add_worklist(Graph *g, int v)
+{
+    if (g->state[v] == N_FREEZE && !move_related(g, v)
+        && g->degree[v] < ncolors(g, v)) {
+        g->state[v] = N_SIMPLIFY;
+    }
+}
+
+/*
+  Briggsの判定：合併したノードの次数の大きい隣接ノードが色の数より
+  少なければ彩色可能性を損なわない
+  Briggs' test: merging is safe if the merged node has fewer neighbors
+  of significant degree than the colors it may use.
+*/
+int
+conservative(Graph *g, int u, int v)
+{
+    int  k, w, n, r, colors;
+    unsigned int forbid;
+    char *seen;
+
+    forbid = g->forbid[u] | g->forbid[v];
+    colors = 0;
+    for (r = 0; r < NUM_REGS; r++) {
+        colors += ((forbid >> r) & 1) == 0;
+    }
+    if (colors == 0) {
+        return 0;
+    }
+    seen = xcalloc(g->nv, 1);
+    n = 0;
+    FOR_EACH_ADJ(g, u, k, w) {
+        if (!seen[w] && g->degree[w] >= ncolors(g, w)) {
+            seen[w] = 1;
+            n++;
+        }
+    }
+    FOR_EACH_ADJ(g, v, k, w) {
+        if (!seen[w] && g->degree[w] >= ncolors(g, w)) {
+            seen[w] = 1;
+            n++;
+        }
+    }
+    free(seen);
+    return n < colors;
+}
+
+void
+combine(Graph *g, int u, int v)
+{
+    int  k, w;
+
+    g->state[v] = N_COALESCED;
+    g->alias[v] = u;
+    for (k = 0; k < g->move_list[v].n; k++) {
+        list_add(&g->move_list[u], g->move_list[v].elem[k]);
+    }
+    enable_moves(g, v);
+    g->forbid[u] |= g->forbid[v];
+    g->crosses[u] |= g->crosses[v];
+    g->cost[u] += g->cost[v];
+    g->save_cost[u] += g->save_cost[v];
+    g->remat[u] = 0;
+    if (g->hint[u] < 0) {
+        g->hint[u] = g->hint[v];
+    }
+    FOR_EACH_ADJ(g, v, k, w) {
+        add_edge(g, w, u);
+        decrement_degree(g, w);
+    }
+    /* 引数レジスタとの辺は隣接行列にしかない / edges to precolored nodes are only in the matrix */
+    for (w = g->pre; w < g->nv; w++) {
+        if (adjacent(g, v, w)) {
+            add_edge(g, w, u);
+        }
+    }
+    if (g->degree[u] >= ncolors(g, u)
+        && (g->state[u] == N_FREEZE || g->state[u] == N_SIMPLIFY)) {
+        g->state[u] = N_SPILL;
+    }
+}
+
+/*
+  スピル用の一時は合併しない。合併したノードはスピルできなくなるため。
+  引数レジスタへは干渉しなければいつでも合併する
+  Spill temporaries are not coalesced, since the merged node could no
+  longer be spilled.  A node is always merged into an argument register
+  it does not interfere with.
+*/
+void
+coalesce(Graph *g, int m)
+{
+    int  u, v, t;
+
+    u = get_alias(g, g->mv_dst[m]);
+    v = get_alias(g, g->mv_src[m]);
+    if (v >= g->pre) {
+        t = u; u = v; v = t;
+    }
+    if (u == v) {
+        g->mv_state[m] = M_COALESCED;
+        add_worklist(g, u);
+    } else if (u >= g->pre) {
+        if (v >= g->pre || adjacent(g, u, v)) {
+            g->mv_state[m] = M_CONSTRAINED;
+            add_worklist(g, v);
+        } else {
+            g->mv_state[m] = M_COALESCED;
+            combine(g, u, v);
+        }
+    } else if (adjacent(g, u, v) || u > g->orig_nv || v > g->orig_nv) {
+        g->mv_state[m] = M_CONSTRAINED;
+        add_worklist(g, u);
+        add_worklist(g, v);
+    } else if (conservative(g, u, v)) {
+        g->mv_state[m] = M_COALESCED;
+        combine(g, u, v);
+        add_worklist(g, u);
+    } else {
+        g->mv_state[m] = M_ACTIVE;
+    }
+}
+
+void
+freeze_moves(Graph *g, int u)
+{
+    int  k, m, s, v;
+
+    for (k = 0; k < g->move_list[u].n; k++) {
+        m = g->move_list[u].elem[k];
+        s = g->mv_state[m];
+        if (s != M_WORKLIST && s != M_ACTIVE) {
+            continue;
+        }
+        v = get_alias(g, g->mv_dst[m]);
+        if (v == get_alias(g, u)) {
+            v = get_alias(g, g->mv_src[m]);
+        }
+        g->mv_state[m] = M_FROZEN;
+        if (g->state[v] == N_FREEZE && !move_related(g, v)
+            && g->degree[v] < ncolors(g, v)) {
+            g->state[v] = N_SIMPLIFY;
+        }
+    }
+}
+
+/*
+  費用/次数が最小のスピル候補 (0: なし)。呼び出しをまたぐノードを先に選び、
+  またがない短い一時はなるべく残す
+  Candidate with the least cost/degree (0: none).  Nodes live across a
+  call are chosen first so that short temporaries which never cross one
+  keep their registers.
+*/
+int
+select_spill(Graph *g)
+{
+    int  v, best;
+
+    best = 0;
+    for (v = 1; v < g->nv; v++) {
+        if (g->state[v] != N_SPILL) {
+            continue;
+        }
+        if (best == 0 || g->crosses[v] > g->crosses[best]
+            || (g->crosses[v] == g->crosses[best]
+                && g->cost[v]/(g->degree[v]+1)
+                   < g->cost[best]/(g->degree[best]+1))) {
+            best = v;
+        }
+    }
+    return best;
+}
+
+/*
+  スタックから降ろして色を付ける。付かなかったノードはN_SPILLにして
+  その数を返す
+  Pop the nodes and color them.  Nodes left without a color are marked
+  N_SPILL and their number is returned.
+*/
+int
+assign_colors(Graph *g)
+{
+    int  v, k, w, nspill;
+    unsigned int taken;
+
+    nspill = 0;
+    while (g->nstack > 0) {
+        v = g->stack[--g->nstack];
+        taken = g->forbid[v];
+        for (k = 0; k < g->adj_list[v].n; k++) {
+            w = get_alias(g, g->adj_list[v].elem[k]);
+            if (g->state[w] == N_COLORED || g->state[w] == N_PRECOLORED) {
+                taken |= 1u << g->color[w];
+            }
+        }
+        /* 引数レジスタとの干渉は隣接行列にだけある
+           Interference with the argument registers is only in the matrix */
+        for (w = g->pre; w < g->nv; w++) {
+            if (!g->use_pre || adjacent(g, v, w)) {
+                taken |= 1u << g->color[w];
+            }
+        }
+        if ((g->color[v] = choose_color(g, v, taken)) < 0) {
+            g->state[v] = N_SPILL;
+            nspill++;
+        } else {
+            g->state[v] = N_COLORED;
+        }
+    }
+    return nspill;
+}
+
+/*
+  呼び出しをまたぐ定数は参照ごとに作り直す (-1)。それ以外で呼び出しを
+  またぐなら空いている呼び出し先退避レジスタを選ぶ。なければ呼び出しの
+  前後で退避するよりスピルのほうが安いときスピルする (-1)
+  A constant live across a call is recreated at each use (-1).  Any
+  other node live across a call takes a free callee-saved register.  If
+  there is none, it is spilled (-1) when that is cheaper than saving a
+  caller-saved register around each call.
+*/
+int
+choose_color(Graph *g, int v, unsigned int taken)
+{
+    int  r;
+
+    if (g->crosses[v]) {
+        if (g->remat[v]) {
+            return -1;
+        }
+        r = pick_color(g, v, taken | ((1u << FIRST_CALLEE_SAVED)-1));
+        if (r >= 0) {
+            return r;
+        }
+        if (g->save_cost[v] > g->cost[v]) {
+            return -1;
+        }
+    }
+    return pick_color(g, v, taken);
+}
+
+/*
+  望ましい色、転送命令の相手の色の順に選ぶ。次に、呼び出しをまたぐなら
+  呼び出し先退避、そうでなければ呼び出し元退避、引数レジスタ、呼び出し先
+  退避の順に選ぶ (-1: なし)。呼び出しをまたがない範囲では引数レジスタも
+  使える
+  Choose the preferred color, then the color of the other end of a move.
+  Then take a callee-saved register if v lives across a call, or else a
+  caller-saved one, an argument register, or a callee-saved one in this
+  order (-1: none).  The argument registers are free wherever no call is
+  crossed.
+*/
+int
+pick_color(Graph *g, int v, unsigned int taken)
+{
+    int  k, m, r, w;
+
+    if (g->hint[v] >= 0 && ((taken >> g->hint[v]) & 1) == 0) {
+        return g->hint[v];
+    }
+    for (k = 0; k < g->move_list[v].n; k++) {
+        m = g->move_list[v].elem[k];
+        w = get_alias(g, g->mv_dst[m]);
+        if (w == v) {
+            w = get_alias(g, g->mv_src[m]);
+        }
+        if (g->state[w] == N_COLORED && ((taken >> g->color[w]) & 1) == 0) {
+            return g->color[w];
+        }
+    }
+    if (!g->crosses[v]) {
+        for (r = 0; r < FIRST_CALLEE_SAVED; r++) {
+            if (((taken >> r) & 1) == 0) {
+                return r;
+            }
+        }
+        for (r = NUM_REGS; r < NUM_REGS+NUM_PARAM_REGS; r++) {
+            if (((taken >> r) & 1) == 0) {
+                return r;
+            }
+        }
+    }
+    for (k = 0; k < NUM_REGS; k++) {
+        r = (k+FIRST_CALLEE_SAVED)%NUM_REGS;
+        if (((taken >> r) & 1) == 0) {
+            return r;
+        }
+    }
+    return -1;
+}
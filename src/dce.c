@@ -0,0 +1,197 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    不要コード除去 / dead code elimination
+
+    副作用のある命令（関数呼び出し列と戻り値）から、値の使用と制御依存
+    （逆支配辺境）を辿って必要な命令に印を付け、残りを取り除く。
+    印のない条件分岐は直接後支配ブロックへの無条件分岐になるので、
+    副作用のない空のループも消える。出口に至らないブロック（無限ループ）
+    は常に必要とする。
+    SSA形式では自動変数への代入は単なる定義なので、読まれない代入
+    （不要なストア）もここで消える。
+
+    Instructions with side effects (call sequences and returns) are
+    marked as useful, and marks are propagated through used values and
+    control dependence (reverse dominance frontiers); everything else
+    is removed.  An unmarked conditional branch becomes a jump to its
+    immediate post-dominator, so loops without side effects disappear.
+    Blocks never reaching the exit (infinite loops) are always kept.
+    In SSA form an assignment to an auto variable is a mere definition,
+    so assignments never read (dead stores) are removed here as well.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ir.h"
+#include  "opt.h"
+#include  "util.h"
+
+static IR_Insn **def;
+static char *live;		/* 印の付いた命令を含むブロック / blocks with marked insns */
+static IR_Block ***rdf;		/* 逆支配辺境 / reverse dominance frontiers */
+static int  *nrdf;
+static IR_Insn **work;
+static int  nwork, work_size;
+
+static void compute_rdf(IR_Func *f, IR_Block **ipdom);
+static void mark(IR_Insn *i);
+static void mark_block(IR_Block *b);
+
+void
+dce(IR_Func *f)
+{
+    int  k, *uses;
+    IR_Block *b, **ipdom;
+    IR_Insn *i, *next;
+
+    ir_build_cfg(f);
+    ipdom = compute_postdominators(f);
+    compute_rdf(f, ipdom);
+    def = xcalloc(f->nvregs+1, sizeof(IR_Insn*));
+    live = xcalloc(f->nblocks, sizeof(char));
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            i->mark = 0;
+            if (i->dst != 0) {
+                def[i->dst] = i;
+            }
+        }
+    }
+
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            switch (i->op) {
+            case  IR_STORE:
+            case  IR_CALL_BEGIN:
+            case  IR_ARG:
+            case  IR_CALL:
+            case  IR_RET:
+            case  IR_TAILCALL:
+                mark(i);
+                break;
+            case  IR_JMP:
+            case  IR_BR:
+                if (ipdom[b->id] == NULL && b != f->exit) {
+                    mark(i);	/* 無限ループ / infinite loop */
+                }
+                break;
+            }
+        }
+    }
+    while (nwork > 0) {
+        i = work[--nwork];
+        for (k = 0; k < ir_num_uses(i); k++) {
+            if (def[*ir_use(i, k)] != NULL) {
+                mark(def[*ir_use(i, k)]);
+            }
+        }
+        mark_block(i->block);
+        if (i->op == IR_PHI) {
+            /* どの先行ブロックから来たかも値を決める
+               The predecessor taken also decides the value */
+            for (k = 0; k < i->nphi; k++) {
+                mark(ir_terminator(i->phi_blk[k]));
+                mark_block(i->phi_blk[k]);
+            }
+        }
+    }
+
+    FOR_EACH_BLOCK(b, f) {
+        for (i = b->head; i != NULL; i = next) {
+            next = i->next;
+            if (i->mark || i->op == IR_JMP) {
+                continue;
+            }
+            if (i->op == IR_BR) {
+                i->op = IR_JMP;
+                i->target[0] = ipdom[b->id];
+                i->target[1] = NULL;
+                i->cond = 0;
+                i->src[0] = i->src[1] = 0;
+                continue;
+            }
+            ir_remove(i);
+        }
+    }
+    /* 値を使わない呼び出し / calls whose values are unused */
+    uses = ir_use_counts(f);
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->op == IR_CALL && i->dst != 0 && uses[i->dst] == 0) {
+                i->dst = 0;
+            }
+        }
+    }
+    free(uses);
+
+    for (k = 0; k < f->nblocks; k++) {
+        free(rdf[k]);
+    }
+    free(rdf);
+    free(nrdf);
+    free(ipdom);
+    free(def);
+    free(live);
+    free(work);
+    rdf = NULL;
+    work = NULL;
+    nwork = work_size = 0;
+    ir_build_cfg(f);
+    ir_remove_unreachable(f);
+}
+
+/* 分岐ブロックbの後続から直接後支配ブロックまでの各ブロックはbに制御依存する
+   Blocks from each successor of b up to its immediate post-dominator
+   are control dependent on b */
+void
+compute_rdf(IR_Func *f, IR_Block **ipdom)
+{
+    int  k;
+    IR_Block *b, *r;
+
+    rdf = xcalloc(f->nblocks, sizeof(IR_Block**));
+    nrdf = xcalloc(f->nblocks, sizeof(int));
+    FOR_EACH_BLOCK(b, f) {
+        if (b->nsucc < 2) {
+            continue;
+        }
+        for (k = 0; k < b->nsucc; k++) {
+            for (r = b->succ[k]; r != NULL && r != ipdom[b->id]; r = ipdom[r->id]) {
+                if (nrdf[r->id] > 0 && rdf[r->id][nrdf[r->id]-1] == b) {
+                    break;
+                }
+                rdf[r->id] = xrealloc(rdf[r->id], (nrdf[r->id]+1)*sizeof(IR_Block*));
+                rdf[r->id][nrdf[r->id]++] = b;
+            }
+        }
+    }
+}
+
+void
+mark(IR_Insn *i)
+{
+    if (i == NULL || i->mark) {
+        return;
+    }
+    i->mark = 1;
+    if (nwork == work_size) {
+        work_size += 64;
+        work = xrealloc(work, work_size*sizeof(IR_Insn*));
+    }
+    work[nwork++] = i;
+}
+
+void
+mark_block(IR_Block *b)
+{
+    int  k;
+
+    if (live[b->id]) {
+        return;
+    }
+    live[b->id] = 1;
+    for (k = 0; k < nrdf[b->id]; k++) {
+        mark(ir_terminator(rdf[b->id][k]));
+    }
+}
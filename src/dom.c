@@ -0,0 +1,204 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    支配木 / dominator tree
+
+    Cooper, Harvey, Kennedyの反復法で直接支配ブロックを求める。
+    支配関係の判定は支配木の前順・後順の番号で行う。
+    Immediate dominators are computed with the iterative algorithm of
+    Cooper, Harvey and Kennedy.  Dominance is tested with the pre- and
+    post-order numbers of the dominator tree.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ir.h"
+#include  "opt.h"
+#include  "util.h"
+
+static void number_postorder(IR_Block *b, int *mark, IR_Block **order, int *n);
+static IR_Block *intersect(IR_Block *a, IR_Block *b);
+static void number_dom_tree(IR_Block *b, int *n);
+static void number_reverse_postorder(IR_Block *b, int *mark, IR_Block **order,
+                                     int *n);
+
+void
+compute_dominators(IR_Func *f)
+{
+    int  k, n, changed;
+    int  *mark;
+    IR_Block *b, *p, *idom, **post;
+
+    FOR_EACH_BLOCK(b, f) {
+        b->rpo = -1;
+        b->idom = NULL;
+        b->dom_child = NULL;
+        b->dom_sibling = NULL;
+    }
+
+    /* 逆後順 / reverse postorder */
+    mark = xcalloc(f->nblocks, sizeof(int));
+    post = xmalloc(f->nblocks*sizeof(IR_Block*));
+    n = 0;
+    number_postorder(f->first, mark, post, &n);
+    free(f->rpo);
+    f->rpo = xmalloc(n*sizeof(IR_Block*));
+    f->nrpo = n;
+    for (k = 0; k < n; k++) {
+        f->rpo[k] = post[n-1-k];
+        f->rpo[k]->rpo = k;
+    }
+    free(post);
+    free(mark);
+
+    f->first->idom = f->first;
+    do {
+        changed = 0;
+        for (k = 1; k < f->nrpo; k++) {
+            b = f->rpo[k];
+            idom = NULL;
+            for (n = 0; n < b->npred; n++) {
+                p = b->pred[n];
+                if (p->rpo < 0 || p->idom == NULL) {
+                    continue;
+                }
+                idom = (idom == NULL) ? p : intersect(p, idom);
+            }
+            if (b->idom != idom) {
+                b->idom = idom;
+                changed = 1;
+            }
+        }
+    } while (changed);
+
+    /* 支配木 / dominator tree */
+    for (k = f->nrpo-1; k > 0; k--) {
+        b = f->rpo[k];
+        b->dom_sibling = b->idom->dom_child;
+        b->idom->dom_child = b;
+    }
+    n = 0;
+    number_dom_tree(f->first, &n);
+}
+
+void
+number_postorder(IR_Block *b, int *mark, IR_Block **order, int *n)
+{
+    int  k;
+
+    mark[b->id] = 1;
+    for (k = 0; k < b->nsucc; k++) {
+        if (!mark[b->succ[k]->id]) {
+            number_postorder(b->succ[k], mark, order, n);
+        }
+    }
+    order[(*n)++] = b;
+}
+
+IR_Block*
+intersect(IR_Block *a, IR_Block *b)
+{
+    while (a != b) {
+        while (a->rpo > b->rpo) {
+            a = a->idom;
+        }
+        while (b->rpo > a->rpo) {
+            b = b->idom;
+        }
+    }
+    return a;
+}
+
+void
+number_dom_tree(IR_Block *b, int *n)
+{
+    IR_Block *c;
+
+    b->dom_pre = (*n)++;
+    for (c = b->dom_child; c != NULL; c = c->dom_sibling) {
+        number_dom_tree(c, n);
+    }
+    b->dom_post = (*n)++;
+}
+
+void
+number_reverse_postorder(IR_Block *b, int *mark, IR_Block **order, int *n)
+{
+    int  k;
+
+    mark[b->id] = 1;
+    for (k = 0; k < b->npred; k++) {
+        if (!mark[b->pred[k]->id]) {
+            number_reverse_postorder(b->pred[k], mark, order, n);
+        }
+    }
+    order[(*n)++] = b;
+}
+
+/*
+ * 直接後支配ブロックを求める（逆向きのCFGに同じ方法を使う）
+ * 出口に至らないブロックと出口自身はNULLになる
+ * Compute immediate post-dominators with the same method on the
+ * reversed CFG.  They are NULL for the exit and blocks never reaching it.
+ */
+IR_Block**
+compute_postdominators(IR_Func *f)
+{
+    int  k, j, n, changed, *mark, *num;
+    IR_Block *b, *s, *a, *c, **order, **ipdom;
+
+    ipdom = xcalloc(f->nblocks, sizeof(IR_Block*));
+    mark = xcalloc(f->nblocks, sizeof(int));
+    num = xcalloc(f->nblocks, sizeof(int));
+    order = xmalloc(f->nblocks*sizeof(IR_Block*));
+    n = 0;
+    number_reverse_postorder(f->exit, mark, order, &n);
+    for (k = 0; k < n; k++) {
+        num[order[k]->id] = k;	/* 出口が最大 / the exit is the largest */
+    }
+    ipdom[f->exit->id] = f->exit;
+    do {
+        changed = 0;
+        for (k = n-2; k >= 0; k--) {
+            b = order[k];
+            a = NULL;
+            for (j = 0; j < b->nsucc; j++) {
+                s = b->succ[j];
+                if (!mark[s->id] || ipdom[s->id] == NULL) {
+                    continue;
+                }
+                if (a == NULL) {
+                    a = s;
+                    continue;
+                }
+                c = s;
+                while (a != c) {
+                    while (num[a->id] < num[c->id]) {
+                        a = ipdom[a->id];
+                    }
+                    while (num[c->id] < num[a->id]) {
+                        c = ipdom[c->id];
+                    }
+                }
+            }
+            if (ipdom[b->id] != a) {
+                ipdom[b->id] = a;
+                changed = 1;
+            }
+        }
+    } while (changed);
+    ipdom[f->exit->id] = NULL;
+    free(mark);
+    free(num);
+    free(order);
+    return ipdom;
+}
+
+int
+dominates(IR_Block *a, IR_Block *b)
+{
+    if (a->rpo < 0 || b->rpo < 0) {
+        return 0;
+    }
+    return a->dom_pre <= b->dom_pre && b->dom_post <= a->dom_post;
+}
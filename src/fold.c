@@ -0,0 +1,353 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    定数畳み込みと代数的簡約 / constant folding and algebraic simplification
+
+    演算は対象の命令と同じ32bitの桁あふれ（2の補数での折り返し）で
+    行う。0での除算とINT_MIN/-1は実行時の振る舞いに任せて畳み込まない。
+    Arithmetic wraps around in 32 bits (two's complement) like the
+    target instructions.  Division by zero and INT_MIN/-1 are left to
+    run time and never folded.
+*/
+
+#include  <limits.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ast.h"
+#include  "ir.h"
+#include  "opt.h"
+#include  "util.h"
+
+static int  fold_kind(int op);
+static int  const_of(IR_Insn **def, int v, int *val);
+static IR_Insn *def_of(IR_Insn **def, int v, int op);
+static void make_const(IR_Insn *i, int val);
+static int  simplify(IR_Insn *i, IR_Insn **def, int *repl);
+static int  resolve(int *repl, int v);
+
+/*
+ * 演算kind (AST_EXP_*) を定数a, bに適用する。畳み込めれば1を返す
+ * 単項演算ではbは使わない
+ * Apply the operation kind (AST_EXP_*) to the constants a and b.
+ * Returns 1 if folded.  b is unused for unary operations.
+ */
+int
+fold_const(int kind, int a, int b, int *val)
+{
+    unsigned int ua = (unsigned int)a, ub = (unsigned int)b;
+
+    switch (kind) {
+    case  AST_EXP_UNARY_PLUS:
+        *val = a;
+        break;
+    case  AST_EXP_UNARY_MINUS:
+        *val = (int)(0u-ua);
+        break;
+    case  AST_EXP_ADD:
+        *val = (int)(ua+ub);
+        break;
+    case  AST_EXP_SUB:
+        *val = (int)(ua-ub);
+        break;
+    case  AST_EXP_MUL:
+        *val = (int)(ua*ub);
+        break;
+    case  AST_EXP_DIV:
+        if (b == 0 || (a == INT_MIN && b == -1)) {
+            return 0;
+        }
+        *val = a/b;
+        break;
+    case  AST_EXP_LT:
+        *val = a < b;
+        break;
+    case  AST_EXP_GT:
+        *val = a > b;
+        break;
+    case  AST_EXP_LTE:
+        *val = a <= b;
+        break;
+    case  AST_EXP_GTE:
+        *val = a >= b;
+        break;
+    case  AST_EXP_EQ:
+        *val = a == b;
+        break;
+    case  AST_EXP_NE:
+        *val = a != b;
+        break;
+    default:
+        return 0;
+    }
+    return 1;
+}
+
+/* IR命令に対応する演算 (0: 畳み込めない) / operation of an IR opcode (0: none) */
+int
+fold_kind(int op)
+{
+    switch (op) {
+    case  IR_NEG:
+        return AST_EXP_UNARY_MINUS;
+    case  IR_ADD:
+        return AST_EXP_ADD;
+    case  IR_SUB:
+        return AST_EXP_SUB;
+    case  IR_MUL:
+        return AST_EXP_MUL;
+    case  IR_DIV:
+        return AST_EXP_DIV;
+    default:
+        return 0;
+    }
+}
+
+int
+const_of(IR_Insn **def, int v, int *val)
+{
+    if (def[v] != NULL && def[v]->op == IR_CONST) {
+        *val = def[v]->imm;
+        return 1;
+    }
+    return 0;
+}
+
+/* vの定義がopならその命令 / the definition of v if its opcode is op */
+IR_Insn*
+def_of(IR_Insn **def, int v, int op)
+{
+    if (def[v] != NULL && def[v]->op == op) {
+        return def[v];
+    }
+    return NULL;
+}
+
+void
+make_const(IR_Insn *i, int val)
+{
+    i->op = IR_CONST;
+    i->imm = val;
+    i->cond = 0;
+    i->src[0] = i->src[1] = 0;
+}
+
+int
+resolve(int *repl, int v)
+{
+    while (repl[v] != 0) {
+        v = repl[v];
+    }
+    return v;
+}
+
+/*
+ * 命令iを簡約する。値が既存のレジスタに等しければrepl[dst]に記録して1を
+ * 返す（iは取り除かれる）。命令を書き換えたときも1を返す
+ * Simplify i.  If its value equals an existing register, record it in
+ * repl[dst] and return 1 (i is to be removed).  Also returns 1 when
+ * i is rewritten.
+ */
+int
+simplify(IR_Insn *i, IR_Insn **def, int *repl)
+{
+    int  k, a, b, ka, kb, va, vb, val, same;
+    IR_Insn *d;
+
+    a = i->src[0];
+    b = i->src[1];
+    va = vb = 0;
+    ka = const_of(def, a, &va);
+    kb = (b != 0) && const_of(def, b, &vb);
+    switch (i->op) {
+    case  IR_MOV:
+        repl[i->dst] = a;
+        return 1;
+    case  IR_PHI:
+        same = 0;
+        for (k = 0; k < i->nphi; k++) {
+            if (i->phi_src[k] == i->dst || i->phi_src[k] == same) {
+                continue;
+            }
+            if (same != 0) {
+                return 0;
+            }
+            same = i->phi_src[k];
+        }
+        if (same == 0) {
+            return 0;
+        }
+        repl[i->dst] = same;
+        return 1;
+    case  IR_SETCC:
+        if (ka && kb) {
+            fold_const(i->cond, va, vb, &val);
+            make_const(i, val);
+            return 1;
+        }
+        if (a == b) {
+            make_const(i, i->cond == AST_EXP_EQ || i->cond == AST_EXP_LTE
+                       || i->cond == AST_EXP_GTE);
+            return 1;
+        }
+        return 0;
+    case  IR_NEG:
+        if (ka) {
+            fold_const(AST_EXP_UNARY_MINUS, va, 0, &val);
+            make_const(i, val);
+            return 1;
+        }
+        if ((d = def_of(def, a, IR_NEG)) != NULL) {	/* -(-x) */
+            repl[i->dst] = d->src[0];
+            return 1;
+        }
+        return 0;
+    case  IR_SHR:
+        if (ka) {
+            make_const(i, (int)((unsigned int)va >> i->imm));
+            return 1;
+        }
+        if (i->imm == 0) {			/* x>>0 */
+            repl[i->dst] = a;
+            return 1;
+        }
+        return 0;
+    case  IR_ADD:
+    case  IR_SUB:
+    case  IR_MUL:
+    case  IR_DIV:
+        break;
+    default:
+        return 0;
+    }
+
+    /* 二項演算 / binary operations */
+    if (ka && kb && fold_const(fold_kind(i->op), va, vb, &val)) {
+        make_const(i, val);
+        return 1;
+    }
+    switch (i->op) {
+    case  IR_ADD:
+        if (kb && vb == 0) {			/* x+0 */
+            repl[i->dst] = a;
+            return 1;
+        }
+        if (ka && va == 0) {			/* 0+x */
+            repl[i->dst] = b;
+            return 1;
+        }
+        if ((d = def_of(def, b, IR_NEG)) != NULL) {	/* x+(-y) */
+            i->op = IR_SUB;
+            i->src[1] = d->src[0];
+            return 1;
+        }
+        break;
+    case  IR_SUB:
+        if (kb && vb == 0) {			/* x-0 */
+            repl[i->dst] = a;
+            return 1;
+        }
+        if (a == b) {				/* x-x */
+            make_const(i, 0);
+            return 1;
+        }
+        if (ka && va == 0) {			/* 0-x */
+            i->op = IR_NEG;
+            i->src[0] = b;
+            i->src[1] = 0;
+            return 1;
+        }
+        if ((d = def_of(def, b, IR_NEG)) != NULL) {	/* x-(-y) */
+            i->op = IR_ADD;
+            i->src[1] = d->src[0];
+            return 1;
+        }
+        break;
+    case  IR_MUL:
+        if ((kb && vb == 0) || (ka && va == 0)) {	/* x*0 */
+            make_const(i, 0);
+            return 1;
+        }
+        if (kb && vb == 1) {			/* x*1 */
+            repl[i->dst] = a;
+            return 1;
+        }
+        if (ka && va == 1) {			/* 1*x */
+            repl[i->dst] = b;
+            return 1;
+        }
+        if (kb && vb == -1) {			/* x*-1 */
+            i->op = IR_NEG;
+            i->src[1] = 0;
+            return 1;
+        }
+        if (ka && va == -1) {			/* -1*x */
+            i->op = IR_NEG;
+            i->src[0] = b;
+            i->src[1] = 0;
+            return 1;
+        }
+        break;
+    case  IR_DIV:
+        if (kb && vb == 1) {			/* x/1 */
+            repl[i->dst] = a;
+            return 1;
+        }
+        break;
+    }
+    return 0;
+}
+
+/*
+ * 定数畳み込みと簡約をSSA形式のIRに行う。変化がなくなるまで逆後順に
+ * 命令を辿り、置き換えたレジスタの参照は最後にまとめて書き換える
+ * Fold constants and simplify the IR in SSA form.  Instructions are
+ * visited in reverse postorder until nothing changes; uses of replaced
+ * registers are rewritten at the end.
+ */
+void
+fold_constants(IR_Func *f)
+{
+    int  k, n, changed, *repl;
+    IR_Block *b;
+    IR_Insn *i, *next, **def;
+
+    compute_dominators(f);
+    do {
+        changed = 0;
+        def = xcalloc(f->nvregs+1, sizeof(IR_Insn*));
+        repl = xcalloc(f->nvregs+1, sizeof(int));
+        FOR_EACH_BLOCK(b, f) {
+            FOR_EACH_INSN(i, b) {
+                if (i->dst != 0) {
+                    def[i->dst] = i;
+                }
+            }
+        }
+        for (n = 0; n < f->nrpo; n++) {
+            b = f->rpo[n];
+            for (i = b->head; i != NULL; i = next) {
+                next = i->next;
+                for (k = 0; k < ir_num_uses(i); k++) {
+                    *ir_use(i, k) = resolve(repl, *ir_use(i, k));
+                }
+                if (i->dst == 0 || !simplify(i, def, repl)) {
+                    continue;
+                }
+                changed = 1;
+                if (repl[i->dst] != 0) {
+                    def[i->dst] = NULL;
+                    ir_remove(i);
+                }
+            }
+        }
+        FOR_EACH_BLOCK(b, f) {
+            FOR_EACH_INSN(i, b) {
+                for (k = 0; k < ir_num_uses(i); k++) {
+                    *ir_use(i, k) = resolve(repl, *ir_use(i, k));
+                }
+            }
+        }
+        free(def);
+        free(repl);
+    } while (changed);
+}
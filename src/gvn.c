@@ -0,0 +1,249 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    大域的値番号付け / global value numbering
+
+    支配木を前順に辿り、支配するブロックで計算済みの式（演算、比較、
+    定数）と同じ式をその結果のレジスタで置き換える (Briggs, Cooper,
+    Simpson: dominator-based value numbering)。式の表は支配木の
+    有効範囲ごとに積み降ろしする。同じブロックの同じ値を合流させる
+    phiも一つにまとめる。
+    SSA形式では変数への代入は新しい名前を作るので、代入前の式と代入後の
+    式は別の値になる。関数呼び出しとメモリの読み書きは番号を付けない。
+
+    The dominator tree is walked in preorder, and an expression
+    (arithmetic, comparison or constant) already computed in a
+    dominating block is replaced with the register holding its result
+    (Briggs, Cooper, Simpson: dominator-based value numbering).  The
+    expression table is pushed and popped along the scopes of the
+    dominator tree.  Phis merging the same values in the same block
+    are also unified.
+    In SSA form an assignment to a variable creates a new name, so an
+    expression before an assignment and one after it are different
+    values.  Calls and memory accesses are never numbered.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ir.h"
+#include  "opt.h"
+#include  "util.h"
+
+#define  HASH_SIZE  211
+
+typedef struct GVN_Expr {
+    int  op;
+    int  cond;
+    int  imm;
+    int  src[2];
+    int  value;			/* 結果のレジスタ / register holding the result */
+    int  bucket;
+    struct GVN_Expr *next;
+} GVN_Expr;
+
+static GVN_Expr *table[HASH_SIZE];
+static GVN_Expr **scope;	/* 登録した式の履歴 / log of entered expressions */
+static int  scope_depth, scope_size;
+static int  *repl;		/* 取り除いた命令の結果 -> 同じ値 / removed result -> same value */
+
+static int  resolve(int v);
+static int  numbered(IR_Insn *i);
+static void canonicalize(IR_Insn *i);
+static int  hash(IR_Insn *i);
+static GVN_Expr *lookup(IR_Insn *i);
+static void enter(IR_Insn *i);
+static int  same_phi(IR_Insn *a, IR_Insn *b);
+static void number_block(IR_Block *b);
+
+void
+gvn(IR_Func *f)
+{
+    int  k;
+    IR_Block *b;
+    IR_Insn *i;
+
+    ir_build_cfg(f);
+    compute_dominators(f);
+    repl = xcalloc(f->nvregs+1, sizeof(int));
+    number_block(f->first);
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            for (k = 0; k < ir_num_uses(i); k++) {
+                *ir_use(i, k) = resolve(*ir_use(i, k));
+            }
+        }
+    }
+    free(repl);
+    free(scope);
+    repl = NULL;
+    scope = NULL;
+    scope_depth = scope_size = 0;
+}
+
+int
+resolve(int v)
+{
+    while (repl[v] != 0) {
+        v = repl[v];
+    }
+    return v;
+}
+
+/* 値番号を付ける命令なら1 / 1 if the instruction is numbered */
+int
+numbered(IR_Insn *i)
+{
+    switch (i->op) {
+    case  IR_CONST:
+    case  IR_NEG:
+    case  IR_ADD:
+    case  IR_SUB:
+    case  IR_MUL:
+    case  IR_DIV:
+    case  IR_SHR:
+    case  IR_SETCC:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* 可換な演算の被演算子をレジスタ番号順に並べる
+   Order the operands of commutative operations by register number */
+void
+canonicalize(IR_Insn *i)
+{
+    int  t;
+
+    if (i->src[0] <= i->src[1]) {
+        return;
+    }
+    switch (i->op) {
+    case  IR_ADD:
+    case  IR_MUL:
+        break;
+    case  IR_SETCC:
+        i->cond = ir_swap_cond(i->cond);
+        break;
+    default:
+        return;
+    }
+    t = i->src[0];
+    i->src[0] = i->src[1];
+    i->src[1] = t;
+}
+
+int
+hash(IR_Insn *i)
+{
+    unsigned int h;
+
+    h = (unsigned int)i->op;
+    h = h*31 + (unsigned int)i->cond;
+    h = h*31 + (unsigned int)i->imm;
+    h = h*31 + (unsigned int)i->src[0];
+    h = h*31 + (unsigned int)i->src[1];
+    return (int)(h % HASH_SIZE);
+}
+
+GVN_Expr*
+lookup(IR_Insn *i)
+{
+    GVN_Expr *e;
+
+    for (e = table[hash(i)]; e != NULL; e = e->next) {
+        if (e->op == i->op && e->cond == i->cond && e->imm == i->imm
+            && e->src[0] == i->src[0] && e->src[1] == i->src[1]) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+void
+enter(IR_Insn *i)
+{
+    int  h;
+    GVN_Expr *e;
+
+    e = xmalloc(sizeof(GVN_Expr));
+    e->op = i->op;
+    e->cond = i->cond;
+    e->imm = i->imm;
+    e->src[0] = i->src[0];
+    e->src[1] = i->src[1];
+    e->value = i->dst;
+    h = hash(i);
+    e->bucket = h;
+    e->next = table[h];
+    table[h] = e;
+    if (scope_depth == scope_size) {
+        scope_size += 64;
+        scope = xrealloc(scope, scope_size*sizeof(GVN_Expr*));
+    }
+    scope[scope_depth++] = e;
+}
+
+/* 同じ先行ブロックから同じ値を受け取るphiなら1
+   1 if the phis receive the same values from the same predecessors */
+int
+same_phi(IR_Insn *a, IR_Insn *b)
+{
+    int  k;
+
+    if (a->nphi != b->nphi) {
+        return 0;
+    }
+    for (k = 0; k < a->nphi; k++) {
+        if (a->phi_blk[k] != b->phi_blk[k]
+            || resolve(a->phi_src[k]) != resolve(b->phi_src[k])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void
+number_block(IR_Block *b)
+{
+    int  k, base;
+    IR_Block *c;
+    IR_Insn *i, *p, *next;
+    GVN_Expr *e;
+
+    base = scope_depth;
+    for (i = b->head; i != NULL; i = next) {
+        next = i->next;
+        if (i->op == IR_PHI) {
+            for (p = b->head; p != i; p = p->next) {
+                if (same_phi(p, i)) {
+                    repl[i->dst] = p->dst;
+                    ir_remove(i);
+                    break;
+                }
+            }
+            continue;
+        }
+        for (k = 0; k < ir_num_uses(i); k++) {
+            *ir_use(i, k) = resolve(*ir_use(i, k));
+        }
+        if (!numbered(i)) {
+            continue;
+        }
+        canonicalize(i);
+        if ((e = lookup(i)) != NULL) {
+            repl[i->dst] = e->value;
+            ir_remove(i);
+        } else {
+            enter(i);
+        }
+    }
+    for (c = b->dom_child; c != NULL; c = c->dom_sibling) {
+        number_block(c);
+    }
+    while (scope_depth > base) {
+        e = scope[--scope_depth];
+        table[e->bucket] = e->next;
+        free(e);
+    }
+}
@@ -0,0 +1,395 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    関数のインライン展開 / function inlining
+
+    呼び出しグラフの強連結成分を呼ばれる側から順に並べ (Tarjan)、その
+    順に各関数へ呼び出し先を展開してから最適化する。展開する関数は
+    最適化済みなので、展開後の大きさを見積もりやすい。
+    展開するのは次のいずれかの呼び出し（大きさはSSA形式の命令数）。
+      - 小さい関数 (-finline-limit=N、既定は20)
+      - inline指定のある関数 (INLINE_HINT_MAX_SIZEまで)
+      - 呼び出し箇所が一つだけの関数 (INLINE_SINGLE_MAX_SIZEまで)
+    同じ強連結成分の中の呼び出し（再帰）は展開しないので、展開は
+    呼び出しグラフの深さで止まる。展開先の関数が大きくなりすぎる
+    (INLINE_CALLER_MAX_SIZE) ときも展開しない。
+    展開は呼び出し先のSSA形式を複製する。仮引数は実引数で、戻り値は
+    呼び出しの後に置くphiで置き換える。
+
+    The strongly connected components of the call graph are ordered
+    callees first (Tarjan), and in that order each function gets its
+    callees inlined and is then optimized.  Inlined functions are
+    already optimized, which makes their size a good estimate.
+    A call is inlined if it calls (the size counts instructions in SSA
+    form)
+      - a small function (-finline-limit=N, 20 by default),
+      - a function declared inline (up to INLINE_HINT_MAX_SIZE), or
+      - a function called from only one place (up to
+        INLINE_SINGLE_MAX_SIZE).
+    Calls within a strongly connected component (recursion) are never
+    inlined, so inlining stops at the depth of the call graph.  Nor are
+    calls inlined when the caller would grow too large
+    (INLINE_CALLER_MAX_SIZE).
+    Inlining copies the callee in SSA form.  Parameters are replaced
+    with the arguments and the return value with a phi placed after
+    the call.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ir.h"
+#include  "opt.h"
+#include  "option.h"
+#include  "parse_action.h"
+#include  "util.h"
+
+#define  INLINE_HINT_MAX_SIZE    100	/* inline指定の関数 / functions declared inline */
+#define  INLINE_SINGLE_MAX_SIZE  400	/* 呼び出しが一箇所の関数 / functions called once */
+#define  INLINE_CALLER_MAX_SIZE  2000	/* 展開後の呼び出し側 / caller after inlining */
+
+static int  max_id;
+static int  *ncalls;		/* 関数id -> 呼び出し箇所の数 / function id -> number of call sites */
+static int  *scc;		/* 関数id -> 強連結成分 / function id -> strongly connected component */
+static int  *dfs_index, *lowlink, *on_stack;
+static IR_Func **stack, **order;
+static int  nstack, norder, counter, nscc;
+
+static void count_calls(IR_Func *f, int delta);
+static void visit(IR_Func *f);
+static int  should_inline(IR_Func *f, IR_Insn *call, IR_Func *g);
+static int  inline_call(IR_Func *f, IR_Insn *call, IR_Func *g);
+static void hoist_enclosing(IR_Insn *begin, IR_Insn *call);
+static IR_Block *split_after(IR_Func *f, IR_Insn *call);
+
+/*
+ * 関数を呼ばれる側から順に並べた配列を返す（呼び出し側でfreeする）
+ * Return the functions ordered callees first (to be freed by the
+ * caller)
+ */
+IR_Func**
+bottom_up_order(int *n)
+{
+    IR_Func *f;
+
+    max_id = 0;
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        if (max_id < f->id) {
+            max_id = f->id;
+        }
+    }
+    free(ncalls);
+    free(scc);
+    ncalls = xcalloc(max_id+1, sizeof(int));
+    scc = xcalloc(max_id+1, sizeof(int));
+    dfs_index = xcalloc(max_id+1, sizeof(int));
+    lowlink = xcalloc(max_id+1, sizeof(int));
+    on_stack = xcalloc(max_id+1, sizeof(int));
+    stack = xmalloc((max_id+1)*sizeof(IR_Func*));
+    order = xmalloc((max_id+1)*sizeof(IR_Func*));
+    nstack = norder = counter = nscc = 0;
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        count_calls(f, 1);
+    }
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        if (dfs_index[f->id] == 0) {
+            visit(f);
+        }
+    }
+    free(dfs_index);
+    free(lowlink);
+    free(on_stack);
+    free(stack);
+    *n = norder;
+    return order;
+}
+
+/* fの中の呼び出しを呼び出し先ごとにdeltaだけ数える
+   Count the calls in f by delta for each callee */
+void
+count_calls(IR_Func *f, int delta)
+{
+    IR_Block *b;
+    IR_Insn *i;
+    IR_Func *g;
+
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->op == IR_CALL && (g = ir_find_func(i->name)) != NULL) {
+                ncalls[g->id] += delta;
+            }
+        }
+    }
+}
+
+/* Tarjanの強連結成分分解 / Tarjan's strongly connected components */
+void
+visit(IR_Func *f)
+{
+    IR_Block *b;
+    IR_Insn *i;
+    IR_Func *g;
+
+    dfs_index[f->id] = lowlink[f->id] = ++counter;
+    stack[nstack++] = f;
+    on_stack[f->id] = 1;
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->op != IR_CALL || (g = ir_find_func(i->name)) == NULL) {
+                continue;
+            }
+            if (dfs_index[g->id] == 0) {
+                visit(g);
+                if (lowlink[f->id] > lowlink[g->id]) {
+                    lowlink[f->id] = lowlink[g->id];
+                }
+            } else if (on_stack[g->id] && lowlink[f->id] > dfs_index[g->id]) {
+                lowlink[f->id] = dfs_index[g->id];
+            }
+        }
+    }
+    if (lowlink[f->id] != dfs_index[f->id]) {
+        return;
+    }
+    /* 呼び出し先の成分はすべて出力済み / all callee components are already out */
+    nscc++;
+    do {
+        g = stack[--nstack];
+        on_stack[g->id] = 0;
+        scc[g->id] = nscc;
+        order[norder++] = g;
+    } while (g != f);
+}
+
+/* fの呼び出しを展開し、展開した数を返す
+   Inline calls in f and return the number of calls inlined */
+int
+inline_calls(IR_Func *f)
+{
+    int  k, n, ncand;
+    IR_Block *b;
+    IR_Insn *i, **cand;
+    IR_Func *g;
+
+    /* 展開で複製した呼び出しは対象にしない
+       Calls copied by inlining are not candidates */
+    ncand = 0;
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            ncand += (i->op == IR_CALL);
+        }
+    }
+    cand = xmalloc((ncand+1)*sizeof(IR_Insn*));
+    ncand = 0;
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->op == IR_CALL) {
+                cand[ncand++] = i;
+            }
+        }
+    }
+
+    n = 0;
+    for (k = 0; k < ncand; k++) {
+        g = ir_find_func(cand[k]->name);
+        if (g != NULL && should_inline(f, cand[k], g) && inline_call(f, cand[k], g)) {
+            ncalls[g->id]--;
+            count_calls(g, 1);
+            ir_build_cfg(f);	/* 次の分割は後続を見る / the next split needs successors */
+            n++;
+        }
+    }
+    free(cand);
+    return n;
+}
+
+int
+should_inline(IR_Func *f, IR_Insn *call, IR_Func *g)
+{
+    int  size;
+
+    if (scc[g->id] == scc[f->id] || call->imm != g->nparams) {
+        return 0;
+    }
+    size = ir_count_insns(g);
+    if (ir_count_insns(f) + size > INLINE_CALLER_MAX_SIZE) {
+        return 0;
+    }
+    return size <= inline_limit
+           || (is_inline_hinted(g->name) && size <= INLINE_HINT_MAX_SIZE)
+           || (ncalls[g->id] == 1 && size <= INLINE_SINGLE_MAX_SIZE);
+}
+
+/*
+ * 呼び出しcallをgの複製で置き換える。呼び出し列が一つのブロックに
+ * 収まっていなければ0
+ * Replace call with a copy of g.  Returns 0 if the call sequence is
+ * not within a single block.
+ */
+int
+inline_call(IR_Func *f, IR_Insn *call, IR_Func *g)
+{
+    int  k, v, *args, *vmap;
+    IR_Block *b, *k_blk, *nb, *pos, **bmap;
+    IR_Insn *i, *c, *begin, *undef, *phi;
+
+    args = xcalloc(g->nparams+1, sizeof(int));
+    if ((begin = ir_call_begin(call, args)) == NULL) {
+        free(args);
+        return 0;
+    }
+    hoist_enclosing(begin, call);
+    ir_remove_call_args(begin, call);
+
+    b = call->block;
+    k_blk = split_after(f, call);
+    vmap = xcalloc(g->nvregs+1, sizeof(int));
+    bmap = xcalloc(g->nblocks, sizeof(IR_Block*));
+    FOR_EACH_BLOCK(nb, g) {
+        if (nb != g->exit) {
+            bmap[nb->id] = ir_new_block(f);
+        }
+        FOR_EACH_INSN(i, nb) {
+            if (i->dst != 0) {
+                vmap[i->dst] = ir_new_vreg(f);
+            }
+        }
+    }
+
+    /* 戻り値を受けるphi / phi receiving the return value */
+    phi = NULL;
+    if (call->dst != 0) {
+        phi = ir_new_insn(IR_PHI);
+        phi->dst = call->dst;
+        ir_insert_before(k_blk->head, phi);
+    }
+
+    pos = b;
+    FOR_EACH_BLOCK(nb, g) {
+        if (nb == g->exit) {
+            continue;
+        }
+        FOR_EACH_INSN(i, nb) {
+            c = ir_new_insn(i->op);
+            *c = *i;
+            c->prev = c->next = NULL;
+            c->dst = vmap[i->dst];
+            for (k = 0; k < 2; k++) {
+                c->src[k] = vmap[i->src[k]];
+                if (i->target[k] != NULL) {
+                    c->target[k] = (i->target[k] == g->exit) ? k_blk
+                                   : bmap[i->target[k]->id];
+                }
+            }
+            if (i->op == IR_PHI) {
+                c->phi_src = xmalloc(i->nphi*sizeof(int));
+                c->phi_blk = xmalloc(i->nphi*sizeof(IR_Block*));
+                for (k = 0; k < i->nphi; k++) {
+                    c->phi_src[k] = vmap[i->phi_src[k]];
+                    c->phi_blk[k] = bmap[i->phi_blk[k]->id];
+                }
+            } else if (i->op == IR_PARAM) {
+                c->op = IR_MOV;
+                c->src[0] = args[i->imm];
+                c->sym = NULL;
+            } else if (i->op == IR_RET) {
+                c->op = IR_JMP;
+                c->src[0] = 0;
+                c->target[0] = k_blk;
+            }
+            ir_append(bmap[nb->id], c);
+            if (phi == NULL || !IR_IS_TERMINATOR(c->op)
+                || (c->target[0] != k_blk && c->target[1] != k_blk)) {
+                continue;
+            }
+            /* 値を返さない経路では値は不定 / undefined on paths returning no value */
+            v = (i->op == IR_RET) ? vmap[i->src[0]] : 0;
+            if (v == 0) {
+                undef = ir_new_insn(IR_CONST);
+                undef->dst = v = ir_new_vreg(f);
+                ir_insert_before(c, undef);
+            }
+            phi->phi_src = xrealloc(phi->phi_src, (phi->nphi+1)*sizeof(int));
+            phi->phi_blk = xrealloc(phi->phi_blk, (phi->nphi+1)*sizeof(IR_Block*));
+            phi->phi_src[phi->nphi] = v;
+            phi->phi_blk[phi->nphi++] = bmap[nb->id];
+        }
+        ir_place_block_after(f, pos, bmap[nb->id]);
+        pos = bmap[nb->id];
+    }
+
+    /* 呼び出しを複製の入口への分岐にする / turn the call into a jump to the copy */
+    c = ir_new_insn(IR_JMP);
+    c->target[0] = bmap[g->first->id];
+    ir_remove(call);
+    ir_append(b, c);
+
+    free(args);
+    free(vmap);
+    free(bmap);
+    return 1;
+}
+
+/*
+ * callが他の呼び出しの実引数の中にあれば、外側の呼び出しのIR_CALL_BEGIN
+ * とそれまでのIR_ARGをcallの後ろに移す。呼び出し列はブロックをまたげ
+ * ないため。
+ * If call is inside an argument of other calls, move the outer
+ * IR_CALL_BEGINs and their IR_ARGs so far after call, since a call
+ * sequence cannot span blocks.
+ */
+void
+hoist_enclosing(IR_Insn *begin, IR_Insn *call)
+{
+    int  depth;
+    IR_Insn *i, *prev;
+
+    depth = 0;
+    for (i = begin->prev; i != NULL; i = prev) {
+        prev = i->prev;
+        if (i->op == IR_CALL) {
+            depth++;
+        } else if (i->op == IR_CALL_BEGIN && depth > 0) {
+            depth--;
+        } else if ((i->op == IR_CALL_BEGIN || i->op == IR_ARG) && depth == 0) {
+            /* 元の順序を保つ / keep the original order */
+            ir_remove(i);
+            ir_insert_after(call, i);
+        }
+    }
+}
+
+/*
+ * callの後の命令を新しいブロックに移して返す。後続のphiは新しい
+ * ブロックから来るようにする
+ * Move the instructions after call to a new block and return it.
+ * The successors' phis now come from the new block.
+ */
+IR_Block*
+split_after(IR_Func *f, IR_Insn *call)
+{
+    int  k, j;
+    IR_Block *b, *nb;
+    IR_Insn *i, *next;
+
+    b = call->block;
+    nb = ir_new_block(f);
+    for (i = call->next; i != NULL; i = next) {
+        next = i->next;
+        ir_remove(i);
+        ir_append(nb, i);
+    }
+    for (k = 0; k < b->nsucc; k++) {
+        FOR_EACH_INSN(i, b->succ[k]) {
+            if (i->op != IR_PHI) {
+                break;
+            }
+            for (j = 0; j < i->nphi; j++) {
+                if (i->phi_blk[j] == b) {
+                    i->phi_blk[j] = nb;
+                }
+            }
+        }
+    }
+    ir_place_block_after(f, b, nb);
+    return nb;
+}
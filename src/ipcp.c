@@ -0,0 +1,511 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    手続き間定数伝播と関数の特殊化 / interprocedural constant propagation
+    and function specialization
+
+    各仮引数に渡される値を、呼び出しグラフ全体で格子（未定・定数・
+    不定）の上で求める。実引数は、定数か呼び出し側の定数の仮引数なら
+    定数とし、不動点まで繰り返す。外から呼ばれるmainの仮引数は不定。
+    すべての呼び出しで同じ定数を受ける仮引数は、その定数にする。
+    そのほかの定数を渡す呼び出しは、同じ定数の組で二箇所以上から呼ばれる
+    か、ループの中にあれば、定数を埋め込んだ複製(name.constprop.N)を
+    呼ぶように付け替える。複製で増える命令数は-fipcp-budget=Nまでとし、
+    展開される小さい関数は複製しない。
+    戻り値については、呼び出し側を最適化するとき（呼び出し先は最適化
+    済み）に、すべてのreturnが同じ定数を返す関数の呼び出しの値を定数に
+    する。
+
+    The values passed to each parameter are computed over the whole
+    call graph on a lattice (unknown, constant, varying).  An argument
+    is constant if it is a constant or a constant parameter of the
+    caller, iterated to a fixed point.  The parameters of main, which
+    is called from outside, are varying.
+    A parameter receiving the same constant at every call becomes that
+    constant.  Other calls passing constants are redirected to a clone
+    with the constants embedded (name.constprop.N) if the same set of
+    constants is passed from two or more places or from inside a loop.
+    Cloning adds at most -fipcp-budget=N instructions, and small
+    functions that will be inlined are not cloned.
+    For return values, when a caller is optimized (its callees already
+    are), the value of a call to a function whose returns all give the
+    same constant becomes that constant.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  "ir.h"
+#include  "opt.h"
+#include  "option.h"
+#include  "symtab.h"
+#include  "util.h"
+
+/* 格子の値 / lattice values */
+enum {
+    IP_TOP,			/* 未定 / unknown yet */
+    IP_CONST,
+    IP_BOTTOM			/* 不定 / varying */
+};
+
+typedef struct IP_Value {
+    int  kind;
+    int  val;
+} IP_Value;
+
+/* 同じ呼び出し先に同じ定数の組を渡す呼び出し
+   Calls passing the same set of constants to the same callee */
+typedef struct IP_Group {
+    IR_Func *callee;
+    int  *known;		/* 仮引数番号で引く / indexed by parameter number */
+    int  *vals;
+    int  nsites;
+    int  hot;			/* ループの中の呼び出しがあれば1 / 1 if called in a loop */
+    IR_Func *clone;
+    struct IP_Group *next;
+} IP_Group;
+
+typedef struct IP_Site {
+    IR_Func *caller;
+    IR_Insn *call;
+    IP_Group *group;
+    struct IP_Site *next;
+} IP_Site;
+
+static int  max_id;
+static IP_Value **lat;		/* 関数id -> 仮引数の値 / function id -> parameter values */
+static IR_Insn ***defs;		/* 関数id -> 仮想レジスタの定義 / function id -> definitions */
+static int  nclones;
+
+static void analyze(void);
+static IR_Insn **def_table(IR_Func *f);
+static IP_Value value_of(IR_Func *f, int v);
+static int  meet(IP_Value *a, IP_Value b);
+static int  const_params(IR_Func *f);
+static void specialize(void);
+static int  *loop_blocks(IR_Func *f);
+static IP_Group *find_group(IP_Group **groups, IR_Func *g, int *known, int *vals);
+static IR_Func *clone_func(IR_Func *g, int *known, int *vals);
+static int  const_return(IR_Func *g, int *val);
+
+/* 仮引数の定数伝播と関数の特殊化 / constant parameters and specialization */
+void
+ipcp(void)
+{
+    int  id;
+    IR_Func *f;
+
+    analyze();
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        report(f, "ipcp", const_params(f), "parameters made constant");
+    }
+    specialize();
+    for (id = 0; id <= max_id; id++) {
+        free(lat[id]);
+        free(defs[id]);
+    }
+    free(lat);
+    free(defs);
+    lat = NULL;
+    defs = NULL;
+}
+
+/* 定数を返す関数の呼び出しの値を定数にし、その数を返す
+   Make the values of calls to functions returning a constant constant,
+   and return the number of them */
+int
+ipcp_returns(IR_Func *f)
+{
+    int  n, val;
+    IR_Block *b;
+    IR_Insn *i, *c;
+    IR_Func *g;
+
+    n = 0;
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->op != IR_CALL || i->dst == 0
+                || (g = ir_find_func(i->name)) == NULL || !const_return(g, &val)) {
+                continue;
+            }
+            c = ir_new_insn(IR_CONST);
+            c->dst = ir_new_vreg(f);
+            c->imm = val;
+            ir_replace_vreg(f, i->dst, c->dst);
+            ir_insert_after(i, c);
+            i->dst = 0;
+            n++;
+        }
+    }
+    return n;
+}
+
+void
+analyze(void)
+{
+    int  k, changed, *args;
+    IR_Block *b;
+    IR_Insn *i;
+    IR_Func *f, *g;
+    IP_Value bottom;
+
+    max_id = 0;
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        if (max_id < f->id) {
+            max_id = f->id;
+        }
+    }
+    lat = xcalloc(max_id+1, sizeof(IP_Value*));
+    defs = xcalloc(max_id+1, sizeof(IR_Insn**));
+    bottom.kind = IP_BOTTOM;
+    bottom.val = 0;
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        lat[f->id] = xcalloc(f->nparams+1, sizeof(IP_Value));
+        defs[f->id] = def_table(f);
+        if (strcmp(f->name, "main") == 0) {
+            for (k = 1; k <= f->nparams; k++) {
+                lat[f->id][k] = bottom;
+            }
+        }
+    }
+
+    do {
+        changed = 0;
+        for (f = IR_funcs; f != NULL; f = f->next) {
+            FOR_EACH_BLOCK(b, f) {
+                FOR_EACH_INSN(i, b) {
+                    if (i->op != IR_CALL || (g = ir_find_func(i->name)) == NULL) {
+                        continue;
+                    }
+                    args = xcalloc((i->imm > g->nparams ? i->imm : g->nparams)+1,
+                                   sizeof(int));
+                    if (i->imm != g->nparams || ir_call_begin(i, args) == NULL) {
+                        for (k = 1; k <= g->nparams; k++) {
+                            changed |= meet(&lat[g->id][k], bottom);
+                        }
+                    } else {
+                        for (k = 1; k <= g->nparams; k++) {
+                            changed |= meet(&lat[g->id][k], value_of(f, args[k]));
+                        }
+                    }
+                    free(args);
+                }
+            }
+        }
+    } while (changed);
+}
+
+IR_Insn**
+def_table(IR_Func *f)
+{
+    IR_Block *b;
+    IR_Insn *i, **def;
+
+    def = xcalloc(f->nvregs+1, sizeof(IR_Insn*));
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->dst != 0) {
+                def[i->dst] = i;
+            }
+        }
+    }
+    return def;
+}
+
+/* fの中の仮想レジスタvの値 / value of register v in f */
+IP_Value
+value_of(IR_Func *f, int v)
+{
+    IP_Value r;
+    IR_Insn *d;
+
+    r.kind = IP_BOTTOM;
+    r.val = 0;
+    d = defs[f->id][v];
+    if (d != NULL && d->op == IR_CONST) {
+        r.kind = IP_CONST;
+        r.val = d->imm;
+    } else if (d != NULL && d->op == IR_PARAM) {
+        r = lat[f->id][d->imm];
+    }
+    return r;
+}
+
+/* aをaとbの交わりにする。変われば1 / Lower a to the meet of a and b; 1 if changed */
+int
+meet(IP_Value *a, IP_Value b)
+{
+    if (b.kind == IP_TOP || a->kind == IP_BOTTOM
+        || (a->kind == IP_CONST && b.kind == IP_CONST && a->val == b.val)) {
+        return 0;
+    }
+    if (a->kind == IP_TOP) {
+        *a = b;
+    } else {
+        a->kind = IP_BOTTOM;
+    }
+    return 1;
+}
+
+/* 定数を受ける仮引数を定数にする / make parameters receiving a constant constant */
+int
+const_params(IR_Func *f)
+{
+    int  n;
+    IR_Block *b;
+    IR_Insn *i;
+    IP_Value *v;
+
+    n = 0;
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->op == IR_PARAM && (v = &lat[f->id][i->imm])->kind == IP_CONST) {
+                i->op = IR_CONST;
+                i->imm = v->val;
+                i->sym = NULL;
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+void
+specialize(void)
+{
+    int  k, n, size, growth, *args, *known, *vals, *in_loop;
+    IR_Block *b;
+    IR_Insn *i, *d;
+    IR_Func *f, *g, *last;
+    IP_Group *groups, *gr, *gnext;
+    IP_Site *sites, *s, *snext;
+
+    groups = NULL;
+    sites = NULL;
+    for (last = IR_funcs; last->next != NULL; last = last->next)
+        ;
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        in_loop = loop_blocks(f);
+        FOR_EACH_BLOCK(b, f) {
+            FOR_EACH_INSN(i, b) {
+                if (i->op != IR_CALL || (g = ir_find_func(i->name)) == NULL || g == f
+                    || strcmp(g->name, "main") == 0 || i->imm != g->nparams
+                    || (flag_inline && ir_count_insns(g) <= inline_limit)) {
+                    continue;
+                }
+                args = xcalloc(g->nparams+1, sizeof(int));
+                known = xcalloc(g->nparams+1, sizeof(int));
+                vals = xcalloc(g->nparams+1, sizeof(int));
+                n = 0;
+                if (ir_call_begin(i, args) != NULL) {
+                    for (k = 1; k <= g->nparams; k++) {
+                        d = defs[f->id][args[k]];
+                        if (lat[g->id][k].kind != IP_CONST
+                            && d != NULL && d->op == IR_CONST) {
+                            known[k] = 1;
+                            vals[k] = d->imm;
+                            n++;
+                        }
+                    }
+                }
+                free(args);
+                if (n == 0) {
+                    free(known);
+                    free(vals);
+                    continue;
+                }
+                gr = find_group(&groups, g, known, vals);
+                gr->nsites++;
+                gr->hot |= in_loop[b->id];
+                s = xmalloc(sizeof(IP_Site));
+                s->caller = f;
+                s->call = i;
+                s->group = gr;
+                s->next = sites;
+                sites = s;
+            }
+        }
+        free(in_loop);
+    }
+
+    growth = 0;
+    for (gr = groups; gr != NULL; gr = gr->next) {
+        size = ir_count_insns(gr->callee);
+        if ((gr->hot || gr->nsites >= 2) && growth + size <= ipcp_budget) {
+            gr->clone = clone_func(gr->callee, gr->known, gr->vals);
+            growth += size;
+        }
+    }
+    for (f = IR_funcs; ; f = f->next) {
+        n = 0;
+        for (s = sites; s != NULL; s = s->next) {
+            if (s->caller == f && s->group->clone != NULL) {
+                s->call->name = s->group->clone->name;
+                n++;
+            }
+        }
+        report(f, "ipcp", n, "calls specialized");
+        if (f == last) {
+            break;
+        }
+    }
+
+    for (s = sites; s != NULL; s = snext) {
+        snext = s->next;
+        free(s);
+    }
+    for (gr = groups; gr != NULL; gr = gnext) {
+        gnext = gr->next;
+        free(gr->known);
+        free(gr->vals);
+        free(gr);
+    }
+}
+
+/* ブロック番号で引く、ループの中なら1の表 / table by block id, 1 if in a loop */
+int*
+loop_blocks(IR_Func *f)
+{
+    int  k, *in_loop;
+    IR_Loop *loops, *l;
+
+    loops = find_loops(f);
+    in_loop = xcalloc(f->nblocks, sizeof(int));
+    for (l = loops; l != NULL; l = l->next) {
+        for (k = 0; k < l->nblocks; k++) {
+            in_loop[l->blocks[k]->id] = 1;
+        }
+    }
+    free_loops(loops);
+    return in_loop;
+}
+
+/* gと定数の組の群を探すか作る。knownとvalsは群に渡すか解放する
+   Find or make the group of g and the constants.  known and vals are
+   handed to the group or freed */
+IP_Group*
+find_group(IP_Group **groups, IR_Func *g, int *known, int *vals)
+{
+    int  k;
+    IP_Group **p;
+
+    for (p = groups; *p != NULL; p = &(*p)->next) {
+        if ((*p)->callee != g) {
+            continue;
+        }
+        for (k = 1; k <= g->nparams; k++) {
+            if ((*p)->known[k] != known[k] || (known[k] && (*p)->vals[k] != vals[k])) {
+                break;
+            }
+        }
+        if (k > g->nparams) {
+            free(known);
+            free(vals);
+            return *p;
+        }
+    }
+    *p = xcalloc(1, sizeof(IP_Group));
+    (*p)->callee = g;
+    (*p)->known = known;
+    (*p)->vals = vals;
+    return *p;
+}
+
+/* gの複製を作り、knownの仮引数を定数にする。関数の列の末尾に加える
+   Make a copy of g with the known parameters constant and append it
+   to the functions */
+IR_Func*
+clone_func(IR_Func *g, int *known, int *vals)
+{
+    int  k, id;
+    char *name;
+    IR_Func *c, *last;
+    IR_Block *b, *nb, **bmap;
+    IR_Insn *i, *n;
+
+    name = xmalloc(strlen(g->name)+32);
+    sprintf(name, "%s.constprop.%d", g->name, ++nclones);
+    id = copy_symtab(g->id);
+    c = ir_new_func(name, id);
+    c->origin = g;
+    free(name);
+    c->nparams = g->nparams;
+    c->params = xcalloc(g->nparams+1, sizeof(SymTab*));
+    for (k = 0; k < g->nparams; k++) {
+        c->params[k] = lookup_sym(id, SYM_VAR, g->params[k]->ident);
+    }
+    while (c->nvregs < g->nvregs) {
+        ir_new_vreg(c);
+    }
+
+    bmap = xcalloc(g->nblocks, sizeof(IR_Block*));
+    FOR_EACH_BLOCK(b, g) {
+        nb = ir_new_block(c);
+        nb->unroll = b->unroll;
+        ir_place_block(c, nb);
+        bmap[b->id] = nb;
+    }
+    c->exit = bmap[g->exit->id];
+    FOR_EACH_BLOCK(b, g) {
+        FOR_EACH_INSN(i, b) {
+            n = ir_new_insn(i->op);
+            *n = *i;
+            n->prev = n->next = NULL;
+            for (k = 0; k < 2; k++) {
+                if (i->target[k] != NULL) {
+                    n->target[k] = bmap[i->target[k]->id];
+                }
+            }
+            if (i->sym != NULL) {
+                n->sym = lookup_sym(id, SYM_VAR, i->sym->ident);
+            }
+            if (i->op == IR_PHI) {
+                n->phi_src = xmalloc(i->nphi*sizeof(int));
+                n->phi_blk = xmalloc(i->nphi*sizeof(IR_Block*));
+                for (k = 0; k < i->nphi; k++) {
+                    n->phi_src[k] = i->phi_src[k];
+                    n->phi_blk[k] = bmap[i->phi_blk[k]->id];
+                }
+            } else if (i->op == IR_PARAM && known[i->imm]) {
+                n->op = IR_CONST;
+                n->imm = vals[i->imm];
+                n->sym = NULL;
+            }
+            ir_append(bmap[b->id], n);
+        }
+    }
+    ir_build_cfg(c);
+    free(bmap);
+
+    for (last = IR_funcs; last->next != NULL; last = last->next)
+        ;
+    last->next = c;
+    return c;
+}
+
+/* gのすべてのreturnが同じ定数を返せば1 / 1 if all returns of g give the same constant */
+int
+const_return(IR_Func *g, int *val)
+{
+    int  n;
+    IR_Block *b;
+    IR_Insn *t, *d, **def;
+
+    def = def_table(g);
+    n = 0;
+    FOR_EACH_BLOCK(b, g) {
+        t = ir_terminator(b);
+        if (t == NULL || t->op != IR_RET || t->src[0] == 0) {
+            continue;
+        }
+        d = def[t->src[0]];
+        if (d == NULL || d->op != IR_CONST || (n > 0 && d->imm != *val)) {
+            n = 0;
+            break;
+        }
+        *val = d->imm;
+        n++;
+    }
+    free(def);
+    return n > 0;
+}
@@ -0,0 +1,662 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    中間表現 / intermediate representation
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  "ir.h"
+#include  "util.h"
+
+IR_Func *IR_funcs;
+
+/* ラベル番号はプログラム全体で通し番号 / label numbers are unique in a program */
+static int ir_label;
+
+IR_Func*
+ir_new_func(const char *name, int id)
+{
+    IR_Func *f;
+
+    f = xcalloc(1, sizeof(IR_Func));
+    if ((f->name = strdup(name)) == NULL) {
+        fprintf(stderr, "Not enough memory for strdup.\n");
+        abort();
+    }
+    f->id = id;
+    return f;
+}
+
+IR_Func*
+ir_find_func(const char *name)
+{
+    IR_Func *f;
+
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        if (strcmp(f->name, name) == 0) {
+            return f;
+        }
+    }
+    return NULL;
+}
+
+IR_Block*
+ir_new_block(IR_Func *f)
+{
+    IR_Block *b;
+
+    b = xcalloc(1, sizeof(IR_Block));
+    b->id = f->nblocks++;
+    b->label = -1;
+    return b;
+}
+
+void
+ir_place_block(IR_Func *f, IR_Block *b)
+{
+    ir_place_block_after(f, f->last, b);
+}
+
+/* posの直後に配置する（posがNULLなら先頭）
+   Place b just after pos (at the beginning if pos is NULL) */
+void
+ir_place_block_after(IR_Func *f, IR_Block *pos, IR_Block *b)
+{
+    if (pos == NULL) {
+        b->prev = NULL;
+        b->next = f->first;
+        if (f->first != NULL) {
+            f->first->prev = b;
+        } else {
+            f->last = b;
+        }
+        f->first = b;
+    } else {
+        b->prev = pos;
+        b->next = pos->next;
+        if (pos->next != NULL) {
+            pos->next->prev = b;
+        } else {
+            f->last = b;
+        }
+        pos->next = b;
+    }
+}
+
+void
+ir_unplace_block(IR_Func *f, IR_Block *b)
+{
+    if (b->prev != NULL) {
+        b->prev->next = b->next;
+    } else {
+        f->first = b->next;
+    }
+    if (b->next != NULL) {
+        b->next->prev = b->prev;
+    } else {
+        f->last = b->prev;
+    }
+    b->prev = b->next = NULL;
+}
+
+#define VREG_CHUNK 64
+
+int
+ir_new_vreg(IR_Func *f)
+{
+    int v = ++f->nvregs;
+
+    if (v >= f->vreg_size) {
+        int i, size = f->vreg_size+VREG_CHUNK;
+        f->phys = xrealloc(f->phys, size*sizeof(int));
+        for (i = f->vreg_size; i < size; i++) {
+            f->phys[i] = -1;
+        }
+        f->vreg_size = size;
+    }
+    return v;
+}
+
+int
+ir_new_label(void)
+{
+    return ir_label++;
+}
+
+IR_Insn*
+ir_new_insn(int op)
+{
+    IR_Insn *i;
+
+    i = xcalloc(1, sizeof(IR_Insn));
+    i->op = op;
+    return i;
+}
+
+void
+ir_append(IR_Block *b, IR_Insn *i)
+{
+    i->block = b;
+    i->next = NULL;
+    i->prev = b->tail;
+    if (b->tail != NULL) {
+        b->tail->next = i;
+    } else {
+        b->head = i;
+    }
+    b->tail = i;
+}
+
+void
+ir_insert_before(IR_Insn *pos, IR_Insn *i)
+{
+    IR_Block *b = pos->block;
+
+    i->block = b;
+    i->next = pos;
+    i->prev = pos->prev;
+    if (pos->prev != NULL) {
+        pos->prev->next = i;
+    } else {
+        b->head = i;
+    }
+    pos->prev = i;
+}
+
+void
+ir_insert_after(IR_Insn *pos, IR_Insn *i)
+{
+    IR_Block *b = pos->block;
+
+    i->block = b;
+    i->prev = pos;
+    i->next = pos->next;
+    if (pos->next != NULL) {
+        pos->next->prev = i;
+    } else {
+        b->tail = i;
+    }
+    pos->next = i;
+}
+
+void
+ir_remove(IR_Insn *i)
+{
+    IR_Block *b = i->block;
+
+    if (i->prev != NULL) {
+        i->prev->next = i->next;
+    } else {
+        b->head = i->next;
+    }
+    if (i->next != NULL) {
+        i->next->prev = i->prev;
+    } else {
+        b->tail = i->prev;
+    }
+    i->prev = i->next = NULL;
+    i->block = NULL;
+}
+
+IR_Insn*
+ir_terminator(IR_Block *b)
+{
+    if (b->tail != NULL && IR_IS_TERMINATOR(b->tail->op)) {
+        return b->tail;
+    }
+    return NULL;
+}
+
+int
+ir_num_uses(IR_Insn *i)
+{
+    switch (i->op) {
+    case  IR_PHI:
+        return i->nphi;
+    case  IR_STORE:
+    case  IR_MOV:
+    case  IR_NEG:
+    case  IR_SHR:
+    case  IR_ARG:
+        return 1;
+    case  IR_RET:
+        return i->src[0] != 0 ? 1 : 0;
+    case  IR_ADD:
+    case  IR_SUB:
+    case  IR_MUL:
+    case  IR_DIV:
+    case  IR_SETCC:
+        return 2;
+    case  IR_BR:
+        return i->cond != 0 ? 2 : 1;
+    default:
+        return 0;
+    }
+}
+
+int*
+ir_use(IR_Insn *i, int k)
+{
+    if (i->op == IR_PHI) {
+        return &i->phi_src[k];
+    }
+    return &i->src[k];
+}
+
+static void add_edge(IR_Block *from, IR_Block *to);
+
+void
+add_edge(IR_Block *from, IR_Block *to)
+{
+    from->succ[from->nsucc++] = to;
+    to->pred = xrealloc(to->pred, (to->npred+1)*sizeof(IR_Block*));
+    to->pred[to->npred++] = from;
+}
+
+void
+ir_build_cfg(IR_Func *f)
+{
+    IR_Block *b;
+    IR_Insn *t;
+
+    FOR_EACH_BLOCK(b, f) {
+        b->nsucc = 0;
+        b->npred = 0;
+    }
+    FOR_EACH_BLOCK(b, f) {
+        if ((t = ir_terminator(b)) == NULL) {
+            if (b != f->exit) {
+                errexit("Basic block without terminator.", __FILE__, __LINE__);
+            }
+            continue;
+        }
+        switch (t->op) {
+        case  IR_JMP:
+            add_edge(b, t->target[0]);
+            break;
+        case  IR_BR:
+            add_edge(b, t->target[0]);
+            if (t->target[1] != t->target[0]) {
+                add_edge(b, t->target[1]);
+            }
+            break;
+        case  IR_RET:
+        case  IR_TAILCALL:
+            add_edge(b, f->exit);
+            break;
+        }
+    }
+}
+
+void
+ir_remove_unreachable(IR_Func *f)
+{
+    int  k, j, n, *mark;
+    IR_Block *b, *next, **stack;
+    IR_Insn *i;
+
+    mark = xcalloc(f->nblocks, sizeof(int));
+    stack = xmalloc(f->nblocks*sizeof(IR_Block*));
+    n = 0;
+    stack[n++] = f->first;
+    mark[f->first->id] = 1;
+    while (n > 0) {
+        b = stack[--n];
+        for (k = 0; k < b->nsucc; k++) {
+            if (!mark[b->succ[k]->id]) {
+                mark[b->succ[k]->id] = 1;
+                stack[n++] = b->succ[k];
+            }
+        }
+    }
+    for (b = f->first; b != NULL; b = next) {
+        next = b->next;
+        if (mark[b->id] || b == f->exit) {
+            continue;
+        }
+        /* 後続のphiから消えるブロックの分を除く
+           Drop the operands for the removed block from successors' phis */
+        for (k = 0; k < b->nsucc; k++) {
+            FOR_EACH_INSN(i, b->succ[k]) {
+                if (i->op != IR_PHI) {
+                    break;
+                }
+                for (j = 0; j < i->nphi; j++) {
+                    if (i->phi_blk[j] == b) {
+                        i->phi_blk[j] = i->phi_blk[i->nphi-1];
+                        i->phi_src[j] = i->phi_src[i->nphi-1];
+                        i->nphi--;
+                        break;
+                    }
+                }
+            }
+        }
+        ir_unplace_block(f, b);
+    }
+    free(stack);
+    free(mark);
+    ir_build_cfg(f);
+}
+
+IR_Block*
+ir_split_edge(IR_Func *f, IR_Block *from, IR_Block *to)
+{
+    int  k;
+    IR_Block *n;
+    IR_Insn *t, *i;
+
+    n = ir_new_block(f);
+    t = ir_terminator(from);
+    for (k = 0; k < 2; k++) {
+        if (t->target[k] == to) {
+            t->target[k] = n;
+        }
+    }
+    i = ir_new_insn(IR_JMP);
+    i->target[0] = to;
+    ir_append(n, i);
+    FOR_EACH_INSN(i, to) {
+        if (i->op != IR_PHI) {
+            break;
+        }
+        for (k = 0; k < i->nphi; k++) {
+            if (i->phi_blk[k] == from) {
+                i->phi_blk[k] = n;
+            }
+        }
+    }
+    /* 落ちる側なら直後に、飛ぶ側なら末尾に置いて分岐を増やさない
+       Place it just after "from" on the fall-through side, otherwise
+       at the end, so that no extra jump is needed on the other path */
+    if (t->op == IR_JMP || t->target[0] == n) {
+        ir_place_block_after(f, from, n);
+    } else {
+        ir_place_block_after(f, f->exit->prev, n);
+    }
+    ir_build_cfg(f);
+    return n;
+}
+
+IR_Insn*
+ir_call_begin(IR_Insn *call, int *args)
+{
+    int  depth;
+    IR_Insn *i;
+
+    depth = 0;
+    for (i = call->prev; i != NULL; i = i->prev) {
+        if (i->op == IR_CALL) {
+            depth++;
+        } else if (i->op == IR_CALL_BEGIN) {
+            if (depth == 0) {
+                return i;
+            }
+            depth--;
+        } else if (i->op == IR_ARG && depth == 0 && args != NULL) {
+            args[i->imm] = i->src[0];
+        }
+    }
+    return NULL;
+}
+
+void
+ir_remove_call_args(IR_Insn *begin, IR_Insn *call)
+{
+    int  depth;
+    IR_Insn *i, *next;
+
+    depth = 0;
+    for (i = begin; i != call; i = next) {
+        next = i->next;
+        if (i->op == IR_CALL) {
+            depth--;
+        } else if (i->op == IR_CALL_BEGIN) {
+            depth++;
+        }
+        if (i == begin || (i->op == IR_ARG && depth == 1)) {
+            ir_remove(i);
+        }
+    }
+}
+
+int*
+ir_use_counts(IR_Func *f)
+{
+    int  k, *uses;
+    IR_Block *b;
+    IR_Insn *i;
+
+    uses = xcalloc(f->nvregs+1, sizeof(int));
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            for (k = 0; k < ir_num_uses(i); k++) {
+                uses[*ir_use(i, k)]++;
+            }
+        }
+    }
+    return uses;
+}
+
+int
+ir_count_insns(IR_Func *f)
+{
+    int  n;
+    IR_Block *b;
+    IR_Insn *i;
+
+    n = 0;
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            n++;
+        }
+    }
+    return n;
+}
+
+void
+ir_replace_vreg(IR_Func *f, int from, int to)
+{
+    int  k;
+    IR_Block *b;
+    IR_Insn *i;
+
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            for (k = 0; k < ir_num_uses(i); k++) {
+                if (*ir_use(i, k) == from) {
+                    *ir_use(i, k) = to;
+                }
+            }
+        }
+    }
+}
+
+int
+ir_swap_cond(int cond)
+{
+    switch (cond) {
+    case  AST_EXP_LT:
+        return AST_EXP_GT;
+    case  AST_EXP_GT:
+        return AST_EXP_LT;
+    case  AST_EXP_LTE:
+        return AST_EXP_GTE;
+    case  AST_EXP_GTE:
+        return AST_EXP_LTE;
+    default:
+        return cond;
+    }
+}
+
+int
+ir_negate_cond(int cond)
+{
+    switch (cond) {
+    case  AST_EXP_LT:
+        return AST_EXP_GTE;
+    case  AST_EXP_GT:
+        return AST_EXP_LTE;
+    case  AST_EXP_LTE:
+        return AST_EXP_GT;
+    case  AST_EXP_GTE:
+        return AST_EXP_LT;
+    case  AST_EXP_EQ:
+        return AST_EXP_NE;
+    case  AST_EXP_NE:
+        return AST_EXP_EQ;
+    default:
+        return cond;
+    }
+}
+
+static const char ir_op_names[][12] = {
+    "nop",          /* IR_NOP        */
+    "const",        /* IR_CONST      */
+    "load",         /* IR_LOAD       */
+    "store",        /* IR_STORE      */
+    "mov",          /* IR_MOV        */
+    "neg",          /* IR_NEG        */
+    "add",          /* IR_ADD        */
+    "sub",          /* IR_SUB        */
+    "mul",          /* IR_MUL        */
+    "div",          /* IR_DIV        */
+    "shr",          /* IR_SHR        */
+    "set",          /* IR_SETCC      */
+    "call_begin",   /* IR_CALL_BEGIN */
+    "arg",          /* IR_ARG        */
+    "call",         /* IR_CALL       */
+    "param",        /* IR_PARAM      */
+    "phi",          /* IR_PHI        */
+    "jmp",          /* IR_JMP        */
+    "br",           /* IR_BR         */
+    "ret",          /* IR_RET        */
+    "tailcall"      /* IR_TAILCALL   */
+};
+
+static const char *cond_name(int cond);
+static void dump_ir_insn(IR_Insn *i);
+
+const char*
+ir_op_name(int op)
+{
+    return ir_op_names[op];
+}
+
+const char*
+cond_name(int cond)
+{
+    switch (cond) {
+    case  AST_EXP_LT:  return "lt";
+    case  AST_EXP_GT:  return "gt";
+    case  AST_EXP_LTE: return "le";
+    case  AST_EXP_GTE: return "ge";
+    case  AST_EXP_EQ:  return "eq";
+    case  AST_EXP_NE:  return "ne";
+    default:           return "nz";
+    }
+}
+
+void
+dump_ir_insn(IR_Insn *i)
+{
+    int k;
+
+    fputs("    ", stderr);
+    if (i->dst != 0) {
+        fprintf(stderr, "v%d = ", i->dst);
+    }
+    fputs(ir_op_name(i->op), stderr);
+    switch (i->op) {
+    case  IR_CONST:
+        fprintf(stderr, " %d", i->imm);
+        break;
+    case  IR_LOAD:
+        fprintf(stderr, " %s", i->sym->ident);
+        break;
+    case  IR_STORE:
+        fprintf(stderr, " %s, v%d", i->sym->ident, i->src[0]);
+        break;
+    case  IR_SETCC:
+        fprintf(stderr, ".%s v%d, v%d", cond_name(i->cond), i->src[0], i->src[1]);
+        break;
+    case  IR_SHR:
+        fprintf(stderr, " v%d, %d", i->src[0], i->imm);
+        break;
+    case  IR_CALL_BEGIN:
+    case  IR_PARAM:
+        fprintf(stderr, " %d", i->imm);
+        break;
+    case  IR_ARG:
+        fprintf(stderr, " %d, v%d", i->imm, i->src[0]);
+        break;
+    case  IR_CALL:
+    case  IR_TAILCALL:
+        fprintf(stderr, " %s/%d", i->name, i->imm);
+        break;
+    case  IR_PHI:
+        for (k = 0; k < i->nphi; k++) {
+            fprintf(stderr, "%s [v%d, B%d]",
+                    k == 0 ? "" : ",", i->phi_src[k], i->phi_blk[k]->id);
+        }
+        break;
+    case  IR_JMP:
+        fprintf(stderr, " B%d", i->target[0]->id);
+        break;
+    case  IR_BR:
+        if (i->cond != 0) {
+            fprintf(stderr, ".%s v%d, v%d", cond_name(i->cond),
+                    i->src[0], i->src[1]);
+        } else {
+            fprintf(stderr, ".nz v%d", i->src[0]);
+        }
+        fprintf(stderr, ", B%d, B%d", i->target[0]->id, i->target[1]->id);
+        break;
+    case  IR_RET:
+        if (i->src[0] != 0) {
+            fprintf(stderr, " v%d", i->src[0]);
+        }
+        break;
+    default:
+        for (k = 0; k < ir_num_uses(i); k++) {
+            fprintf(stderr, "%s v%d", k == 0 ? "" : ",", *ir_use(i, k));
+        }
+    }
+    fputs("\n", stderr);
+}
+
+void
+dump_ir(IR_Func *f)
+{
+    int k;
+    IR_Block *b;
+    IR_Insn *i;
+
+    fprintf(stderr, "ir %s(", f->name);
+    for (k = 0; k < f->nparams; k++) {
+        fprintf(stderr, "%s%s", k == 0 ? "" : ", ", f->params[k]->ident);
+    }
+    fputs(")\n", stderr);
+    FOR_EACH_BLOCK(b, f) {
+        fprintf(stderr, "  B%d", b->id);
+        if (b->label >= 0) {
+            fprintf(stderr, " (.L%d)", b->label);
+        }
+        if (b == f->exit) {
+            fputs(" (exit)", stderr);
+        }
+        fputs(":", stderr);
+        if (b->npred > 0) {
+            fputs(" preds", stderr);
+            for (k = 0; k < b->npred; k++) {
+                fprintf(stderr, " B%d", b->pred[k]->id);
+            }
+        }
+        fputs("\n", stderr);
+        FOR_EACH_INSN(i, b) {
+            dump_ir_insn(i);
+        }
+    }
+    fputs("\n", stderr);
+}
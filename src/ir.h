@@ -0,0 +1,196 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    中間表現 / intermediate representation
+
+    ASTとアーキテクチャ依存部の間に置く三番地コード。
+    命令は仮想レジスタ（1から、0は「なし」）を読み書きし、基本ブロックに
+    並べられる。基本ブロックは関数ごとに制御フローグラフ(CFG)を構成する。
+    Three-address code placed between the AST and the architecture
+    dependent parts.  Instructions read and write virtual registers
+    (numbered from 1, 0 means "none") and are grouped into basic blocks,
+    which form a control-flow graph (CFG) for each function.
+*/
+
+#ifndef  IR_H
+#define  IR_H
+
+#include  <stdio.h>
+#include  "ast.h"
+#include  "symtab.h"
+
+/* IR命令の種別 / IR opcodes */
+enum {
+    IR_NOP,
+    IR_CONST,         /* dst = imm */
+    IR_LOAD,          /* dst = sym (スタック上の変数 / variable in the stack) */
+    IR_STORE,         /* sym = src[0] */
+    IR_MOV,           /* dst = src[0] */
+    IR_NEG,           /* dst = -src[0] */
+    IR_ADD,           /* dst = src[0] + src[1] */
+    IR_SUB,           /* dst = src[0] - src[1] */
+    IR_MUL,           /* dst = src[0] * src[1] */
+    IR_DIV,           /* dst = src[0] / src[1] */
+    IR_SHR,           /* dst = src[0] >> imm (論理シフト / logical shift) */
+    IR_SETCC,         /* dst = src[0] cond src[1] */
+    IR_CALL_BEGIN,    /* 関数呼び出し列の開始 / start of a call sequence (imm: number of args) */
+    IR_ARG,           /* 第imm引数 = src[0] / argument #imm = src[0] */
+    IR_CALL,          /* dst = name(...) (imm: number of args, dst 0: value unused) */
+    IR_PARAM,         /* dst = 第imm仮引数 / formal parameter #imm */
+    IR_PHI,           /* dst = phi(phi_src[i] from phi_blk[i]) */
+    /* 以下はブロック末尾の命令 / terminators */
+    IR_JMP,           /* goto target[0] */
+    IR_BR,            /* if (src[0] cond src[1]) target[0] else target[1]
+                         cond 0: if (src[0] != 0) */
+    IR_RET,           /* return src[0] (0: no value), then go to the exit block */
+    IR_TAILCALL       /* フレームを再利用してname(...)の値を返す
+                         return name(...) reusing the frame (imm: number of args) */
+};
+
+typedef struct IR_Insn {
+    int  op;
+    int  dst;                   /* 定義する仮想レジスタ / defined register */
+    int  src[2];                /* 参照する仮想レジスタ / used registers */
+    int  imm;
+    int  cond;                  /* AST_EXP_LT, ..., AST_EXP_NE or 0 */
+    struct SymTab   *sym;       /* IR_LOAD, IR_STORE */
+    char *name;                 /* IR_CALL */
+    struct IR_Block *target[2]; /* IR_JMP, IR_BR */
+    int  nphi;                  /* IR_PHI: number of incoming values */
+    int  *phi_src;
+    struct IR_Block **phi_blk;
+    int  mark;                  /* 解析用の印 / mark for analyses */
+    unsigned int save;          /* IR_CALL: 前後で退避するレジスタの集合 (regalloc.c)
+                                   IR_CALL: set of registers saved around it (regalloc.c) */
+    struct IR_Block *block;     /* 所属ブロック / containing block */
+    struct IR_Insn  *prev;
+    struct IR_Insn  *next;
+} IR_Insn;
+
+typedef struct IR_Block {
+    int  id;                    /* 関数内の通し番号 / serial number in a function */
+    int  label;                 /* ラベル番号 (-1: なし) / label number (-1: none) */
+    int  unroll;                /* ループヘッダの#pragma unroll(N) (0: なし)
+                                   #pragma unroll(N) on a loop header (0: none) */
+    IR_Insn *head;
+    IR_Insn *tail;
+    int  npred;
+    struct IR_Block **pred;
+    int  nsucc;
+    struct IR_Block *succ[2];
+    struct IR_Block *prev;      /* 配置順 / layout order */
+    struct IR_Block *next;
+    /* 支配木 (dom.c) / dominator tree (dom.c) */
+    int  rpo;                   /* 逆後順の番号 (-1: 到達不能) / reverse postorder (-1: unreachable) */
+    struct IR_Block *idom;
+    struct IR_Block *dom_child;
+    struct IR_Block *dom_sibling;
+    int  dom_pre;
+    int  dom_post;
+    void *aux;                  /* 解析用 / for analyses */
+} IR_Block;
+
+typedef struct IR_Func {
+    char *name;
+    int  id;                    /* シンボルテーブルのid / id of the symbol table */
+    int  nparams;
+    struct SymTab **params;
+    IR_Block *first;            /* 配置順の先頭（入口）/ first in layout (entry) */
+    IR_Block *last;
+    IR_Block *exit;             /* 唯一の出口（末尾に配置）/ unique exit, placed last */
+    int  nblocks;               /* 割り当てたブロック番号の数 / number of block ids */
+    int  nvregs;                /* 割り当てた仮想レジスタの数 / number of registers */
+    int  vreg_size;
+    int  *phys;                 /* 仮想レジスタ -> 物理レジスタ (-1: 未割り付け)
+                                   virtual -> physical register (-1: none) */
+    unsigned int callee_saved;  /* 使う呼び出し先退避レジスタの集合 (regalloc.c)
+                                   set of callee-saved registers used (regalloc.c) */
+    int  nrpo;                  /* 到達可能なブロック数 / number of reachable blocks */
+    IR_Block **rpo;             /* 逆後順 (dom.c) / reverse postorder (dom.c) */
+    int  pure;                  /* 副作用がなければ1 (pure.c) / 1 if free of side effects (pure.c) */
+    struct IR_Func *origin;     /* 複製元 (ipcp.c) / function cloned from (ipcp.c) */
+    int  reachable;             /* mainなどから呼ばれ得れば1 (cg.c) / 1 if callable from main etc. (cg.c) */
+    struct IR_Func *next;
+} IR_Func;
+
+/* 関数のIRのリスト（ソース上の順）/ IR of functions in source order */
+extern IR_Func *IR_funcs;
+
+#define  IR_IS_TERMINATOR(op)  ((op) == IR_JMP || (op) == IR_BR || (op) == IR_RET \
+                               || (op) == IR_TAILCALL)
+
+#define  FOR_EACH_BLOCK(B, F) \
+    for ((B) = (F)->first; (B) != NULL; (B) = (B)->next)
+#define  FOR_EACH_INSN(I, B) \
+    for ((I) = (B)->head; (I) != NULL; (I) = (I)->next)
+
+extern IR_Func  *ir_new_func(const char *name, int id);
+/* 名前がnameの関数 (put_intなどはNULL) / function named name (NULL for put_int etc.) */
+extern IR_Func  *ir_find_func(const char *name);
+extern IR_Block *ir_new_block(IR_Func *f);
+extern void ir_place_block(IR_Func *f, IR_Block *b);
+extern void ir_place_block_after(IR_Func *f, IR_Block *pos, IR_Block *b);
+extern void ir_unplace_block(IR_Func *f, IR_Block *b);
+extern int  ir_new_vreg(IR_Func *f);
+extern int  ir_new_label(void);
+
+extern IR_Insn *ir_new_insn(int op);
+extern void ir_append(IR_Block *b, IR_Insn *i);
+extern void ir_insert_before(IR_Insn *pos, IR_Insn *i);
+extern void ir_insert_after(IR_Insn *pos, IR_Insn *i);
+extern void ir_remove(IR_Insn *i);
+extern IR_Insn *ir_terminator(IR_Block *b);
+
+/* 命令が参照する仮想レジスタの数とk番目へのポインタ
+   Number of registers used by an instruction and a pointer to the k-th one */
+extern int  ir_num_uses(IR_Insn *i);
+extern int  *ir_use(IR_Insn *i, int k);
+
+/* 末尾命令から後続・先行ブロックを求め直す
+   Recompute successors and predecessors from the terminators */
+extern void ir_build_cfg(IR_Func *f);
+
+/* 入口から到達できないブロックを取り除く（出口は残す）
+   Remove blocks unreachable from the entry (except the exit) */
+extern void ir_remove_unreachable(IR_Func *f);
+
+/* 辺from->toの途中にブロックを挿入して返す
+   Insert a new block on the edge from->to and return it */
+extern IR_Block *ir_split_edge(IR_Func *f, IR_Block *from, IR_Block *to);
+
+/* callに対応するIR_CALL_BEGIN（同じブロックになければNULL）。argsが
+   NULLでなければ第k引数の値をargs[k]に入れる
+   The IR_CALL_BEGIN matching call (NULL if not in the same block).
+   If args is not NULL, args[k] receives the value of argument #k */
+extern IR_Insn *ir_call_begin(IR_Insn *call, int *args);
+
+/* 呼び出しのIR_CALL_BEGINと、入れ子の呼び出しのものを除くIR_ARGを
+   取り除く / Remove the IR_CALL_BEGIN and the IR_ARGs of a call,
+   leaving those of nested calls */
+extern void ir_remove_call_args(IR_Insn *begin, IR_Insn *call);
+
+/* 仮想レジスタごとの参照の数（呼び出し側でfreeする）
+   Number of uses of each register (to be freed by the caller) */
+extern int  *ir_use_counts(IR_Func *f);
+
+/* 関数の命令数 / number of instructions in a function */
+extern int  ir_count_insns(IR_Func *f);
+
+/* 仮想レジスタfromの参照をすべてtoに置き換える
+   Replace all uses of register "from" with "to" */
+extern void ir_replace_vreg(IR_Func *f, int from, int to);
+
+/* 被演算子を入れ替えたときの比較 (a < b -> b > a)
+   Comparison with the operands swapped (a < b -> b > a) */
+extern int  ir_swap_cond(int cond);
+
+/* 否定した比較 (a < b -> a >= b) / negated comparison (a < b -> a >= b) */
+extern int  ir_negate_cond(int cond);
+
+extern const char *ir_op_name(int op);
+extern void dump_ir(IR_Func *f);
+
+/* ASTからIRを作る / build IR from AST (ir_build.c) */
+extern void build_ir(void);
+
+#endif	/* IR_H */
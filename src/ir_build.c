@@ -0,0 +1,456 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    ASTからIRへの変換 / translation from AST to IR
+
+    命令の並びとラベル番号はcg.cが以前ASTから直接生成していたコードと
+    同じ順序になるようにしている。各仮想レジスタには元のASTノードに
+    割り付けたレジスタを初期値として記録する（-O0ではそのまま使う）。
+    The order of instructions and label numbers follows the code that
+    cg.c used to generate directly from the AST.  Each virtual register
+    records the register assigned to its AST node as the initial
+    assignment, which is used as is at -O0.
+*/
+
+#include  <assert.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ast.h"
+#include  "ir.h"
+#include  "parse_action.h"
+#include  "symtab.h"
+#include  "util.h"
+
+static IR_Func  *cur_func;	/* 処理中の関数 / function under construction */
+static IR_Block *cur_block;	/* 命令の追加先 / block to append instructions */
+
+static IR_Func *build_func(AST_Node *f);
+static IR_Block *new_label_block(void);
+static void start_block(IR_Block *b);
+static int  new_vreg(AST_Node *e);
+static IR_Insn *emit(int op, int dst, int src0, int src1);
+static void emit_jmp(IR_Block *target);
+static void build_stm(AST_Node *s);
+static void build_stm_if(AST_Node *s);
+static void build_stm_while(AST_Node *s);
+static void build_stm_for(AST_Node *s);
+static void build_stm_dowhile(AST_Node *s);
+static void build_stm_return(AST_Node *s);
+static void build_cond(AST_Node *e, IR_Block *t, IR_Block *f);
+static void build_children(AST_Node *e, int v[]);
+static int  build_exp(AST_Node *e);
+static int  build_exp_call(AST_Node *e, int use);
+static int  build_exp_n2(AST_Node *e);
+
+void
+build_ir(void)
+{
+    AST_List *l;
+    IR_Func  *f, **tail;
+
+    tail = &IR_funcs;
+    TRAVERSE_AST_LIST(l, AST_root, {
+        f = build_func(l->elem);
+        *tail = f;
+        tail = &f->next;
+    });
+}
+
+IR_Func*
+build_func(AST_Node *f)
+{
+    int  i;
+    AST_List *l;
+    IR_Func *func;
+
+    assert(f->child[0]->sub_kind == AST_EXP_IDENT);
+    func = cur_func = ir_new_func(f->child[0]->str, f->id);
+    TRAVERSE_AST_LIST(l, f->list, func->nparams++);
+    func->params = xcalloc(func->nparams+1, sizeof(SymTab*));
+    i = 0;
+    TRAVERSE_AST_LIST(l, f->list, func->params[i++] = l->elem->child[0]->symtab);
+
+    start_block(ir_new_block(func));
+    func->exit = ir_new_block(func);
+    TRAVERSE_AST_LIST(l, f->child[1]->list, build_stm(l->elem));
+    emit_jmp(func->exit);
+    ir_place_block(func, func->exit);
+    ir_build_cfg(func);
+    /* 実引数の一時変数の分だけフレームを取り直す / Make room for the argument temporaries */
+    reassign_memory(func->id);
+
+    cur_func = NULL;
+    cur_block = NULL;
+    return func;
+}
+
+/* 分岐先になるブロック。ラベル番号は作成時に決める
+   A block to be a branch target.  Its label is numbered on creation. */
+IR_Block*
+new_label_block(void)
+{
+    IR_Block *b = ir_new_block(cur_func);
+    b->label = ir_new_label();
+    return b;
+}
+
+/* bを配置して以降の命令の追加先にする
+   Place b and make it the destination of the following instructions */
+void
+start_block(IR_Block *b)
+{
+    ir_place_block(cur_func, b);
+    cur_block = b;
+}
+
+int
+new_vreg(AST_Node *e)
+{
+    int v = ir_new_vreg(cur_func);
+    cur_func->phys[v] = e->reg;
+    return v;
+}
+
+IR_Insn*
+emit(int op, int dst, int src0, int src1)
+{
+    IR_Insn *i = ir_new_insn(op);
+
+    i->dst = dst;
+    i->src[0] = src0;
+    i->src[1] = src1;
+    ir_append(cur_block, i);
+    if (IR_IS_TERMINATOR(op)) {
+        /* 後続の命令（到達不能でも）は新しいブロックに置く
+           Following instructions, even if unreachable, go to a new block */
+        start_block(ir_new_block(cur_func));
+    }
+    return i;
+}
+
+void
+emit_jmp(IR_Block *target)
+{
+    IR_Insn *i = ir_new_insn(IR_JMP);
+
+    i->target[0] = target;
+    ir_append(cur_block, i);
+    cur_block = NULL;
+}
+
+void
+build_stm(AST_Node *s)
+{
+    AST_List *l;
+
+    if (s == NULL) {
+        return;
+    }
+    switch (s->sub_kind) {
+    case  AST_STM_LIST:
+        TRAVERSE_AST_LIST(l, s->list, build_stm(l->elem));
+        break;
+    case  AST_STM_DEC:
+        /* Nothing to do */
+        break;
+    case  AST_STM_ASIGN:
+        if (s->child[0] != NULL && s->child[0]->sub_kind == AST_EXP_CALL) {
+            build_exp_call(s->child[0], 0);
+        } else {
+            build_exp(s->child[0]);
+        }
+        break;
+    case  AST_STM_IF:
+        build_stm_if(s);
+        break;
+    case  AST_STM_WHILE:
+        build_stm_while(s);
+        break;
+    case  AST_STM_FOR:
+        build_stm_for(s);
+        break;
+    case  AST_STM_DOWHILE:
+        build_stm_dowhile(s);
+        break;
+    case  AST_STM_RETURN:
+        build_stm_return(s);
+        break;
+    default:
+        errexit("Invalid statement kind", __FILE__, __LINE__);
+    }
+}
+
+void
+build_stm_if(AST_Node *s)
+{
+    IR_Block *l_else = NULL, *l_end, *l_cmp, *l_then;
+
+    l_cmp = l_end = new_label_block();
+    if (s->child[2] != NULL) { /* else */
+        l_cmp = l_else = new_label_block();
+    }
+    l_then = ir_new_block(cur_func);
+
+    build_cond(s->child[0], l_then, l_cmp);
+    start_block(l_then);
+    build_stm(s->child[1]);
+    if (s->child[2] != NULL) {
+        emit_jmp(l_end);
+        start_block(l_else);
+        build_stm(s->child[2]);
+    }
+    emit_jmp(l_end);
+    start_block(l_end);
+}
+
+void
+build_stm_while(AST_Node *s)
+{
+    IR_Block *l_begin, *l_exit, *body;
+
+    l_begin = new_label_block();
+    l_exit = new_label_block();
+    body = ir_new_block(cur_func);
+    l_begin->unroll = take_loop_pragma();
+    emit_jmp(l_begin);
+    start_block(l_begin);
+    build_cond(s->child[0], body, l_exit);
+    start_block(body);
+    build_stm(s->child[1]);
+    emit_jmp(l_begin);
+    start_block(l_exit);
+}
+
+void
+build_stm_for(AST_Node *s)
+{
+    IR_Block *l_begin, *l_exit, *body;
+
+    l_begin = new_label_block();
+    l_exit = new_label_block();
+    body = ir_new_block(cur_func);
+    l_begin->unroll = take_loop_pragma();
+    build_exp(s->child[0]);
+    emit_jmp(l_begin);
+    start_block(l_begin);
+    build_cond(s->child[1], body, l_exit);
+    start_block(body);
+    build_stm(s->child[3]);
+    build_exp(s->child[2]);
+    emit_jmp(l_begin);
+    start_block(l_exit);
+}
+
+void
+build_stm_dowhile(AST_Node *s)
+{
+    IR_Block *l_begin, *l_exit;
+
+    l_begin = new_label_block();
+    l_exit = new_label_block();
+    l_begin->unroll = take_loop_pragma();
+    emit_jmp(l_begin);
+    start_block(l_begin);
+    build_stm(s->child[0]);
+    take_loop_pragma();		/* 末尾のwhile / the trailing while */
+    build_cond(s->child[1], l_begin, l_exit);
+    start_block(l_exit);
+}
+
+void
+build_stm_return(AST_Node *s)
+{
+    emit(IR_RET, 0, build_exp(s->child[0]), 0);
+}
+
+/*
+ * 条件式eが真ならt、偽ならfに分岐する
+ * 比較演算子は値にせずそのまま分岐命令の条件にする
+ * Branch to t if e is true, otherwise to f.
+ * A relational operator becomes the condition of the branch
+ * instead of a value.
+ */
+void
+build_cond(AST_Node *e, IR_Block *t, IR_Block *f)
+{
+    int  v[2];
+    IR_Insn *br;
+
+    br = ir_new_insn(IR_BR);
+    switch (e->sub_kind) {
+    case  AST_EXP_LT:
+    case  AST_EXP_GT:
+    case  AST_EXP_LTE:
+    case  AST_EXP_GTE:
+    case  AST_EXP_EQ:
+    case  AST_EXP_NE:
+        build_children(e, v);
+        br->cond = e->sub_kind;
+        br->src[0] = v[0];
+        br->src[1] = v[1];
+        break;
+    default:
+        br->src[0] = build_exp(e);
+    }
+    br->target[0] = t;
+    br->target[1] = f;
+    ir_append(cur_block, br);
+    cur_block = NULL;
+}
+
+/* レジスタ割り付けと同じ順番で子を評価する
+   Evaluate children in the same order as the register assignment */
+void
+build_children(AST_Node *e, int v[])
+{
+    int  i0, i1, r0, r1;
+
+    r0 = r1 = 0;
+    if (e->child[0] != NULL) {
+        r0 = e->child[0]->rank;
+    }
+    if (e->child[1] != NULL) {
+        r1 = e->child[1]->rank;
+    }
+    if (r0 >= r1) {
+        i0 = 0; i1 = 1;
+    } else {
+        i0 = 1; i1 = 0;
+    }
+    v[0] = v[1] = 0;
+    v[i0] = build_exp(e->child[i0]);
+    v[i1] = build_exp(e->child[i1]);
+}
+
+/* 式の値を持つ仮想レジスタを返す / Return the register holding the value */
+int
+build_exp(AST_Node *e)
+{
+    int  v;
+    IR_Insn *i;
+
+    if (e == NULL) {
+        return 0;
+    }
+    switch (e->sub_kind) {
+    case  AST_EXP_ASGN:
+        v = build_exp(e->child[1]);
+        if (e->child[0]->sub_kind != AST_EXP_IDENT) {
+            errexit("Invalid destination operand for assign.",
+                    __FILE__, __LINE__);
+        }
+        i = emit(IR_STORE, 0, v, 0);
+        i->sym = e->child[0]->symtab;
+        return v;
+    case  AST_EXP_IDENT:
+        v = new_vreg(e);
+        i = emit(IR_LOAD, v, 0, 0);
+        i->sym = e->symtab;
+        return v;
+    case  AST_EXP_CNST_INT:
+        v = new_vreg(e);
+        i = emit(IR_CONST, v, 0, 0);
+        i->imm = e->val;
+        return v;
+    case  AST_EXP_CALL:
+        return build_exp_call(e, 1);
+    default:
+        return build_exp_n2(e);
+    }
+}
+
+/*
+ * 関数呼び出し。useが0なら戻り値は使わない
+ * Function call.  The return value is not used if use is 0.
+ */
+int
+build_exp_call(AST_Node *e, int use)
+{
+    int  n, k, v;
+    AST_List *l;
+    IR_Insn *i;
+    SymTab **tmp;
+
+    assert(e->child[0]->sub_kind == AST_EXP_IDENT);
+    n = 0;
+    TRAVERSE_AST_LIST(l, e->list, ++n);
+    /*
+      呼び出しを含む実引数は呼び出し列の前に評価して一時変数に置く。
+      内側の呼び出しが設定済みの引数レジスタを壊さないようにするため。
+      単純な実引数は従来どおり直接引数レジスタへ渡す。
+      Arguments containing calls are evaluated into temporaries before
+      the call sequence, so that the inner calls do not clobber the
+      argument registers already set. Simple arguments still go
+      directly to the ABI registers.
+    */
+    tmp = xcalloc(n+1, sizeof(SymTab*));
+    k = 0;
+    TRAVERSE_AST_LIST(l, e->list, {
+        if (ast_has_call(l->elem)) {
+            tmp[k] = append_temp_sym(cur_func->id);
+            i = emit(IR_STORE, 0, build_exp(l->elem), 0);
+            i->sym = tmp[k];
+        }
+        k++;
+    });
+    i = emit(IR_CALL_BEGIN, 0, 0, 0);
+    i->imm = n;
+    n = 0;
+    TRAVERSE_AST_LIST(l, e->list, {
+        if (tmp[n] != NULL) {
+            v = new_vreg(l->elem);
+            i = emit(IR_LOAD, v, 0, 0);
+            i->sym = tmp[n];
+        } else {
+            v = build_exp(l->elem);
+        }
+        i = emit(IR_ARG, 0, v, 0);
+        i->imm = ++n;
+    });
+    free(tmp);
+    v = use ? new_vreg(e) : 0;
+    i = emit(IR_CALL, v, 0, 0);
+    i->imm = n;
+    i->name = e->child[0]->str;
+    return v;
+}
+
+int
+build_exp_n2(AST_Node *e)
+{
+    int  v[2], op;
+    IR_Insn *i;
+
+    build_children(e, v);
+    switch (e->sub_kind) {
+    case  AST_EXP_UNARY_PLUS:
+        return v[0];
+    case  AST_EXP_UNARY_MINUS:
+        return emit(IR_NEG, new_vreg(e), v[0], 0)->dst;
+    case  AST_EXP_MUL:
+        op = IR_MUL;
+        break;
+    case  AST_EXP_DIV:
+        op = IR_DIV;
+        break;
+    case  AST_EXP_ADD:
+        op = IR_ADD;
+        break;
+    case  AST_EXP_SUB:
+        op = IR_SUB;
+        break;
+    case  AST_EXP_LT:
+    case  AST_EXP_GT:
+    case  AST_EXP_LTE:
+    case  AST_EXP_GTE:
+    case  AST_EXP_EQ:
+    case  AST_EXP_NE:
+        i = emit(IR_SETCC, new_vreg(e), v[0], v[1]);
+        i->cond = e->sub_kind;
+        return i->dst;
+    default:
+        fprintf(stderr, "Unsupported sub_kind %d\n", e->sub_kind);
+        return 0;
+    }
+    return emit(op, new_vreg(e), v[0], v[1])->dst;
+}
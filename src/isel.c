@@ -0,0 +1,462 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    命令選択 / instruction selection
+
+    命令iの被演算子を定義する命令dは、次のとき木に取り込んでiの位置で
+    計算する。
+    - dの値はiだけが一度使い、同じブロックでiより前にある
+    - dからiまでの間に、木が読むレジスタや木の途中の値のレジスタへの
+      書き込み、木が読む変数への格納、呼び出し列がない
+    定数は位置によらないので、どの参照も即値などとして覆える。参照が
+    すべてそうなれば定数の命令を出さない。
+    An instruction d defining an operand of instruction i is taken into
+    the tree and computed at i when
+    - the value of d is used once, by i, and d is before i in the block
+    - between d and i nothing writes a register the tree reads or keeps
+      an inner value in, nothing stores to a variable the tree reads, and
+      there is no call sequence.
+    Constants don't depend on the position, so any use may cover one as
+    an immediate or the like.  If all the uses do, the constant itself
+    is not emitted.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  "arch_common.h"
+#include  "ir.h"
+#include  "isel.h"
+#include  "opt.h"
+#include  "option.h"
+#include  "util.h"
+
+/* Isel_Node.state */
+enum { NODE_NONE, NODE_ROOT, NODE_FOLDED, NODE_FALLBACK };
+
+static void canonicalize(IR_Insn *i);
+static int  is_const(int v);
+static Isel_Node *new_leaf(IR_Insn *def, int v);
+static int  foldable(IR_Insn *d, IR_Insn *u);
+static unsigned int tree_regs(Isel_Node *n, int top);
+static int  tree_loads(Isel_Node *n, SymTab *sym);
+static void label(Isel_Node *n);
+static void select_root(Isel_Node *n);
+static void mark(Isel_Node *n, int nt);
+static void reduce(FILE *out, Isel_Node *n, int nt);
+
+static IR_Func *cur_func;	/* 選択中の関数 / function being selected */
+static Isel_Node *nodes;	/* 命令ごと（i->markが番号）と葉 / per instruction (i->mark) and leaves */
+static int  nnodes;
+static int  *uses;		/* 仮想レジスタの参照の数 / uses of a register */
+static int  *ndefs;		/* 定義の数 / definitions of a register */
+static IR_Insn **defs;		/* 唯一の定義 / the definition if unique */
+static int  *consumed;		/* 即値などで覆った参照の数 / uses covered as immediates etc. */
+static int  *rule_count;
+
+#define  PHYS(v)  (cur_func->phys[(v)])
+#define  NODE(i)  (&nodes[(i)->mark])
+
+void
+isel_select(IR_Func *f)
+{
+    int  n, k, v, nrules;
+    IR_Block *b;
+    IR_Insn *i, *d;
+    Isel_Node *p;
+
+    cur_func = NULL;
+    if (opt_level == 0 || !flag_isel) {
+        return;
+    }
+    cur_func = f;
+    n = 0;
+    ndefs = xcalloc(f->nvregs+1, sizeof(int));
+    defs = xcalloc(f->nvregs+1, sizeof(IR_Insn*));
+    consumed = xcalloc(f->nvregs+1, sizeof(int));
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            i->mark = n++;
+            if (i->dst != 0) {
+                ndefs[i->dst]++;
+                defs[i->dst] = i;
+            }
+        }
+    }
+    uses = ir_use_counts(f);
+    for (nrules = 0; isel_rules[nrules].name != NULL; nrules++) {
+        ;
+    }
+    rule_count = xcalloc(nrules+1, sizeof(int));
+    /* 葉は命令ごとに高々2つ / at most two leaves per instruction */
+    nodes = xcalloc(3*n+1, sizeof(Isel_Node));
+    nnodes = n;
+
+    /* 命令の順に木を作る。dの取り込みはdの子が決まってから調べる
+       Build the trees in order; d is checked after its kids are decided */
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            canonicalize(i);
+            p = NODE(i);
+            p->insn = i;
+            p->reg = i->dst != 0 ? PHYS(i->dst) : -1;
+            for (k = 0; k < ISEL_MAX_NT; k++) {
+                p->cost[k] = ISEL_INF;
+                p->rule[k] = -1;
+            }
+            for (k = 0; k < 2; k++) {
+                if ((v = i->src[k]) == 0) {
+                    continue;
+                }
+                d = ndefs[v] == 1 ? defs[v] : NULL;
+                if (foldable(d, i)) {
+                    p->kid[k] = NODE(d);
+                    NODE(d)->parent = p;
+                } else {
+                    p->kid[k] = new_leaf(d, v);
+                }
+            }
+        }
+    }
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (NODE(i)->parent == NULL) {
+                select_root(NODE(i));
+            }
+        }
+    }
+}
+
+/*
+  交換できる演算と比較は定数を右に置く。被演算子を入れ替えた比較は
+  条件も入れ替える
+  Commutative operations and comparisons get the constant on the right.
+  A comparison with its operands swapped gets the condition swapped too.
+*/
+void
+canonicalize(IR_Insn *i)
+{
+    int t;
+
+    if (!is_const(i->src[0]) || is_const(i->src[1])) {
+        return;
+    }
+    switch (i->op) {
+    case  IR_SETCC:
+    case  IR_BR:
+        if (i->cond == 0) {
+            return;
+        }
+        i->cond = ir_swap_cond(i->cond);
+        break;
+    case  IR_ADD:
+    case  IR_MUL:
+        break;
+    default:
+        return;
+    }
+    t = i->src[0]; i->src[0] = i->src[1]; i->src[1] = t;
+}
+
+int
+is_const(int v)
+{
+    return v != 0 && ndefs[v] == 1 && defs[v]->op == IR_CONST;
+}
+
+/*
+  取り込まない被演算子の葉。値はレジスタにあり、定数ならその規則でも
+  覆える。定数をレジスタで使う費用はその命令の分とする
+  Leaf for an operand not taken in.  The value is in a register, and a
+  constant may also be covered by its rules.  Using a constant in the
+  register costs its instruction.
+*/
+Isel_Node*
+new_leaf(IR_Insn *def, int v)
+{
+    int  k;
+    Isel_Node *p;
+
+    p = &nodes[nnodes++];
+    p->insn = def != NULL && def->op == IR_CONST ? def : NULL;
+    p->reg = PHYS(v);
+    for (k = 0; k < ISEL_MAX_NT; k++) {
+        p->cost[k] = ISEL_INF;
+        p->rule[k] = -1;
+    }
+    p->cost[ISEL_REG] = p->insn != NULL ? 1 : 0;
+    p->state = NODE_FOLDED;
+    return p;
+}
+
+/* dをuの木に取り込めれば1 / 1 if d can be taken into the tree of u */
+int
+foldable(IR_Insn *d, IR_Insn *u)
+{
+    unsigned int regs;
+    IR_Insn *x;
+
+    if (d == NULL || d->block != u->block || uses[d->dst] != 1) {
+        return 0;
+    }
+    switch (d->op) {
+    case  IR_LOAD:
+    case  IR_NEG:
+    case  IR_ADD:
+    case  IR_SUB:
+    case  IR_MUL:
+    case  IR_SHR:
+    case  IR_SETCC:
+        break;
+    default:
+        return 0;
+    }
+    regs = tree_regs(NODE(d), 1);
+    for (x = d->next; x != u; x = x->next) {
+        if (x == NULL) {
+            return 0;		/* uより後ろ / after u */
+        }
+        switch (x->op) {
+        case  IR_CALL_BEGIN:
+        case  IR_ARG:
+        case  IR_CALL:
+        case  IR_TAILCALL:
+            return 0;
+        case  IR_STORE:
+            if (tree_loads(NODE(d), x->sym)) {
+                return 0;
+            }
+            break;
+        default:
+            break;
+        }
+        if (x->dst != 0 && PHYS(x->dst) >= 0 && (regs >> PHYS(x->dst)) & 1) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+  木が読むレジスタと、根(top)以外の節が書くレジスタの集合。後者は
+  もとの位置より後で書かれることになる
+  Set of registers read by a tree and written by its nodes other than
+  the root (top).  The latter are now written later than they were.
+*/
+unsigned int
+tree_regs(Isel_Node *n, int top)
+{
+    int  k, v;
+    unsigned int regs;
+
+    regs = 0;
+    if (!top && n->reg >= 0) {
+        regs |= 1u << n->reg;
+    }
+    for (k = 0; k < 2; k++) {
+        if ((v = n->insn->src[k]) == 0) {
+            continue;
+        }
+        if (n->kid[k] != NULL && n->kid[k]->parent == n) {
+            regs |= tree_regs(n->kid[k], 0);
+        } else if (PHYS(v) >= 0) {
+            regs |= 1u << PHYS(v);
+        }
+    }
+    return regs;
+}
+
+/* 木が変数symを読めば1 / 1 if a tree reads variable sym */
+int
+tree_loads(Isel_Node *n, SymTab *sym)
+{
+    int  k;
+
+    if (n->insn->op == IR_LOAD && n->insn->sym == sym) {
+        return 1;
+    }
+    for (k = 0; k < 2; k++) {
+        if (n->kid[k] != NULL && n->kid[k]->parent == n
+            && tree_loads(n->kid[k], sym)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* 下から各非終端記号の最小費用を求める / least cost of each nonterminal, bottom-up */
+void
+label(Isel_Node *n)
+{
+    int  k, r, c;
+    const Isel_Rule *p;
+
+    for (k = 0; k < 2; k++) {
+        if (n->kid[k] != NULL) {
+            label(n->kid[k]);
+        }
+    }
+    if (n->insn == NULL) {
+        return;
+    }
+    for (r = 0; isel_rules[r].name != NULL; r++) {
+        p = &isel_rules[r];
+        if (p->op != n->insn->op) {
+            continue;
+        }
+        c = p->cost;
+        for (k = 0; k < 2; k++) {
+            if ((p->kid[k] < 0) != (n->kid[k] == NULL)) {
+                c = ISEL_INF;
+            } else if (p->kid[k] >= 0) {
+                c += n->kid[k]->cost[p->kid[k]];
+            }
+        }
+        if (c < ISEL_INF && p->dcost != NULL) {
+            c += p->dcost(n)-p->cost;
+        }
+        if (c < n->cost[p->nt] && (p->cond == NULL || p->cond(n))) {
+            n->cost[p->nt] = c;
+            n->rule[p->nt] = r;
+        }
+    }
+}
+
+/*
+  nを根として覆う。覆えなければ従来どおりに出力し、取り込むはずだった
+  子はそれぞれ根にする
+  Cover a tree rooted at n.  If it can't be covered, n is emitted as
+  before and the kids that were to be taken in become roots themselves.
+*/
+void
+select_root(Isel_Node *n)
+{
+    int  k, nt;
+
+    label(n);
+    nt = n->insn->dst != 0 ? ISEL_REG : ISEL_STMT;
+    if (n->cost[nt] >= ISEL_INF) {
+        n->state = NODE_FALLBACK;
+        for (k = 0; k < 2; k++) {
+            if (n->kid[k] != NULL && n->kid[k]->parent == n) {
+                n->kid[k]->parent = NULL;
+                select_root(n->kid[k]);
+            }
+        }
+        return;
+    }
+    n->state = NODE_ROOT;
+    mark(n, nt);
+}
+
+/* 選んだ非終端記号を記録し、定数の参照を数える / record the nonterminals chosen and count the uses of constants */
+void
+mark(Isel_Node *n, int nt)
+{
+    int  k, r;
+
+    n->nt = nt;
+    if ((r = n->rule[nt]) < 0) {
+        return;			/* レジスタにある / in a register */
+    }
+    for (k = 0; k < 2; k++) {
+        if (isel_rules[r].kid[k] < 0) {
+            continue;
+        }
+        if (n->kid[k]->parent == n) {
+            n->kid[k]->state = NODE_FOLDED;
+        } else if (n->kid[k]->rule[isel_rules[r].kid[k]] >= 0) {
+            consumed[n->insn->src[k]]++;
+        }
+        mark(n->kid[k], isel_rules[r].kid[k]);
+    }
+}
+
+int
+isel_gen(FILE *out, IR_Insn *i, int aux)
+{
+    Isel_Node *n;
+
+    if (cur_func == NULL) {
+        return 0;
+    }
+    n = NODE(i);
+    switch (n->state) {
+    case  NODE_FOLDED:
+        return 1;
+    case  NODE_ROOT:
+        if (i->op == IR_CONST && consumed[i->dst] == uses[i->dst]) {
+            return 1;		/* 参照はすべて即値 / all uses are immediates */
+        }
+        n->aux = aux;
+        reduce(out, n, n->nt);
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/*
+  即値などとして木に取り込んだ命令と、参照がすべて即値の定数は
+  レジスタに書かない
+  An instruction taken into a tree as an immediate or the like, and a
+  constant all of whose uses are immediates, write no register.
+*/
+int
+isel_writes(IR_Insn *i)
+{
+    Isel_Node *n;
+
+    if (cur_func == NULL) {
+        return 1;
+    }
+    n = NODE(i);
+    switch (n->state) {
+    case  NODE_FOLDED:
+        return n->nt == ISEL_REG;
+    case  NODE_ROOT:
+        return i->op != IR_CONST || consumed[i->dst] != uses[i->dst];
+    default:
+        return 1;
+    }
+}
+
+/* 上から子、自分の順に出力する / emit the kids, then the node, top-down */
+void
+reduce(FILE *out, Isel_Node *n, int nt)
+{
+    int  k, r;
+
+    if ((r = n->rule[nt]) < 0) {
+        return;
+    }
+    rule_count[r]++;
+    for (k = 0; k < 2; k++) {
+        if (isel_rules[r].kid[k] >= 0) {
+            reduce(out, n->kid[k], isel_rules[r].kid[k]);
+        }
+    }
+    if (isel_rules[r].emit != NULL) {
+        isel_rules[r].emit(out, n);
+    }
+}
+
+void
+isel_end(IR_Func *f)
+{
+    int  r;
+
+    if (cur_func == NULL) {
+        return;
+    }
+    for (r = 0; isel_rules[r].name != NULL; r++) {
+        report(f, "isel", rule_count[r], isel_rules[r].name);
+    }
+    free(nodes);
+    free(uses);
+    free(ndefs);
+    free(defs);
+    free(consumed);
+    free(rule_count);
+    cur_func = NULL;
+}
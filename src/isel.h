@@ -0,0 +1,88 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    命令選択 / instruction selection
+
+    基本ブロック内で一度だけ使う値を使う側の命令の木に取り込み、
+    アーキテクチャ依存部の規則表(isel_rules)で木を覆う。覆い方は
+    下から費用が最小のものを求め（BURS）、上から出力する。
+    A value used once in its basic block is taken into the tree of the
+    instruction using it, and the tree is covered with the table of
+    rules in the architecture dependent part (isel_rules).  The cover of
+    least cost is found bottom-up (BURS) and emitted top-down.
+*/
+
+#ifndef  ISEL_H
+#define  ISEL_H
+
+#include  <stdio.h>
+#include  "ir.h"
+
+/* 非終端記号。2以降はアーキテクチャ依存部が決める
+   Nonterminals; those from 2 on are up to the architecture dependent part */
+#define  ISEL_STMT    0		/* 値を残さない命令 / no value left */
+#define  ISEL_REG     1		/* 値がレジスタにある / value in a register */
+#define  ISEL_MAX_NT  8
+#define  ISEL_INF     (1<<24)	/* 導出できない / not derivable */
+
+/* 木の節 / node of a tree */
+typedef struct Isel_Node {
+    IR_Insn *insn;		/* 命令（レジスタの葉はNULL）/ the instruction (NULL for a register leaf) */
+    int  reg;			/* 値の物理レジスタ / physical register of the value */
+    int  nt;			/* 還元する非終端記号 / nonterminal reduced to */
+    int  aux;			/* IR_ARG: スタックで渡す引数の数 / IR_ARG: params in the stack */
+    struct Isel_Node *kid[2];	/* src[0], src[1] */
+    struct Isel_Node *parent;	/* 取り込む先（isel.c内部用）/ tree taking it in (isel.c only) */
+    int  state;			/* isel.c内部用 / isel.c only */
+    int  cost[ISEL_MAX_NT];
+    int  rule[ISEL_MAX_NT];	/* isel_rulesの番号 (-1: レジスタにある) / index in isel_rules (-1: in a register) */
+} Isel_Node;
+
+/*
+  opの節が子からkid[]を導出できればntを導出する。condは子の値などの
+  追加の条件、emitは子を出力した後に呼ばれる（NULLなら何も出さない）。
+  dcostがあれば節ごとにcostの代わりに呼ばれ、ISEL_INFなら導出しない
+  A node of op derives nt if its kids derive kid[] (-1: no kid).  cond
+  is an extra condition such as the value of a kid, and emit is called
+  after the kids are emitted (nothing is emitted if NULL).  If given,
+  dcost is called for each node in place of cost; ISEL_INF means the
+  rule does not apply.
+*/
+typedef struct Isel_Rule {
+    const char *name;
+    int  nt;
+    int  op;
+    int  kid[2];
+    int  cost;
+    int  (*cond)(const Isel_Node *n);
+    void (*emit)(FILE *out, Isel_Node *n);
+    int  (*dcost)(const Isel_Node *n);
+} Isel_Rule;
+
+/* アーキテクチャ依存部の規則表（nameがNULLで終わる）
+   Rules of the architecture dependent part (terminated by a NULL name) */
+extern const Isel_Rule isel_rules[];
+
+/* fの命令を選ぶ。-O0や-fno-iselでは何もしない
+   Select the instructions of f; nothing is done at -O0 or with -fno-isel */
+extern void isel_select(IR_Func *f);
+
+/*
+  iを選んだ規則で出力して1を返す。木に取り込まれた命令は何も出さずに
+  1、選べなかった命令は0を返す（従来どおりに出力する）。IR_BRは比較、
+  IR_RETは戻り値の設定、IR_ARGは引数の設定だけを受け持つ
+  Emit i by the rules selected and return 1.  For an instruction taken
+  into a tree nothing is emitted and 1 is returned; 0 is returned for
+  one not selected, which is emitted as before.  Only the comparison of
+  IR_BR, the return value of IR_RET and the argument of IR_ARG are
+  covered.
+*/
+extern int  isel_gen(FILE *out, IR_Insn *i, int aux);
+
+/* iの出力がデスティネーションのレジスタに書けば1 / 1 if the code for i writes its destination register */
+extern int  isel_writes(IR_Insn *i);
+
+/* fの選択を終える / finish the selection for f */
+extern void isel_end(IR_Func *f);
+
+#endif	/* ISEL_H */
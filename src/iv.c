@@ -0,0 +1,422 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    帰納変数の強さの軽減と除去 / induction variable strength reduction
+    and elimination
+
+    基本帰納変数は、ヘッダのphiで、後退辺から来る値がループ不変な量を
+    足し引きしたものである変数。基本帰納変数iとループ不変なkの積
+    i*k（派生帰納変数）は、初期値init*k、増分step*kの新しい基本帰納
+    変数に置き換えて、ループ内の乗算を加算にする。
+    そのうえで、元の変数が増分と終了判定にしか使われなければ、判定を
+    新しい変数とループ不変な上限n*kの比較に書き換え（kは0以外の定数）、
+    元の変数は不要コード除去に任せる。初期値と増分が同じ基本帰納変数は
+    一つにまとめる。
+    整数は32ビットで桁あふれするので、判定を書き換えるのは初期値、
+    増分、上限が定数で、判定される値とそのk倍がすべてintに収まると
+    分かるときだけにする。
+
+    A basic induction variable is a header phi whose value from the
+    back edge adds or subtracts a loop-invariant amount to it.  The
+    product i*k of a basic induction variable i and an invariant k (a
+    derived induction variable) is replaced with a new basic induction
+    variable starting at init*k and stepping by step*k, turning the
+    multiplication in the loop into an addition.
+    Then if the original variable is used only by its increment and the
+    exit test, the test is rewritten to compare the new variable with
+    the invariant bound n*k (k a non-zero constant), leaving the
+    original variable to dead code elimination.  Basic induction
+    variables with the same start and step are merged.
+    As integers wrap at 32 bits, a test is rewritten only when the start,
+    step and bound are constants and every value tested, and its product
+    with k, are known to fit in an int.
+*/
+
+#include  <limits.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ir.h"
+#include  "opt.h"
+#include  "util.h"
+
+static IR_Func *cur_func;
+static IR_Insn **def;
+static int  def_size;
+
+static void set_def(IR_Insn *i);
+static int  invariant(IR_Loop *l, int v);
+static int  phi_slot(IR_Loop *l, IR_Insn *phi);
+static IR_Insn *iv_next(IR_Loop *l, IR_Insn *phi);
+static IR_Insn *basic_iv(IR_Loop *l, int v, int *is_next);
+static IR_Insn *new_insn(int op, int dst, int a, int b);
+static IR_Insn *reduce(IR_Loop *l, IR_Insn *phi, int k);
+static void replace_test(IR_Loop *l, IR_Insn *phi, IR_Insn *p, int k);
+static int  const_of(int v, long long *c);
+static int  test_fits(IR_Loop *l, IR_Insn *phi, IR_Insn *test, int k);
+static int  count_uses(IR_Insn *i, int v);
+static void merge_ivs(IR_Loop *l);
+static int  precedes(IR_Insn *a, IR_Insn *b);
+
+/* 加算に置き換えた乗算の数を返す / returns the number of multiplications replaced */
+int
+reduce_ivs(IR_Func *f)
+{
+    int  k, s, n, is_next;
+    IR_Block *b;
+    IR_Insn *i, *next, *phi, *p;
+    IR_Loop *loops, *l;
+
+    cur_func = f;
+    loops = find_loops(f);
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            set_def(i);
+        }
+    }
+
+    n = 0;
+    for (l = loops; l != NULL; l = l->next) {
+        for (k = 0; k < l->nblocks; k++) {
+            for (i = l->blocks[k]->head; i != NULL; i = next) {
+                next = i->next;
+                if (i->op != IR_MUL) {
+                    continue;
+                }
+                for (s = 0; s < 2; s++) {
+                    phi = basic_iv(l, i->src[s], &is_next);
+                    if (phi != NULL && invariant(l, i->src[1-s])) {
+                        break;
+                    }
+                }
+                if (s == 2) {
+                    continue;
+                }
+                p = reduce(l, phi, i->src[1-s]);
+                ir_replace_vreg(f, i->dst,
+                                is_next ? iv_next(l, p)->dst : p->dst);
+                ir_remove(i);
+                n++;
+                if (def[i->src[1-s]]->op == IR_CONST && def[i->src[1-s]]->imm != 0) {
+                    replace_test(l, phi, p, i->src[1-s]);
+                }
+            }
+        }
+        merge_ivs(l);
+    }
+
+    free(def);
+    def = NULL;
+    def_size = 0;
+    free_loops(loops);
+    cur_func = NULL;
+    return n;
+}
+
+void
+set_def(IR_Insn *i)
+{
+    int  size;
+
+    if (i->dst == 0) {
+        return;
+    }
+    if (i->dst >= def_size) {
+        size = cur_func->nvregs+64;
+        def = xrealloc(def, size*sizeof(IR_Insn*));
+        while (def_size < size) {
+            def[def_size++] = NULL;
+        }
+    }
+    def[i->dst] = i;
+}
+
+int
+invariant(IR_Loop *l, int v)
+{
+    return v < def_size && def[v] != NULL && !loop_contains(l, def[v]->block);
+}
+
+/* プリヘッダから来る値の位置 / index of the value from the preheader */
+int
+phi_slot(IR_Loop *l, IR_Insn *phi)
+{
+    return phi->phi_blk[0] == l->preheader ? 0 : 1;
+}
+
+/* phiが基本帰納変数なら増分の命令 / the increment if phi is a basic IV */
+IR_Insn*
+iv_next(IR_Loop *l, IR_Insn *phi)
+{
+    int  v;
+    IR_Insn *d;
+
+    if (phi->op != IR_PHI || phi->block != l->header || phi->nphi != 2
+        || (phi->phi_blk[0] != l->preheader && phi->phi_blk[1] != l->preheader)) {
+        return NULL;
+    }
+    v = phi->phi_src[1-phi_slot(l, phi)];
+    if (v >= def_size || (d = def[v]) == NULL || !loop_contains(l, d->block)) {
+        return NULL;
+    }
+    if (d->op == IR_ADD && d->src[0] == phi->dst && invariant(l, d->src[1])) {
+        return d;
+    }
+    if (d->op == IR_ADD && d->src[1] == phi->dst && invariant(l, d->src[0])) {
+        return d;
+    }
+    if (d->op == IR_SUB && d->src[0] == phi->dst && invariant(l, d->src[1])) {
+        return d;
+    }
+    return NULL;
+}
+
+/* vが基本帰納変数（またはその増分後の値）ならそのphi
+   The phi if v is a basic IV (or its incremented value) */
+IR_Insn*
+basic_iv(IR_Loop *l, int v, int *is_next)
+{
+    int  s;
+    IR_Insn *d;
+
+    if (v >= def_size || (d = def[v]) == NULL) {
+        return NULL;
+    }
+    *is_next = 0;
+    if (iv_next(l, d) != NULL) {
+        return d;
+    }
+    if (d->op != IR_ADD && d->op != IR_SUB) {
+        return NULL;
+    }
+    *is_next = 1;
+    for (s = 0; s < 2; s++) {
+        if (def[d->src[s]] != NULL && iv_next(l, def[d->src[s]]) == d) {
+            return def[d->src[s]];
+        }
+    }
+    return NULL;
+}
+
+IR_Insn*
+new_insn(int op, int dst, int a, int b)
+{
+    IR_Insn *i;
+
+    i = ir_new_insn(op);
+    i->dst = dst;
+    i->src[0] = a;
+    i->src[1] = b;
+    return i;
+}
+
+/* phi*kに等しい新しい基本帰納変数を作る
+   Make a new basic IV equal to phi*k */
+IR_Insn*
+reduce(IR_Loop *l, IR_Insn *phi, int k)
+{
+    int  slot;
+    IR_Insn *next, *pos, *init, *step, *p, *pn;
+
+    next = iv_next(l, phi);
+    slot = phi_slot(l, phi);
+    pos = ir_terminator(l->preheader);
+    init = new_insn(IR_MUL, ir_new_vreg(cur_func), phi->phi_src[slot], k);
+    step = new_insn(IR_MUL, ir_new_vreg(cur_func),
+                    next->src[next->src[0] == phi->dst ? 1 : 0], k);
+    ir_insert_before(pos, init);
+    ir_insert_before(pos, step);
+
+    p = ir_new_insn(IR_PHI);
+    p->dst = ir_new_vreg(cur_func);
+    pn = new_insn(next->op, ir_new_vreg(cur_func), p->dst, step->dst);
+    p->nphi = 2;
+    p->phi_src = xmalloc(2*sizeof(int));
+    p->phi_blk = xmalloc(2*sizeof(IR_Block*));
+    p->phi_blk[slot] = l->preheader;
+    p->phi_src[slot] = init->dst;
+    p->phi_blk[1-slot] = phi->phi_blk[1-slot];
+    p->phi_src[1-slot] = pn->dst;
+    ir_insert_before(phi, p);
+    ir_insert_after(next, pn);
+
+    set_def(init);
+    set_def(step);
+    set_def(p);
+    set_def(pn);
+    return p;
+}
+
+/*
+ * phi（とその増分後の値）が増分と終了判定にしか使われていなければ、
+ * 判定をp（=phi*k）と上限*kの比較に書き換える
+ * If phi (and its incremented value) are used only by the increment
+ * and an exit test, rewrite the test to compare p (= phi*k) with
+ * bound*k.
+ */
+void
+replace_test(IR_Loop *l, IR_Insn *phi, IR_Insn *p, int k)
+{
+    int  n, s, only_test, *uses;
+    IR_Insn *next, *pn, *t, *test, *bound;
+
+    next = iv_next(l, phi);
+    pn = iv_next(l, p);
+    test = NULL;
+    for (n = 0; n < l->nblocks; n++) {
+        t = ir_terminator(l->blocks[n]);
+        if (t->op != IR_BR || t->cond == 0) {
+            continue;
+        }
+        for (s = 0; s < 2; s++) {
+            if ((t->src[s] == phi->dst || t->src[s] == next->dst)
+                && invariant(l, t->src[1-s])) {
+                break;
+            }
+        }
+        if (s < 2) {
+            if (test != NULL) {
+                return;
+            }
+            test = t;
+        }
+    }
+    if (test == NULL) {
+        return;
+    }
+    uses = ir_use_counts(cur_func);
+    only_test = uses[phi->dst] == 1 + count_uses(test, phi->dst)
+                && uses[next->dst] == 1 + count_uses(test, next->dst);
+    free(uses);
+    if (!only_test || !test_fits(l, phi, test, k)) {
+        return;
+    }
+
+    for (s = 0; s < 2; s++) {
+        if (test->src[s] == phi->dst) {
+            test->src[s] = p->dst;
+        } else if (test->src[s] == next->dst) {
+            test->src[s] = pn->dst;
+        } else {
+            bound = new_insn(IR_MUL, ir_new_vreg(cur_func), test->src[s], k);
+            ir_insert_before(ir_terminator(l->preheader), bound);
+            set_def(bound);
+            test->src[s] = bound->dst;
+        }
+    }
+    if (def[k]->imm < 0) {
+        test->cond = ir_swap_cond(test->cond);	/* 負数倍で大小が逆転 / negation flips */
+    }
+}
+
+/* vが定数ならその値をcに置いて1 / 1 with the value in c if v is a constant */
+int
+const_of(int v, long long *c)
+{
+    if (v >= def_size || def[v] == NULL || def[v]->op != IR_CONST) {
+        return 0;
+    }
+    *c = def[v]->imm;
+    return 1;
+}
+
+/*
+ * testの書き換えで桁あふれが起きないか。最初に判定される値v0から
+ * 上限に向かって進むなら、判定される値はv0から上限+増分までに収まる。
+ * 等号の比較は上限にちょうど届く場合に限る
+ * Whether rewriting test is free of overflow.  If the first value
+ * tested, v0, steps towards the bound, the values tested stay between
+ * v0 and the bound plus the step.  An equality test also needs the
+ * bound to be hit exactly.
+ */
+int
+test_fits(IR_Loop *l, IR_Insn *phi, IR_Insn *test, int k)
+{
+    int  n, s;
+    long long init, step, bound, c, v[3];
+    IR_Insn *next;
+
+    next = iv_next(l, phi);
+    s = test->src[0] == phi->dst || test->src[0] == next->dst ? 1 : 0;
+    if (!const_of(phi->phi_src[phi_slot(l, phi)], &init)
+        || !const_of(next->src[next->src[0] == phi->dst ? 1 : 0], &step)
+        || !const_of(test->src[s], &bound) || !const_of(k, &c)) {
+        return 0;
+    }
+    if (next->op == IR_SUB) {
+        step = -step;
+    }
+    v[0] = test->src[1-s] == next->dst ? init+step : init;
+    v[1] = bound;
+    v[2] = bound+step;
+    if (step != 0) {
+        if (step > 0 ? v[0] >= bound : v[0] <= bound) {
+            return 0;
+        }
+        if ((test->cond == AST_EXP_EQ || test->cond == AST_EXP_NE)
+            && (bound-v[0])%step != 0) {
+            return 0;
+        }
+    }
+    for (n = 0; n < 3; n++) {
+        if (v[n] < INT_MIN || v[n] > INT_MAX
+            || v[n]*c < INT_MIN || v[n]*c > INT_MAX) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int
+count_uses(IR_Insn *i, int v)
+{
+    return (i->src[0] == v) + (i->src[1] == v);
+}
+
+/* 初期値と増分が同じ基本帰納変数をまとめる
+   Merge basic IVs with the same start and step */
+void
+merge_ivs(IR_Loop *l)
+{
+    int  sa, sb;
+    IR_Insn *a, *b, *na, *nb, *next;
+
+    for (a = l->header->head; a != NULL && a->op == IR_PHI; a = a->next) {
+        if ((na = iv_next(l, a)) == NULL) {
+            continue;
+        }
+        for (b = a->next; b != NULL && b->op == IR_PHI; b = next) {
+            next = b->next;
+            if ((nb = iv_next(l, b)) == NULL || nb->op != na->op
+                || nb->block != na->block
+                || a->phi_src[phi_slot(l, a)] != b->phi_src[phi_slot(l, b)]) {
+                continue;
+            }
+            sa = na->src[na->src[0] == a->dst ? 1 : 0];
+            sb = nb->src[nb->src[0] == b->dst ? 1 : 0];
+            if (sa != sb) {
+                continue;
+            }
+            /* 先に計算される増分を残す / keep the increment computed first */
+            if (!precedes(na, nb)) {
+                ir_remove(na);
+                ir_insert_before(nb, na);
+            }
+            ir_replace_vreg(cur_func, b->dst, a->dst);
+            ir_replace_vreg(cur_func, nb->dst, na->dst);
+            ir_remove(nb);
+            ir_remove(b);
+        }
+    }
+}
+
+/* 同じブロックでaがbより前なら1 / 1 if a comes before b in the same block */
+int
+precedes(IR_Insn *a, IR_Insn *b)
+{
+    for (; a != NULL; a = a->next) {
+        if (a == b) {
+            return 1;
+        }
+    }
+    return 0;
+}
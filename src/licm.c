@@ -0,0 +1,108 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    ループ不変式の移動 / loop-invariant code motion
+
+    内側のループから順に、被演算子がすべてループ外で定義された演算を
+    プリヘッダに移す。移した命令の結果はループ内で不変になるので、
+    それを使う命令も続けて移せる。移す命令は例外を起こさない純粋な
+    演算に限るので、ループ本体が一度も実行されなくても安全に先に
+    計算できる（除算は0と-1以外の定数で割るときだけ）。
+    SSA形式では変数はレジスタなので、変数の読み出しと、ループ内で
+    書くだけの変数への代入は命令としては残らない。
+
+    Innermost loops first, operations whose operands are all defined
+    outside the loop are moved to the preheader.  The moved results
+    are invariant, so the instructions using them can follow.  Only
+    pure operations that never trap are moved, so computing them early
+    is safe even if the loop body never runs (division only by a
+    constant other than 0 and -1).
+    In SSA form variables live in registers, so neither reads of
+    variables nor assignments to variables only written in the loop
+    remain as instructions.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ir.h"
+#include  "opt.h"
+#include  "util.h"
+
+static IR_Insn **def;
+
+static int  is_invariant(IR_Loop *l, IR_Insn *i);
+static int  defined_outside(IR_Loop *l, int v);
+
+/* 移した命令の数を返す / returns the number of moved instructions */
+int
+licm(IR_Func *f)
+{
+    int  k, changed, nmoved;
+    IR_Block *b;
+    IR_Insn *i, *next;
+    IR_Loop *loops, *l;
+
+    loops = find_loops(f);
+    def = xcalloc(f->nvregs+1, sizeof(IR_Insn*));
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->dst != 0) {
+                def[i->dst] = i;
+            }
+        }
+    }
+
+    nmoved = 0;
+    for (l = loops; l != NULL; l = l->next) {
+        do {
+            changed = 0;
+            for (k = 0; k < l->nblocks; k++) {
+                for (i = l->blocks[k]->head; i != NULL; i = next) {
+                    next = i->next;
+                    if (!is_invariant(l, i)) {
+                        continue;
+                    }
+                    ir_remove(i);
+                    ir_insert_before(ir_terminator(l->preheader), i);
+                    nmoved++;
+                    changed = 1;
+                }
+            }
+        } while (changed);
+    }
+    free(def);
+    def = NULL;
+    free_loops(loops);
+    return nmoved;
+}
+
+int
+is_invariant(IR_Loop *l, IR_Insn *i)
+{
+    switch (i->op) {
+    case  IR_CONST:
+        return 1;
+    case  IR_NEG:
+    case  IR_SHR:
+        return defined_outside(l, i->src[0]);
+    case  IR_DIV:
+        if (def[i->src[1]] == NULL || def[i->src[1]]->op != IR_CONST
+            || def[i->src[1]]->imm == 0 || def[i->src[1]]->imm == -1) {
+            return 0;
+        }
+        /* FALLTHROUGH */
+    case  IR_ADD:
+    case  IR_SUB:
+    case  IR_MUL:
+    case  IR_SETCC:
+        return defined_outside(l, i->src[0]) && defined_outside(l, i->src[1]);
+    default:
+        return 0;
+    }
+}
+
+int
+defined_outside(IR_Loop *l, int v)
+{
+    return def[v] != NULL && !loop_contains(l, def[v]->block);
+}
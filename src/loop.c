@@ -0,0 +1,258 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    自然ループ / natural loops
+
+    支配するブロックへの辺（後退辺）ごとに、その先をヘッダとする自然
+    ループを求める。ヘッダが同じループは一つにまとめる。各ループには
+    ループ外からの唯一の先行ブロックとしてプリヘッダを用意し、ヘッダの
+    phiのうちループ外から来る値はプリヘッダ経由にする。
+    後退辺を持たない既約でないループは扱わない。
+
+    For each edge to a dominating block (back edge), the natural loop
+    headed by its target is collected; loops sharing a header are
+    merged.  Each loop is given a preheader as the only predecessor
+    outside the loop, and the values of the header's phis coming from
+    outside are routed through it.  Irreducible loops, which have no
+    back edges, are not handled.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ir.h"
+#include  "opt.h"
+#include  "util.h"
+
+static int  is_header(IR_Block *h);
+static IR_Block *make_preheader(IR_Func *f, IR_Block *h);
+static void route_phis(IR_Func *f, IR_Block *h, IR_Block *ph, int nout);
+static IR_Loop *collect_loop(IR_Func *f, IR_Block *h, IR_Block *ph);
+
+/*
+ * 関数のループを内側から順に並べたリストを返す
+ * Return the loops of a function, innermost first
+ */
+IR_Loop*
+find_loops(IR_Func *f)
+{
+    int  k, n, nheaders;
+    IR_Block **headers, **preheaders;
+    IR_Loop *loops, *l, *m, **pos;
+
+    ir_build_cfg(f);
+    compute_dominators(f);
+    headers = xmalloc(f->nrpo*sizeof(IR_Block*));
+    nheaders = 0;
+    for (k = 0; k < f->nrpo; k++) {
+        if (f->rpo[k] != f->first && is_header(f->rpo[k])) {
+            headers[nheaders++] = f->rpo[k];
+        }
+    }
+
+    /* 外側のループが内側のプリヘッダを含むよう、先にすべて作る
+       Make all preheaders first so that outer loops contain the inner
+       ones' */
+    preheaders = xmalloc(f->nrpo*sizeof(IR_Block*));
+    for (k = 0; k < nheaders; k++) {
+        preheaders[k] = make_preheader(f, headers[k]);
+        ir_build_cfg(f);
+        compute_dominators(f);
+    }
+    loops = NULL;
+    for (k = 0; k < nheaders; k++) {
+        l = collect_loop(f, headers[k], preheaders[k]);
+        /* 小さい（内側の）順に挿入する / insert smaller (inner) loops first */
+        for (pos = &loops; *pos != NULL && (*pos)->nblocks <= l->nblocks;
+             pos = &(*pos)->next) {
+            ;
+        }
+        l->next = *pos;
+        *pos = l;
+    }
+    free(headers);
+    free(preheaders);
+
+    /* ヘッダを含む最小のループが外側のループ
+       The smallest loop containing the header is the enclosing one */
+    for (l = loops; l != NULL; l = l->next) {
+        for (m = l->next; m != NULL; m = m->next) {
+            if (loop_contains(m, l->header)) {
+                l->parent = m;
+                break;
+            }
+        }
+    }
+    for (l = loops; l != NULL; l = l->next) {
+        n = 0;
+        for (m = l; m != NULL; m = m->parent) {
+            n++;
+        }
+        l->depth = n;
+    }
+    return loops;
+}
+
+int
+loop_contains(IR_Loop *l, IR_Block *b)
+{
+    return b->id < l->nmember && l->member[b->id];
+}
+
+void
+free_loops(IR_Loop *loops)
+{
+    IR_Loop *next;
+
+    for (; loops != NULL; loops = next) {
+        next = loops->next;
+        free(loops->blocks);
+        free(loops->member);
+        free(loops);
+    }
+}
+
+/* hが支配する先行ブロックがあれば1 / 1 if a predecessor is dominated by h */
+int
+is_header(IR_Block *h)
+{
+    int  k;
+
+    for (k = 0; k < h->npred; k++) {
+        if (dominates(h, h->pred[k])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * ループ外の先行ブロックが一つで、その後続がhだけならそれを使う。
+ * そうでなければ新しいブロックを作ってループ外からの辺をまとめる
+ * Use the only predecessor outside the loop if h is its only
+ * successor; otherwise make a new block collecting the edges from
+ * outside.
+ */
+IR_Block*
+make_preheader(IR_Func *f, IR_Block *h)
+{
+    int  k, j, nout;
+    IR_Block *p, *ph, *out;
+    IR_Insn *i, *t;
+
+    nout = 0;
+    out = NULL;
+    for (k = 0; k < h->npred; k++) {
+        if (!dominates(h, h->pred[k])) {
+            out = h->pred[k];
+            nout++;
+        }
+    }
+    if (nout == 1 && out->nsucc == 1) {
+        return out;
+    }
+
+    ph = ir_new_block(f);
+    i = ir_new_insn(IR_JMP);
+    i->target[0] = h;
+    ir_append(ph, i);
+    for (k = 0; k < h->npred; k++) {
+        p = h->pred[k];
+        if (dominates(h, p)) {
+            continue;
+        }
+        t = ir_terminator(p);
+        for (j = 0; j < 2; j++) {
+            if (t->target[j] == h) {
+                t->target[j] = ph;
+            }
+        }
+    }
+    route_phis(f, h, ph, nout);
+    ir_place_block_after(f, h->prev, ph);
+    return ph;
+}
+
+/* ヘッダのphiのループ外からの値をプリヘッダから来るようにする
+   Make the values of the header's phis from outside come from the
+   preheader */
+void
+route_phis(IR_Func *f, IR_Block *h, IR_Block *ph, int nout)
+{
+    int  k, n, m;
+    IR_Insn *i, *phi;
+
+    for (i = h->head; i != NULL && i->op == IR_PHI; i = i->next) {
+        if (nout == 1) {
+            for (k = 0; k < i->nphi; k++) {
+                if (!dominates(h, i->phi_blk[k])) {
+                    i->phi_blk[k] = ph;
+                }
+            }
+            continue;
+        }
+        phi = ir_new_insn(IR_PHI);
+        phi->dst = ir_new_vreg(f);
+        phi->sym = i->sym;
+        phi->phi_src = xmalloc(nout*sizeof(int));
+        phi->phi_blk = xmalloc(nout*sizeof(IR_Block*));
+        n = m = 0;
+        for (k = 0; k < i->nphi; k++) {
+            if (dominates(h, i->phi_blk[k])) {
+                i->phi_src[n] = i->phi_src[k];
+                i->phi_blk[n++] = i->phi_blk[k];
+            } else {
+                phi->phi_src[m] = i->phi_src[k];
+                phi->phi_blk[m++] = i->phi_blk[k];
+            }
+        }
+        phi->nphi = m;
+        i->phi_src[n] = phi->dst;
+        i->phi_blk[n++] = ph;
+        i->nphi = n;
+        ir_insert_before(ph->head, phi);
+    }
+}
+
+/* 後退辺の元から逆向きにヘッダまで辿る
+   Walk backwards from the sources of back edges up to the header */
+IR_Loop*
+collect_loop(IR_Func *f, IR_Block *h, IR_Block *ph)
+{
+    int  k, n;
+    IR_Block *b, **stack;
+    IR_Loop *l;
+
+    l = xcalloc(1, sizeof(IR_Loop));
+    l->header = h;
+    l->preheader = ph;
+    l->nmember = f->nblocks;
+    l->member = xcalloc(f->nblocks, sizeof(char));
+    l->member[h->id] = 1;
+    stack = xmalloc(f->nblocks*sizeof(IR_Block*));
+    n = 0;
+    for (k = 0; k < h->npred; k++) {
+        b = h->pred[k];
+        if (dominates(h, b) && !l->member[b->id]) {
+            l->member[b->id] = 1;
+            stack[n++] = b;
+        }
+    }
+    while (n > 0) {
+        b = stack[--n];
+        for (k = 0; k < b->npred; k++) {
+            if (b->pred[k]->rpo >= 0 && !l->member[b->pred[k]->id]) {
+                l->member[b->pred[k]->id] = 1;
+                stack[n++] = b->pred[k];
+            }
+        }
+    }
+    free(stack);
+
+    l->blocks = xmalloc(f->nrpo*sizeof(IR_Block*));
+    for (k = 0; k < f->nrpo; k++) {
+        if (l->member[f->rpo[k]->id]) {
+            l->blocks[l->nblocks++] = f->rpo[k];
+        }
+    }
+    return l;
+}
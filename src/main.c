@@ -5,43 +5,271 @@
 */
 
 #include  <libgen.h>
+#include  <signal.h>
+#include  <spawn.h>
 #include  <stdio.h>
 #include  <stdlib.h>
 #include  <string.h>
+#include  <unistd.h>
+#include  <sys/wait.h>
 #include  "ast.h"
 #include  "cg.h"
+#include  "option.h"
 #include  "symtab.h"
+#include  "util.h"
 
 extern FILE  *yyin;
 extern int   yynerrs;
 extern void  yyparse(void);
+extern char  **environ;
 
-int
-main(int argc, char **argv)
+/*
+  アセンブラ/リンカのドライバ。生成したアセンブリは一時ファイルを介さず
+  パイプで標準入力に流し込む。
+  Assembler/linker driver. The generated assembly is streamed into
+  its standard input through a pipe instead of a temporary file.
+*/
+static const char ASM_DRIVER[] = "gcc";
+
+int  opt_level;
+int  flag_dump_ir;
+int  flag_dump_ssa;
+int  flag_unroll_loops;
+int  unroll_factor = 4;
+int  flag_inline = 1;
+int  inline_limit = 20;
+int  flag_ipcp = 1;
+int  ipcp_budget = 200;
+int  flag_pure_calls = 1;
+int  eval_limit = 100000;
+int  flag_keep_unused;
+int  nexports;
+char **exports;
+int  flag_regalloc_graph = -1;
+int  flag_omit_frame_pointer = -1;
+int  flag_isel = 1;
+int  flag_peephole = 1;
+int  flag_opt_report;
+
+static void usage(const char *prog);
+static void set_flag(const char *prog, const char *flag);
+static char *default_out_file(const char *in_file);
+static int  has_suffix(const char *name, const char *suffix);
+static FILE *spawn_assembler(const char *out_file, pid_t *pid);
+static int  wait_assembler(pid_t pid);
+
+void
+usage(const char *prog)
 {
-    char *in_file, *out_file;
-    int  fnlen;
-    FILE *out;
+    fprintf(stderr, "usage: %s [-o output] [-O<n>] [-fdump-ir] [-fdump-ssa]"
+            " [-funroll-loops] [-funroll-factor=N] [-fno-inline]"
+            " [-finline-limit=N] [-fno-ipcp] [-fipcp-budget=N]"
+            " [-fno-pure-calls] [-feval-limit=N] [-fkeep-unused]"
+            " [-fexport=NAME] [-fregalloc=graph|linear]"
+            " [-f[no-]omit-frame-pointer] [-fno-isel] [-fno-peephole]"
+            " [-fopt-report] file.c\n", prog);
+    exit(-1);
+}
 
-    in_file = argv[1];
-    if ((yyin = fopen(in_file, "r")) == NULL) {
-        fprintf(stderr, "Can't open the input file %s.\n", in_file);
-        exit(-1);
+/* -f<flag> */
+void
+set_flag(const char *prog, const char *flag)
+{
+    if (strcmp(flag, "dump-ir") == 0) {
+        flag_dump_ir = 1;
+    } else if (strcmp(flag, "dump-ssa") == 0) {
+        flag_dump_ssa = 1;
+    } else if (strcmp(flag, "unroll-loops") == 0) {
+        flag_unroll_loops = 1;
+    } else if (strncmp(flag, "unroll-factor=", 14) == 0) {
+        if ((unroll_factor = atoi(flag+14)) < 1) {
+            fprintf(stderr, "Invalid unroll factor -f%s.\n", flag);
+            usage(prog);
+        }
+    } else if (strcmp(flag, "no-inline") == 0) {
+        flag_inline = 0;
+    } else if (strncmp(flag, "inline-limit=", 13) == 0) {
+        if ((inline_limit = atoi(flag+13)) < 0) {
+            fprintf(stderr, "Invalid inline limit -f%s.\n", flag);
+            usage(prog);
+        }
+    } else if (strcmp(flag, "no-ipcp") == 0) {
+        flag_ipcp = 0;
+    } else if (strncmp(flag, "ipcp-budget=", 12) == 0) {
+        if ((ipcp_budget = atoi(flag+12)) < 0) {
+            fprintf(stderr, "Invalid ipcp budget -f%s.\n", flag);
+            usage(prog);
+        }
+    } else if (strcmp(flag, "no-pure-calls") == 0) {
+        flag_pure_calls = 0;
+    } else if (strncmp(flag, "eval-limit=", 11) == 0) {
+        if ((eval_limit = atoi(flag+11)) < 0) {
+            fprintf(stderr, "Invalid eval limit -f%s.\n", flag);
+            usage(prog);
+        }
+    } else if (strcmp(flag, "keep-unused") == 0) {
+        flag_keep_unused = 1;
+    } else if (strncmp(flag, "export=", 7) == 0) {
+        exports = xrealloc(exports, (nexports+1)*sizeof(char*));
+        exports[nexports++] = (char *)flag+7;
+    } else if (strcmp(flag, "regalloc=graph") == 0) {
+        flag_regalloc_graph = 1;
+    } else if (strcmp(flag, "regalloc=linear") == 0) {
+        flag_regalloc_graph = 0;
+    } else if (strcmp(flag, "omit-frame-pointer") == 0) {
+        flag_omit_frame_pointer = 1;
+    } else if (strcmp(flag, "no-omit-frame-pointer") == 0) {
+        flag_omit_frame_pointer = 0;
+    } else if (strcmp(flag, "no-isel") == 0) {
+        flag_isel = 0;
+    } else if (strcmp(flag, "no-peephole") == 0) {
+        flag_peephole = 0;
+    } else if (strcmp(flag, "opt-report") == 0) {
+        flag_opt_report = 1;
+    } else {
+        fprintf(stderr, "Unknown flag -f%s.\n", flag);
+        usage(prog);
     }
-    if ((out_file = strdup(basename(in_file))) == NULL) {
+}
+
+/* foo.c -> foo.s（カレントディレクトリ / in the current directory） */
+char*
+default_out_file(const char *in_file)
+{
+    char *path, *out_file;
+    int  fnlen;
+
+    if ((path = strdup(in_file)) == NULL
+        || (out_file = strdup(basename(path))) == NULL) {
         fputs("Not enough memory for strdup.\n", stderr);
         exit(-1);
     }
+    free(path);
     fnlen = strlen(out_file);
-    if (strcmp(&out_file[fnlen-2], ".c") != 0) {
+    if (!has_suffix(out_file, ".c")) {
         fputs("Illegal suffix.\n", stderr);
         exit(-1);
     }
     out_file[fnlen-1] = 's';
-    if ((out = fopen(out_file, "w")) == NULL) {
-        fprintf(stderr, "Can't open the output file %s.\n", out_file);
+    return out_file;
+}
+
+int
+has_suffix(const char *name, const char *suffix)
+{
+    int  nlen = strlen(name), slen = strlen(suffix);
+
+    return nlen >= slen && strcmp(&name[nlen-slen], suffix) == 0;
+}
+
+/*
+  出力先が.oならアセンブルのみ、それ以外なら実行ファイルまで作る。
+  ドライバの標準入力をパイプにつなぎ、書き込み側をFILEとして返す。
+  If out_file ends with ".o", only assemble it; otherwise link it as well.
+  The driver reads from a pipe connected to its standard input,
+  and the writing end is returned as a FILE.
+*/
+FILE*
+spawn_assembler(const char *out_file, pid_t *pid)
+{
+    int  fd[2], err, i;
+    char *args[8];
+    FILE *out;
+    posix_spawn_file_actions_t  actions;
+
+    i = 0;
+    args[i++] = (char *)ASM_DRIVER;
+    if (has_suffix(out_file, ".o")) {
+        args[i++] = "-c";
+    }
+    args[i++] = "-x";
+    args[i++] = "assembler";
+    args[i++] = "-o";
+    args[i++] = (char *)out_file;
+    args[i++] = "-";
+    args[i] = NULL;
+
+    if (pipe(fd) != 0) {
+        perror("pipe");
+        exit(-1);
+    }
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fd[0], STDIN_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fd[0]);
+    posix_spawn_file_actions_addclose(&actions, fd[1]);
+    err = posix_spawnp(pid, ASM_DRIVER, &actions, NULL, args, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fd[0]);
+    if (err != 0) {
+        fprintf(stderr, "Can't execute %s: %s\n", ASM_DRIVER, strerror(err));
+        exit(-1);
+    }
+    if ((out = fdopen(fd[1], "w")) == NULL) {
+        perror("fdopen");
+        exit(-1);
+    }
+    /* 子が先に終了してもその終了コードを返せるようにSIGPIPEは無視する
+       Ignore SIGPIPE so that the exit status of the driver is reported
+       even if it terminates before reading all of the input. */
+    signal(SIGPIPE, SIG_IGN);
+    return out;
+}
+
+/* ドライバの終了コードをそのまま返す / Pass through the driver's exit status */
+int
+wait_assembler(pid_t pid)
+{
+    int status;
+
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("waitpid");
+        return -1;
+    }
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status)) {
+        fprintf(stderr, "%s terminated by signal %d.\n",
+                ASM_DRIVER, WTERMSIG(status));
+        return 128+WTERMSIG(status);
+    }
+    return -1;
+}
+
+int
+main(int argc, char **argv)
+{
+    char *in_file, *out_file = NULL;
+    int  c, ret;
+    pid_t pid = 0;
+    FILE *out;
+
+    while ((c = getopt(argc, argv, "o:f:O:")) != -1) {
+        switch (c) {
+        case 'o':
+            out_file = optarg;
+            break;
+        case 'f':
+            set_flag(argv[0], optarg);
+            break;
+        case 'O':
+            opt_level = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (optind != argc-1) {
+        usage(argv[0]);
+    }
+    in_file = argv[optind];
+    if ((yyin = fopen(in_file, "r")) == NULL) {
+        fprintf(stderr, "Can't open the input file %s.\n", in_file);
         exit(-1);
     }
+    if (out_file == NULL) {
+        out_file = default_out_file(in_file);
+    }
 
     yyparse();
     if (yynerrs > 0) {
@@ -53,7 +281,32 @@ main(int argc, char **argv)
     dump_symtab();
     dump_ast();
 
+    if (strcmp(out_file, "-") == 0) {
+        out = stdout;
+    } else if (has_suffix(out_file, ".s")) {
+        if ((out = fopen(out_file, "w")) == NULL) {
+            fprintf(stderr, "Can't open the output file %s.\n", out_file);
+            exit(-1);
+        }
+    } else {
+        out = spawn_assembler(out_file, &pid);
+    }
+
     gen_code(out);
 
-    return 0;
+    ret = 0;
+    if (out != stdout) {
+        if (fclose(out) != 0 && pid == 0) {
+            perror(out_file);
+            ret = -1;
+        }
+    } else if (fflush(out) != 0) {
+        perror("stdout");
+        ret = -1;
+    }
+    if (pid != 0) {
+        ret = wait_assembler(pid);
+    }
+
+    return ret;
 }
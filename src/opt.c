@@ -0,0 +1,95 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    最適化の手順 / optimization pipeline
+
+    -O1以上では全関数をSSA形式にし、手続き間で定数を伝播して関数を
+    特殊化(ipcp.c)してから、呼び出しグラフの呼ばれる側から順に、呼び出し
+    先を展開(inline.c)してから最適化する。純粋な関数の呼び出しは翻訳時に
+    評価するか共通化する(pure.c)。最後に末尾位置の呼び出しを分岐にし
+    (tailcall.c)、SSA形式を解体してからレジスタ割り付け(regalloc.c)に
+    渡す。
+    At -O1 and above all functions are put into SSA form and constants
+    are propagated across calls, specializing functions (ipcp.c).  The
+    functions are then optimized callees first in the call graph, each
+    after its callees are inlined (inline.c).  Calls to pure functions
+    are evaluated at compile time or shared (pure.c).  Finally calls in tail
+    position become jumps (tailcall.c) and the functions are taken out
+    of SSA form before the register allocation (regalloc.c).
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ir.h"
+#include  "opt.h"
+#include  "option.h"
+
+void
+optimize(void)
+{
+    int  n, k, nfuncs;
+    IR_Func *f, **order;
+
+    if (opt_level < 1) {
+        return;
+    }
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        ir_remove_unreachable(f);
+        build_ssa(f);
+        if (flag_dump_ssa) {
+            dump_ir(f);
+        }
+    }
+    if (flag_ipcp) {
+        ipcp();
+    }
+    if (flag_pure_calls) {
+        find_pure_functions();
+    }
+    order = bottom_up_order(&nfuncs);
+    for (k = 0; k < nfuncs; k++) {
+        f = order[k];
+        if (flag_ipcp) {
+            report(f, "ipcp", ipcp_returns(f), "constant return values propagated");
+        }
+        if (flag_inline) {
+            report(f, "inline", inline_calls(f), "calls inlined");
+        }
+        report(f, "tailrec", tail_recursion(f), "tail calls turned into loops");
+        sccp(f);
+        n = ir_count_insns(f);
+        gvn(f);
+        report(f, "gvn", n - ir_count_insns(f), "instructions removed");
+        if (flag_pure_calls) {
+            report(f, "pure", eval_pure_calls(f), "calls evaluated");
+            report(f, "pure", remove_repeated_calls(f), "repeated calls removed");
+        }
+        fold_constants(f);
+        report(f, "licm", licm(f), "instructions hoisted");
+        report(f, "scev", scev(f), "loops replaced with closed forms");
+        fold_constants(f);
+        report(f, "iv", reduce_ivs(f), "multiplications strength-reduced");
+        fold_constants(f);
+        report(f, "unroll", unroll_loops(f), "loops unrolled");
+        sccp(f);
+        fold_constants(f);
+        n = ir_count_insns(f);
+        dce(f);
+        report(f, "dce", n - ir_count_insns(f), "instructions removed");
+        verify_ssa(f);
+    }
+    free(order);
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        report(f, "tailcall", tail_calls(f), "calls turned into jumps");
+        destroy_ssa(f);
+    }
+}
+
+/* -fopt-report: 各処理の結果 / results of each pass */
+void
+report(IR_Func *f, const char *pass, int n, const char *what)
+{
+    if (flag_opt_report && n > 0) {
+        fprintf(stderr, "%s: %s: %d %s\n", f->name, pass, n, what);
+    }
+}
@@ -0,0 +1,136 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    IRの解析と最適化 / analyses and optimizations on IR
+*/
+
+#ifndef  OPT_H
+#define  OPT_H
+
+#include  "ir.h"
+
+/* 逆後順と支配木を求める (dom.c)
+   Compute the reverse postorder and the dominator tree (dom.c) */
+extern void compute_dominators(IR_Func *f);
+
+/* aがbを支配すれば1 (compute_dominatorsの後で使う)
+   1 if a dominates b (valid after compute_dominators) */
+extern int  dominates(IR_Block *a, IR_Block *b);
+
+/* 直接後支配ブロックの表（ブロック番号で引く、呼び出し側でfreeする）
+   Table of immediate post-dominators indexed by block id (to be freed
+   by the caller) */
+extern IR_Block **compute_postdominators(IR_Func *f);
+
+/* 自然ループ (loop.c) / natural loops (loop.c) */
+typedef struct IR_Loop {
+    IR_Block *header;
+    IR_Block *preheader;        /* ループ外の唯一の先行ブロック / the only predecessor outside */
+    int  nblocks;
+    IR_Block **blocks;          /* ヘッダを含む本体（逆後順）/ body with the header (in RPO) */
+    int  nmember;
+    char *member;               /* ブロック番号で引く / indexed by block id */
+    int  depth;                 /* 入れ子の深さ（最外が1）/ nesting depth (1: outermost) */
+    struct IR_Loop *parent;     /* 外側のループ / enclosing loop */
+    struct IR_Loop *next;       /* 内側から順 / innermost first */
+} IR_Loop;
+
+/* ループを求めてプリヘッダを作る。内側から順のリストを返す
+   Find the loops and make their preheaders.  Returns them innermost
+   first */
+extern IR_Loop *find_loops(IR_Func *f);
+extern int  loop_contains(IR_Loop *l, IR_Block *b);
+extern void free_loops(IR_Loop *loops);
+
+/* SSA形式の構築・解体・検査 (ssa.c)
+   construction, destruction and verification of SSA form (ssa.c) */
+extern void build_ssa(IR_Func *f);
+extern void destroy_ssa(IR_Func *f);
+extern void verify_ssa(IR_Func *f);
+
+/* 定数畳み込みと代数的簡約 (fold.c)
+   constant folding and algebraic simplification (fold.c) */
+extern int  fold_const(int kind, int a, int b, int *val);
+extern void fold_constants(IR_Func *f);
+
+/* 疎な条件付き定数伝播 (sccp.c)
+   sparse conditional constant propagation (sccp.c) */
+extern void sccp(IR_Func *f);
+
+/* 大域的値番号付け (gvn.c) / global value numbering (gvn.c) */
+extern void gvn(IR_Func *f);
+
+/* ループ不変式の移動。移した命令の数を返す (licm.c)
+   loop-invariant code motion; returns the number of moved
+   instructions (licm.c) */
+extern int  licm(IR_Func *f);
+
+/* ループの閉じた式での置き換え。置き換えたループの数を返す (scev.c)
+   closed-form evaluation of loops; returns the number of loops
+   replaced (scev.c) */
+extern int  scev(IR_Func *f);
+
+/* 帰納変数の強さの軽減。置き換えた乗算の数を返す (iv.c)
+   induction variable strength reduction; returns the number of
+   multiplications replaced (iv.c) */
+extern int  reduce_ivs(IR_Func *f);
+
+/* ループ展開。展開したループの数を返す (unroll.c)
+   loop unrolling; returns the number of loops unrolled (unroll.c) */
+extern int  unroll_loops(IR_Func *f);
+
+/* 手続き間定数伝播と関数の特殊化 (ipcp.c)
+   interprocedural constant propagation and specialization (ipcp.c) */
+extern void ipcp(void);
+/* 定数を返す関数の呼び出しの値を定数にし、その数を返す
+   Make the values of calls to functions returning a constant constant
+   and return the number of them */
+extern int  ipcp_returns(IR_Func *f);
+
+/* 純粋関数の呼び出しの最適化 (pure.c)
+   optimization of pure function calls (pure.c) */
+/* 各関数が純粋か(IR_Func.pure)を求める
+   Find out whether each function is pure (IR_Func.pure) */
+extern void find_pure_functions(void);
+/* 定数の引数での純粋な呼び出しを評価し、その数を返す
+   Evaluate pure calls with constant arguments and return the number
+   of them */
+extern int  eval_pure_calls(IR_Func *f);
+/* 支配する呼び出しと同じ引数の純粋な呼び出しを取り除き、その数を返す
+   Remove pure calls with the same arguments as a dominating call and
+   return the number of them */
+extern int  remove_repeated_calls(IR_Func *f);
+
+/* 関数のインライン展開 (inline.c) / function inlining (inline.c) */
+/* 関数を呼ばれる側から順に並べた配列（呼び出し側でfreeする）
+   Array of the functions ordered callees first (to be freed by the
+   caller) */
+extern IR_Func **bottom_up_order(int *n);
+/* fの呼び出しを展開し、展開した数を返す
+   Inline calls in f and return the number of calls inlined */
+extern int  inline_calls(IR_Func *f);
+
+/* 末尾再帰のループ化。ループにした呼び出しの数を返す (tailcall.c)
+   tail recursion elimination; returns the number of calls turned into
+   a loop (tailcall.c) */
+extern int  tail_recursion(IR_Func *f);
+/* 末尾位置の呼び出しをIR_TAILCALLにし、その数を返す (tailcall.c)
+   Turn calls in tail position into IR_TAILCALL and return the number
+   of them (tailcall.c) */
+extern int  tail_calls(IR_Func *f);
+
+/* 不要コード除去 (dce.c) / dead code elimination (dce.c) */
+extern void dce(IR_Func *f);
+
+/* -Oの指定に従って全関数を最適化する (opt.c)
+   Optimize all functions as specified by -O (opt.c) */
+extern void optimize(void);
+/* -fopt-reportで処理の結果を表示する (opt.c)
+   Print the result of a pass with -fopt-report (opt.c) */
+extern void report(IR_Func *f, const char *pass, int n, const char *what);
+
+/* IRの仮想レジスタを物理レジスタに割り付ける (regalloc.c)
+   Assign physical registers to the virtual registers (regalloc.c) */
+extern void regalloc(IR_Func *f);
+
+#endif	/* OPT_H */
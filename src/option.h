@@ -0,0 +1,33 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    コマンドラインオプション / command line options
+*/
+
+#ifndef  OPTION_H
+#define  OPTION_H
+
+extern int  opt_level;		/* -O<n>: 最適化レベル / optimization level */
+extern int  flag_dump_ir;	/* -fdump-ir: IRを標準エラー出力に出す / dump IR */
+extern int  flag_dump_ssa;	/* -fdump-ssa: SSA構築直後のIRを出す / dump IR in SSA form */
+extern int  flag_unroll_loops;	/* -funroll-loops: ループを展開する / unroll loops */
+extern int  unroll_factor;	/* -funroll-factor=N: 部分展開の倍数 / partial unroll factor */
+extern int  flag_inline;	/* -fno-inline: 関数を展開しない / do not inline functions */
+extern int  inline_limit;	/* -finline-limit=N: 展開する小さい関数の大きさ / size of small functions to inline */
+extern int  flag_ipcp;		/* -fno-ipcp: 手続き間定数伝播をしない / no interprocedural constant propagation */
+extern int  ipcp_budget;	/* -fipcp-budget=N: 関数の複製で増やす命令数 / instructions added by cloning */
+extern int  flag_pure_calls;	/* -fno-pure-calls: 純粋な呼び出しを最適化しない / no optimization of pure calls */
+extern int  eval_limit;		/* -feval-limit=N: 呼び出しの翻訳時評価の歩数 / steps of compile-time evaluation */
+extern int  flag_keep_unused;	/* -fkeep-unused: 呼ばれない関数も出力する / emit uncalled functions */
+extern int  nexports;		/* -fexport=NAME: 外から呼ばれる関数 / functions called from outside */
+extern char **exports;
+extern int  flag_regalloc_graph;	/* -fregalloc=graph|linear: 彩色で割り付ける (-1: -O2以上なら)
+				   allocate registers by graph coloring (-1: at -O2 and above) */
+extern int  flag_omit_frame_pointer;	/* -f[no-]omit-frame-pointer: フレームポインタを省略する
+				   (-1: -O1なら末端関数だけ、-O2以上ならすべて)
+				   omit the frame pointer (-1: leaf functions at -O1, all at -O2 and above) */
+extern int  flag_isel;		/* -fno-isel: 木の覆いによる命令選択をしない / no tree-covering instruction selection */
+extern int  flag_peephole;	/* -fno-peephole: 覗き穴最適化をしない / no peephole optimization */
+extern int  flag_opt_report;	/* -fopt-report: 最適化の結果を報告する / report optimizations */
+
+#endif	/* OPTION_H */
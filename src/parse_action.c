@@ -12,6 +12,7 @@
 #include  "ast.h"
 #include  "parse_action.h"
 #include  "symtab.h"
+#include  "util.h"
 
 extern int yylineno;
 extern int yynerrs;
@@ -19,9 +20,23 @@ extern int yynerrs;
 /* 処理中関数のid */
 static int current_func_id;
 
+/* #pragma unroll(N): 次のループ（for, while, do）への指定と、ループ
+   キーワードごとの指定の列（出現順）
+   #pragma unroll(N): the factor for the next loop keyword (for, while,
+   do) and the factors of all loop keywords in source order */
+static int  pending_unroll;
+static int  *loop_pragmas;
+static int  nloop_pragmas, loop_pragma_size, loop_pragma_pos;
+
+/* inlineの直後の識別子（関数名）の列 / identifiers (function names) after inline */
+static int  pending_inline;
+static char **inline_names;
+static int  ninline_names;
+
 static void append_arg_sym(AST_Node *p);
 static void check_stm(AST_Node *s);
 static void check_exp(AST_Node *n);
+static int  read_pragma(const char *line);
 
 AST_Node*
 act_ID(char *id)
@@ -338,3 +353,91 @@ act_block_item_list(AST_List *l, AST_Node *item)
     nl = append_AST_List(l, item);
     return l == NULL ? nl : l;
 }
+
+/*
+ * 1行（長い行はその一部）を読む。#pragmaの行は改行だけにして行番号を
+ * 保つ。認識しない#pragmaは無視する
+ * Read a line (or part of a long line).  A #pragma line is replaced
+ * with a bare newline to keep line numbers; unknown pragmas are
+ * ignored.
+ */
+int
+lex_read_line(char *buf, int max_size, FILE *in)
+{
+    static int  line_start = 1;
+    int  n, pragma;
+
+    if (fgets(buf, max_size, in) == NULL) {
+        return 0;
+    }
+    n = strlen(buf);
+    pragma = line_start && read_pragma(buf);
+    line_start = (buf[n-1] == '\n');
+    if (pragma) {
+        strcpy(buf, line_start ? "\n" : " ");
+        n = 1;
+    }
+    return n;
+}
+
+/* #pragmaの行なら1 / 1 if the line is a #pragma */
+int
+read_pragma(const char *line)
+{
+    int  factor;
+
+    line += strspn(line, " \t");
+    if (strncmp(line, "#pragma", 7) != 0) {
+        return 0;
+    }
+    if (sscanf(line, "#pragma unroll ( %d )", &factor) == 1) {
+        pending_unroll = factor < 1 ? 1 : factor;
+    }
+    return 1;
+}
+
+void
+lex_loop_keyword(void)
+{
+    if (nloop_pragmas == loop_pragma_size) {
+        loop_pragma_size += 16;
+        loop_pragmas = xrealloc(loop_pragmas, loop_pragma_size*sizeof(int));
+    }
+    loop_pragmas[nloop_pragmas++] = pending_unroll;
+    pending_unroll = 0;
+}
+
+int
+take_loop_pragma(void)
+{
+    return loop_pragma_pos < nloop_pragmas ? loop_pragmas[loop_pragma_pos++] : 0;
+}
+
+int
+lex_inline_keyword(const char *text)
+{
+    if (strcmp(text, "inline") == 0) {
+        pending_inline = 1;
+        return 1;
+    }
+    if (pending_inline) {
+        inline_names = xrealloc(inline_names, (ninline_names+1)*sizeof(char*));
+        inline_names[ninline_names] = xmalloc(strlen(text)+1);
+        strcpy(inline_names[ninline_names++], text);
+        pending_inline = 0;
+    }
+    return 0;
+}
+
+int
+is_inline_hinted(const char *name)
+{
+    int  k;
+
+    for (k = 0; k < ninline_names; k++) {
+        if (strcmp(inline_names[k], name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -9,6 +9,7 @@
 #ifndef  PARSE_ACTION_H
 #define  PARSE_ACTION_H
 
+#include  <stdio.h>
 #include  "ast.h"
 
 extern AST_Node  *act_ID(char *id);
@@ -38,4 +39,23 @@ extern AST_List  *act_block_item_list(AST_List *l, AST_Node *item);
 extern AST_List  *act_unit_list(AST_List *lu, AST_Node *f);
 extern AST_Node  *act_function_def(AST_Node *id, AST_List *lp, AST_Node *s);
 
+/* 字句解析部から呼ぶ #pragma unroll(N) の処理
+   #pragma unroll(N), called from the lexer */
+extern int  lex_read_line(char *buf, int max_size, FILE *in);
+extern void lex_loop_keyword(void);
+
+/* ループの指定を出現順に取り出す (0: 指定なし)
+   Take the pragma of each loop in source order (0: none) */
+extern int  take_loop_pragma(void);
+
+/* 字句解析部から識別子ごとに呼ぶ。textがinlineなら1を返し、
+   次の識別子（関数名）を展開の候補として記録する
+   Called from the lexer for each identifier.  Returns 1 if text is
+   "inline", recording the next identifier (function name) as a hint
+   for inlining */
+extern int  lex_inline_keyword(const char *text);
+
+/* 関数nameにinlineの指定があれば1 / 1 if function name is marked inline */
+extern int  is_inline_hinted(const char *name);
+
 #endif	/* PARSE_ACTION_H */
@@ -0,0 +1,236 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    覗き穴最適化の共通部分 / common part of the peephole optimizer
+
+    出力を行ごとに命令・ラベル・指示語に分け、アーキテクチャ依存部の
+    規則(peep_rules)を当てはめる。書き換えた行だけを組み立て直し、
+    他の行は元のまま出力する。
+    The output is split into instructions, labels and directives line by
+    line, and the rules of the architecture dependent part (peep_rules)
+    are applied.  Only the rewritten lines are put together again; the
+    others are written as they were.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  "ir.h"
+#include  "opt.h"
+#include  "peephole.h"
+#include  "util.h"
+
+static void parse_line(Peep_Insn *p, char *line);
+static int  split_operands(Peep_Insn *p, const char *s);
+static int  compact(Peep_Insn *v, int n);
+static void print_insn(FILE *out, const Peep_Insn *p);
+
+void
+peephole(FILE *out, char *text, IR_Func *f)
+{
+    int  i, n, max, nrules, changed;
+    int  *count;
+    char *line, *next;
+    Peep_Insn *v;
+    const Peep_Rule *r;
+
+    /* 行に分ける / split into lines */
+    n = 0; max = 64;
+    v = xmalloc(max*sizeof(Peep_Insn));
+    for (line = text; *line != '\0'; line = next) {
+        if ((next = strchr(line, '\n')) != NULL) {
+            *next++ = '\0';
+        } else {
+            next = line+strlen(line);
+        }
+        if (n == max) {
+            max *= 2;
+            v = xrealloc(v, max*sizeof(Peep_Insn));
+        }
+        parse_line(&v[n++], line);
+    }
+
+    for (nrules = 0; peep_rules[nrules].name != NULL; nrules++) {
+        ;
+    }
+    count = xcalloc(nrules+1, sizeof(int));
+    do {
+        changed = 0;
+        for (i = 0; i < n; i++) {
+            for (r = peep_rules; r->name != NULL; r++) {
+                if (r->apply(&v[i], n-i)) {
+                    count[r-peep_rules]++;
+                    changed = 1;
+                    n = compact(v, n);
+                    if (i >= n) {
+                        break;
+                    }
+                }
+            }
+        }
+    } while (changed);
+
+    for (i = 0; i < n; i++) {
+        print_insn(out, &v[i]);
+        free(v[i].label);
+    }
+    for (r = peep_rules; r->name != NULL; r++) {
+        report(f, "peephole", count[r-peep_rules], r->name);
+    }
+    free(count);
+    free(v);
+}
+
+/* 1行を分解する。分解できない行は元のまま出す
+   Take a line apart.  Lines that can't be are written as they are */
+void
+parse_line(Peep_Insn *p, char *line)
+{
+    int  len;
+    char *s;
+
+    memset(p, 0, sizeof(Peep_Insn));
+    p->text = line;
+    p->nopd = -1;
+    len = strlen(line);
+    if (line[0] != '\t') {
+        if (len > 1 && line[len-1] == ':') {
+            p->label = xmalloc(len);
+            memcpy(p->label, line, len-1);
+            p->label[len-1] = '\0';
+        }
+        return;
+    }
+    s = line+1;
+    len = strcspn(s, "\t");
+    if (len == 0 || len >= (int)sizeof(p->op)) {
+        return;
+    }
+    memcpy(p->op, s, len);
+    p->op[len] = '\0';
+    if (p->op[0] == '.' || strchr(p->op, ' ') != NULL) {
+        p->op[0] = '.';		/* 指示語 / directive */
+        return;
+    }
+    p->nopd = s[len] == '\0' ? 0 : split_operands(p, s+len+1);
+}
+
+/* 括弧の外のカンマで区切る / split at commas outside brackets */
+int
+split_operands(Peep_Insn *p, const char *s)
+{
+    int  n, depth, len;
+    const char *start;
+
+    n = 0; depth = 0;
+    for (start = s; ; s++) {
+        if (*s == '(' || *s == '[') {
+            depth++;
+        } else if (*s == ')' || *s == ']') {
+            depth--;
+        } else if ((*s == ',' && depth == 0) || *s == '\0') {
+            while (*start == ' ') {
+                start++;
+            }
+            len = s-start;
+            if (n == PEEP_MAX_OPDS || len == 0 || len >= PEEP_OPD_LEN) {
+                p->op[0] = '\0';
+                return -1;
+            }
+            memcpy(p->opd[n], start, len);
+            p->opd[n++][len] = '\0';
+            if (*s == '\0') {
+                return n;
+            }
+            start = s+1;
+        }
+    }
+}
+
+/* 削除した行を詰める / drop the deleted lines */
+int
+compact(Peep_Insn *v, int n)
+{
+    int  i, j;
+
+    for (i = j = 0; i < n; i++) {
+        if (v[i].deleted) {
+            free(v[i].label);
+        } else {
+            v[j++] = v[i];
+        }
+    }
+    return j;
+}
+
+void
+print_insn(FILE *out, const Peep_Insn *p)
+{
+    int  k;
+
+    if (p->text != NULL) {
+        fprintf(out, "%s\n", p->text);
+        return;
+    }
+    fprintf(out, "\t%s", p->op);
+    for (k = 0; k < p->nopd; k++) {
+        fprintf(out, "%s%s", k == 0 ? "\t" : ", ", p->opd[k]);
+    }
+    fputc('\n', out);
+}
+
+/* nopdが負なら数は問わない / any number of operands if nopd is negative */
+int
+peep_is(const Peep_Insn *p, const char *op, int nopd)
+{
+    return peep_is_insn(p) && strcmp(p->op, op) == 0
+        && (nopd < 0 || p->nopd == nopd);
+}
+
+/* ラベルでも指示語でもない命令なら1 / 1 if an instruction, not a label or directive */
+int
+peep_is_insn(const Peep_Insn *p)
+{
+    return p->label == NULL && p->op[0] != '\0' && p->op[0] != '.'
+        && p->nopd >= 0;
+}
+
+void
+peep_delete(Peep_Insn *p)
+{
+    p->deleted = 1;
+}
+
+void
+peep_rewrite(Peep_Insn *p, const char *op, int nopd,
+             const char *a, const char *b, const char *c)
+{
+    const char *opds[3];
+    char tmp[3][PEEP_OPD_LEN], tmp_op[sizeof(p->op)];
+    int  k;
+
+    /* 元の命令やオペランドを渡されてもよいように写してから書く
+       Copy first, as the opcode and operands given may be the old ones */
+    opds[0] = a; opds[1] = b; opds[2] = c;
+    for (k = 0; k < nopd && k < 3; k++) {
+        snprintf(tmp[k], PEEP_OPD_LEN, "%s", opds[k]);
+    }
+    snprintf(tmp_op, sizeof(tmp_op), "%s", op);
+    memcpy(p->op, tmp_op, sizeof(p->op));
+    for (k = 0; k < nopd && k < 3; k++) {
+        memcpy(p->opd[k], tmp[k], PEEP_OPD_LEN);
+    }
+    p->nopd = nopd;
+    p->text = NULL;
+}
+
+int
+peep_label_follows(Peep_Insn *w, int n, int k, const char *label)
+{
+    for (k++; k < n && w[k].label != NULL; k++) {
+        if (strcmp(w[k].label, label) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
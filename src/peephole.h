@@ -0,0 +1,63 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    覗き穴最適化 / peephole optimization
+
+    関数ごとに出力したアセンブリを命令の列として溜め、アーキテクチャ
+    依存部の規則表(peep_rules)を先頭から窓をずらしながら当てはめる。
+    規則は書き換えたら1を返し、変化がなくなるまで繰り返す。
+    The assembly emitted for a function is buffered as a list of
+    instructions, and the table of rules in the architecture dependent
+    part (peep_rules) is applied to a window sliding from the top.
+    A rule returns 1 if it rewrote something, and this is repeated until
+    nothing changes.
+*/
+
+#ifndef  PEEPHOLE_H
+#define  PEEPHOLE_H
+
+#include  <stdio.h>
+#include  "ir.h"
+
+#define  PEEP_MAX_OPDS  4	/* オペランドの最大数 / maximum number of operands */
+#define  PEEP_OPD_LEN   40
+
+/* 出力の1行 / a line of the output */
+typedef struct Peep_Insn {
+    char *text;			/* 元の行（書き換えたらNULL）/ the line, NULL once rewritten */
+    char *label;		/* ラベル行ならその名前 / name if a label line */
+    char op[16];		/* 命令（指示語なら'.'で始まる）/ opcode ('.' for directives) */
+    int  nopd;			/* オペランドの数 / number of operands */
+    char opd[PEEP_MAX_OPDS][PEEP_OPD_LEN];
+    int  deleted;
+} Peep_Insn;
+
+/*
+  w[0]から始まる窓（後にn-1命令ある）に当てはめ、書き換えたら1を返す
+  Applied to the window starting at w[0], followed by n-1 instructions;
+  returns 1 if it rewrote them
+*/
+typedef struct Peep_Rule {
+    const char *name;
+    int  (*apply)(Peep_Insn *w, int n);
+} Peep_Rule;
+
+/* アーキテクチャ依存部の規則表（nameがNULLで終わる）
+   Rules of the architecture dependent part (terminated by a NULL name) */
+extern const Peep_Rule peep_rules[];
+
+/* 関数の出力textに規則を当てはめてoutに書く
+   Apply the rules to text emitted for f and write it to out */
+extern void peephole(FILE *out, char *text, IR_Func *f);
+
+/* 規則から使う補助 / helpers for the rules */
+extern int  peep_is(const Peep_Insn *p, const char *op, int nopd);
+extern int  peep_is_insn(const Peep_Insn *p);
+extern void peep_delete(Peep_Insn *p);
+extern void peep_rewrite(Peep_Insn *p, const char *op, int nopd,
+                         const char *a, const char *b, const char *c);
+/* w[k]の直後から続くラベルにlabelがあれば1
+   1 if label is among the labels right after w[k] */
+extern int  peep_label_follows(Peep_Insn *w, int n, int k, const char *label);
+
+#endif	/* PEEPHOLE_H */
@@ -0,0 +1,456 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    純粋関数の呼び出しの最適化 / optimization of pure function calls
+
+    TLには大域変数もポインタもないので、put_intなどの外部の関数も副作用
+    のある関数も呼ばない関数は純粋（結果が引数だけで決まり、副作用が
+    ない）である。これを呼び出しグラフの上で求める。
+    純粋な関数を定数の引数で呼ぶ呼び出しは、ASTを解釈して翻訳時に
+    評価し、その値で置き換える。解釈は-feval-limit=Nの歩数で打ち切り、
+    0での除算や値のないreturnのように値が決まらないときも諦める。
+    同じ引数で純粋な関数を呼ぶ呼び出しが、それを支配する呼び出しの後に
+    あれば、前の呼び出しの値を使って取り除く。
+
+    TL has no globals or pointers, so a function calling neither
+    external functions such as put_int nor functions with side effects
+    is pure: its result depends only on its arguments and it has no
+    side effects.  This is computed over the call graph.
+    A call to a pure function with constant arguments is evaluated at
+    compile time by interpreting the AST and replaced with the value.
+    The interpretation gives up after -feval-limit=N steps, or when the
+    value is undefined as in a division by zero or a return without a
+    value.  A pure call with the same arguments as a call dominating it
+    is removed, using the value of the earlier call.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  "ast.h"
+#include  "ir.h"
+#include  "opt.h"
+#include  "option.h"
+#include  "symtab.h"
+#include  "util.h"
+
+/* 解釈中の関数の変数 / variables of the function being interpreted */
+typedef struct Eval_Frame {
+    int  *vals;			/* エントリー番号で引く / indexed by entry id */
+    char *set;			/* 値が入っていれば1 / 1 if assigned */
+    int  returned;
+    int  ret;
+} Eval_Frame;
+
+/* 解釈での呼び出しの深さの上限 / maximum call depth in interpretation */
+#define  EVAL_MAX_DEPTH  1000
+
+static int  steps;		/* 残りの歩数 / remaining steps */
+static int  depth;
+
+static IR_Func *pure_callee(IR_Insn *call);
+static AST_Node *find_ast_func(const char *name);
+static int  eval_func(AST_Node *func, int nargs, int *args, int *val);
+static int  eval_stm(AST_Node *s, Eval_Frame *fr);
+static int  eval_exp(AST_Node *e, Eval_Frame *fr, int *val);
+static int  same_args(int *a, int *b, int n);
+
+/* 各関数が純粋かを求める / find out whether each function is pure */
+void
+find_pure_functions(void)
+{
+    int  changed;
+    IR_Block *b;
+    IR_Insn *i;
+    IR_Func *f, *g;
+
+    for (f = IR_funcs; f != NULL; f = f->next) {
+        f->pure = 1;
+    }
+    do {
+        changed = 0;
+        for (f = IR_funcs; f != NULL; f = f->next) {
+            if (!f->pure) {
+                continue;
+            }
+            FOR_EACH_BLOCK(b, f) {
+                FOR_EACH_INSN(i, b) {
+                    if ((i->op == IR_CALL || i->op == IR_TAILCALL)
+                        && ((g = ir_find_func(i->name)) == NULL || !g->pure)) {
+                        f->pure = 0;
+                    }
+                }
+            }
+            changed |= !f->pure;
+        }
+    } while (changed);
+}
+
+/* 定数の引数での純粋な呼び出しを評価し、その数を返す
+   Evaluate pure calls with constant arguments and return the number of
+   them */
+int
+eval_pure_calls(IR_Func *f)
+{
+    int  n, k, val, ok, *args;
+    IR_Block *b;
+    IR_Insn *i, *next, *begin, *c, **def;
+    IR_Func *g;
+    AST_Node *func;
+
+    def = xcalloc(f->nvregs+1, sizeof(IR_Insn*));
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->dst != 0) {
+                def[i->dst] = i;
+            }
+        }
+    }
+    n = 0;
+    FOR_EACH_BLOCK(b, f) {
+        for (i = b->head; i != NULL; i = next) {
+            next = i->next;
+            if ((g = pure_callee(i)) == NULL
+                || (func = find_ast_func(g->origin != NULL ? g->origin->name : g->name))
+                   == NULL) {
+                continue;
+            }
+            args = xcalloc(i->imm+1, sizeof(int));
+            ok = (begin = ir_call_begin(i, args)) != NULL;
+            for (k = 1; ok && k <= i->imm; k++) {
+                if (args[k] == 0 || def[args[k]] == NULL || def[args[k]]->op != IR_CONST) {
+                    ok = 0;
+                } else {
+                    args[k] = def[args[k]]->imm;
+                }
+            }
+            steps = eval_limit;
+            depth = 0;
+            if (ok && eval_func(func, i->imm, args, &val)) {
+                if (i->dst != 0) {
+                    c = ir_new_insn(IR_CONST);
+                    c->dst = i->dst;
+                    c->imm = val;
+                    ir_insert_before(i, c);
+                    def[c->dst] = c;
+                }
+                ir_remove_call_args(begin, i);
+                ir_remove(i);
+                n++;
+            }
+            free(args);
+        }
+    }
+    free(def);
+    return n;
+}
+
+/* 支配する呼び出しと同じ引数の純粋な呼び出しを取り除き、その数を返す
+   Remove pure calls with the same arguments as a dominating call and
+   return the number of them */
+int
+remove_repeated_calls(IR_Func *f)
+{
+    int  n, j, k, ncalls, **args;
+    IR_Block *b, **blk;
+    IR_Insn *i, **calls;
+
+    compute_dominators(f);
+    calls = NULL;
+    blk = NULL;
+    args = NULL;
+    ncalls = 0;
+    n = 0;
+    for (k = 0; k < f->nrpo; k++) {
+        b = f->rpo[k];
+        FOR_EACH_INSN(i, b) {
+            if (pure_callee(i) == NULL) {
+                continue;
+            }
+            calls = xrealloc(calls, (ncalls+1)*sizeof(IR_Insn*));
+            blk = xrealloc(blk, (ncalls+1)*sizeof(IR_Block*));
+            args = xrealloc(args, (ncalls+1)*sizeof(int*));
+            calls[ncalls] = i;
+            blk[ncalls] = b;
+            args[ncalls] = xcalloc(i->imm+1, sizeof(int));
+            if (ir_call_begin(i, args[ncalls]) == NULL) {
+                free(args[ncalls]);
+                continue;
+            }
+            ncalls++;
+        }
+    }
+
+    /* 逆後順では支配する呼び出しが先に来る
+       A dominating call comes first in the reverse postorder */
+    for (k = 1; k < ncalls; k++) {
+        for (j = 0; j < k; j++) {
+            if (calls[j] != NULL && strcmp(calls[j]->name, calls[k]->name) == 0
+                && (calls[k]->dst == 0 || calls[j]->dst != 0)
+                && same_args(args[j], args[k], calls[k]->imm)
+                && dominates(blk[j], blk[k])) {
+                break;
+            }
+        }
+        if (j == k) {
+            continue;
+        }
+        if (calls[k]->dst != 0) {
+            ir_replace_vreg(f, calls[k]->dst, calls[j]->dst);
+        }
+        ir_remove_call_args(ir_call_begin(calls[k], NULL), calls[k]);
+        ir_remove(calls[k]);
+        calls[k] = NULL;
+        n++;
+    }
+
+    for (k = 0; k < ncalls; k++) {
+        free(args[k]);
+    }
+    free(args);
+    free(calls);
+    free(blk);
+    return n;
+}
+
+/* iが純粋な関数の呼び出しならその関数 / the callee if i calls a pure function */
+IR_Func*
+pure_callee(IR_Insn *i)
+{
+    IR_Func *g;
+
+    if (i->op != IR_CALL || (g = ir_find_func(i->name)) == NULL || !g->pure
+        || i->imm != g->nparams) {
+        return NULL;
+    }
+    return g;
+}
+
+AST_Node*
+find_ast_func(const char *name)
+{
+    AST_List *l;
+
+    TRAVERSE_AST_LIST(l, AST_root, {
+        if (strcmp(l->elem->child[0]->str, name) == 0) {
+            return l->elem;
+        }
+    });
+    return NULL;
+}
+
+/*
+ * 関数funcを引数argsで解釈し、値を*valに入れる。評価できれば1を返す
+ * Interpret func with args and store the value in *val.  Returns 1 if
+ * evaluated.
+ */
+int
+eval_func(AST_Node *func, int nargs, int *args, int *val)
+{
+    int  k, size, ok;
+    AST_List *l;
+    SymTab *t;
+    Eval_Frame fr;
+
+    if (++depth > EVAL_MAX_DEPTH) {
+        return 0;
+    }
+    size = 0;
+    for (t = get_symtab(func->id); t != NULL; t = t->next) {
+        if (size <= t->entry) {
+            size = t->entry+1;
+        }
+    }
+    fr.vals = xcalloc(size, sizeof(int));
+    fr.set = xcalloc(size, sizeof(char));
+    fr.returned = 0;
+    fr.ret = 0;
+    k = 0;
+    TRAVERSE_AST_LIST(l, func->list, {
+        if (++k <= nargs) {
+            t = l->elem->child[0]->symtab;
+            fr.vals[t->entry] = args[k];
+            fr.set[t->entry] = 1;
+        }
+    });
+    ok = 0;
+    if (k == nargs) {
+        ok = 1;
+        TRAVERSE_AST_LIST(l, func->child[1]->list, {
+            if (ok && !fr.returned) {
+                ok = eval_stm(l->elem, &fr);
+            }
+        });
+        ok = ok && fr.returned;
+        *val = fr.ret;
+    }
+    free(fr.vals);
+    free(fr.set);
+    depth--;
+    return ok;
+}
+
+/* 文を解釈する。打ち切れば0 / interpret a statement; 0 if given up */
+int
+eval_stm(AST_Node *s, Eval_Frame *fr)
+{
+    int  c, v;
+    AST_List *l;
+
+    if (s == NULL) {
+        return 1;
+    }
+    if (--steps < 0) {
+        return 0;
+    }
+    switch (s->sub_kind) {
+    case  AST_STM_LIST:
+        TRAVERSE_AST_LIST(l, s->list, {
+            if (!eval_stm(l->elem, fr)) {
+                return 0;
+            }
+            if (fr->returned) {
+                return 1;
+            }
+        });
+        return 1;
+    case  AST_STM_DEC:
+        return 1;
+    case  AST_STM_ASIGN:
+        return eval_exp(s->child[0], fr, &v);
+    case  AST_STM_IF:
+        if (!eval_exp(s->child[0], fr, &c)) {
+            return 0;
+        }
+        return eval_stm(c ? s->child[1] : s->child[2], fr);
+    case  AST_STM_WHILE:
+        for (;;) {
+            if (!eval_exp(s->child[0], fr, &c)) {
+                return 0;
+            }
+            if (!c) {
+                return 1;
+            }
+            if (!eval_stm(s->child[1], fr)) {
+                return 0;
+            }
+            if (fr->returned) {
+                return 1;
+            }
+        }
+    case  AST_STM_FOR:
+        if (!eval_exp(s->child[0], fr, &v)) {
+            return 0;
+        }
+        for (;;) {
+            if (!eval_exp(s->child[1], fr, &c)) {
+                return 0;
+            }
+            if (!c) {
+                return 1;
+            }
+            if (!eval_stm(s->child[3], fr)) {
+                return 0;
+            }
+            if (fr->returned) {
+                return 1;
+            }
+            if (!eval_exp(s->child[2], fr, &v)) {
+                return 0;
+            }
+        }
+    case  AST_STM_DOWHILE:
+        do {
+            if (!eval_stm(s->child[0], fr)) {
+                return 0;
+            }
+            if (fr->returned) {
+                return 1;
+            }
+            if (!eval_exp(s->child[1], fr, &c)) {
+                return 0;
+            }
+        } while (c);
+        return 1;
+    case  AST_STM_RETURN:
+        if (s->child[0] == NULL || !eval_exp(s->child[0], fr, &fr->ret)) {
+            return 0;
+        }
+        fr->returned = 1;
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* 式を解釈する。打ち切れば0 / interpret an expression; 0 if given up */
+int
+eval_exp(AST_Node *e, Eval_Frame *fr, int *val)
+{
+    int  n, a, b, *args;
+    AST_List *l;
+    AST_Node *func;
+
+    if (e == NULL) {
+        *val = 0;
+        return 1;
+    }
+    if (--steps < 0) {
+        return 0;
+    }
+    switch (e->sub_kind) {
+    case  AST_EXP_ASGN:
+        if (e->child[0]->sub_kind != AST_EXP_IDENT || !eval_exp(e->child[1], fr, val)) {
+            return 0;
+        }
+        fr->vals[e->child[0]->symtab->entry] = *val;
+        fr->set[e->child[0]->symtab->entry] = 1;
+        return 1;
+    case  AST_EXP_IDENT:
+        if (!fr->set[e->symtab->entry]) {
+            return 0;		/* 未初期化 / uninitialized */
+        }
+        *val = fr->vals[e->symtab->entry];
+        return 1;
+    case  AST_EXP_CNST_INT:
+        *val = e->val;
+        return 1;
+    case  AST_EXP_CALL:
+        if ((func = find_ast_func(e->child[0]->str)) == NULL) {
+            return 0;
+        }
+        n = 0;
+        TRAVERSE_AST_LIST(l, e->list, ++n);
+        args = xcalloc(n+1, sizeof(int));
+        n = 0;
+        TRAVERSE_AST_LIST(l, e->list, {
+            if (!eval_exp(l->elem, fr, &args[++n])) {
+                free(args);
+                return 0;
+            }
+        });
+        a = eval_func(func, n, args, val);
+        free(args);
+        return a;
+    default:
+        b = 0;
+        if (!eval_exp(e->child[0], fr, &a)
+            || (e->child[1] != NULL && !eval_exp(e->child[1], fr, &b))) {
+            return 0;
+        }
+        return fold_const(e->sub_kind, a, b, val);
+    }
+}
+
+int
+same_args(int *a, int *b, int n)
+{
+    int  k;
+
+    for (k = 1; k <= n; k++) {
+        if (a[k] != b[k]) {
+            return 0;
+        }
+    }
+    return 1;
+}
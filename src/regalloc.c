@@ -0,0 +1,695 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    レジスタ割り付け / register allocation
+
+    線形走査法 (Poletto and Sarkar)。命令に通し番号を振り、ブロック単位の
+    生存解析から仮想レジスタごとに1本の生存区間を作る。区間を始点の順に
+    見て、空いている物理レジスタを割り当てる。呼び出しをまたぐ区間には
+    呼び出し先退避レジスタを、それ以外には呼び出し元退避レジスタを
+    優先し、呼び出しのたびの退避を避ける。
+    空きがなければ終点が最も遠い区間をスピルし、定数なら参照の直前で
+    作り直し、そうでなければスタック上の一時変数を介して読み書きする。
+    スピルがなくなるまで繰り返す。
+    実引数用のレジスタは呼び出し列で使うので割り付けない (グラフ彩色
+    だけが値を合併する)。呼び出し元退避レジスタは従来どおり呼び出しの
+    前後で退避し、呼び出し先退避レジスタは関数の入口で退避する
+    (arch_*.c)。
+    -O0ではASTに割り付けたレジスタ(cg.c)をそのまま使い、それで足りない
+    関数だけをここで割り付け直す。-O2以上と-fregalloc=graphではグラフ
+    彩色(color.c)を使う。
+
+    Linear scan (Poletto and Sarkar).  Instructions are numbered and
+    block-level liveness gives one live interval per virtual register.
+    Intervals are visited in order of their starts, and each gets a free
+    physical register: a callee-saved one first if it lives across a
+    call, a caller-saved one first otherwise, which avoids saving it
+    around every call.  When none is free, the
+    interval ending furthest away is spilled: a constant is rematerialized
+    just before each use, anything else goes through a temporary in the
+    stack.  This is repeated until nothing is spilled.
+    The argument registers are left out since call sequences use them;
+    only graph coloring merges values into them.
+    Caller-saved registers are saved around calls as before, and
+    callee-saved ones are saved on function entry (arch_*.c).
+    At -O0 the registers assigned to the AST (cg.c) are used as is, and
+    only the functions for which they do not suffice are reallocated here.
+    At -O2 and above, or with -fregalloc=graph, graph coloring (color.c)
+    is used instead.
+*/
+
+#include  <limits.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  "arch_common.h"
+#include  "ir.h"
+#include  "opt.h"
+#include  "option.h"
+#include  "regalloc.h"
+#include  "symtab.h"
+#include  "util.h"
+
+#define  NUM_SCRATCH 3		/* ASTに割り付けるレジスタの数 / registers for the AST (cg.c) */
+
+/* 1回の割り付けの状態 / state of one round of allocation */
+typedef struct Scan {
+    IR_Func *f;
+    int  nv;			/* 仮想レジスタの数+1 / number of registers + 1 */
+    int  orig_nv;		/* これより大きいのはスピル用の一時 / temporaries above this */
+    int  *start, *end;		/* 生存区間 / live intervals */
+    unsigned int *forbid;	/* 使えない物理レジスタ / physical registers not allowed */
+    char *crosses;		/* 呼び出しをまたぐ / live across a call */
+    int  *reg;			/* 割り付け結果 (-1: なし) / result (-1: none) */
+    char *spill;
+    int  pre_from;		/* ここから引数レジスタも使える / argument registers usable from here */
+} Scan;
+
+static int  needs_realloc(IR_Func *f);
+static void linear_scan(IR_Func *f);
+static void number_insns(IR_Func *f);
+static void build_intervals(Scan *s);
+static void add_call_constraints(Scan *s);
+static int  param_regs_from(IR_Func *f);
+static int  scan_intervals(Scan *s);
+static int  pick_reg(Scan *s, int v, unsigned int busy);
+static int  const_def(IR_Func *f, int v, int *imm);
+
+void
+regalloc(IR_Func *f)
+{
+    IR_Block *b;
+    IR_Insn *i;
+
+    if (opt_level == 0 && !needs_realloc(f)) {
+        /* ASTのレジスタはすべて退避する / save all of the AST registers */
+        FOR_EACH_BLOCK(b, f) {
+            FOR_EACH_INSN(i, b) {
+                if (i->op == IR_CALL) {
+                    i->save = (1u << NUM_SCRATCH)-1;
+                }
+            }
+        }
+        f->callee_saved = 0;
+        return;
+    }
+    if (flag_regalloc_graph > 0 || (flag_regalloc_graph < 0 && opt_level >= 2)) {
+        color_regs(f);
+    } else {
+        linear_scan(f);
+    }
+}
+
+/* ASTでレジスタが足りなかった値がある / some value ran out of AST registers */
+int
+needs_realloc(IR_Func *f)
+{
+    int  k;
+    IR_Block *b;
+    IR_Insn *i;
+
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->dst != 0 && f->phys[i->dst] < 0) {
+                return 1;
+            }
+            for (k = 0; k < ir_num_uses(i); k++) {
+                if (f->phys[*ir_use(i, k)] < 0) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+void
+linear_scan(IR_Func *f)
+{
+    int  v, nspill, slots;
+    SymTab *slot;
+    Scan s;
+
+    s.f = f;
+    s.orig_nv = f->nvregs;
+    slots = 0;
+    for (;;) {
+        ir_build_cfg(f);
+        number_insns(f);
+        s.nv = f->nvregs+1;
+        s.start = xmalloc(s.nv*sizeof(int));
+        s.end = xmalloc(s.nv*sizeof(int));
+        s.forbid = xcalloc(s.nv, sizeof(unsigned int));
+        s.crosses = xcalloc(s.nv, 1);
+        s.reg = xmalloc(s.nv*sizeof(int));
+        s.spill = xcalloc(s.nv, 1);
+        build_intervals(&s);
+        add_call_constraints(&s);
+        s.pre_from = param_regs_from(f);
+        nspill = scan_intervals(&s);
+        if (nspill == 0) {
+            break;
+        }
+        for (v = 1; v < s.nv; v++) {
+            if (s.spill[v]) {
+                slot = NULL;
+                spill_vreg(f, v, &slot);
+                slots += slot != NULL;
+            }
+        }
+        free(s.start); free(s.end); free(s.forbid); free(s.crosses);
+        free(s.reg); free(s.spill);
+    }
+
+    set_phys_regs(f, s.reg, s.nv);
+    free(s.start); free(s.end); free(s.forbid); free(s.crosses);
+    free(s.reg); free(s.spill);
+    if (slots > 0) {
+        reassign_memory(f->id);
+    }
+}
+
+/*
+  割り付け結果をphysに写し、使う呼び出し先退避レジスタの集合と呼び出し
+  ごとに退避するレジスタを求める
+  Copy the result into phys, and find the set of callee-saved registers
+  used and the registers saved around each call
+*/
+void
+set_phys_regs(IR_Func *f, const int *reg, int nv)
+{
+    int  v;
+
+    f->callee_saved = 0;
+    for (v = 1; v < nv; v++) {
+        f->phys[v] = reg[v];
+        if (reg[v] >= FIRST_CALLEE_SAVED && reg[v] < NUM_REGS) {
+            f->callee_saved |= 1u << reg[v];
+        }
+    }
+    set_call_saves(f, NULL);
+}
+
+/*
+  呼び出しの後も生きている値の呼び出し元退避レジスタだけを退避する。
+  何も生きていなければ呼び出しの前後で何もしない。writtenがNULLでなければ
+  written[v]が0の値（レジスタに書かれない値）は退避しない
+  Save only the caller-saved registers of values still live after each
+  call, so that nothing is done around a call across which nothing lives.
+  Unless written is NULL, values with written[v] == 0 (never put in a
+  register) are not saved.
+*/
+void
+set_call_saves(IR_Func *f, const char *written)
+{
+    int  v, k, words, nv;
+    unsigned int **in, **out, *live;
+    IR_Block *b;
+    IR_Insn *i;
+
+    ir_build_cfg(f);
+    nv = f->nvregs+1;
+    compute_liveness(f, nv, &in, &out);
+    words = (nv+BITS-1)/BITS;
+    live = xmalloc(words*sizeof(unsigned int));
+    FOR_EACH_BLOCK(b, f) {
+        memcpy(live, out[b->id], words*sizeof(unsigned int));
+        for (i = b->tail; i != NULL; i = i->prev) {
+            if (i->op == IR_CALL) {
+                i->save = 0;
+                for (v = 1; v < nv; v++) {
+                    if (TEST_BIT(live, v) && v != i->dst && f->phys[v] >= 0
+                        && f->phys[v] < FIRST_CALLEE_SAVED
+                        && (written == NULL || written[v])) {
+                        i->save |= 1u << f->phys[v];
+                    }
+                }
+            }
+            if (i->dst != 0) {
+                CLEAR_BIT(live, i->dst);
+            }
+            for (k = 0; k < ir_num_uses(i); k++) {
+                SET_BIT(live, *ir_use(i, k));
+            }
+        }
+    }
+    free(live);
+    free_liveness(f, in, out);
+}
+
+/*
+  配置順に命令の番号をmarkに入れる。k番目の命令の参照は2k、定義は2k+1
+  の位置とする
+  Number the instructions in layout order into mark.  The uses of
+  instruction #k are at position 2k and its def at 2k+1.
+*/
+void
+number_insns(IR_Func *f)
+{
+    int  n;
+    IR_Block *b;
+    IR_Insn *i;
+
+    n = 0;
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            i->mark = n++;
+        }
+    }
+}
+
+/*
+  ブロックの入口と出口で生きている仮想レジスタの集合をブロック番号で
+  引く表にして返す
+  Return the sets of registers live into and out of each block, in
+  tables indexed by block id
+*/
+void
+compute_liveness(IR_Func *f, int nv, unsigned int ***live_in,
+                 unsigned int ***live_out)
+{
+    int  words, n, k, j, v, changed;
+    unsigned int **gen, **kill, **in, **out, w;
+    IR_Block *b;
+    IR_Insn *i;
+
+    words = (nv+BITS-1)/BITS;
+    n = f->nblocks;
+    gen = xcalloc(n, sizeof(unsigned int*));
+    kill = xcalloc(n, sizeof(unsigned int*));
+    in = xcalloc(n, sizeof(unsigned int*));
+    out = xcalloc(n, sizeof(unsigned int*));
+    FOR_EACH_BLOCK(b, f) {
+        gen[b->id] = xcalloc(words, sizeof(unsigned int));
+        kill[b->id] = xcalloc(words, sizeof(unsigned int));
+        in[b->id] = xcalloc(words, sizeof(unsigned int));
+        out[b->id] = xcalloc(words, sizeof(unsigned int));
+        FOR_EACH_INSN(i, b) {
+            for (k = 0; k < ir_num_uses(i); k++) {
+                v = *ir_use(i, k);
+                if (!TEST_BIT(kill[b->id], v)) {
+                    SET_BIT(gen[b->id], v);
+                }
+            }
+            if (i->dst != 0) {
+                SET_BIT(kill[b->id], i->dst);
+            }
+        }
+    }
+
+    /* 後ろ向きの反復 / backward iteration */
+    do {
+        changed = 0;
+        for (b = f->last; b != NULL; b = b->prev) {
+            for (k = 0; k < b->nsucc; k++) {
+                for (j = 0; j < words; j++) {
+                    out[b->id][j] |= in[b->succ[k]->id][j];
+                }
+            }
+            for (j = 0; j < words; j++) {
+                w = gen[b->id][j] | (out[b->id][j] & ~kill[b->id][j]);
+                if (w != in[b->id][j]) {
+                    in[b->id][j] = w;
+                    changed = 1;
+                }
+            }
+        }
+    } while (changed);
+
+    for (j = 0; j < n; j++) {
+        free(gen[j]);
+        free(kill[j]);
+    }
+    free(gen);
+    free(kill);
+    *live_in = in;
+    *live_out = out;
+}
+
+void
+free_liveness(IR_Func *f, unsigned int **live_in, unsigned int **live_out)
+{
+    int  j;
+
+    for (j = 0; j < f->nblocks; j++) {
+        free(live_in[j]);
+        free(live_out[j]);
+    }
+    free(live_in);
+    free(live_out);
+}
+
+/*
+  ブロックの入口で生きている値は入口から、出口で生きている値は出口まで
+  区間を延ばす。配置が飛び飛びのループでも区間は1本で、その分は保守的
+  Extend an interval to the start of each block it is live into and to
+  the end of each block it is live out of.  Loops laid out apart still
+  get a single, conservative interval.
+*/
+void
+build_intervals(Scan *s)
+{
+    int  n, k, v, pos;
+    int  *first, *last;
+    unsigned int **in, **out;
+    IR_Func *f = s->f;
+    IR_Block *b;
+    IR_Insn *i;
+
+    compute_liveness(f, s->nv, &in, &out);
+    n = f->nblocks;
+    first = xmalloc(n*sizeof(int));
+    last = xmalloc(n*sizeof(int));
+    pos = 0;
+    FOR_EACH_BLOCK(b, f) {
+        first[b->id] = 2*pos;
+        FOR_EACH_INSN(i, b) {
+            pos++;
+        }
+        last[b->id] = 2*pos-1;
+    }
+
+    for (v = 0; v < s->nv; v++) {
+        s->start[v] = INT_MAX;
+        s->end[v] = -1;
+    }
+#define  EXTEND(v, p)  do { \
+        if ((p) < s->start[v]) s->start[v] = (p); \
+        if ((p) > s->end[v]) s->end[v] = (p); \
+    } while (0)
+    FOR_EACH_BLOCK(b, f) {
+        for (v = 1; v < s->nv; v++) {
+            if (TEST_BIT(in[b->id], v)) {
+                EXTEND(v, first[b->id]);
+            }
+            if (TEST_BIT(out[b->id], v)) {
+                EXTEND(v, last[b->id]+1);
+            }
+        }
+        FOR_EACH_INSN(i, b) {
+            for (k = 0; k < ir_num_uses(i); k++) {
+                EXTEND(*ir_use(i, k), 2*i->mark);
+            }
+            if (i->dst != 0) {
+                EXTEND(i->dst, 2*i->mark+1);
+            }
+        }
+    }
+#undef  EXTEND
+    free_liveness(f, in, out);
+    free(first); free(last);
+}
+
+/*
+  呼び出しをまたぐ値の制約。呼び出し列の開始で退避して呼び出し後に戻す
+  ので、開始より後に定義された値は呼び出し元退避レジスタに置けない。
+  戻り値を使わない呼び出しはレジスタ0を退避しない (cg.c)
+  Constraints on values live across a call.  Registers are saved at the
+  start of the call sequence and restored after the call, so a value
+  defined after the start cannot be in a caller-saved register.  A call
+  whose value is unused does not save register 0 (cg.c).
+*/
+void
+add_call_constraints(Scan *s)
+{
+    int  v, pc, pb, r;
+    unsigned int caller;
+    IR_Block *b;
+    IR_Insn *i, *begin;
+
+    caller = 0;
+    for (r = 0; r < FIRST_CALLEE_SAVED; r++) {
+        caller |= 1u << r;
+    }
+    FOR_EACH_BLOCK(b, s->f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->op != IR_CALL) {
+                continue;
+            }
+            pc = 2*i->mark+1;
+            begin = ir_call_begin(i, NULL);
+            pb = begin != NULL ? 2*begin->mark : -1;
+            for (v = 1; v < s->nv; v++) {
+                if (s->start[v] >= pc || s->end[v] <= pc) {
+                    continue;
+                }
+                s->crosses[v] = 1;
+                if (i->dst == 0) {
+                    s->forbid[v] |= 1u;
+                }
+                if (s->start[v] > pb) {
+                    s->forbid[v] |= caller;
+                }
+            }
+        }
+    }
+}
+
+/*
+  呼び出しのない関数では、引数をすべて読んだ後の区間に引数レジスタも
+  使える。その位置を返す (INT_MAX: 使えない)
+  In a function without calls, intervals starting after all of the
+  parameters are read may use the argument registers as well.  Return
+  that position (INT_MAX: never).
+*/
+int
+param_regs_from(IR_Func *f)
+{
+    int  pos;
+    IR_Block *b;
+    IR_Insn *i;
+
+    pos = 0;
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            switch (i->op) {
+            case  IR_CALL_BEGIN:
+            case  IR_CALL:
+            case  IR_TAILCALL:
+                return INT_MAX;
+            case  IR_PARAM:
+                if (b != f->first || b->npred > 0) {
+                    return INT_MAX;
+                }
+                pos = 2*i->mark+2;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    return pos;
+}
+
+/*
+  区間を始点の順に割り付け、スピルした数を返す。スピル用の一時はスピル
+  しない
+  Allocate the intervals in order of their starts and return the number
+  of spills.  Spill temporaries are never spilled.
+*/
+int
+scan_intervals(Scan *s)
+{
+    int  n, k, j, v, r, nact, victim, nspill, maxpos;
+    int  *order, *count, *active;
+    unsigned int busy;
+
+    maxpos = 0;
+    for (v = 1; v < s->nv; v++) {
+        s->reg[v] = -1;
+        if (s->end[v] >= 0 && s->start[v] > maxpos) {
+            maxpos = s->start[v];
+        }
+    }
+    s->reg[0] = -1;
+
+    /* 始点による分布数え上げソート / counting sort by start */
+    count = xcalloc(maxpos+2, sizeof(int));
+    for (v = 1; v < s->nv; v++) {
+        if (s->end[v] >= 0) {
+            count[s->start[v]+1]++;
+        }
+    }
+    for (k = 0; k <= maxpos; k++) {
+        count[k+1] += count[k];
+    }
+    n = count[maxpos+1];
+    order = xmalloc((n+1)*sizeof(int));
+    for (v = 1; v < s->nv; v++) {
+        if (s->end[v] >= 0) {
+            order[count[s->start[v]]++] = v;
+        }
+    }
+    free(count);
+
+    active = xmalloc((NUM_REGS+NUM_PARAM_REGS+1)*sizeof(int));
+    nact = 0;
+    nspill = 0;
+    for (k = 0; k < n; k++) {
+        v = order[k];
+        /* 終わった区間を外す / expire finished intervals */
+        busy = 0;
+        for (j = 0; j < nact; ) {
+            if (s->end[active[j]] < s->start[v]) {
+                active[j] = active[--nact];
+            } else {
+                busy |= 1u << s->reg[active[j]];
+                j++;
+            }
+        }
+        if ((r = pick_reg(s, v, busy)) >= 0) {
+            s->reg[v] = r;
+            active[nact++] = v;
+            continue;
+        }
+        /* 終点が最も遠いものをスピル / spill the one ending furthest */
+        victim = -1;
+        for (j = 0; j < nact; j++) {
+            if (active[j] <= s->orig_nv
+                && (s->forbid[v] >> s->reg[active[j]] & 1) == 0
+                && (victim < 0 || s->end[active[j]] > s->end[active[victim]])) {
+                victim = j;
+            }
+        }
+        if (victim >= 0
+            && (v > s->orig_nv || s->end[active[victim]] > s->end[v])) {
+            s->reg[v] = s->reg[active[victim]];
+            s->reg[active[victim]] = -1;
+            s->spill[active[victim]] = 1;
+            active[victim] = v;
+        } else if (v <= s->orig_nv) {
+            s->spill[v] = 1;
+        } else {
+            errexit("Number of registers is not sufficient.",
+                    __FILE__, __LINE__);
+        }
+        nspill++;
+    }
+    free(active);
+    free(order);
+    return nspill;
+}
+
+/*
+  呼び出しをまたぐなら呼び出し先退避レジスタから、そうでなければ呼び出し元
+  退避レジスタ、使えるなら引数レジスタ、呼び出し先退避レジスタの順に空きを
+  探す (-1: なし)
+  Look for a free register among the callee-saved ones first if v lives
+  across a call.  Otherwise try the caller-saved ones, the argument
+  registers if usable, and then the callee-saved ones (-1: none).
+*/
+int
+pick_reg(Scan *s, int v, unsigned int busy)
+{
+    int  k, r;
+    unsigned int taken = busy | s->forbid[v];
+
+    if (!s->crosses[v]) {
+        for (r = 0; r < FIRST_CALLEE_SAVED; r++) {
+            if ((taken >> r & 1) == 0) {
+                return r;
+            }
+        }
+        if (s->start[v] >= s->pre_from) {
+            for (r = NUM_REGS; r < NUM_REGS+NUM_PARAM_REGS; r++) {
+                if ((taken >> r & 1) == 0) {
+                    return r;
+                }
+            }
+        }
+    }
+    for (k = 0; k < NUM_REGS; k++) {
+        r = (k+FIRST_CALLEE_SAVED)%NUM_REGS;
+        if ((taken >> r & 1) == 0) {
+            return r;
+        }
+    }
+    return -1;
+}
+
+/*
+  vの定義がすべて同じ値の定数ならその値をimmに入れて1を返す
+  Return 1 with the value in imm if every def of v is the same constant
+*/
+int
+const_def(IR_Func *f, int v, int *imm)
+{
+    int  n;
+    IR_Block *b;
+    IR_Insn *i;
+
+    n = 0;
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if (i->dst != v) {
+                continue;
+            }
+            if (i->op != IR_CONST || (n > 0 && i->imm != *imm)) {
+                return 0;
+            }
+            *imm = i->imm;
+            n++;
+        }
+    }
+    return n > 0;
+}
+
+/*
+  vを参照ごと・定義ごとの短い一時に分ける。定数は参照の直前で作り直し、
+  それ以外は一時変数*slotを介する
+  Split v into short temporaries for each use and def.  A constant is
+  rematerialized just before each use; anything else goes through the
+  temporary variable *slot.
+*/
+void
+spill_vreg(IR_Func *f, int v, SymTab **slot)
+{
+    int  k, t, imm, remat;
+    IR_Block *b;
+    IR_Insn *i, *next, *m;
+
+    imm = 0;
+    remat = const_def(f, v, &imm);
+    FOR_EACH_BLOCK(b, f) {
+        for (i = b->head; i != NULL; i = next) {
+            next = i->next;
+            if (remat && i->dst == v) {
+                ir_remove(i);
+                continue;
+            }
+            t = 0;
+            for (k = 0; k < ir_num_uses(i); k++) {
+                if (*ir_use(i, k) != v) {
+                    continue;
+                }
+                if (t == 0) {
+                    t = ir_new_vreg(f);
+                    if (remat) {
+                        m = ir_new_insn(IR_CONST);
+                        m->imm = imm;
+                    } else {
+                        if (*slot == NULL) {
+                            *slot = append_temp_sym(f->id);
+                        }
+                        m = ir_new_insn(IR_LOAD);
+                        m->sym = *slot;
+                    }
+                    m->dst = t;
+                    ir_insert_before(i, m);
+                }
+                *ir_use(i, k) = t;
+            }
+            if (i->dst == v) {
+                if (*slot == NULL) {
+                    *slot = append_temp_sym(f->id);
+                }
+                t = ir_new_vreg(f);
+                m = ir_new_insn(IR_STORE);
+                m->src[0] = t;
+                m->sym = *slot;
+                ir_insert_after(i, m);
+                i->dst = t;
+            }
+        }
+    }
+}
@@ -0,0 +1,45 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    レジスタ割り付けの共通部分 / common part of the register allocators
+
+    線形走査法(regalloc.c)とグラフ彩色(color.c)で共有する。
+    Shared by linear scan (regalloc.c) and graph coloring (color.c).
+*/
+
+#ifndef  REGALLOC_H
+#define  REGALLOC_H
+
+#include  "ir.h"
+#include  "symtab.h"
+
+/* 仮想レジスタの集合（ビット列）/ sets of registers (bit vectors) */
+#define  BITS  (sizeof(unsigned int)*8)
+#define  SET_BIT(s, n)    ((s)[(n)/BITS] |= 1u << ((n)%BITS))
+#define  CLEAR_BIT(s, n)  ((s)[(n)/BITS] &= ~(1u << ((n)%BITS)))
+#define  TEST_BIT(s, n)   (((s)[(n)/BITS] >> ((n)%BITS)) & 1)
+
+/* ブロックの入口と出口で生きている仮想レジスタ（ブロック番号で引く）
+   Registers live into and out of each block (indexed by block id) */
+extern void compute_liveness(IR_Func *f, int nv, unsigned int ***live_in,
+                             unsigned int ***live_out);
+extern void free_liveness(IR_Func *f, unsigned int **live_in,
+                          unsigned int **live_out);
+
+/* vを参照・定義ごとの一時に分ける。*slotはスタック上の一時変数
+   (NULLなら必要に応じて作る) / Split v into a temporary for each use
+   and def; *slot is the temporary in the stack (made if NULL) */
+extern void spill_vreg(IR_Func *f, int v, SymTab **slot);
+
+/* 割り付け結果reg[1..nv-1]をfに設定する / Set the result reg[1..nv-1] to f */
+extern void set_phys_regs(IR_Func *f, const int *reg, int nv);
+
+/* 呼び出しごとに退避するレジスタを求める。written[v]が0の値は除く
+   (NULLなら全部) / Find the registers saved around each call, leaving
+   out values with written[v] == 0 (all if NULL) */
+extern void set_call_saves(IR_Func *f, const char *written);
+
+/* グラフ彩色による割り付け (color.c) / allocation by graph coloring (color.c) */
+extern void color_regs(IR_Func *f);
+
+#endif	/* REGALLOC_H */
@@ -0,0 +1,435 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    疎な条件付き定数伝播 / sparse conditional constant propagation
+
+    Wegman-Zadeckの方法。各仮想レジスタの値を 未定(TOP) < 定数 <
+    非定数(BOTTOM) の束で表し、実行されうる辺だけを辿って伝播する。
+    定数と分かった値は定数命令に置き換え、条件が定数になった分岐は
+    無条件分岐にして、実行されないブロックを取り除く。
+    The method of Wegman and Zadeck.  The value of each virtual register
+    is a lattice of undetermined (TOP) < constant < non-constant
+    (BOTTOM), propagated only along edges that may be executed.  Values
+    found constant become constant instructions, branches on constant
+    conditions become jumps, and blocks never executed are removed.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ast.h"
+#include  "ir.h"
+#include  "opt.h"
+#include  "util.h"
+
+enum { LAT_TOP, LAT_CONST, LAT_BOTTOM };
+
+typedef struct Lattice {
+    int  kind;
+    int  val;
+} Lattice;
+
+/* 仮想レジスタを使う命令の一覧 / instructions using a register */
+typedef struct UseList {
+    IR_Insn **insn;
+    int  n;
+    int  size;
+} UseList;
+
+static IR_Func *cur_func;
+static Lattice *lat;
+static UseList *uses;
+static int  *block_exec;	/* ブロックが実行されうる / block may be executed */
+static int  *edge_exec;		/* 辺 (block id*2+後続の番号) / edge (block id*2+succ index) */
+static IR_Block **cfg_work;	/* 辺の作業リスト (from, to の組) / edge worklist (from, to pairs) */
+static int  cfg_n, cfg_size;
+static IR_Insn **ssa_work;
+static int  ssa_n, ssa_size;
+
+static void add_use(int v, IR_Insn *i);
+static void push_edge(IR_Block *from, IR_Block *to);
+static void push_insn(IR_Insn *i);
+static int  edge_index(IR_Block *from, IR_Block *to);
+static void set_lattice(int v, int kind, int val);
+static void visit(IR_Insn *i);
+static void visit_phi(IR_Insn *i);
+static void visit_branch(IR_Insn *i);
+static int  eval_binary(int kind, int a, int b, Lattice *r);
+static void rewrite(IR_Func *f);
+static void drop_phi_operands(IR_Block *b, IR_Block *pred);
+
+void
+sccp(IR_Func *f)
+{
+    int  k;
+    IR_Block *b, *from, *to;
+    IR_Insn *i;
+
+    cur_func = f;
+    ir_build_cfg(f);
+    lat = xcalloc(f->nvregs+1, sizeof(Lattice));
+    uses = xcalloc(f->nvregs+1, sizeof(UseList));
+    block_exec = xcalloc(f->nblocks, sizeof(int));
+    edge_exec = xcalloc(f->nblocks*2, sizeof(int));
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            for (k = 0; k < ir_num_uses(i); k++) {
+                add_use(*ir_use(i, k), i);
+            }
+        }
+    }
+
+    block_exec[f->first->id] = 1;
+    FOR_EACH_INSN(i, f->first) {
+        visit(i);
+    }
+    while (cfg_n > 0 || ssa_n > 0) {
+        while (cfg_n > 0) {
+            to = cfg_work[--cfg_n];
+            from = cfg_work[--cfg_n];
+            k = edge_index(from, to);
+            if (edge_exec[k]) {
+                continue;
+            }
+            edge_exec[k] = 1;
+            if (block_exec[to->id]) {
+                /* 新しく実行されうる辺の分だけphiを見直す
+                   Only phis change for a newly executable edge */
+                FOR_EACH_INSN(i, to) {
+                    if (i->op != IR_PHI) {
+                        break;
+                    }
+                    visit_phi(i);
+                }
+            } else {
+                block_exec[to->id] = 1;
+                FOR_EACH_INSN(i, to) {
+                    visit(i);
+                }
+            }
+        }
+        while (ssa_n > 0) {
+            i = ssa_work[--ssa_n];
+            if (i->block != NULL && block_exec[i->block->id]) {
+                visit(i);
+            }
+        }
+    }
+
+    rewrite(f);
+
+    for (k = 0; k <= f->nvregs; k++) {
+        free(uses[k].insn);
+    }
+    free(uses);
+    free(lat);
+    free(block_exec);
+    free(edge_exec);
+    free(cfg_work);
+    free(ssa_work);
+    cfg_work = NULL;
+    ssa_work = NULL;
+    cfg_n = cfg_size = ssa_n = ssa_size = 0;
+    cur_func = NULL;
+}
+
+void
+add_use(int v, IR_Insn *i)
+{
+    UseList *u = &uses[v];
+
+    if (u->n == u->size) {
+        u->size += 4;
+        u->insn = xrealloc(u->insn, u->size*sizeof(IR_Insn*));
+    }
+    u->insn[u->n++] = i;
+}
+
+void
+push_edge(IR_Block *from, IR_Block *to)
+{
+    if (cfg_n+2 > cfg_size) {
+        cfg_size += 32;
+        cfg_work = xrealloc(cfg_work, cfg_size*sizeof(IR_Block*));
+    }
+    cfg_work[cfg_n++] = from;
+    cfg_work[cfg_n++] = to;
+}
+
+void
+push_insn(IR_Insn *i)
+{
+    if (ssa_n == ssa_size) {
+        ssa_size += 32;
+        ssa_work = xrealloc(ssa_work, ssa_size*sizeof(IR_Insn*));
+    }
+    ssa_work[ssa_n++] = i;
+}
+
+int
+edge_index(IR_Block *from, IR_Block *to)
+{
+    return from->id*2 + (from->succ[0] == to ? 0 : 1);
+}
+
+/* 値を束の上で下げる。変化したら使う命令を作業リストに積む
+   Lower a value in the lattice; users are queued if it changed */
+void
+set_lattice(int v, int kind, int val)
+{
+    int  k;
+    Lattice *l = &lat[v];
+
+    if (l->kind == LAT_BOTTOM || kind == LAT_TOP) {
+        return;
+    }
+    if (l->kind == LAT_CONST && kind == LAT_CONST) {
+        if (l->val == val) {
+            return;
+        }
+        kind = LAT_BOTTOM;	/* 異なる定数 / different constants */
+    }
+    l->kind = kind;
+    l->val = val;
+    for (k = 0; k < uses[v].n; k++) {
+        push_insn(uses[v].insn[k]);
+    }
+}
+
+/* 二項演算の評価 / evaluate a binary operation */
+int
+eval_binary(int kind, int a, int b, Lattice *r)
+{
+    Lattice *la = &lat[a], *lb = &lat[b];
+
+    /* 片方が0の乗算は他方によらず0 / x*0 is 0 whatever x is */
+    if (kind == AST_EXP_MUL
+        && ((la->kind == LAT_CONST && la->val == 0)
+            || (lb->kind == LAT_CONST && lb->val == 0))) {
+        r->kind = LAT_CONST;
+        r->val = 0;
+    } else if (la->kind == LAT_BOTTOM || lb->kind == LAT_BOTTOM) {
+        r->kind = LAT_BOTTOM;
+    } else if (la->kind == LAT_TOP || lb->kind == LAT_TOP) {
+        r->kind = LAT_TOP;
+    } else if (fold_const(kind, la->val, lb->val, &r->val)) {
+        r->kind = LAT_CONST;
+    } else {
+        r->kind = LAT_BOTTOM;
+    }
+    return r->kind;
+}
+
+void
+visit(IR_Insn *i)
+{
+    Lattice r;
+
+    r.kind = LAT_BOTTOM;
+    r.val = 0;
+    switch (i->op) {
+    case  IR_PHI:
+        visit_phi(i);
+        return;
+    case  IR_JMP:
+    case  IR_BR:
+    case  IR_RET:
+    case  IR_TAILCALL:
+        visit_branch(i);
+        return;
+    case  IR_CONST:
+        r.kind = LAT_CONST;
+        r.val = i->imm;
+        break;
+    case  IR_MOV:
+        r = lat[i->src[0]];
+        break;
+    case  IR_NEG:
+        if (lat[i->src[0]].kind == LAT_CONST) {
+            r.kind = LAT_CONST;
+            fold_const(AST_EXP_UNARY_MINUS, lat[i->src[0]].val, 0, &r.val);
+        } else {
+            r.kind = lat[i->src[0]].kind;
+        }
+        break;
+    case  IR_ADD:
+        eval_binary(AST_EXP_ADD, i->src[0], i->src[1], &r);
+        break;
+    case  IR_SUB:
+        eval_binary(AST_EXP_SUB, i->src[0], i->src[1], &r);
+        break;
+    case  IR_MUL:
+        eval_binary(AST_EXP_MUL, i->src[0], i->src[1], &r);
+        break;
+    case  IR_DIV:
+        eval_binary(AST_EXP_DIV, i->src[0], i->src[1], &r);
+        break;
+    case  IR_SHR:
+        r = lat[i->src[0]];
+        if (r.kind == LAT_CONST) {
+            r.val = (int)((unsigned int)r.val >> i->imm);
+        }
+        break;
+    case  IR_SETCC:
+        eval_binary(i->cond, i->src[0], i->src[1], &r);
+        break;
+    default:
+        /* 呼び出しの戻り値、仮引数、メモリの値は分からない
+           Return values, parameters and memory are unknown */
+        break;
+    }
+    if (i->dst != 0) {
+        set_lattice(i->dst, r.kind, r.val);
+    }
+}
+
+void
+visit_phi(IR_Insn *i)
+{
+    int  k, kind = LAT_TOP, val = 0;
+    Lattice *l;
+
+    for (k = 0; k < i->nphi && kind != LAT_BOTTOM; k++) {
+        if (!edge_exec[edge_index(i->phi_blk[k], i->block)]) {
+            continue;
+        }
+        l = &lat[i->phi_src[k]];
+        if (l->kind == LAT_TOP) {
+            continue;
+        }
+        if (l->kind == LAT_BOTTOM || (kind == LAT_CONST && val != l->val)) {
+            kind = LAT_BOTTOM;
+        } else {
+            kind = LAT_CONST;
+            val = l->val;
+        }
+    }
+    set_lattice(i->dst, kind, val);
+}
+
+void
+visit_branch(IR_Insn *i)
+{
+    Lattice r;
+    IR_Block *b = i->block;
+
+    if (i->op == IR_JMP) {
+        push_edge(b, i->target[0]);
+        return;
+    }
+    if (i->op == IR_RET || i->op == IR_TAILCALL) {
+        push_edge(b, cur_func->exit);
+        return;
+    }
+    if (i->cond != 0) {
+        eval_binary(i->cond, i->src[0], i->src[1], &r);
+    } else {
+        r = lat[i->src[0]];
+        r.val = (r.val != 0);
+    }
+    if (r.kind == LAT_CONST) {
+        push_edge(b, i->target[r.val ? 0 : 1]);
+    } else if (r.kind == LAT_BOTTOM) {
+        push_edge(b, i->target[0]);
+        push_edge(b, i->target[1]);
+    }
+}
+
+/* predからの値をbのphiから除く / drop the values from pred in b's phis */
+void
+drop_phi_operands(IR_Block *b, IR_Block *pred)
+{
+    int  k;
+    IR_Insn *i;
+
+    FOR_EACH_INSN(i, b) {
+        /* 定数にしたphiは並びの中に残っている
+           Phis made constants are still among the phis */
+        if (i->op == IR_CONST) {
+            continue;
+        }
+        if (i->op != IR_PHI) {
+            break;
+        }
+        for (k = 0; k < i->nphi; k++) {
+            if (i->phi_blk[k] == pred) {
+                i->phi_blk[k] = i->phi_blk[i->nphi-1];
+                i->phi_src[k] = i->phi_src[--i->nphi];
+                break;
+            }
+        }
+    }
+}
+
+void
+rewrite(IR_Func *f)
+{
+    int  k, taken;
+    IR_Block *b;
+    IR_Insn *i;
+
+    FOR_EACH_BLOCK(b, f) {
+        if (!block_exec[b->id]) {
+            continue;
+        }
+        FOR_EACH_INSN(i, b) {
+            if (i->dst != 0 && lat[i->dst].kind == LAT_CONST
+                && i->op != IR_CONST && i->op != IR_CALL) {
+                i->op = IR_CONST;
+                i->imm = lat[i->dst].val;
+                i->cond = 0;
+                i->src[0] = i->src[1] = 0;
+                if (i->nphi > 0) {
+                    free(i->phi_src);
+                    free(i->phi_blk);
+                    i->phi_src = NULL;
+                    i->phi_blk = NULL;
+                    i->nphi = 0;
+                }
+            }
+        }
+        /* 片側の辺しか実行されない分岐は無条件分岐にする
+           A branch with only one executable edge becomes a jump */
+        i = ir_terminator(b);
+        if (i == NULL || i->op != IR_BR || b->nsucc != 2) {
+            continue;
+        }
+        for (k = 0; k < 2; k++) {
+            if (!edge_exec[b->id*2+k]) {
+                break;
+            }
+        }
+        if (k == 2 || !edge_exec[b->id*2+(1-k)]) {
+            continue;
+        }
+        taken = 1-k;
+        drop_phi_operands(b->succ[k], b);
+        i->op = IR_JMP;
+        i->target[0] = b->succ[taken];
+        i->target[1] = NULL;
+        i->cond = 0;
+        i->src[0] = i->src[1] = 0;
+    }
+    /* CONSTにしたphiはブロック先頭のphi列の途中に残りうるので後ろへ移す
+       Phis turned into constants may sit among the phis; move them after */
+    FOR_EACH_BLOCK(b, f) {
+        IR_Insn *next, *last_phi = NULL;
+        for (i = b->head; i != NULL; i = next) {
+            next = i->next;
+            if (i->op == IR_PHI) {
+                last_phi = i;
+            }
+        }
+        if (last_phi == NULL) {
+            continue;
+        }
+        for (i = b->head; i != last_phi; i = next) {
+            next = i->next;
+            if (i->op != IR_PHI) {
+                ir_remove(i);
+                ir_insert_after(last_phi, i);
+            }
+        }
+    }
+    ir_build_cfg(f);
+    ir_remove_unreachable(f);
+}
@@ -0,0 +1,731 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    ループの閉じた式での置き換え / closed-form evaluation of loops
+    (scalar evolution)
+
+    ループ内の値を繰り返し回数kの多項式 c0 + c1*C(k,1) + c2*C(k,2) + ...
+    (C(k,j)は二項係数、係数はループ不変) として表す。ヘッダのphiの値が
+    「自分自身 + 多項式D(k)」で更新されるなら、その値は初期値 + D(t)の
+    t < kでの和で、二項係数の和の公式 Σ C(t,j) = C(k,j+1) により一つ次数の
+    高い多項式になる (chains of recurrences)。
+    最内側の数え上げループ（unroll.cと同じ形）で、本体が副作用のない
+    演算だけからなり、ループ外で使われるphiがすべて多項式で表せれば、
+    繰り返し回数nを求めてphiの最終値を直接計算し、ループをなくす。
+    nは初期値と上限が定数なら翻訳時に求め、そうでなければ増分が1か-1の
+    ときだけ実行時に求める。除算命令は使えないので、C(n,2)は論理シフトで、
+    C(n,3)は3の逆数（2^32を法とする）の乗算で求める。
+    Cと同じく符号付き整数の桁あふれが起きないことを前提にする。
+
+    A value in a loop is expressed as a polynomial
+    c0 + c1*C(k,1) + c2*C(k,2) + ... in the iteration count k, where
+    C(k,j) is a binomial coefficient and the coefficients are loop
+    invariant.  When a header phi is updated as "itself + D(k)" for a
+    polynomial D, its value is the start value plus the sum of D(t) for
+    t < k, which the identity sum C(t,j) = C(k,j+1) turns into a
+    polynomial of one degree higher (chains of recurrences).
+    For an innermost counted loop (of the same shape as in unroll.c)
+    whose body has no side effects, if every phi used outside the loop
+    is such a polynomial, the trip count n is computed, the final values
+    of the phis are computed directly and the loop disappears.
+    n is computed at compile time when the start and the bound are
+    constants, otherwise at run time only for a step of 1 or -1.  No
+    division instruction is available, so C(n,2) uses a logical shift
+    and C(n,3) a multiplication by the inverse of 3 modulo 2^32.
+    As in C, signed integers are assumed never to overflow.
+*/
+
+#include  <limits.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ast.h"
+#include  "ir.h"
+#include  "opt.h"
+#include  "util.h"
+
+#define  MAX_DEGREE  3
+#define  INVERSE_OF_3  (-1431655765)	/* 0xaaaaaaab: 3*x = 1 (mod 2^32) */
+
+/* 繰り返し回数kの多項式 / polynomial in the iteration count k */
+typedef struct SE_Poly {
+    int  self;                  /* 求めているphi自身の係数 / coefficient of the phi being evaluated */
+    int  deg;                   /* 次数 (-1: 0) / degree (-1: zero) */
+    int  c[MAX_DEGREE+1];       /* C(k,j)の係数のレジスタ (0: 係数0)
+                                   registers of the coefficients of C(k,j) (0: zero) */
+} SE_Poly;
+
+enum { SE_NONE, SE_BUSY, SE_DONE, SE_FAIL };
+
+typedef struct SE_Value {
+    int  state;
+    IR_Insn *under;             /* selfを含むとき求めていたphi / phi being evaluated if self != 0 */
+    SE_Poly poly;
+} SE_Value;
+
+static IR_Func *cur_func;
+static IR_Loop *cur_loop;
+static IR_Insn *cur_phi;
+static IR_Insn **def;
+static SE_Value *val;
+static IR_Insn **code;		/* プリヘッダに置く命令 / instructions for the preheader */
+static int  ncode, code_size;
+static int  binom[MAX_DEGREE+1];	/* C(n,j)のレジスタ / registers of C(n,j) */
+
+static int  innermost(IR_Loop *loops, IR_Loop *l);
+static int  replace_loop(IR_Loop *l);
+static int  pure_body(IR_Loop *l, IR_Block **exit);
+static int  used_outside(IR_Loop *l, int v);
+static int  phi_slot(IR_Loop *l, IR_Insn *phi);
+static int  const_value(int v, int *x);
+static int  loop_step(IR_Loop *l, IR_Insn *phi, int *step);
+static int  trip_count(IR_Loop *l, IR_Insn *iv, int cond, int bound, int step);
+static int  eval(int v, SE_Poly *p);
+static int  eval_insn(IR_Insn *d, SE_Poly *p);
+static int  eval_phi(IR_Insn *phi, SE_Poly *p);
+static void poly_const(SE_Poly *p, int v);
+static void poly_add(SE_Poly *p, SE_Poly *a, SE_Poly *b, int sign);
+static void poly_scale(SE_Poly *p, SE_Poly *a, int k);
+static int  poly_mul(SE_Poly *p, SE_Poly *a, SE_Poly *b);
+static int  poly_at(SE_Poly *p, int n);
+static int  binomial(int n, int j);
+static int  emit(int op, int a, int b);
+static int  constant(int x);
+static int  reg_of(int c);
+static int  add(int a, int b);
+static int  sub(int a, int b);
+static int  mul(int a, int b);
+
+/* 置き換えたループの数を返す / returns the number of loops replaced */
+int
+scev(IR_Func *f)
+{
+    int  n, changed;
+    IR_Loop *loops, *l;
+
+    cur_func = f;
+    n = 0;
+    do {
+        changed = 0;
+        loops = find_loops(f);
+        for (l = loops; l != NULL; l = l->next) {
+            if (innermost(loops, l) && replace_loop(l)) {
+                changed = 1;
+                break;
+            }
+        }
+        free_loops(loops);
+        if (changed) {
+            /* 外側のループが最内側になるので探し直す
+               The enclosing loop becomes innermost; search again */
+            n++;
+            ir_build_cfg(f);
+            ir_remove_unreachable(f);
+        }
+    } while (changed);
+    free(code);
+    code = NULL;
+    code_size = 0;
+    cur_func = NULL;
+    return n;
+}
+
+int
+innermost(IR_Loop *loops, IR_Loop *l)
+{
+    IR_Loop *m;
+
+    for (m = loops; m != NULL; m = m->next) {
+        if (m->parent == l) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* ループlを閉じた式に置き換えられれば置き換えて1を返す
+   Replace the loop l with closed forms if possible and return 1 */
+int
+replace_loop(IR_Loop *l)
+{
+    int  k, s, cond, bound, step, n, ok, *final;
+    IR_Block *b, *exit;
+    IR_Insn *i, *t, *iv, *next;
+    SE_Poly p;
+
+    t = ir_terminator(l->header);
+    if (t->op != IR_BR || t->cond == 0 || !pure_body(l, &exit)) {
+        return 0;
+    }
+    for (i = l->header->head; i != t; i = i->next) {
+        if (i->op != IR_PHI || i->nphi != 2) {
+            return 0;
+        }
+    }
+
+    def = xcalloc(cur_func->nvregs+1, sizeof(IR_Insn*));
+    FOR_EACH_BLOCK(b, cur_func) {
+        FOR_EACH_INSN(i, b) {
+            if (i->dst != 0) {
+                def[i->dst] = i;
+            }
+        }
+    }
+
+    /* 判定を「iv cond bound の間回る」の形にする
+       Put the test in the form "loop while iv cond bound" */
+    s = loop_contains(l, t->target[0]) ? 0 : 1;
+    cond = (s == 0) ? t->cond : ir_negate_cond(t->cond);
+    for (k = 0; k < 2; k++) {
+        iv = def[t->src[k]];
+        if (iv != NULL && iv->op == IR_PHI && iv->block == l->header) {
+            break;
+        }
+    }
+    ok = 0;
+    bound = step = 0;
+    if (k < 2) {
+        bound = t->src[1-k];
+        if (k == 1) {
+            cond = ir_swap_cond(cond);
+        }
+        ok = def[bound] != NULL && !loop_contains(l, def[bound]->block)
+             && loop_step(l, iv, &step);
+    }
+
+    cur_loop = l;
+    val = xcalloc(cur_func->nvregs+1, sizeof(SE_Value));
+    final = xcalloc(cur_func->nvregs+1, sizeof(int));
+    ncode = 0;
+    for (k = 0; k <= MAX_DEGREE; k++) {
+        binom[k] = 0;
+    }
+    if (ok && (n = trip_count(l, iv, cond, bound, step)) != 0) {
+        for (i = l->header->head; ok && i != t; i = i->next) {
+            if (!used_outside(l, i->dst)) {
+                continue;
+            }
+            ok = eval(i->dst, &p);
+            if (ok) {
+                final[i->dst] = poly_at(&p, n);
+            }
+        }
+    } else {
+        ok = 0;
+    }
+
+    if (ok) {
+        for (k = 0; k < ncode; k++) {
+            ir_insert_before(ir_terminator(l->preheader), code[k]);
+        }
+        for (i = l->header->head; i != t; i = next) {
+            next = i->next;
+            if (final[i->dst] != 0) {
+                ir_replace_vreg(cur_func, i->dst, final[i->dst]);
+            }
+            ir_remove(i);
+        }
+        t->op = IR_JMP;
+        t->cond = 0;
+        t->src[0] = t->src[1] = 0;
+        t->target[0] = exit;
+        t->target[1] = NULL;
+    } else {
+        for (k = 0; k < ncode; k++) {
+            free(code[k]);
+        }
+    }
+    ncode = 0;
+    free(final);
+    free(val);
+    free(def);
+    val = NULL;
+    def = NULL;
+    cur_loop = NULL;
+    return ok;
+}
+
+/*
+ * 本体が副作用のない演算だけからなり、ヘッダだけが出口なら1。
+ * exitにはヘッダのループ外の後続が入る
+ * 1 if the body consists only of operations without side effects and
+ * the header is the only exit.  exit receives the header's successor
+ * outside the loop.
+ */
+int
+pure_body(IR_Loop *l, IR_Block **exit)
+{
+    int  k, j;
+    IR_Block *b;
+    IR_Insn *i;
+
+    *exit = NULL;
+    for (k = 0; k < l->nblocks; k++) {
+        b = l->blocks[k];
+        for (j = 0; j < b->nsucc; j++) {
+            if (loop_contains(l, b->succ[j])) {
+                continue;
+            }
+            if (b != l->header || *exit != NULL) {
+                return 0;
+            }
+            *exit = b->succ[j];
+        }
+        FOR_EACH_INSN(i, b) {
+            switch (i->op) {
+            case  IR_CONST:
+            case  IR_MOV:
+            case  IR_NEG:
+            case  IR_ADD:
+            case  IR_SUB:
+            case  IR_MUL:
+            case  IR_SHR:
+            case  IR_SETCC:
+            case  IR_PHI:
+            case  IR_JMP:
+            case  IR_BR:
+                break;
+            default:
+                return 0;
+            }
+        }
+    }
+    return *exit != NULL;
+}
+
+/* vがループ外で使われていれば1 / 1 if v is used outside the loop */
+int
+used_outside(IR_Loop *l, int v)
+{
+    int  k;
+    IR_Block *b;
+    IR_Insn *i;
+
+    FOR_EACH_BLOCK(b, cur_func) {
+        if (loop_contains(l, b)) {
+            continue;
+        }
+        FOR_EACH_INSN(i, b) {
+            for (k = 0; k < ir_num_uses(i); k++) {
+                if (*ir_use(i, k) == v) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int
+phi_slot(IR_Loop *l, IR_Insn *phi)
+{
+    return phi->phi_blk[0] == l->preheader ? 0 : 1;
+}
+
+int
+const_value(int v, int *x)
+{
+    if (def[v] != NULL && def[v]->op == IR_CONST) {
+        *x = def[v]->imm;
+        return 1;
+    }
+    return 0;
+}
+
+/* phiの増分が0以外の定数なら1 / 1 if phi steps by a non-zero constant */
+int
+loop_step(IR_Loop *l, IR_Insn *phi, int *step)
+{
+    IR_Insn *next;
+
+    next = def[phi->phi_src[1-phi_slot(l, phi)]];
+    if (next == NULL || (next->op != IR_ADD && next->op != IR_SUB)) {
+        return 0;
+    }
+    if (next->src[0] == phi->dst) {
+        if (!const_value(next->src[1], step)) {
+            return 0;
+        }
+    } else if (next->op != IR_ADD || next->src[1] != phi->dst
+               || !const_value(next->src[0], step)) {
+        return 0;
+    }
+    if (next->op == IR_SUB) {
+        if (*step == INT_MIN) {
+            return 0;
+        }
+        *step = -*step;
+    }
+    return *step != 0;
+}
+
+/*
+ * 繰り返し回数を求めるレジスタを返す（求められなければ0）
+ * Return a register computing the trip count (0 if unknown)
+ */
+int
+trip_count(IR_Loop *l, IR_Insn *iv, int cond, int bound, int step)
+{
+    int  init, a, b, runs, d;
+    long long dist, trips, last;
+
+    switch (cond) {
+    case  AST_EXP_LT:
+    case  AST_EXP_LTE:
+        if (step < 0) {
+            return 0;
+        }
+        break;
+    case  AST_EXP_GT:
+    case  AST_EXP_GTE:
+        if (step > 0) {
+            return 0;
+        }
+        break;
+    default:
+        return 0;
+    }
+    init = iv->phi_src[phi_slot(l, iv)];
+
+    if (const_value(init, &a) && const_value(bound, &b)) {
+        fold_const(cond, a, b, &runs);
+        trips = 0;
+        if (runs) {
+            dist = (step > 0) ? (long long)b - a : (long long)a - b;
+            step = (step > 0) ? step : -step;
+            if (cond == AST_EXP_LT || cond == AST_EXP_GT) {
+                trips = (dist + step - 1)/step;
+            } else {
+                trips = dist/step + 1;
+            }
+        }
+        last = a + trips*((cond == AST_EXP_LT || cond == AST_EXP_LTE) ? step : -step);
+        if (last < INT_MIN || last > INT_MAX) {
+            return 0;		/* 元のループは桁あふれする / the loop overflows */
+        }
+        return constant((int)(unsigned int)trips);
+    }
+
+    /* 回るなら |bound - init| (+1) 回 / |bound - init| (+1) times if it runs */
+    if (step != 1 && step != -1) {
+        return 0;
+    }
+    runs = emit(IR_SETCC, init, bound);
+    code[ncode-1]->cond = cond;
+    d = (step > 0) ? sub(bound, init) : sub(init, bound);
+    if (cond == AST_EXP_LTE || cond == AST_EXP_GTE) {
+        d = add(d, constant(1));
+    }
+    return mul(d, runs);
+}
+
+/* vを多項式で表せれば1 / 1 if v is expressed as a polynomial */
+int
+eval(int v, SE_Poly *p)
+{
+    int  ok;
+    IR_Insn *d;
+    SE_Value *e;
+
+    d = def[v];
+    if (d == NULL) {
+        return 0;
+    }
+    if (!loop_contains(cur_loop, d->block)) {
+        poly_const(p, v);
+        return 1;
+    }
+    if (d == cur_phi) {
+        poly_const(p, 0);
+        p->self = 1;
+        return 1;
+    }
+    e = &val[v];
+    if (e->state == SE_DONE && (e->poly.self == 0 || e->under == cur_phi)) {
+        *p = e->poly;
+        return 1;
+    }
+    if (e->state == SE_BUSY || e->state == SE_FAIL) {
+        return 0;		/* 循環か失敗済み / a cycle or failed already */
+    }
+    e->state = SE_BUSY;
+    if (d->op == IR_PHI && d->block == cur_loop->header) {
+        ok = eval_phi(d, p);
+    } else {
+        ok = eval_insn(d, p);
+    }
+    e->state = ok ? SE_DONE : SE_FAIL;
+    e->under = cur_phi;
+    e->poly = *p;
+    return ok;
+}
+
+int
+eval_insn(IR_Insn *d, SE_Poly *p)
+{
+    SE_Poly a, b;
+
+    if (d->op == IR_PHI) {
+        return 0;		/* 本体内の合流 / a join in the body */
+    }
+    if (ir_num_uses(d) > 0 && !eval(d->src[0], &a)) {
+        return 0;
+    }
+    if (ir_num_uses(d) > 1 && !eval(d->src[1], &b)) {
+        return 0;
+    }
+    switch (d->op) {
+    case  IR_CONST:
+        poly_const(p, constant(d->imm));
+        return 1;
+    case  IR_MOV:
+        *p = a;
+        return 1;
+    case  IR_NEG:
+        poly_const(&b, 0);
+        poly_add(p, &b, &a, -1);
+        return 1;
+    case  IR_ADD:
+        poly_add(p, &a, &b, 1);
+        return 1;
+    case  IR_SUB:
+        poly_add(p, &a, &b, -1);
+        return 1;
+    case  IR_MUL:
+        return poly_mul(p, &a, &b);
+    case  IR_SHR:
+    case  IR_SETCC:
+        /* ループ不変なときだけ / only when loop invariant */
+        if (a.self != 0 || a.deg > 0) {
+            return 0;
+        }
+        if (d->op == IR_SHR) {
+            poly_const(p, emit(IR_SHR, reg_of(a.c[0]), 0));
+        } else if (b.self != 0 || b.deg > 0) {
+            return 0;
+        } else {
+            poly_const(p, emit(IR_SETCC, reg_of(a.c[0]), reg_of(b.c[0])));
+        }
+        code[ncode-1]->imm = d->imm;
+        code[ncode-1]->cond = d->cond;
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/*
+ * phi = 自分自身 + D(k) なら phi(k) = 初期値 + Σ_{t<k} D(t)
+ * If phi = itself + D(k), then phi(k) = start + sum_{t<k} D(t)
+ */
+int
+eval_phi(IR_Insn *phi, SE_Poly *p)
+{
+    int  j, ok;
+    IR_Insn *saved;
+    SE_Poly d;
+
+    saved = cur_phi;
+    cur_phi = phi;
+    ok = eval(phi->phi_src[1-phi_slot(cur_loop, phi)], &d);
+    cur_phi = saved;
+    if (!ok || d.self != 1 || d.deg >= MAX_DEGREE) {
+        return 0;
+    }
+    poly_const(p, phi->phi_src[phi_slot(cur_loop, phi)]);
+    for (j = 0; j <= d.deg; j++) {
+        p->c[j+1] = d.c[j];
+    }
+    p->deg = d.deg + 1;
+    return 1;
+}
+
+/* 定数項だけの多項式 (v: 0なら係数0) / polynomial of only a constant term */
+void
+poly_const(SE_Poly *p, int v)
+{
+    int  j;
+
+    p->self = 0;
+    p->deg = (v != 0) ? 0 : -1;
+    p->c[0] = v;
+    for (j = 1; j <= MAX_DEGREE; j++) {
+        p->c[j] = 0;
+    }
+}
+
+/* p = a + sign*b */
+void
+poly_add(SE_Poly *p, SE_Poly *a, SE_Poly *b, int sign)
+{
+    int  j;
+    SE_Poly r;
+
+    r.self = a->self + sign*b->self;
+    r.deg = (a->deg > b->deg) ? a->deg : b->deg;
+    for (j = 0; j <= MAX_DEGREE; j++) {
+        r.c[j] = (sign > 0) ? add(a->c[j], b->c[j]) : sub(a->c[j], b->c[j]);
+    }
+    *p = r;
+}
+
+/* p = a*k (kはループ不変なレジスタ / k is a loop-invariant register) */
+void
+poly_scale(SE_Poly *p, SE_Poly *a, int k)
+{
+    int  j;
+    SE_Poly r;
+
+    r.self = 0;
+    r.deg = (k != 0) ? a->deg : -1;
+    for (j = 0; j <= MAX_DEGREE; j++) {
+        r.c[j] = mul(a->c[j], k);
+    }
+    *p = r;
+}
+
+/*
+ * p = a*b。一方がループ不変か、どちらも1次のときだけ
+ * (a0 + a1*k)(b0 + b1*k) = a0*b0 + (a0*b1 + a1*b0 + a1*b1)*k
+ *                          + 2*a1*b1*C(k,2)
+ * Only when either is loop invariant or both are of degree 1.
+ */
+int
+poly_mul(SE_Poly *p, SE_Poly *a, SE_Poly *b)
+{
+    int  m;
+    SE_Poly r;
+
+    if (a->self != 0 || b->self != 0) {
+        return 0;
+    }
+    if (a->deg <= 0) {
+        poly_scale(p, b, a->c[0]);
+        return 1;
+    }
+    if (b->deg <= 0) {
+        poly_scale(p, a, b->c[0]);
+        return 1;
+    }
+    if (a->deg > 1 || b->deg > 1) {
+        return 0;
+    }
+    m = mul(a->c[1], b->c[1]);
+    poly_const(&r, mul(a->c[0], b->c[0]));
+    r.c[1] = add(add(mul(a->c[0], b->c[1]), mul(a->c[1], b->c[0])), m);
+    r.c[2] = add(m, m);
+    r.deg = 2;
+    *p = r;
+    return 1;
+}
+
+/* k = nでの値 / value at k = n */
+int
+poly_at(SE_Poly *p, int n)
+{
+    int  j, v;
+
+    v = p->c[0];
+    for (j = 1; j <= p->deg; j++) {
+        if (p->c[j] != 0) {
+            v = add(v, mul(p->c[j], binomial(n, j)));
+        }
+    }
+    return reg_of(v);
+}
+
+/*
+ * C(n,j)。nは符号なしの回数
+ * C(n,2) = h*(2n-1-2h) (h = n>>1)、C(n,3) = C(n,2)*(n-2)/3
+ * C(n,j), where n is an unsigned count.
+ */
+int
+binomial(int n, int j)
+{
+    int  h, t;
+
+    if (binom[j] != 0) {
+        return binom[j];
+    }
+    switch (j) {
+    case  1:
+        binom[j] = n;
+        break;
+    case  2:
+        h = emit(IR_SHR, n, 0);
+        code[ncode-1]->imm = 1;
+        t = sub(sub(sub(add(n, n), constant(1)), h), h);
+        binom[j] = mul(h, t);
+        break;
+    case  3:
+        t = mul(binomial(n, 2), sub(n, constant(2)));
+        binom[j] = mul(t, constant(INVERSE_OF_3));
+        break;
+    }
+    return binom[j];
+}
+
+/* プリヘッダに置く命令を作る / make an instruction for the preheader */
+int
+emit(int op, int a, int b)
+{
+    IR_Insn *i;
+
+    i = ir_new_insn(op);
+    i->dst = ir_new_vreg(cur_func);
+    i->src[0] = a;
+    i->src[1] = b;
+    if (ncode == code_size) {
+        code_size += 64;
+        code = xrealloc(code, code_size*sizeof(IR_Insn*));
+    }
+    code[ncode++] = i;
+    return i->dst;
+}
+
+int
+constant(int x)
+{
+    int  v;
+
+    v = emit(IR_CONST, 0, 0);
+    code[ncode-1]->imm = x;
+    return v;
+}
+
+/* 係数のレジスタ（係数0なら定数0）/ register of a coefficient (const 0 for zero) */
+int
+reg_of(int c)
+{
+    return (c != 0) ? c : constant(0);
+}
+
+/* 以下、0は係数0を表す / below, 0 stands for a zero coefficient */
+int
+add(int a, int b)
+{
+    if (a == 0 || b == 0) {
+        return a + b;
+    }
+    return emit(IR_ADD, a, b);
+}
+
+int
+sub(int a, int b)
+{
+    if (b == 0) {
+        return a;
+    }
+    if (a == 0) {
+        return emit(IR_NEG, b, 0);
+    }
+    return emit(IR_SUB, a, b);
+}
+
+int
+mul(int a, int b)
+{
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    return emit(IR_MUL, a, b);
+}
@@ -0,0 +1,656 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    SSA形式 / static single assignment form
+
+    構築：仮引数と自動変数をすべて仮想レジスタに昇格する。ブロックを
+    またいで生きる変数についてだけ反復支配辺境にphiを置き、支配木を
+    辿って名前を付け替える (Cytron et al., semi-pruned)。IR_LOAD/IR_STORE
+    は消え、仮引数の値はIR_PARAMで入口ブロックに定義される。
+    解体：クリティカル辺を分割し、phiを先行ブロック末尾の並列コピーに
+    置き換える。並列コピーは循環を一時レジスタで断ち切って逐次化する。
+
+    Construction: all formal parameters and auto variables are promoted
+    to virtual registers.  Phis are placed on the iterated dominance
+    frontiers only for variables live across blocks, then names are
+    rewritten along the dominator tree (Cytron et al., semi-pruned).
+    IR_LOAD/IR_STORE disappear and the values of formal parameters are
+    defined by IR_PARAM in the entry block.
+    Destruction: critical edges are split and each phi becomes parallel
+    copies at the end of its predecessors, which are sequentialized by
+    breaking cycles with a temporary register.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ir.h"
+#include  "opt.h"
+#include  "symtab.h"
+#include  "util.h"
+
+/* 昇格する変数ごとの情報 / state for each promoted variable */
+typedef struct SSA_Var {
+    SymTab *sym;
+    int  *stack;		/* 現在の名前のスタック / stack of current names */
+    int  depth;
+    int  size;
+    int  global;		/* ブロックをまたいで生きる / live across blocks */
+} SSA_Var;
+
+static IR_Func *cur_func;
+static SSA_Var *vars;
+static int  nvars;
+static int  *repl;		/* IR_LOADの結果 -> 変数の値 / result of IR_LOAD -> value */
+static int  repl_size;
+static int  *rename_log;	/* 名前を積んだ変数の履歴 / log of pushed variables */
+static int  log_depth, log_size;
+static IR_Insn *init_pos;	/* 入口での初期値の挿入位置 / insertion point of initial values */
+
+static SSA_Var *var_of(SymTab *sym);
+static void collect_vars(IR_Func *f);
+static void insert_phis(IR_Func *f);
+static IR_Block ***dominance_frontiers(IR_Func *f, int **ndf);
+static void insert_initial_values(IR_Func *f);
+static void insert_at_entry(IR_Func *f, IR_Insn *i);
+static void push_name(SSA_Var *v, int name, int logged);
+static int  top_name(SSA_Var *v);
+static int  resolve(int v);
+static void rename_block(IR_Block *b);
+static void prune_phis(IR_Func *f);
+static void promote_vars(IR_Func *f);
+static void sequentialize_copies(IR_Func *f, IR_Block *b,
+                                 int *dst, int *src, int n);
+static void verify_error(IR_Func *f, IR_Block *b, const char *mes, int v);
+
+void
+build_ssa(IR_Func *f)
+{
+    int  k;
+
+    cur_func = f;
+    ir_build_cfg(f);
+    compute_dominators(f);
+    collect_vars(f);
+    insert_phis(f);
+
+    repl_size = f->nvregs+1;
+    repl = xcalloc(repl_size, sizeof(int));
+    init_pos = NULL;
+    insert_initial_values(f);
+    rename_block(f->first);
+    prune_phis(f);
+    promote_vars(f);
+
+    for (k = 0; k < nvars; k++) {
+        free(vars[k].stack);
+    }
+    free(vars);
+    free(repl);
+    free(rename_log);
+    vars = NULL;
+    repl = NULL;
+    rename_log = NULL;
+    nvars = log_depth = log_size = 0;
+    cur_func = NULL;
+
+    verify_ssa(f);
+}
+
+/* 昇格対象の変数でなければNULL / NULL unless sym is promoted */
+SSA_Var*
+var_of(SymTab *sym)
+{
+    if (sym == NULL || sym->entry < 1 || sym->entry > nvars
+        || vars[sym->entry-1].sym != sym) {
+        return NULL;
+    }
+    return &vars[sym->entry-1];
+}
+
+void
+collect_vars(IR_Func *f)
+{
+    int  *killed;
+    IR_Block *b;
+    IR_Insn *i;
+    SymTab *t;
+    SSA_Var *v;
+
+    nvars = 0;
+    for (t = get_symtab(f->id); t != NULL; t = t->next) {
+        if (nvars < t->entry) {
+            nvars = t->entry;
+        }
+    }
+    vars = xcalloc(nvars+1, sizeof(SSA_Var));
+    for (t = get_symtab(f->id); t != NULL; t = t->next) {
+        if ((t->kind == SYM_ARG || t->kind == SYM_AUTOVAR) && !t->promoted) {
+            vars[t->entry-1].sym = t;
+        }
+    }
+
+    /* 定義より前に読まれる変数はブロックをまたいで生きる
+       A variable read before written in a block is live across blocks */
+    killed = xcalloc(nvars+1, sizeof(int));
+    FOR_EACH_BLOCK(b, f) {
+        FOR_EACH_INSN(i, b) {
+            if ((v = var_of(i->sym)) == NULL) {
+                continue;
+            }
+            if (i->op == IR_LOAD && killed[v-vars] != b->id+1) {
+                v->global = 1;
+            } else if (i->op == IR_STORE) {
+                killed[v-vars] = b->id+1;
+            }
+        }
+    }
+    free(killed);
+}
+
+IR_Block***
+dominance_frontiers(IR_Func *f, int **ndf)
+{
+    int  k, j;
+    IR_Block *b, *r, ***df;
+
+    df = xcalloc(f->nblocks, sizeof(IR_Block**));
+    *ndf = xcalloc(f->nblocks, sizeof(int));
+    for (k = 0; k < f->nrpo; k++) {
+        b = f->rpo[k];
+        if (b->npred < 2) {
+            continue;
+        }
+        for (j = 0; j < b->npred; j++) {
+            for (r = b->pred[j]; r->rpo >= 0 && r != b->idom; r = r->idom) {
+                if ((*ndf)[r->id] > 0 && df[r->id][(*ndf)[r->id]-1] == b) {
+                    break;
+                }
+                df[r->id] = xrealloc(df[r->id],
+                                     ((*ndf)[r->id]+1)*sizeof(IR_Block*));
+                df[r->id][(*ndf)[r->id]++] = b;
+            }
+        }
+    }
+    return df;
+}
+
+void
+insert_phis(IR_Func *f)
+{
+    int  k, j, n, p, *ndf, *has_phi, *queued;
+    IR_Block *b, *d, **work, ***df;
+    IR_Insn *i, *phi;
+    SSA_Var *v;
+
+    df = dominance_frontiers(f, &ndf);
+    has_phi = xcalloc(f->nblocks, sizeof(int));
+    queued = xcalloc(f->nblocks, sizeof(int));
+    work = xmalloc((f->nblocks+1)*sizeof(IR_Block*));
+    for (k = 0; k < nvars; k++) {
+        v = &vars[k];
+        if (v->sym == NULL || !v->global) {
+            continue;
+        }
+        /* 入口は初期値（仮引数の値または未定義）の定義点
+           The entry defines the initial value (parameter or undefined) */
+        n = 0;
+        work[n++] = f->first;
+        queued[f->first->id] = k+1;
+        FOR_EACH_BLOCK(b, f) {
+            if (b->rpo < 0 || queued[b->id] == k+1) {
+                continue;
+            }
+            FOR_EACH_INSN(i, b) {
+                if (i->op == IR_STORE && i->sym == v->sym) {
+                    queued[b->id] = k+1;
+                    work[n++] = b;
+                    break;
+                }
+            }
+        }
+        while (n > 0) {
+            b = work[--n];
+            for (j = 0; j < ndf[b->id]; j++) {
+                d = df[b->id][j];
+                if (has_phi[d->id] == k+1) {
+                    continue;
+                }
+                has_phi[d->id] = k+1;
+                phi = ir_new_insn(IR_PHI);
+                phi->dst = ir_new_vreg(f);
+                phi->sym = v->sym;
+                phi->nphi = d->npred;
+                phi->phi_src = xcalloc(d->npred, sizeof(int));
+                phi->phi_blk = xmalloc(d->npred*sizeof(IR_Block*));
+                for (p = 0; p < d->npred; p++) {
+                    phi->phi_blk[p] = d->pred[p];
+                }
+                if (d->head != NULL) {
+                    ir_insert_before(d->head, phi);
+                } else {
+                    ir_append(d, phi);
+                }
+                if (queued[d->id] != k+1) {
+                    queued[d->id] = k+1;
+                    work[n++] = d;
+                }
+            }
+        }
+    }
+    for (k = 0; k < f->nblocks; k++) {
+        free(df[k]);
+    }
+    free(df);
+    free(ndf);
+    free(has_phi);
+    free(queued);
+    free(work);
+}
+
+/* 仮引数の値を入口でIR_PARAMとして定義する
+   Define the values of the formal parameters by IR_PARAM at the entry */
+void
+insert_initial_values(IR_Func *f)
+{
+    int  k;
+    IR_Insn *i;
+    SSA_Var *v;
+
+    for (k = 0; k < f->nparams; k++) {
+        if ((v = var_of(f->params[k])) == NULL) {
+            continue;
+        }
+        i = ir_new_insn(IR_PARAM);
+        i->dst = ir_new_vreg(f);
+        i->imm = k+1;
+        i->sym = v->sym;
+        insert_at_entry(f, i);
+        push_name(v, i->dst, 0);
+    }
+}
+
+void
+insert_at_entry(IR_Func *f, IR_Insn *i)
+{
+    IR_Block *b = f->first;
+
+    if (init_pos != NULL) {
+        ir_insert_after(init_pos, i);
+    } else if (b->head != NULL) {
+        ir_insert_before(b->head, i);
+    } else {
+        ir_append(b, i);
+    }
+    init_pos = i;
+}
+
+void
+push_name(SSA_Var *v, int name, int logged)
+{
+    if (v->depth == v->size) {
+        v->size += 8;
+        v->stack = xrealloc(v->stack, v->size*sizeof(int));
+    }
+    v->stack[v->depth++] = name;
+    if (logged) {
+        if (log_depth == log_size) {
+            log_size += 32;
+            rename_log = xrealloc(rename_log, log_size*sizeof(int));
+        }
+        rename_log[log_depth++] = v-vars;
+    }
+}
+
+/*
+ * 変数の現在の名前。まだ定義されていない自動変数は0とする
+ * The current name of a variable.  An auto variable not yet assigned
+ * is taken as 0.
+ */
+int
+top_name(SSA_Var *v)
+{
+    IR_Insn *i;
+
+    if (v->depth == 0) {
+        i = ir_new_insn(IR_CONST);
+        i->dst = ir_new_vreg(cur_func);
+        i->imm = 0;
+        insert_at_entry(cur_func, i);
+        push_name(v, i->dst, 0);
+    }
+    return v->stack[v->depth-1];
+}
+
+int
+resolve(int v)
+{
+    if (v > 0 && v < repl_size && repl[v] != 0) {
+        return repl[v];
+    }
+    return v;
+}
+
+void
+rename_block(IR_Block *b)
+{
+    int  k, j, base;
+    IR_Block *c, *s;
+    IR_Insn *i, *next;
+    SSA_Var *v;
+
+    base = log_depth;
+    for (i = b->head; i != NULL; i = next) {
+        next = i->next;
+        if (i->op == IR_PHI) {
+            if ((v = var_of(i->sym)) != NULL) {
+                push_name(v, i->dst, 1);
+            }
+            continue;
+        }
+        for (k = 0; k < ir_num_uses(i); k++) {
+            *ir_use(i, k) = resolve(*ir_use(i, k));
+        }
+        if ((v = var_of(i->sym)) == NULL) {
+            continue;
+        }
+        if (i->op == IR_LOAD) {
+            repl[i->dst] = top_name(v);
+            ir_remove(i);
+        } else if (i->op == IR_STORE) {
+            push_name(v, i->src[0], 1);
+            ir_remove(i);
+        }
+    }
+    for (k = 0; k < b->nsucc; k++) {
+        s = b->succ[k];
+        FOR_EACH_INSN(i, s) {
+            if (i->op != IR_PHI) {
+                break;
+            }
+            if ((v = var_of(i->sym)) == NULL) {
+                continue;
+            }
+            for (j = 0; j < i->nphi; j++) {
+                if (i->phi_blk[j] == b) {
+                    i->phi_src[j] = top_name(v);
+                }
+            }
+        }
+    }
+    for (c = b->dom_child; c != NULL; c = c->dom_sibling) {
+        rename_block(c);
+    }
+    while (log_depth > base) {
+        vars[rename_log[--log_depth]].depth--;
+    }
+}
+
+/*
+ * 使われないphiと、自身以外に値が一つしかないphiを取り除く
+ * Remove phis that are unused or that merge a single value besides
+ * themselves.
+ */
+void
+prune_phis(IR_Func *f)
+{
+    int  k, same, changed, *uses;
+    IR_Block *b;
+    IR_Insn *i, *next;
+
+    do {
+        changed = 0;
+        uses = ir_use_counts(f);
+        FOR_EACH_BLOCK(b, f) {
+            for (i = b->head; i != NULL && i->op == IR_PHI; i = next) {
+                next = i->next;
+                same = 0;
+                for (k = 0; k < i->nphi; k++) {
+                    if (i->phi_src[k] == i->dst || i->phi_src[k] == same) {
+                        continue;
+                    }
+                    if (same != 0) {
+                        break;
+                    }
+                    same = i->phi_src[k];
+                }
+                if (uses[i->dst] == 0) {
+                    ir_remove(i);
+                    changed = 1;
+                } else if (k == i->nphi && same != 0) {
+                    ir_replace_vreg(f, i->dst, same);
+                    ir_remove(i);
+                    changed = 1;
+                }
+            }
+        }
+        free(uses);
+    } while (changed);
+}
+
+/* 変数をスタックから外してメモリを割り付け直す
+   Take the variables off the stack and redo the memory assignment */
+void
+promote_vars(IR_Func *f)
+{
+    int  k;
+
+    for (k = 0; k < nvars; k++) {
+        if (vars[k].sym != NULL) {
+            vars[k].sym->promoted = 1;
+        }
+    }
+    reassign_memory(f->id);
+}
+
+void
+destroy_ssa(IR_Func *f)
+{
+    int  k, n, npred, *dst, *src;
+    IR_Block *b, *s, **preds, **phi_blocks;
+    IR_Insn *i, *next;
+
+    ir_build_cfg(f);
+    phi_blocks = xmalloc(f->nblocks*sizeof(IR_Block*));
+    n = 0;
+    FOR_EACH_BLOCK(b, f) {
+        if (b->head != NULL && b->head->op == IR_PHI) {
+            phi_blocks[n++] = b;
+        }
+    }
+    while (n > 0) {
+        s = phi_blocks[--n];
+        npred = s->npred;
+        preds = xmalloc(npred*sizeof(IR_Block*));
+        for (k = 0; k < npred; k++) {
+            preds[k] = s->pred[k];
+        }
+        /* クリティカル辺を分割する / split critical edges */
+        for (k = 0; k < npred; k++) {
+            if (preds[k]->nsucc > 1) {
+                preds[k] = ir_split_edge(f, preds[k], s);
+            }
+        }
+        dst = xmalloc(f->nvregs*sizeof(int));
+        src = xmalloc(f->nvregs*sizeof(int));
+        for (k = 0; k < npred; k++) {
+            int  m = 0, j;
+            FOR_EACH_INSN(i, s) {
+                if (i->op != IR_PHI) {
+                    break;
+                }
+                for (j = 0; j < i->nphi; j++) {
+                    if (i->phi_blk[j] == preds[k]) {
+                        dst[m] = i->dst;
+                        src[m++] = i->phi_src[j];
+                        break;
+                    }
+                }
+            }
+            sequentialize_copies(f, preds[k], dst, src, m);
+        }
+        for (i = s->head; i != NULL && i->op == IR_PHI; i = next) {
+            next = i->next;
+            ir_remove(i);
+        }
+        free(dst);
+        free(src);
+        free(preds);
+    }
+    free(phi_blocks);
+    ir_build_cfg(f);
+}
+
+/*
+ * 並列コピー dst[k] = src[k] (k < n) をbの末尾命令の前に並べる
+ * 他のコピーの元になっていない行き先から順に書き、残りが循環なら
+ * 一つの行き先を一時レジスタに退避して断ち切る
+ * Place the parallel copies dst[k] = src[k] (k < n) before the
+ * terminator of b.  Destinations not read by other copies are written
+ * first; when only cycles remain, one destination is saved to a
+ * temporary register to break the cycle.
+ */
+void
+sequentialize_copies(IR_Func *f, IR_Block *b, int *dst, int *src, int n)
+{
+    int  k, j, t;
+    IR_Insn *pos, *i;
+
+    pos = ir_terminator(b);
+    for (k = 0; k < n; ) {
+        if (dst[k] == src[k]) {
+            dst[k] = dst[n-1];
+            src[k] = src[--n];
+        } else {
+            k++;
+        }
+    }
+    while (n > 0) {
+        for (k = 0; k < n; k++) {
+            for (j = 0; j < n; j++) {
+                if (src[j] == dst[k]) {
+                    break;
+                }
+            }
+            if (j == n) {
+                break;
+            }
+        }
+        i = ir_new_insn(IR_MOV);
+        if (k < n) {
+            i->dst = dst[k];
+            i->src[0] = src[k];
+            dst[k] = dst[n-1];
+            src[k] = src[--n];
+        } else {
+            t = ir_new_vreg(f);
+            i->dst = t;
+            i->src[0] = dst[0];
+            for (j = 0; j < n; j++) {
+                if (src[j] == dst[0]) {
+                    src[j] = t;
+                }
+            }
+        }
+        ir_insert_before(pos, i);
+    }
+}
+
+void
+verify_error(IR_Func *f, IR_Block *b, const char *mes, int v)
+{
+    fprintf(stderr, "SSA verification failed in %s, B%d: %s (v%d)\n",
+            f->name, b->id, mes, v);
+    dump_ir(f);
+    errexit("Broken SSA form.", __FILE__, __LINE__);
+}
+
+/*
+ * SSA形式の検査：定義は一つだけで、定義が使用を支配していること。
+ * phiはブロックの先頭にあり、先行ブロックごとに一つの値を持つこと。
+ * Verify SSA form: each register has one definition which dominates
+ * its uses.  Phis are at the beginning of a block and have one value
+ * for each predecessor.
+ */
+void
+verify_ssa(IR_Func *f)
+{
+    int  k, j, pos, v, *def_pos;
+    IR_Block *b, **def_blk;
+    IR_Insn *i;
+
+    ir_build_cfg(f);
+    compute_dominators(f);
+    def_blk = xcalloc(f->nvregs+1, sizeof(IR_Block*));
+    def_pos = xcalloc(f->nvregs+1, sizeof(int));
+    FOR_EACH_BLOCK(b, f) {
+        if (b->rpo < 0 && b->head != NULL) {
+            verify_error(f, b, "unreachable block", 0);
+        }
+        if (b != f->exit && ir_terminator(b) == NULL) {
+            verify_error(f, b, "missing terminator", 0);
+        }
+        pos = 0;
+        FOR_EACH_INSN(i, b) {
+            pos++;
+            if (i->block != b) {
+                verify_error(f, b, "instruction in a wrong block", i->dst);
+            }
+            if (IR_IS_TERMINATOR(i->op) && i != b->tail) {
+                verify_error(f, b, "terminator in the middle", 0);
+            }
+            if ((i->op == IR_LOAD || i->op == IR_STORE) && i->sym->promoted) {
+                verify_error(f, b, "access to a promoted variable", i->dst);
+            }
+            if (i->op == IR_PHI) {
+                if (i->prev != NULL && i->prev->op != IR_PHI) {
+                    verify_error(f, b, "phi after non-phi", i->dst);
+                }
+                if (i->nphi != b->npred) {
+                    verify_error(f, b, "phi arity mismatch", i->dst);
+                }
+                for (k = 0; k < b->npred; k++) {
+                    for (j = 0; j < i->nphi; j++) {
+                        if (i->phi_blk[j] == b->pred[k]) {
+                            break;
+                        }
+                    }
+                    if (j == i->nphi) {
+                        verify_error(f, b, "phi misses a predecessor", i->dst);
+                    }
+                }
+            }
+            if ((v = i->dst) != 0) {
+                if (v > f->nvregs || def_blk[v] != NULL) {
+                    verify_error(f, b, "multiple definitions", v);
+                }
+                def_blk[v] = b;
+                def_pos[v] = pos;
+            }
+        }
+    }
+    FOR_EACH_BLOCK(b, f) {
+        pos = 0;
+        FOR_EACH_INSN(i, b) {
+            pos++;
+            for (k = 0; k < ir_num_uses(i); k++) {
+                v = *ir_use(i, k);
+                if (v <= 0 || v > f->nvregs || def_blk[v] == NULL) {
+                    verify_error(f, b, "use without definition", v);
+                }
+                if (i->op == IR_PHI) {
+                    if (!dominates(def_blk[v], i->phi_blk[k])) {
+                        verify_error(f, b, "phi operand not dominated", v);
+                    }
+                } else if (def_blk[v] == b) {
+                    if (def_pos[v] >= pos) {
+                        verify_error(f, b, "use before definition", v);
+                    }
+                } else if (!dominates(def_blk[v], b)) {
+                    verify_error(f, b, "use not dominated", v);
+                }
+            }
+        }
+    }
+    free(def_blk);
+    free(def_pos);
+}
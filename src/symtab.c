@@ -175,6 +175,68 @@ assign_memory(void)
     }
 }
 
+SymTab*
+get_symtab(int id)
+{
+    if (id <= 0 || id > max_id) {
+        fprintf(stderr, "Illegal function id(%d).\n", id);
+        abort();
+    }
+    return symtab_array[id];
+}
+
+void
+reassign_memory(int id)
+{
+    if (id <= 0 || id > max_id) {
+        fprintf(stderr, "Illegal function id(%d).\n", id);
+        abort();
+    }
+    arch_assign_memory(symtab_array[id]);
+}
+
+SymTab*
+append_temp_sym(int id)
+{
+    char buf[16];
+    SymTab *t, **tail;
+
+    if (id <= 0 || id > max_id) {
+        fprintf(stderr, "Illegal function id(%d).\n", id);
+        abort();
+    }
+    t = xcalloc(1, sizeof(SymTab));
+    t->type = TYPE_INT;
+    t->kind = SYM_AUTOVAR;
+    for (tail = &symtab_array[id]; *tail != NULL; tail = &(*tail)->next) {
+        t->entry = (*tail)->entry;
+    }
+    t->entry++;
+    snprintf(buf, sizeof(buf), "$t%d", t->entry);
+    if ((t->ident = strdup(buf)) == NULL) {
+        fprintf(stderr, "Not enough memory for strdup.\n");
+        abort();
+    }
+    *tail = t;
+    return t;
+}
+
+int
+copy_symtab(int id)
+{
+    SymTab *t, **tail;
+
+    tail = &current_symtab.next;
+    for (t = get_symtab(id); t != NULL; t = t->next) {
+        *tail = xmalloc(sizeof(SymTab));
+        **tail = *t;
+        (*tail)->next = NULL;
+        tail = &(*tail)->next;
+    }
+    commit_current_symtab(max_id+1);
+    return max_id;
+}
+
 void
 dump_symtab(void)
 {
@@ -27,6 +27,8 @@ typedef struct SymTab {
                      id when this is a parameter
                      (numbering from 1, 0 means it's not a parameter */
     int  type;	  /* 変数型（現在はintのみ) / type (currently only int) */
+    int  promoted; /* レジスタに昇格済みなら1（スタック上に領域を置かない）
+                      1 if promoted to registers (no slot in the stack) */
     char  *ident; /* 変数名 / variable name (identifier) */
     struct SymTab *next;
 } SymTab;
@@ -51,6 +53,10 @@ extern  SymTab  *lookup_sym(int id, int symkind, char *ident);
 */
 extern  void commit_current_symtab(int id);
 
+/* idで識別される関数のシンボルテーブルの先頭を返す
+   Return the head of the symbol table of the function identified by id */
+extern  SymTab *get_symtab(int id);
+
 /* 読み出された関数で必要とするスタックフレームのサイズを返す
    Retruns the stack frame size
 */
@@ -59,6 +65,21 @@ extern  int get_frame_size(int id);
 /* メモリの割り付け / memory assignment  */
 extern  void assign_memory(void);
 
+/* idで識別される関数のメモリを割り付け直す
+   Redo the memory assignment of the function identified by id */
+extern  void reassign_memory(int id);
+
+/* idで識別される関数に名前のない一時変数（スピル領域など）を追加する
+   Add an anonymous temporary (e.g. a spill slot) to the function
+   identified by id */
+extern  SymTab *append_temp_sym(int id);
+
+/* idで識別される関数のシンボルテーブルを複製して新しいidで登録し、
+   そのidを返す（関数の複製用）
+   Copy the symbol table of the function identified by id, register
+   the copy with a new id and return it (for cloning functions) */
+extern  int  copy_symtab(int id);
+
 extern  void dump_symtab(void);
 
 #endif	/* SYMTAB_H */
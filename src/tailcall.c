@@ -0,0 +1,275 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    末尾呼び出しの最適化 / tail call optimization
+
+    値をそのまま返す自分自身の呼び出し（末尾再帰）は、入口の直後の
+    ループヘッダへの分岐にする。仮引数はヘッダのphiになり、実引数の
+    値を受け取る。return n * f(n-1) のように結果に値を足すか掛けてから
+    返す線形再帰は、累積値のphi（初期値は0または1）を加えて末尾再帰に
+    し、残りのreturnは累積値との演算結果を返す。
+    その他の末尾位置の呼び出しは、引数をすべてレジスタで渡せれば
+    IR_TAILCALLにして、フレームを捨ててから呼び出し先へ飛ぶ。
+    IR_TAILCALLは展開の妨げになるので、全関数の最適化の後で作る。
+
+    A call to the function itself whose value is returned as is (tail
+    recursion) becomes a jump to a loop header just after the entry.
+    The parameters become phis in the header receiving the arguments.
+    A linear recursion that adds to or multiplies the result before
+    returning it, like return n * f(n-1), gets an accumulator phi
+    (starting at 0 or 1) to become tail recursive, and the other
+    returns give the result combined with the accumulator.
+    Other calls in tail position become IR_TAILCALL, which discards the
+    frame and jumps to the callee, if all the arguments are passed in
+    registers.  IR_TAILCALL is made after all functions are optimized
+    since it would get in the way of inlining.
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  "arch_common.h"
+#include  "ir.h"
+#include  "opt.h"
+#include  "util.h"
+
+static IR_Insn *tail_call_of(IR_Func *f, IR_Block *b, IR_Insn **acc_op);
+static int  is_self_call(IR_Func *f, IR_Insn *call);
+static IR_Insn *new_insn(int op, int dst, int a, int b);
+static IR_Insn *new_phi(IR_Block *header, int v, IR_Block *from);
+static void add_phi_src(IR_Insn *phi, int v, IR_Block *from);
+
+/* 末尾再帰をループにした呼び出しの数を返す
+   Returns the number of tail recursive calls turned into a loop */
+int
+tail_recursion(IR_Func *f)
+{
+    int  k, n, v, nsite, acc_op, *args;
+    IR_Block *b, *entry, *header, **site_blk;
+    IR_Insn *i, *next, *t, *c, *call, *op, *acc, **sites, **ops, **phis;
+
+    /* 自分への末尾呼び出しを集め、累積に使う演算を決める
+       Collect the self tail calls and decide the accumulating operation */
+    sites = xmalloc(f->nblocks*sizeof(IR_Insn*));
+    ops = xmalloc(f->nblocks*sizeof(IR_Insn*));
+    site_blk = xmalloc(f->nblocks*sizeof(IR_Block*));
+    nsite = 0;
+    acc_op = 0;
+    FOR_EACH_BLOCK(b, f) {
+        if ((call = tail_call_of(f, b, &op)) == NULL || !is_self_call(f, call)) {
+            continue;
+        }
+        if (op != NULL) {
+            if (acc_op != 0 && op->op != acc_op) {
+                continue;
+            }
+            acc_op = op->op;
+        }
+        sites[nsite] = call;
+        ops[nsite] = op;
+        site_blk[nsite++] = b;
+    }
+    if (nsite == 0 || f->first->npred > 0) {
+        free(sites);
+        free(ops);
+        free(site_blk);
+        return 0;
+    }
+
+    /* 新しい入口に仮引数を移し、元の入口をループヘッダにする
+       Move the parameters to a new entry and make the old entry the
+       loop header */
+    header = f->first;
+    entry = ir_new_block(f);
+    ir_place_block_after(f, NULL, entry);
+    phis = xcalloc(f->nparams+1, sizeof(IR_Insn*));
+    for (i = header->head; i != NULL; i = next) {
+        next = i->next;
+        if (i->op == IR_PARAM) {
+            ir_remove(i);
+            ir_append(entry, i);
+            v = ir_new_vreg(f);
+            ir_replace_vreg(f, i->dst, v);
+            phis[i->imm] = new_phi(header, i->dst, entry);
+            phis[i->imm]->dst = v;
+        }
+    }
+    acc = NULL;
+    if (acc_op != 0) {
+        c = ir_new_insn(IR_CONST);
+        c->dst = ir_new_vreg(f);
+        c->imm = (acc_op == IR_MUL) ? 1 : 0;
+        ir_append(entry, c);
+        acc = new_phi(header, c->dst, entry);
+        acc->dst = ir_new_vreg(f);
+    }
+    c = ir_new_insn(IR_JMP);
+    c->target[0] = header;
+    ir_append(entry, c);
+
+    for (n = 0; n < nsite; n++) {
+        call = sites[n];
+        op = ops[n];
+        b = site_blk[n];
+        t = ir_terminator(b);
+        args = xcalloc(f->nparams+1, sizeof(int));
+        ir_remove_call_args(ir_call_begin(call, args), call);
+        for (k = 1; k <= f->nparams; k++) {
+            if (phis[k] != NULL) {
+                add_phi_src(phis[k], args[k], b);
+            }
+        }
+        if (acc != NULL && op == NULL) {
+            add_phi_src(acc, acc->dst, b);
+        } else if (acc != NULL) {
+            c = new_insn(acc_op, ir_new_vreg(f), acc->dst,
+                         op->src[op->src[0] == call->dst ? 1 : 0]);
+            ir_insert_before(t, c);
+            add_phi_src(acc, c->dst, b);
+            ir_remove(op);
+        }
+        ir_remove(call);
+        ir_remove(t);
+        c = ir_new_insn(IR_JMP);
+        c->target[0] = header;
+        ir_append(b, c);
+        free(args);
+    }
+
+    /* 残りのreturnは累積値と合わせた値を返す
+       The remaining returns give the value combined with the accumulator */
+    if (acc != NULL) {
+        FOR_EACH_BLOCK(b, f) {
+            t = ir_terminator(b);
+            if (t != NULL && t->op == IR_RET && t->src[0] != 0) {
+                c = new_insn(acc_op, ir_new_vreg(f), acc->dst, t->src[0]);
+                ir_insert_before(t, c);
+                t->src[0] = c->dst;
+            }
+        }
+    }
+
+    ir_build_cfg(f);
+    free(phis);
+    free(sites);
+    free(ops);
+    free(site_blk);
+    return nsite;
+}
+
+/*
+ * 末尾位置の呼び出しを、フレームを再利用して飛ぶIR_TAILCALLにする。
+ * 変えた数を返す
+ * Turn calls in tail position into IR_TAILCALL jumping with the frame
+ * reused.  Returns the number of calls changed.
+ */
+int
+tail_calls(IR_Func *f)
+{
+    int  n;
+    IR_Block *b;
+    IR_Insn *i, *call, *begin;
+
+    n = 0;
+    FOR_EACH_BLOCK(b, f) {
+        if ((call = tail_call_of(f, b, NULL)) == NULL || call->imm > NUM_PARAM_REGS
+            || (begin = ir_call_begin(call, NULL)) == NULL) {
+            continue;
+        }
+        /* 入れ子の呼び出しは設定済みの引数レジスタを壊す
+           A nested call would clobber the argument registers already set */
+        for (i = begin->next; i != call && i->op != IR_CALL_BEGIN; i = i->next)
+            ;
+        if (i != call) {
+            continue;
+        }
+        ir_remove(ir_terminator(b));
+        call->op = IR_TAILCALL;
+        call->dst = 0;
+        n++;
+    }
+    if (n > 0) {
+        ir_build_cfg(f);
+    }
+    return n;
+}
+
+/*
+ * bが呼び出しの値をそのまま返して終わるならその呼び出し。acc_opが
+ * NULLでなければ、値に一度だけ足すか掛けてから返すものも認め、その
+ * 命令を*acc_opに入れる（なければNULL）
+ * The call if b ends by returning its value as is.  If acc_op is not
+ * NULL, one addition to or multiplication of the value before the
+ * return is also allowed and stored in *acc_op (NULL if none).
+ */
+IR_Insn*
+tail_call_of(IR_Func *f, IR_Block *b, IR_Insn **acc_op)
+{
+    IR_Insn *t, *call, *op;
+
+    t = ir_terminator(b);
+    if (t == NULL || t->prev == NULL
+        || (t->op != IR_RET && (t->op != IR_JMP || t->target[0] != f->exit))) {
+        return NULL;
+    }
+    call = t->prev;
+    op = NULL;
+    if (acc_op != NULL && t->op == IR_RET && call->dst == t->src[0]
+        && (call->op == IR_ADD || call->op == IR_MUL) && call->prev != NULL) {
+        op = call;
+        call = op->prev;
+        if (call->op != IR_CALL || call->dst == 0
+            || (op->src[0] == call->dst) == (op->src[1] == call->dst)) {
+            return NULL;
+        }
+    }
+    if (call->op != IR_CALL
+        || (op == NULL && t->op == IR_RET && t->src[0] != call->dst)) {
+        return NULL;
+    }
+    if (acc_op != NULL) {
+        *acc_op = op;
+    }
+    return call;
+}
+
+int
+is_self_call(IR_Func *f, IR_Insn *call)
+{
+    return strcmp(call->name, f->name) == 0 && call->imm == f->nparams
+           && ir_call_begin(call, NULL) != NULL;
+}
+
+IR_Insn*
+new_insn(int op, int dst, int a, int b)
+{
+    IR_Insn *i;
+
+    i = ir_new_insn(op);
+    i->dst = dst;
+    i->src[0] = a;
+    i->src[1] = b;
+    return i;
+}
+
+/* headerの先頭にfromからvを受けるphiを置く
+   Put a phi receiving v from "from" at the top of header */
+IR_Insn*
+new_phi(IR_Block *header, int v, IR_Block *from)
+{
+    IR_Insn *phi;
+
+    phi = ir_new_insn(IR_PHI);
+    add_phi_src(phi, v, from);
+    ir_insert_before(header->head, phi);
+    return phi;
+}
+
+void
+add_phi_src(IR_Insn *phi, int v, IR_Block *from)
+{
+    phi->phi_src = xrealloc(phi->phi_src, (phi->nphi+1)*sizeof(int));
+    phi->phi_blk = xrealloc(phi->phi_blk, (phi->nphi+1)*sizeof(IR_Block*));
+    phi->phi_src[phi->nphi] = v;
+    phi->phi_blk[phi->nphi++] = from;
+}
@@ -0,0 +1,59 @@
+	.text
+	.p2align 2
+	.global	g
+g:
+	mul	w8, w0, w1
+	add	w0, w8, w0
+_END_g:
+	ret
+
+	.global	f
+f:
+	str	x30, [sp, -16]!
+	add	w0, w0, 1
+	add	w1, w1, w1, lsl 1
+	ldr	x30, [sp], 16
+	b	g
+_END_f:
+	ldr	x30, [sp], 16
+	ret
+
+	.global	_main
+_main:
+	str	x30, [sp, -16]!
+	mov	w0, 2
+	mov	w1, 5
+	bl	f
+	bl	put_int
+	mov	w0, 1
+	mov	w1, 2
+	bl	f
+	mov	w1, 7
+	bl	g
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
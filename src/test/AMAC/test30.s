@@ -0,0 +1,78 @@
+	.text
+	.p2align 2
+	.global	g
+g:
+	str	x30, [sp, -64]!
+	str	x19, [sp, 16]
+	str	x20, [sp, 24]
+	str	x21, [sp, 32]
+	str	x22, [sp, 40]
+	str	x23, [sp, 48]
+	str	x24, [sp, 56]
+	mov	w19, w0
+	mov	w20, w1
+	mov	w21, w2
+	mov	w22, w3
+	mov	w23, w4
+	mov	w24, w5
+	mov	w0, w19
+	bl	put_int
+	mul	w9, w19, w20
+	mul	w8, w21, w22
+	add	w9, w9, w8
+	mul	w8, w23, w24
+	add	w19, w9, w8
+	mov	w0, w19
+	bl	put_int
+	mov	w0, w24
+	bl	put_int
+	add	w0, w19, w24
+	bl	put_int
+	mov	w0, w19
+_END_g:
+	ldr	x19, [sp, 16]
+	ldr	x20, [sp, 24]
+	ldr	x21, [sp, 32]
+	ldr	x22, [sp, 40]
+	ldr	x23, [sp, 48]
+	ldr	x24, [sp, 56]
+	ldr	x30, [sp], 64
+	ret
+
+	.global	_main
+_main:
+	str	x30, [sp, -16]!
+	mov	w0, 1
+	mov	w1, 2
+	mov	w2, 3
+	mov	w3, 4
+	mov	w4, 5
+	mov	w5, 6
+	bl	g
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
@@ -0,0 +1,98 @@
+	.text
+	.p2align 2
+	.global	h
+h:
+	str	x30, [sp, -96]!
+	str	x19, [sp, 16]
+	str	x20, [sp, 24]
+	str	x21, [sp, 32]
+	str	x22, [sp, 40]
+	str	x23, [sp, 48]
+	str	x25, [sp, 56]
+	str	x26, [sp, 64]
+	mov	w19, w0
+	mov	w20, w1
+	mov	w21, w2
+	mov	w22, w3
+	mov	w23, w4
+	mul	w25, w19, w20
+	mul	w26, w21, w22
+	mov	w10, 0
+	mov	w11, 0
+.L0:
+	cmp	w11, 1000
+	b.ge	.L1
+	str	w10, [sp, 84]
+	str	w11, [sp, 80]
+	mov	w0, w11
+	bl	put_int
+	ldr	w10, [sp, 84]
+	ldr	w11, [sp, 80]
+	add	w8, w25, w10
+	add	w8, w8, w26
+	add	w8, w8, w23
+	add	w12, w8, 100
+	str	w11, [sp, 84]
+	str	w12, [sp, 80]
+	sub	w0, w12, 200
+	bl	put_int
+	ldr	w11, [sp, 84]
+	ldr	w12, [sp, 80]
+	mov	w10, w12
+	add	w8, w11, 300
+	mov	w11, w8
+	b	.L0
+.L1:
+	add	w8, w10, w19
+	add	w8, w8, w20
+	add	w8, w8, w21
+	add	w8, w8, w22
+	add	w0, w8, w23
+_END_h:
+	ldr	x19, [sp, 16]
+	ldr	x20, [sp, 24]
+	ldr	x21, [sp, 32]
+	ldr	x22, [sp, 40]
+	ldr	x23, [sp, 48]
+	ldr	x25, [sp, 56]
+	ldr	x26, [sp, 64]
+	ldr	x30, [sp], 96
+	ret
+
+	.global	_main
+_main:
+	str	x30, [sp, -16]!
+	mov	w0, 1
+	mov	w1, 2
+	mov	w2, 3
+	mov	w3, 4
+	mov	w4, 5
+	bl	h
+	mov	w8, w0
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
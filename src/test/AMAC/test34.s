@@ -0,0 +1,78 @@
+	.text
+	.p2align 2
+	.global	calc
+calc:
+	str	x30, [sp, -32]!
+	str	x19, [sp, 16]
+	str	x20, [sp, 24]
+	mov	w19, w0
+	mov	w20, w1
+	mov	w0, w19
+	bl	put_int
+	add	w0, w19, 1
+	add	w9, w20, 2
+	mul	w15, w19, w20
+	mul	w14, w0, w9
+	add	w13, w15, w14
+	sub	w12, w0, w9
+	mul	w11, w13, w12
+	sub	w10, w15, w14
+	add	w8, w19, w20
+	add	w8, w0, w8
+	add	w8, w9, w8
+	add	w8, w15, w8
+	add	w8, w14, w8
+	add	w8, w13, w8
+	add	w8, w12, w8
+	add	w8, w11, w8
+	add	w9, w10, w8
+	mul	w8, w15, w14
+	add	w9, w9, w8
+	mul	w8, w14, w13
+	mul	w8, w12, w8
+	add	w9, w9, w8
+	mul	w8, w11, w10
+	add	w0, w9, w8
+_END_calc:
+	ldr	x19, [sp, 16]
+	ldr	x20, [sp, 24]
+	ldr	x30, [sp], 32
+	ret
+
+	.global	_main
+_main:
+	str	x30, [sp, -16]!
+	mov	w0, 3
+	mov	w1, 4
+	bl	calc
+	bl	put_int
+	mov	w0, 5
+	mov	w1, 7
+	bl	calc
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
@@ -0,0 +1,100 @@
+	.text
+	.p2align 2
+	.global	sq
+sq:
+	stp	x29, x30, [sp, -32]!
+	add	x29, sp, 32
+	str	w0, [x29, -4]
+	ldr	w8, [x29, -4]
+	ldr	w9, [x29, -4]
+	mul	w8, w8, w9
+	mov	w0, w8
+	b	_END_sq
+_END_sq:
+	ldp	x29, x30, [sp], 32
+	ret
+
+	.global	api
+api:
+	stp	x29, x30, [sp, -32]!
+	add	x29, sp, 32
+	str	w0, [x29, -4]
+	str	w1, [x29, -8]
+	sub	sp, sp, #16
+	str	w9, [sp, 4]
+	str	w10, [sp, 0]
+	ldr	w8, [x29, -4]
+	mov	w0, w8
+	bl	sq
+	mov	w8, w0
+	ldr	w9, [sp, 4]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+	sub	sp, sp, #16
+	str	w8, [sp, 8]
+	str	w10, [sp, 0]
+	ldr	w8, [x29, -8]
+	mov	w0, w8
+	bl	sq
+	mov	w9, w0
+	ldr	w8, [sp, 8]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+	add	w8, w8, w9
+	mov	w0, w8
+	b	_END_api
+_END_api:
+	ldp	x29, x30, [sp], 32
+	ret
+
+	.global	_main
+_main:
+	stp	x29, x30, [sp, -32]!
+	add	x29, sp, 32
+	sub	sp, sp, #16
+	str	w9, [sp, 4]
+	str	w10, [sp, 0]
+	mov	w8, 3
+	mov	w0, w8
+	mov	w8, 4
+	mov	w1, w8
+	bl	api
+	mov	w8, w0
+	ldr	w9, [sp, 4]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+	str	w8, [x29, -4]
+	sub	sp, sp, #16
+	str	w9, [sp, 4]
+	str	w10, [sp, 0]
+	ldr	w8, [x29, -4]
+	mov	w0, w8
+	bl	put_int
+	ldr	w9, [sp, 4]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+_END_main:
+	ldp	x29, x30, [sp], 32
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
@@ -0,0 +1,49 @@
+	.text
+	.p2align 2
+	.global	_main
+_main:
+	stp	x29, x30, [sp, -16]!
+	add	x29, sp, 16
+	mov	w11, 0
+	mov	w9, 0
+	mov	w12, 1
+.L5:
+	cmp	w11, 10
+	b.ge	.L4
+	add	w13, w12, w9
+	add	w14, w11, 1
+	mov	w11, w14
+	mov	w9, w12
+	mov	w12, w13
+	b	.L5
+.L4:
+	mov	w0, w9
+	bl	put_int
+	mov	w0, 16
+	ldp	x29, x30, [sp], 16
+	b	put_int
+_END_main:
+	ldp	x29, x30, [sp], 16
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
@@ -0,0 +1,52 @@
+	.text
+	.p2align 2
+	.global	_main
+_main:
+	str	x30, [sp, -16]!
+	mov	w0, 261
+	bl	put_int
+	mov	w9, 36
+	mov	w0, 84
+.L7:
+	cbnz	w9, .L4
+	b	.L5
+.L4:
+	cmp	w0, w9
+	b.ge	.L6
+	mov	w8, w9
+	mov	w9, w0
+	mov	w0, w8
+	b	.L7
+.L6:
+	sub	w0, w0, w9
+	b	.L7
+.L5:
+	bl	put_int
+	mov	w0, 81
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
@@ -0,0 +1,155 @@
+	.text
+	.p2align 2
+	.global	show
+show:
+	stp	x29, x30, [sp, -64]!
+	add	x29, sp, 64
+	str	x19, [sp, 16]
+	str	x22, [sp, 24]
+	str	x23, [sp, 32]
+	str	x24, [sp, 40]
+	str	x25, [sp, 48]
+	mov	w19, w0
+	sub	w22, w19, 2
+	mov	w8, 0x2
+	movk	w8, 0x8000, lsl 16
+	cmp	w19, w8
+	b.ge	.L6
+	mov	w23, 0
+	b	.L7
+.L9:
+	cmp	w24, w22
+	b.ge	.L8
+	mul	w0, w24, w24
+	bl	put_int
+	add	w25, w24, 1
+	mul	w0, w25, w25
+	bl	put_int
+	add	w25, w25, 1
+	mul	w0, w25, w25
+	bl	put_int
+	add	w8, w25, 1
+	mov	w24, w8
+	b	.L9
+.L7:
+	mov	w25, w23
+.L0:
+	cmp	w25, w19
+	b.ge	.L1
+	mul	w0, w25, w25
+	bl	put_int
+	add	w8, w25, 1
+	mov	w25, w8
+	b	.L0
+.L1:
+	b	_END_show
+.L8:
+	mov	w23, w24
+	b	.L7
+.L6:
+	mov	w24, 0
+	b	.L9
+_END_show:
+	ldr	x19, [sp, 16]
+	ldr	x22, [sp, 24]
+	ldr	x23, [sp, 32]
+	ldr	x24, [sp, 40]
+	ldr	x25, [sp, 48]
+	ldp	x29, x30, [sp], 64
+	ret
+
+	.global	countdown
+countdown:
+	stp	x29, x30, [sp, -64]!
+	add	x29, sp, 64
+	str	x21, [sp, 16]
+	str	x22, [sp, 24]
+	str	x23, [sp, 32]
+	str	x24, [sp, 40]
+	str	x25, [sp, 48]
+	mov	w8, w0
+	mov	w22, w8
+	mov	w23, 0
+.L11:
+	cmp	w22, 1
+	b.le	.L10
+	mov	w0, w22
+	bl	put_int
+	add	w24, w23, w22
+	sub	w25, w22, 1
+	mov	w0, w25
+	bl	put_int
+	sub	w9, w25, 1
+	mov	w22, w9
+	add	w8, w24, w25
+	mov	w23, w8
+	b	.L11
+.L10:
+	mov	w21, w22
+	mov	w22, w23
+.L2:
+	cmp	w21, 0
+	b.le	.L3
+	mov	w0, w21
+	bl	put_int
+	add	w8, w22, w21
+	sub	w9, w21, 1
+	mov	w21, w9
+	mov	w22, w8
+	b	.L2
+.L3:
+	mov	w0, w22
+_END_countdown:
+	ldr	x21, [sp, 16]
+	ldr	x22, [sp, 24]
+	ldr	x23, [sp, 32]
+	ldr	x24, [sp, 40]
+	ldr	x25, [sp, 48]
+	ldp	x29, x30, [sp], 64
+	ret
+
+	.global	_main
+_main:
+	stp	x29, x30, [sp, -16]!
+	add	x29, sp, 16
+	mov	w0, 7
+	bl	show
+	mov	w0, 5
+	bl	countdown
+	mov	w8, w0
+	bl	put_int
+	mov	w0, 10
+	bl	put_int
+	mov	w0, 11
+	bl	put_int
+	mov	w0, 12
+	bl	put_int
+	mov	w0, 13
+	bl	put_int
+.L4:
+.L5:
+_END_main:
+	ldp	x29, x30, [sp], 16
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
@@ -0,0 +1,59 @@
+	.text
+	.p2align 2
+	.global	poly
+poly:
+	mul	w9, w0, w0
+	add	w9, w9, w9, lsl 1
+	add	w8, w0, w0, lsl 2
+	add	w9, w9, w8
+	sub	w8, w9, 7
+	mul	w9, w8, w0
+	add	w0, w9, 1
+_END_poly:
+	ret
+
+	.global	_main
+_main:
+	str	x30, [sp, -32]!
+	str	x19, [sp, 16]
+	mov	w0, 21
+	bl	put_int
+	mov	w0, 4
+	bl	poly
+	mov	w19, w0
+	mov	w0, 5
+	bl	poly
+	add	w0, w19, w0
+	bl	put_int
+	mov	w0, 372
+	bl	put_int
+	mov	w0, 2302
+	ldr	x19, [sp, 16]
+	ldr	x30, [sp], 32
+	b	put_int
+_END_main:
+	ldr	x19, [sp, 16]
+	ldr	x30, [sp], 32
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
@@ -0,0 +1,97 @@
+	.text
+	.p2align 2
+	.global	scale
+scale:
+	cmp	w1, 0
+	cset	w8, gt
+	mul	w8, w1, w8
+	mul	w9, w0, w1
+	mul	w11, w9, w8
+	lsr	w10, w8, #1
+	add	w8, w8, w8
+	sub	w8, w8, 1
+	sub	w8, w8, w10
+	sub	w8, w8, w10
+	mul	w8, w10, w8
+	add	w0, w11, w8
+.L0:
+.L1:
+_END_scale:
+	ret
+
+	.global	_main
+_main:
+	str	x30, [sp, -48]!
+	str	x19, [sp, 16]
+	str	x20, [sp, 24]
+	str	x21, [sp, 32]
+	mov	w20, 1
+.L2:
+	cmp	w20, 3
+	b.ge	.L3
+	mov	w0, w20
+	mov	w1, 2
+	bl	scale.constprop.1
+	mov	w19, w0
+	add	w21, w20, 1
+	mov	w0, w21
+	mov	w1, 2
+	bl	scale.constprop.1
+	add	w0, w19, w0
+	bl	put_int
+	mov	w0, w20
+	mov	w1, 5
+	bl	scale
+	bl	put_int
+	mov	w20, w21
+	b	.L2
+.L3:
+	mov	w0, 7
+	mov	w1, 9
+	bl	scale
+	mov	w19, w0
+	mov	w0, w20
+	mov	w1, 9
+	bl	scale
+	add	w0, w19, w0
+	ldr	x19, [sp, 16]
+	ldr	x20, [sp, 24]
+	ldr	x21, [sp, 32]
+	ldr	x30, [sp], 48
+	b	put_int
+_END_main:
+	ldr	x19, [sp, 16]
+	ldr	x20, [sp, 24]
+	ldr	x21, [sp, 32]
+	ldr	x30, [sp], 48
+	ret
+
+	.global	scale.constprop.1
+scale.constprop.1:
+	add	w9, w0, w0
+	add	w9, w9, w9
+	add	w0, w9, 1
+_END_scale.constprop.1:
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
@@ -0,0 +1,81 @@
+	.text
+	.p2align 2
+	.global	tri
+tri:
+	cmp	w0, 0
+	cset	w8, gt
+	mul	w8, w0, w8
+	mul	w11, w0, w8
+	lsr	w10, w8, #1
+	add	w8, w8, w8
+	sub	w8, w8, 1
+	sub	w8, w8, w10
+	sub	w8, w8, w10
+	mul	w8, w10, w8
+	sub	w0, w11, w8
+.L0:
+.L1:
+_END_tri:
+	ret
+
+	.global	fact
+fact:
+	mov	w8, 1
+.L3:
+	cmp	w0, 2
+	b.ge	.L2
+	mov	w0, w8
+	b	_END_fact
+.L2:
+	mul	w8, w0, w8
+	sub	w9, w0, 1
+	mov	w0, w9
+	b	.L3
+_END_fact:
+	ret
+
+	.global	_main
+_main:
+	str	x30, [sp, -32]!
+	str	x19, [sp, 16]
+	mov	w0, 10
+	bl	tri
+	mov	w19, w0
+	bl	put_int
+	mov	w0, 1000
+	bl	tri
+	bl	put_int
+	mov	w0, 120
+	bl	put_int
+	mov	w0, 10
+	bl	fact
+	sub	w0, w0, w19
+	ldr	x19, [sp, 16]
+	ldr	x30, [sp], 32
+	b	put_int
+_END_main:
+	ldr	x19, [sp, 16]
+	ldr	x30, [sp], 32
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
@@ -0,0 +1,93 @@
+	.text
+	.p2align 2
+	.global	twice
+twice:
+	stp	x29, x30, [sp, -32]!
+	add	x29, sp, 32
+	str	w0, [x29, -4]
+	ldr	w8, [x29, -4]
+	ldr	w9, [x29, -4]
+	add	w8, w8, w9
+	mov	w0, w8
+	b	_END_twice
+_END_twice:
+	ldp	x29, x30, [sp], 32
+	ret
+
+	.global	unused
+unused:
+	stp	x29, x30, [sp, -32]!
+	add	x29, sp, 32
+	str	w0, [x29, -8]
+	str	w1, [x29, -12]
+	ldr	w8, [x29, -8]
+	ldr	w9, [x29, -12]
+	mul	w8, w8, w9
+	str	w8, [x29, -4]
+	sub	sp, sp, #16
+	str	w9, [sp, 4]
+	str	w10, [sp, 0]
+	ldr	w8, [x29, -4]
+	mov	w0, w8
+	bl	twice
+	mov	w8, w0
+	ldr	w9, [sp, 4]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+	ldr	w9, [x29, -8]
+	sub	w8, w8, w9
+	mov	w0, w8
+	b	_END_unused
+_END_unused:
+	ldp	x29, x30, [sp], 32
+	ret
+
+	.global	_main
+_main:
+	stp	x29, x30, [sp, -32]!
+	add	x29, sp, 32
+	sub	sp, sp, #16
+	str	w9, [sp, 4]
+	str	w10, [sp, 0]
+	mov	w8, 21
+	mov	w0, w8
+	bl	twice
+	mov	w8, w0
+	ldr	w9, [sp, 4]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+	str	w8, [x29, -4]
+	sub	sp, sp, #16
+	str	w9, [sp, 4]
+	str	w10, [sp, 0]
+	ldr	w8, [x29, -4]
+	mov	w0, w8
+	bl	put_int
+	ldr	w9, [sp, 4]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+_END_main:
+	ldp	x29, x30, [sp], 32
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
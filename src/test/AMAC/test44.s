@@ -0,0 +1,79 @@
+	.text
+	.p2align 2
+	.global	leaf
+leaf:
+	mov	w8, w0
+	mov	w9, w1
+	mul	w10, w8, w9
+	add	w8, w10, w8
+	sub	w0, w8, w9
+_END_leaf:
+	ret
+
+	.global	outer
+outer:
+	str	x30, [sp, -48]!
+	str	x19, [sp, 16]
+	str	x21, [sp, 24]
+	str	x22, [sp, 32]
+	str	x23, [sp, 40]
+	mov	w19, w0
+	mov	w21, 0
+	mov	w22, 0
+.L0:
+	cmp	w22, w19
+	b.ge	.L1
+	mov	w0, w22
+	mov	w1, w19
+	bl	leaf
+	mov	w8, w0
+	add	w23, w8, w21
+	mov	w0, w23
+	bl	put_int
+	mov	w21, w23
+	add	w8, w22, 1
+	mov	w22, w8
+	b	.L0
+.L1:
+	mov	w0, w21
+_END_outer:
+	ldr	x19, [sp, 16]
+	ldr	x21, [sp, 24]
+	ldr	x22, [sp, 32]
+	ldr	x23, [sp, 40]
+	ldr	x30, [sp], 48
+	ret
+
+	.global	_main
+_main:
+	str	x30, [sp, -16]!
+	mov	w0, 4
+	bl	outer
+	mov	w8, w0
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
@@ -0,0 +1,95 @@
+	.text
+	.p2align 2
+	.global	wide
+wide:
+	stp	x29, x30, [sp, -16]!
+	add	x29, sp, 16
+	add	w3, w0, w1
+	add	w1, w1, w2
+	mul	w0, w0, w2
+	mul	w15, w3, w1
+	sub	w14, w0, w15
+	add	w13, w3, w14
+	mul	w12, w1, w13
+	add	w11, w0, w12
+	sub	w10, w15, w11
+	mul	w9, w14, w10
+	add	w8, w3, w2
+	add	w8, w3, w8
+	add	w8, w1, w8
+	add	w8, w0, w8
+	add	w8, w15, w8
+	add	w8, w14, w8
+	add	w8, w13, w8
+	add	w8, w12, w8
+	add	w8, w11, w8
+	add	w8, w10, w8
+	add	w9, w9, w8
+	mul	w8, w0, w15
+	add	w9, w9, w8
+	mul	w8, w15, w14
+	mul	w8, w13, w8
+	add	w9, w9, w8
+	mul	w8, w12, w11
+	mul	w8, w10, w8
+	add	w0, w9, w8
+_END_wide:
+	ldp	x29, x30, [sp], 16
+	ret
+
+	.global	sumto
+sumto:
+	stp	x29, x30, [sp, -16]!
+	add	x29, sp, 16
+	mov	w8, 0
+.L1:
+	cbnz	w0, .L0
+	mov	w0, w8
+	b	_END_sumto
+.L0:
+	add	w8, w0, w8
+	sub	w9, w0, 1
+	mov	w0, w9
+	b	.L1
+_END_sumto:
+	ldp	x29, x30, [sp], 16
+	ret
+
+	.global	_main
+_main:
+	stp	x29, x30, [sp, -16]!
+	add	x29, sp, 16
+	mov	w0, 1
+	mov	w1, 2
+	mov	w2, 3
+	bl	wide
+	bl	put_int
+	mov	w0, 10
+	bl	sumto
+	ldp	x29, x30, [sp], 16
+	b	put_int
+_END_main:
+	ldp	x29, x30, [sp], 16
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
@@ -0,0 +1,63 @@
+	.text
+	.p2align 2
+	.global	count
+count:
+	mov	w8, 0
+	mov	w9, 0
+	mov	w10, 0
+.L0:
+	cmp	w9, w0
+	b.ge	.L1
+	cmp	w9, 0
+	b.ne	.L3
+	add	w8, w8, 5
+	b	.L2
+.L3:
+	add	w8, w10, w8
+.L2:
+	add	w9, w9, 1
+	add	w10, w10, 3
+	b	.L0
+.L1:
+	mov	w0, w8
+	b	_END_count
+_END_count:
+	ret
+
+	.global	_main
+_main:
+	str	x30, [sp, -16]!
+	mov	w0, 6
+	bl	count
+	cmp	w0, 0
+	b.eq	.L4
+	bl	put_int
+.L4:
+	mov	w0, 0
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.text
+	.p2align 2
+.LC0:
+	.string "%d\n"
+	.text
+	.p2align 2
+put_int:
+	sub	sp, sp, #32
+	stp	x29, x30, [sp, #16]
+	add	x29, sp, #16
+	stur	w0, [x29, #-4]
+	ldur	w9, [x29, #-4]
+	mov	x8, x9
+	adrp	x0, .LC0@PAGE
+	add	x0, x0, .LC0@PAGEOFF
+	mov	x9, sp
+	str	x8, [x9]
+	bl	_printf
+	ldp	x29, x30, [sp, #16]
+	add	sp, sp, #32
+	ret
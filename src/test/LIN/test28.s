@@ -0,0 +1,56 @@
+	.text
+	.globl	g
+g:
+	movl	%edi, %eax
+	imull	%esi, %eax
+	addl	%edi, %eax
+_END_g:
+	ret
+
+	.globl	f
+f:
+	subq	$8, %rsp
+	addl	$1, %edi
+	leal	(%rsi,%rsi,2), %esi
+	addq	$8, %rsp
+	jmp	g
+_END_f:
+	addq	$8, %rsp
+	ret
+
+	.globl	main
+main:
+	subq	$8, %rsp
+	movl	$2, %edi
+	movl	$5, %esi
+	call	f
+	movl	%eax, %edi
+	call	put_int
+	movl	$1, %edi
+	movl	$2, %esi
+	call	f
+	movl	%eax, %edi
+	movl	$7, %esi
+	call	g
+	movl	%eax, %edi
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	leaq	.LC0(%rip), %rdi
+	movl	$0, %eax
+	call	printf@PLT
+	leave
+	ret
@@ -0,0 +1,31 @@
+	.text
+	.globl	main
+main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	$1, %edi
+	call	put_int
+	movl	$2, %edi
+	call	put_int
+	movl	$25, %edi
+	leave
+	jmp	put_int
+_END_main:
+	leave
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	leaq	.LC0(%rip), %rdi
+	movl	$0, %eax
+	call	printf@PLT
+	leave
+	ret
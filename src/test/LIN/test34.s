@@ -0,0 +1,78 @@
+	.text
+	.globl	calc
+calc:
+	subq	$24, %rsp
+	movq	%rbx, 16(%rsp)
+	movq	%r12, 8(%rsp)
+	movl	%edi, %ebx
+	movl	%esi, %r12d
+	movl	%ebx, %edi
+	call	put_int
+	leal	1(%rbx), %r8d
+	leal	2(%r12), %ecx
+	movl	%ebx, %edx
+	imull	%r12d, %edx
+	movl	%r8d, %esi
+	imull	%ecx, %esi
+	leal	(%rdx,%rsi), %edi
+	movl	%r8d, %r11d
+	subl	%ecx, %r11d
+	movl	%edi, %r10d
+	imull	%r11d, %r10d
+	movl	%edx, %eax
+	subl	%esi, %eax
+	leal	(%rbx,%r12), %r9d
+	addl	%r9d, %r8d
+	addl	%r8d, %ecx
+	addl	%edx, %ecx
+	addl	%esi, %ecx
+	addl	%edi, %ecx
+	addl	%r11d, %ecx
+	addl	%r10d, %ecx
+	addl	%eax, %ecx
+	imull	%esi, %edx
+	addl	%ecx, %edx
+	imull	%esi, %edi
+	imull	%edi, %r11d
+	addl	%edx, %r11d
+	imull	%r10d, %eax
+	addl	%r11d, %eax
+_END_calc:
+	movq	16(%rsp), %rbx
+	movq	8(%rsp), %r12
+	addq	$24, %rsp
+	ret
+
+	.globl	main
+main:
+	subq	$8, %rsp
+	movl	$3, %edi
+	movl	$4, %esi
+	call	calc
+	movl	%eax, %edi
+	call	put_int
+	movl	$5, %edi
+	movl	$7, %esi
+	call	calc
+	movl	%eax, %edi
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	leaq	.LC0(%rip), %rdi
+	movl	$0, %eax
+	call	printf@PLT
+	leave
+	ret
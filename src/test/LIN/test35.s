@@ -0,0 +1,92 @@
+	.text
+	.globl	sq
+sq:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	%edi, -4(%rbp)
+	subq	$16, %rsp
+	movl	-4(%rbp), %eax
+	movl	-4(%rbp), %r10d
+	imull	%r10d, %eax
+	jmp	_END_sq
+_END_sq:
+	leave
+	ret
+
+	.globl	api
+api:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	%edi, -4(%rbp)
+	movl	%esi, -8(%rbp)
+	subq	$16, %rsp
+	subq	$16, %rsp
+	movl	%r10d, 4(%rsp)
+	movl	%r11d, 0(%rsp)
+	movl	-4(%rbp), %eax
+	movl	%eax, %edi
+	call	sq
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	addq	$16, %rsp
+	subq	$16, %rsp
+	movl	%eax, 8(%rsp)
+	movl	%r11d, 0(%rsp)
+	movl	-8(%rbp), %eax
+	movl	%eax, %edi
+	call	sq
+	movl	%eax, %r10d
+	movl	8(%rsp), %eax
+	movl	0(%rsp), %r11d
+	addq	$16, %rsp
+	addl	%r10d, %eax
+	jmp	_END_api
+_END_api:
+	leave
+	ret
+
+	.globl	main
+main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16, %rsp
+	subq	$16, %rsp
+	movl	%r10d, 4(%rsp)
+	movl	%r11d, 0(%rsp)
+	movl	$3, %eax
+	movl	%eax, %edi
+	movl	$4, %eax
+	movl	%eax, %esi
+	call	api
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	addq	$16, %rsp
+	movl	%eax, -4(%rbp)
+	subq	$16, %rsp
+	movl	%r10d, 4(%rsp)
+	movl	%r11d, 0(%rsp)
+	movl	-4(%rbp), %eax
+	movl	%eax, %edi
+	call	put_int
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	addq	$16, %rsp
+_END_main:
+	leave
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	leaq	.LC0(%rip), %rdi
+	movl	$0, %eax
+	call	printf@PLT
+	leave
+	ret
@@ -0,0 +1,46 @@
+	.text
+	.globl	main
+main:
+	subq	$8, %rsp
+	movl	$261, %edi
+	call	put_int
+	movl	$36, %r10d
+	movl	$84, %edi
+.L7:
+	testl	%r10d, %r10d
+	jne	.L4
+	jmp	.L5
+.L4:
+	cmpl	%r10d, %edi
+	jge	.L6
+	movl	%r10d, %eax
+	movl	%edi, %r10d
+	movl	%eax, %edi
+	jmp	.L7
+.L6:
+	subl	%r10d, %edi
+	jmp	.L7
+.L5:
+	call	put_int
+	movl	$81, %edi
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	leaq	.LC0(%rip), %rdi
+	movl	$0, %eax
+	call	printf@PLT
+	leave
+	ret
@@ -0,0 +1,54 @@
+	.text
+	.globl	poly
+poly:
+	movl	%edi, %r10d
+	imull	%edi, %r10d
+	leal	(%r10,%r10,2), %r10d
+	leal	(%rdi,%rdi,4), %eax
+	addl	%eax, %r10d
+	leal	-7(%r10), %eax
+	movl	%eax, %r10d
+	imull	%edi, %r10d
+	leal	1(%r10), %eax
+_END_poly:
+	ret
+
+	.globl	main
+main:
+	subq	$8, %rsp
+	movq	%rbx, 0(%rsp)
+	movl	$21, %edi
+	call	put_int
+	movl	$4, %edi
+	call	poly
+	movl	%eax, %ebx
+	movl	$5, %edi
+	call	poly
+	leal	(%rbx,%rax), %edi
+	call	put_int
+	movl	$372, %edi
+	call	put_int
+	movl	$2302, %edi
+	movq	0(%rsp), %rbx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	movq	0(%rsp), %rbx
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	leaq	.LC0(%rip), %rdi
+	movl	$0, %eax
+	call	printf@PLT
+	leave
+	ret
@@ -0,0 +1,95 @@
+	.text
+	.globl	scale
+scale:
+	testl	%esi, %esi
+	setg	%al
+	movzbl	%al, %eax
+	imull	%esi, %eax
+	movl	%edi, %r10d
+	imull	%esi, %r10d
+	movl	%r10d, %edi
+	imull	%eax, %edi
+	movl	%eax, %r11d
+	shrl	$1, %r11d
+	addl	%eax, %eax
+	subl	$1, %eax
+	subl	%r11d, %eax
+	subl	%r11d, %eax
+	imull	%r11d, %eax
+	addl	%edi, %eax
+.L0:
+.L1:
+_END_scale:
+	ret
+
+	.globl	main
+main:
+	subq	$24, %rsp
+	movq	%rbx, 16(%rsp)
+	movq	%r12, 8(%rsp)
+	movq	%r13, 0(%rsp)
+	movl	$1, %ebx
+.L2:
+	cmpl	$3, %ebx
+	jge	.L3
+	movl	%ebx, %edi
+	movl	$2, %esi
+	call	scale.constprop.1
+	movl	%eax, %r13d
+	leal	1(%rbx), %r12d
+	movl	%r12d, %edi
+	movl	$2, %esi
+	call	scale.constprop.1
+	leal	(%r13,%rax), %edi
+	call	put_int
+	movl	%ebx, %edi
+	movl	$5, %esi
+	call	scale
+	movl	%eax, %edi
+	call	put_int
+	movl	%r12d, %ebx
+	jmp	.L2
+.L3:
+	movl	$7, %edi
+	movl	$9, %esi
+	call	scale
+	movl	%eax, %r12d
+	movl	%ebx, %edi
+	movl	$9, %esi
+	call	scale
+	leal	(%r12,%rax), %edi
+	movq	16(%rsp), %rbx
+	movq	8(%rsp), %r12
+	movq	0(%rsp), %r13
+	addq	$24, %rsp
+	jmp	put_int
+_END_main:
+	movq	16(%rsp), %rbx
+	movq	8(%rsp), %r12
+	movq	0(%rsp), %r13
+	addq	$24, %rsp
+	ret
+
+	.globl	scale.constprop.1
+scale.constprop.1:
+	leal	(%rdi,%rdi,1), %r10d
+	leal	(%r10,%r10,1), %r10d
+	leal	1(%r10), %eax
+_END_scale.constprop.1:
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	leaq	.LC0(%rip), %rdi
+	movl	$0, %eax
+	call	printf@PLT
+	leave
+	ret
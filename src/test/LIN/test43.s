@@ -0,0 +1,85 @@
+	.text
+	.globl	twice
+twice:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	%edi, -4(%rbp)
+	subq	$16, %rsp
+	movl	-4(%rbp), %eax
+	movl	-4(%rbp), %r10d
+	addl	%r10d, %eax
+	jmp	_END_twice
+_END_twice:
+	leave
+	ret
+
+	.globl	unused
+unused:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	%edi, -8(%rbp)
+	movl	%esi, -12(%rbp)
+	subq	$16, %rsp
+	movl	-8(%rbp), %eax
+	movl	-12(%rbp), %r10d
+	imull	%r10d, %eax
+	movl	%eax, -4(%rbp)
+	subq	$16, %rsp
+	movl	%r10d, 4(%rsp)
+	movl	%r11d, 0(%rsp)
+	movl	-4(%rbp), %eax
+	movl	%eax, %edi
+	call	twice
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	addq	$16, %rsp
+	movl	-8(%rbp), %r10d
+	subl	%r10d, %eax
+	jmp	_END_unused
+_END_unused:
+	leave
+	ret
+
+	.globl	main
+main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16, %rsp
+	subq	$16, %rsp
+	movl	%r10d, 4(%rsp)
+	movl	%r11d, 0(%rsp)
+	movl	$21, %eax
+	movl	%eax, %edi
+	call	twice
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	addq	$16, %rsp
+	movl	%eax, -4(%rbp)
+	subq	$16, %rsp
+	movl	%r10d, 4(%rsp)
+	movl	%r11d, 0(%rsp)
+	movl	-4(%rbp), %eax
+	movl	%eax, %edi
+	call	put_int
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	addq	$16, %rsp
+_END_main:
+	leave
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	leaq	.LC0(%rip), %rdi
+	movl	$0, %eax
+	call	printf@PLT
+	leave
+	ret
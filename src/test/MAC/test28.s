@@ -0,0 +1,59 @@
+	.section	__TEXT,__text
+	.globl	g
+g:
+	movl	%edi, %eax
+	imull	%esi, %eax
+	addl	%edi, %eax
+_END_g:
+	ret
+
+	.globl	f
+f:
+	subq	$8, %rsp
+	addl	$1, %edi
+	leal	(%rsi,%rsi,2), %esi
+	addq	$8, %rsp
+	jmp	g
+_END_f:
+	addq	$8, %rsp
+	ret
+
+	.globl	_main
+_main:
+	subq	$8, %rsp
+	movl	$2, %edi
+	movl	$5, %esi
+	call	f
+	movl	%eax, %edi
+	call	put_int
+	movl	$1, %edi
+	movl	$2, %esi
+	call	f
+	movl	%eax, %edi
+	movl	$7, %esi
+	call	g
+	movl	%eax, %edi
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	__TEXT,__cstring
+.LC0:
+	.string "%d\n"
+	.section	__TEXT,__text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	leaq	.LC0(%rip), %rax
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	movq	%rax, %rdi
+	movb	$0, %al
+	callq	_printf
+	movl	%eax, -8(%rbp)
+	addq	$16, %rsp
+	popq	%rbp
+	retq
@@ -0,0 +1,34 @@
+	.section	__TEXT,__text
+	.globl	_main
+_main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	$1, %edi
+	call	put_int
+	movl	$2, %edi
+	call	put_int
+	movl	$25, %edi
+	leave
+	jmp	put_int
+_END_main:
+	leave
+	ret
+
+	.section	__TEXT,__cstring
+.LC0:
+	.string "%d\n"
+	.section	__TEXT,__text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	leaq	.LC0(%rip), %rax
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	movq	%rax, %rdi
+	movb	$0, %al
+	callq	_printf
+	movl	%eax, -8(%rbp)
+	addq	$16, %rsp
+	popq	%rbp
+	retq
@@ -0,0 +1,77 @@
+	.section	__TEXT,__text
+	.globl	g
+g:
+	subq	$56, %rsp
+	movq	%rbx, 40(%rsp)
+	movq	%r12, 32(%rsp)
+	movq	%r13, 24(%rsp)
+	movq	%r14, 16(%rsp)
+	movq	%r15, 8(%rsp)
+	movl	%edi, %ebx
+	movl	%esi, %r12d
+	movl	%edx, %r13d
+	movl	%ecx, %r14d
+	movl	%r8d, %r15d
+	movl	%r9d, 52(%rsp)
+	movl	%ebx, %edi
+	call	put_int
+	movl	%ebx, %r10d
+	imull	%r12d, %r10d
+	movl	%r13d, %eax
+	imull	%r14d, %eax
+	addl	%eax, %r10d
+	movl	%r15d, %eax
+	imull	52(%rsp), %eax
+	leal	(%r10,%rax), %ebx
+	movl	%ebx, %edi
+	call	put_int
+	movl	52(%rsp), %edi
+	call	put_int
+	movl	%ebx, %edi
+	addl	52(%rsp), %edi
+	call	put_int
+	movl	%ebx, %eax
+_END_g:
+	movq	40(%rsp), %rbx
+	movq	32(%rsp), %r12
+	movq	24(%rsp), %r13
+	movq	16(%rsp), %r14
+	movq	8(%rsp), %r15
+	addq	$56, %rsp
+	ret
+
+	.globl	_main
+_main:
+	subq	$8, %rsp
+	movl	$1, %edi
+	movl	$2, %esi
+	movl	$3, %edx
+	movl	$4, %ecx
+	movl	$5, %r8d
+	movl	$6, %r9d
+	call	g
+	movl	%eax, %edi
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	__TEXT,__cstring
+.LC0:
+	.string "%d\n"
+	.section	__TEXT,__text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	leaq	.LC0(%rip), %rax
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	movq	%rax, %rdi
+	movb	$0, %al
+	callq	_printf
+	movl	%eax, -8(%rbp)
+	addq	$16, %rsp
+	popq	%rbp
+	retq
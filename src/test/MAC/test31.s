@@ -0,0 +1,87 @@
+	.section	__TEXT,__text
+	.globl	h
+h:
+	subq	$56, %rsp
+	movq	%r12, 16(%rsp)
+	movq	%r13, 8(%rsp)
+	movl	%edi, 44(%rsp)
+	movl	%esi, 40(%rsp)
+	movl	%edx, 36(%rsp)
+	movl	%ecx, 32(%rsp)
+	movl	%r8d, 28(%rsp)
+	movl	44(%rsp), %r12d
+	imull	40(%rsp), %r12d
+	movl	36(%rsp), %r10d
+	movl	%r10d, %r13d
+	imull	32(%rsp), %r13d
+	xorl	%r11d, %r11d
+	movl	%r11d, 48(%rsp)
+	xorl	%eax, %eax
+	movl	%eax, 52(%rsp)
+.L0:
+	cmpl	$1000, 52(%rsp)
+	jge	.L1
+	movl	52(%rsp), %edi
+	call	put_int
+	movl	%r12d, %eax
+	addl	48(%rsp), %eax
+	addl	%r13d, %eax
+	addl	28(%rsp), %eax
+	leal	100(%rax), %r11d
+	movl	%r11d, 0(%rsp)
+	leal	-200(%r11), %eax
+	movl	%eax, %edi
+	call	put_int
+	movl	0(%rsp), %r11d
+	movl	%r11d, 48(%rsp)
+	movl	52(%rsp), %eax
+	addl	$300, %eax
+	movl	%eax, 52(%rsp)
+	jmp	.L0
+.L1:
+	movl	48(%rsp), %eax
+	addl	44(%rsp), %eax
+	addl	40(%rsp), %eax
+	addl	36(%rsp), %eax
+	addl	32(%rsp), %eax
+	addl	28(%rsp), %eax
+_END_h:
+	movq	16(%rsp), %r12
+	movq	8(%rsp), %r13
+	addq	$56, %rsp
+	ret
+
+	.globl	_main
+_main:
+	subq	$8, %rsp
+	movl	$1, %edi
+	movl	$2, %esi
+	movl	$3, %edx
+	movl	$4, %ecx
+	movl	$5, %r8d
+	call	h
+	movl	%eax, %edi
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	__TEXT,__cstring
+.LC0:
+	.string "%d\n"
+	.section	__TEXT,__text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	leaq	.LC0(%rip), %rax
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	movq	%rax, %rdi
+	movb	$0, %al
+	callq	_printf
+	movl	%eax, -8(%rbp)
+	addq	$16, %rsp
+	popq	%rbp
+	retq
@@ -0,0 +1,90 @@
+	.section	__TEXT,__text
+	.globl	g
+g:
+	subq	$56, %rsp
+	movq	%rbx, 48(%rsp)
+	movq	%r12, 40(%rsp)
+	movq	%r13, 32(%rsp)
+	movq	%r14, 24(%rsp)
+	movq	%r15, 16(%rsp)
+	movl	%edi, %ebx
+	movl	%esi, %r12d
+	movl	%edx, %r13d
+	movl	%ecx, %r14d
+	movl	%r8d, %r15d
+	movl	%r9d, %r10d
+	movl	%ebx, %eax
+	imull	%r12d, %eax
+	movl	%r13d, %r11d
+	imull	%r14d, %r11d
+	addl	%r11d, %eax
+	movl	%r15d, %r11d
+	imull	%r10d, %r11d
+	addl	%eax, %r11d
+	movl	%r10d, 4(%rsp)
+	movl	%r11d, 0(%rsp)
+	movl	%r11d, %edi
+	call	put_int
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	movl	%r10d, %edi
+	call	put_int
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	movl	%r15d, %edi
+	call	put_int
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	leal	(%r11,%r10), %eax
+	addl	%r15d, %eax
+	movl	%eax, %edi
+	call	put_int
+	movl	0(%rsp), %r11d
+	leal	(%r11,%rbx), %eax
+	addl	%r12d, %eax
+	addl	%r13d, %eax
+	addl	%r14d, %eax
+_END_g:
+	movq	48(%rsp), %rbx
+	movq	40(%rsp), %r12
+	movq	32(%rsp), %r13
+	movq	24(%rsp), %r14
+	movq	16(%rsp), %r15
+	addq	$56, %rsp
+	ret
+
+	.globl	_main
+_main:
+	subq	$8, %rsp
+	movl	$1, %edi
+	movl	$2, %esi
+	movl	$3, %edx
+	movl	$4, %ecx
+	movl	$5, %r8d
+	movl	$6, %r9d
+	call	g
+	movl	%eax, %edi
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	__TEXT,__cstring
+.LC0:
+	.string "%d\n"
+	.section	__TEXT,__text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	leaq	.LC0(%rip), %rax
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	movq	%rax, %rdi
+	movb	$0, %al
+	callq	_printf
+	movl	%eax, -8(%rbp)
+	addq	$16, %rsp
+	popq	%rbp
+	retq
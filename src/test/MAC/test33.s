@@ -0,0 +1,79 @@
+	.section	__TEXT,__text
+	.globl	leaf
+leaf:
+	movq	%rbx, -8(%rsp)
+	movl	%edi, %eax
+	movl	%esi, %r10d
+	leal	1(%rax), %r11d
+	leal	2(%r10), %edi
+	movl	%eax, %esi
+	imull	%r10d, %esi
+	movl	%r11d, %edx
+	imull	%edi, %edx
+	leal	(%rsi,%rdx), %ecx
+	movl	%r11d, %r8d
+	subl	%edi, %r8d
+	movl	%ecx, %r9d
+	imull	%r8d, %r9d
+	movl	%esi, %ebx
+	subl	%edx, %ebx
+	addl	%r10d, %eax
+	addl	%r11d, %eax
+	addl	%edi, %eax
+	addl	%esi, %eax
+	addl	%edx, %eax
+	addl	%ecx, %eax
+	addl	%r8d, %eax
+	addl	%r9d, %eax
+	addl	%ebx, %eax
+	movl	%esi, %r10d
+	imull	%edx, %r10d
+	addl	%r10d, %eax
+	movl	%edx, %r10d
+	imull	%ecx, %r10d
+	imull	%r8d, %r10d
+	addl	%r10d, %eax
+	movl	%r9d, %r10d
+	imull	%ebx, %r10d
+	addl	%r10d, %eax
+_END_leaf:
+	movq	-8(%rsp), %rbx
+	ret
+
+	.globl	_main
+_main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	$3, %edi
+	movl	$4, %esi
+	call	leaf
+	movl	%eax, %edi
+	call	put_int
+	movl	$5, %edi
+	movl	$7, %esi
+	call	leaf
+	movl	%eax, %edi
+	leave
+	jmp	put_int
+_END_main:
+	leave
+	ret
+
+	.section	__TEXT,__cstring
+.LC0:
+	.string "%d\n"
+	.section	__TEXT,__text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	leaq	.LC0(%rip), %rax
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	movq	%rax, %rdi
+	movb	$0, %al
+	callq	_printf
+	movl	%eax, -8(%rbp)
+	addq	$16, %rsp
+	popq	%rbp
+	retq
@@ -0,0 +1,57 @@
+	.section	__TEXT,__text
+	.globl	poly
+poly:
+	movl	%edi, %r10d
+	imull	%edi, %r10d
+	leal	(%r10,%r10,2), %r10d
+	leal	(%rdi,%rdi,4), %eax
+	addl	%eax, %r10d
+	leal	-7(%r10), %eax
+	movl	%eax, %r10d
+	imull	%edi, %r10d
+	leal	1(%r10), %eax
+_END_poly:
+	ret
+
+	.globl	_main
+_main:
+	subq	$8, %rsp
+	movq	%rbx, 0(%rsp)
+	movl	$21, %edi
+	call	put_int
+	movl	$4, %edi
+	call	poly
+	movl	%eax, %ebx
+	movl	$5, %edi
+	call	poly
+	leal	(%rbx,%rax), %edi
+	call	put_int
+	movl	$372, %edi
+	call	put_int
+	movl	$2302, %edi
+	movq	0(%rsp), %rbx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	movq	0(%rsp), %rbx
+	addq	$8, %rsp
+	ret
+
+	.section	__TEXT,__cstring
+.LC0:
+	.string "%d\n"
+	.section	__TEXT,__text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	leaq	.LC0(%rip), %rax
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	movq	%rax, %rdi
+	movb	$0, %al
+	callq	_printf
+	movl	%eax, -8(%rbp)
+	addq	$16, %rsp
+	popq	%rbp
+	retq
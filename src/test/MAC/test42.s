@@ -0,0 +1,82 @@
+	.section	__TEXT,__text
+	.globl	tri
+tri:
+	testl	%edi, %edi
+	setg	%al
+	movzbl	%al, %eax
+	imull	%edi, %eax
+	imull	%eax, %edi
+	movl	%eax, %r11d
+	shrl	$1, %r11d
+	addl	%eax, %eax
+	subl	$1, %eax
+	subl	%r11d, %eax
+	subl	%r11d, %eax
+	imull	%r11d, %eax
+	negl	%eax
+	addl	%edi, %eax
+.L0:
+.L1:
+_END_tri:
+	ret
+
+	.globl	fact
+fact:
+	movl	$1, %eax
+.L3:
+	cmpl	$2, %edi
+	jge	.L2
+	jmp	_END_fact
+.L2:
+	imull	%edi, %eax
+	leal	-1(%rdi), %r10d
+	movl	%r10d, %edi
+	jmp	.L3
+_END_fact:
+	ret
+
+	.globl	_main
+_main:
+	subq	$8, %rsp
+	movq	%rbx, 0(%rsp)
+	movl	$10, %edi
+	call	tri
+	movl	%eax, %ebx
+	movl	%ebx, %edi
+	call	put_int
+	movl	$1000, %edi
+	call	tri
+	movl	%eax, %edi
+	call	put_int
+	movl	$120, %edi
+	call	put_int
+	movl	$10, %edi
+	call	fact
+	movl	%eax, %edi
+	subl	%ebx, %edi
+	movq	0(%rsp), %rbx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	movq	0(%rsp), %rbx
+	addq	$8, %rsp
+	ret
+
+	.section	__TEXT,__cstring
+.LC0:
+	.string "%d\n"
+	.section	__TEXT,__text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	leaq	.LC0(%rip), %rax
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	movq	%rax, %rdi
+	movb	$0, %al
+	callq	_printf
+	movl	%eax, -8(%rbp)
+	addq	$16, %rsp
+	popq	%rbp
+	retq
@@ -0,0 +1,104 @@
+	.section	__TEXT,__text
+	.globl	wide
+wide:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16, %rsp
+	movq	%rbx, -8(%rbp)
+	movq	%r12, -16(%rbp)
+	leal	(%rdi,%rsi), %r9d
+	leal	(%rsi,%rdx), %ebx
+	movl	%edi, %r8d
+	imull	%edx, %r8d
+	movl	%r9d, %ecx
+	imull	%ebx, %ecx
+	movl	%r8d, %esi
+	subl	%ecx, %esi
+	leal	(%r9,%rsi), %edi
+	movl	%ebx, %r11d
+	imull	%edi, %r11d
+	leal	(%r8,%r11), %r10d
+	movl	%ecx, %eax
+	subl	%r10d, %eax
+	movl	%esi, %r12d
+	imull	%eax, %r12d
+	addl	%r9d, %edx
+	addl	%r9d, %edx
+	addl	%ebx, %edx
+	addl	%r8d, %edx
+	addl	%ecx, %edx
+	addl	%esi, %edx
+	addl	%edi, %edx
+	addl	%r11d, %edx
+	addl	%r10d, %edx
+	addl	%eax, %edx
+	addl	%r12d, %edx
+	imull	%ecx, %r8d
+	addl	%r8d, %edx
+	imull	%ecx, %esi
+	imull	%esi, %edi
+	addl	%edx, %edi
+	imull	%r11d, %r10d
+	imull	%r10d, %eax
+	addl	%edi, %eax
+_END_wide:
+	movq	-8(%rbp), %rbx
+	movq	-16(%rbp), %r12
+	leave
+	ret
+
+	.globl	sumto
+sumto:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	xorl	%eax, %eax
+.L1:
+	testl	%edi, %edi
+	jne	.L0
+	jmp	_END_sumto
+.L0:
+	addl	%edi, %eax
+	leal	-1(%rdi), %r10d
+	movl	%r10d, %edi
+	jmp	.L1
+_END_sumto:
+	leave
+	ret
+
+	.globl	_main
+_main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	$1, %edi
+	movl	$2, %esi
+	movl	$3, %edx
+	call	wide
+	movl	%eax, %edi
+	call	put_int
+	movl	$10, %edi
+	call	sumto
+	movl	%eax, %edi
+	leave
+	jmp	put_int
+_END_main:
+	leave
+	ret
+
+	.section	__TEXT,__cstring
+.LC0:
+	.string "%d\n"
+	.section	__TEXT,__text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	leaq	.LC0(%rip), %rax
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	movq	%rax, %rdi
+	movb	$0, %al
+	callq	_printf
+	movl	%eax, -8(%rbp)
+	addq	$16, %rsp
+	popq	%rbp
+	retq
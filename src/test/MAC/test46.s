@@ -0,0 +1,59 @@
+	.section	__TEXT,__text
+	.globl	count
+count:
+	movl	$0, %eax
+	movl	$0, %r10d
+	movl	$0, %r11d
+.L0:
+	cmpl	%edi, %r10d
+	jge	.L1
+	cmpl	$0, %r10d
+	jne	.L3
+	addl	$5, %eax
+	jmp	.L2
+.L3:
+	addl	%r11d, %eax
+.L2:
+	addl	$1, %r10d
+	addl	$3, %r11d
+	jmp	.L0
+.L1:
+	jmp	_END_count
+_END_count:
+	ret
+
+	.globl	_main
+_main:
+	subq	$8, %rsp
+	movl	$6, %edi
+	call	count
+	movl	%eax, %edi
+	cmpl	$0, %edi
+	je	.L4
+	call	put_int
+.L4:
+	movl	$0, %edi
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	__TEXT,__cstring
+.LC0:
+	.string "%d\n"
+	.section	__TEXT,__text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	leaq	.LC0(%rip), %rax
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	movq	%rax, %rdi
+	movb	$0, %al
+	callq	_printf
+	movl	%eax, -8(%rbp)
+	addq	$16, %rsp
+	popq	%rbp
+	retq
@@ -0,0 +1,76 @@
+	.section	__TEXT,__text
+	.globl	acc
+acc:
+	movq	%rbx, -8(%rsp)
+	xorl	%ecx, %ecx
+	movl	$1, %r8d
+	movl	$5, %ebx
+	movl	$1000, %edx
+	xorl	%r11d, %r11d
+	movl	$4, %r9d
+	movl	%r8d, %eax
+	movl	%ecx, %r10d
+.L0:
+	cmpl	%edi, %r10d
+	jge	.L1
+	addl	%r11d, %ecx
+	addl	%esi, %ecx
+	imull	%ebx, %eax
+	subl	%ecx, %eax
+	cmpl	%edx, %eax
+	jle	.L3
+	subl	%edx, %eax
+.L2:
+	addl	%r8d, %r10d
+	addl	%r9d, %r11d
+	jmp	.L0
+.L1:
+	movl	$9, %r10d
+	imull	%r10d, %eax
+	addl	%ecx, %eax
+	jmp	_END_acc
+.L3:
+	jmp	.L2
+_END_acc:
+	movq	-8(%rsp), %rbx
+	ret
+
+	.globl	_main
+_main:
+	subq	$8, %rsp
+	movl	$8, %edi
+	movl	$3, %esi
+	call	acc
+	movl	%eax, %edi
+	call	put_int
+	movl	$3, %edi
+	movl	$2, %esi
+	call	acc
+	movl	%eax, %r10d
+	movl	$10, %eax
+	movl	%r10d, %edi
+	imull	%eax, %edi
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	__TEXT,__cstring
+.LC0:
+	.string "%d\n"
+	.section	__TEXT,__text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16,%rsp
+	leaq	.LC0(%rip), %rax
+	movl	%edi, -4(%rbp)
+	movl	-4(%rbp), %esi
+	movq	%rax, %rdi
+	movb	$0, %al
+	callq	_printf
+	movl	%eax, -8(%rbp)
+	addq	$16, %rsp
+	popq	%rbp
+	retq
@@ -0,0 +1,81 @@
+	.text
+	.global	main
+main:
+	stp	x29, x30, [sp, -32]!
+	add	x29, sp, 32
+	mov	w9, 0
+	str	w9, [x29, -4]
+	mov	w9, 3
+	str	w9, [x29, -8]
+.L0:
+	ldr	w8, [x29, -8]
+	mov	w9, 10
+	cmp	w8, w9
+	b.gt	.L1
+	ldr	w8, [x29, -8]
+	mov	w9, 0xca00
+	movk	w9, 0x3b9a, lsl 16
+	mul	w8, w8, w9
+	str	w8, [x29, -4]
+	ldr	w8, [x29, -8]
+	mov	w9, 1
+	add	w8, w8, w9
+	str	w8, [x29, -8]
+	b	.L0
+.L1:
+	sub	sp, sp, #16
+	str	w9, [sp, 4]
+	str	w10, [sp, 0]
+	ldr	w8, [x29, -4]
+	mov	w0, w8
+	bl	put_int
+	ldr	w9, [sp, 4]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+	mov	w9, 3
+	str	w9, [x29, -8]
+.L2:
+	ldr	w8, [x29, -8]
+	mov	w9, 10
+	cmp	w8, w9
+	b.gt	.L3
+	mov	w8, 0xffff
+	movk	w8, 0x7fff, lsl 16
+	neg	w8, w8
+	ldr	w9, [x29, -8]
+	mul	w9, w9, w8
+	str	w9, [x29, -4]
+	ldr	w8, [x29, -8]
+	mov	w9, 1
+	add	w8, w8, w9
+	str	w8, [x29, -8]
+	b	.L2
+.L3:
+	sub	sp, sp, #16
+	str	w9, [sp, 4]
+	str	w10, [sp, 0]
+	ldr	w8, [x29, -4]
+	mov	w0, w8
+	bl	put_int
+	ldr	w9, [sp, 4]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+_END_main:
+	ldp	x29, x30, [sp], 32
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	stp	x29, x30, [sp, -32]!
+	mov	x29, sp
+	str	w0, [sp, 28]
+	ldr	w1, [sp, 28]
+	adrp	x0, .LC0
+	add	x0, x0, :lo12:.LC0
+	bl	printf
+	nop
+	ldp	x29, x30, [sp], 32
+	ret
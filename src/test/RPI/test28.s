@@ -0,0 +1,52 @@
+	.text
+	.global	g
+g:
+	mul	w8, w0, w1
+	add	w0, w8, w0
+_END_g:
+	ret
+
+	.global	f
+f:
+	str	x30, [sp, -16]!
+	add	w0, w0, 1
+	add	w1, w1, w1, lsl 1
+	ldr	x30, [sp], 16
+	b	g
+_END_f:
+	ldr	x30, [sp], 16
+	ret
+
+	.global	main
+main:
+	str	x30, [sp, -16]!
+	mov	w0, 2
+	mov	w1, 5
+	bl	f
+	bl	put_int
+	mov	w0, 1
+	mov	w1, 2
+	bl	f
+	mov	w1, 7
+	bl	g
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	stp	x29, x30, [sp, -32]!
+	mov	x29, sp
+	str	w0, [sp, 28]
+	ldr	w1, [sp, 28]
+	adrp	x0, .LC0
+	add	x0, x0, :lo12:.LC0
+	bl	printf
+	nop
+	ldp	x29, x30, [sp], 32
+	ret
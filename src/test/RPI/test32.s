@@ -0,0 +1,78 @@
+	.text
+	.global	g
+g:
+	str	x30, [sp, -80]!
+	str	x19, [sp, 16]
+	str	x20, [sp, 24]
+	str	x21, [sp, 32]
+	str	x22, [sp, 40]
+	str	x23, [sp, 48]
+	str	x24, [sp, 56]
+	str	x25, [sp, 64]
+	mov	w19, w0
+	mov	w20, w1
+	mov	w21, w2
+	mov	w22, w3
+	mov	w23, w4
+	mov	w24, w5
+	mul	w8, w19, w20
+	mul	w9, w21, w22
+	add	w8, w8, w9
+	mul	w9, w23, w24
+	add	w25, w8, w9
+	mov	w0, w25
+	bl	put_int
+	mov	w0, w24
+	bl	put_int
+	mov	w0, w23
+	bl	put_int
+	add	w8, w25, w24
+	add	w0, w8, w23
+	bl	put_int
+	add	w8, w25, w19
+	add	w8, w8, w20
+	add	w8, w8, w21
+	add	w0, w8, w22
+_END_g:
+	ldr	x19, [sp, 16]
+	ldr	x20, [sp, 24]
+	ldr	x21, [sp, 32]
+	ldr	x22, [sp, 40]
+	ldr	x23, [sp, 48]
+	ldr	x24, [sp, 56]
+	ldr	x25, [sp, 64]
+	ldr	x30, [sp], 80
+	ret
+
+	.global	main
+main:
+	str	x30, [sp, -16]!
+	mov	w0, 1
+	mov	w1, 2
+	mov	w2, 3
+	mov	w3, 4
+	mov	w4, 5
+	mov	w5, 6
+	bl	g
+	mov	w8, w0
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	stp	x29, x30, [sp, -32]!
+	mov	x29, sp
+	str	w0, [sp, 28]
+	ldr	w1, [sp, 28]
+	adrp	x0, .LC0
+	add	x0, x0, :lo12:.LC0
+	bl	printf
+	nop
+	ldp	x29, x30, [sp], 32
+	ret
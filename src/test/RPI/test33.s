@@ -0,0 +1,66 @@
+	.text
+	.global	leaf
+leaf:
+	mov	w8, w0
+	mov	w9, w1
+	add	w10, w8, 1
+	add	w11, w9, 2
+	mul	w12, w8, w9
+	mul	w13, w10, w11
+	add	w14, w12, w13
+	sub	w15, w10, w11
+	mul	w0, w14, w15
+	sub	w1, w12, w13
+	add	w8, w8, w9
+	add	w8, w10, w8
+	add	w8, w11, w8
+	add	w8, w12, w8
+	add	w8, w13, w8
+	add	w8, w14, w8
+	add	w8, w15, w8
+	add	w8, w0, w8
+	add	w8, w1, w8
+	mul	w9, w12, w13
+	add	w8, w8, w9
+	mul	w9, w13, w14
+	mul	w9, w15, w9
+	add	w8, w8, w9
+	mul	w9, w0, w1
+	add	w0, w8, w9
+_END_leaf:
+	ret
+
+	.global	main
+main:
+	stp	x29, x30, [sp, -16]!
+	add	x29, sp, 16
+	mov	w0, 3
+	mov	w1, 4
+	bl	leaf
+	mov	w8, w0
+	bl	put_int
+	mov	w0, 5
+	mov	w1, 7
+	bl	leaf
+	mov	w8, w0
+	ldp	x29, x30, [sp], 16
+	b	put_int
+_END_main:
+	ldp	x29, x30, [sp], 16
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	stp	x29, x30, [sp, -32]!
+	mov	x29, sp
+	str	w0, [sp, 28]
+	ldr	w1, [sp, 28]
+	adrp	x0, .LC0
+	add	x0, x0, :lo12:.LC0
+	bl	printf
+	nop
+	ldp	x29, x30, [sp], 32
+	ret
@@ -0,0 +1,93 @@
+	.text
+	.global	sq
+sq:
+	stp	x29, x30, [sp, -32]!
+	add	x29, sp, 32
+	str	w0, [x29, -4]
+	ldr	w8, [x29, -4]
+	ldr	w9, [x29, -4]
+	mul	w8, w8, w9
+	mov	w0, w8
+	b	_END_sq
+_END_sq:
+	ldp	x29, x30, [sp], 32
+	ret
+
+	.global	api
+api:
+	stp	x29, x30, [sp, -32]!
+	add	x29, sp, 32
+	str	w0, [x29, -4]
+	str	w1, [x29, -8]
+	sub	sp, sp, #16
+	str	w9, [sp, 4]
+	str	w10, [sp, 0]
+	ldr	w8, [x29, -4]
+	mov	w0, w8
+	bl	sq
+	mov	w8, w0
+	ldr	w9, [sp, 4]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+	sub	sp, sp, #16
+	str	w8, [sp, 8]
+	str	w10, [sp, 0]
+	ldr	w8, [x29, -8]
+	mov	w0, w8
+	bl	sq
+	mov	w9, w0
+	ldr	w8, [sp, 8]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+	add	w8, w8, w9
+	mov	w0, w8
+	b	_END_api
+_END_api:
+	ldp	x29, x30, [sp], 32
+	ret
+
+	.global	main
+main:
+	stp	x29, x30, [sp, -32]!
+	add	x29, sp, 32
+	sub	sp, sp, #16
+	str	w9, [sp, 4]
+	str	w10, [sp, 0]
+	mov	w8, 3
+	mov	w0, w8
+	mov	w8, 4
+	mov	w1, w8
+	bl	api
+	mov	w8, w0
+	ldr	w9, [sp, 4]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+	str	w8, [x29, -4]
+	sub	sp, sp, #16
+	str	w9, [sp, 4]
+	str	w10, [sp, 0]
+	ldr	w8, [x29, -4]
+	mov	w0, w8
+	bl	put_int
+	ldr	w9, [sp, 4]
+	ldr	w10, [sp, 0]
+	add	sp, sp, 16
+_END_main:
+	ldp	x29, x30, [sp], 32
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	stp	x29, x30, [sp, -32]!
+	mov	x29, sp
+	str	w0, [sp, 28]
+	ldr	w1, [sp, 28]
+	adrp	x0, .LC0
+	add	x0, x0, :lo12:.LC0
+	bl	printf
+	nop
+	ldp	x29, x30, [sp], 32
+	ret
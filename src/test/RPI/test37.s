@@ -0,0 +1,42 @@
+	.text
+	.global	main
+main:
+	stp	x29, x30, [sp, -16]!
+	add	x29, sp, 16
+	mov	w11, 0
+	mov	w9, 0
+	mov	w12, 1
+.L5:
+	cmp	w11, 10
+	b.ge	.L4
+	add	w13, w12, w9
+	add	w14, w11, 1
+	mov	w11, w14
+	mov	w9, w12
+	mov	w12, w13
+	b	.L5
+.L4:
+	mov	w0, w9
+	bl	put_int
+	mov	w0, 16
+	ldp	x29, x30, [sp], 16
+	b	put_int
+_END_main:
+	ldp	x29, x30, [sp], 16
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	stp	x29, x30, [sp, -32]!
+	mov	x29, sp
+	str	w0, [sp, 28]
+	ldr	w1, [sp, 28]
+	adrp	x0, .LC0
+	add	x0, x0, :lo12:.LC0
+	bl	printf
+	nop
+	ldp	x29, x30, [sp], 32
+	ret
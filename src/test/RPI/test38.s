@@ -0,0 +1,45 @@
+	.text
+	.global	main
+main:
+	str	x30, [sp, -16]!
+	mov	w0, 261
+	bl	put_int
+	mov	w9, 36
+	mov	w0, 84
+.L7:
+	cbnz	w9, .L4
+	b	.L5
+.L4:
+	cmp	w0, w9
+	b.ge	.L6
+	mov	w8, w9
+	mov	w9, w0
+	mov	w0, w8
+	b	.L7
+.L6:
+	sub	w0, w0, w9
+	b	.L7
+.L5:
+	bl	put_int
+	mov	w0, 81
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	stp	x29, x30, [sp, -32]!
+	mov	x29, sp
+	str	w0, [sp, 28]
+	ldr	w1, [sp, 28]
+	adrp	x0, .LC0
+	add	x0, x0, :lo12:.LC0
+	bl	printf
+	nop
+	ldp	x29, x30, [sp], 32
+	ret
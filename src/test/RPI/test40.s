@@ -0,0 +1,52 @@
+	.text
+	.global	poly
+poly:
+	mul	w9, w0, w0
+	add	w9, w9, w9, lsl 1
+	add	w8, w0, w0, lsl 2
+	add	w9, w9, w8
+	sub	w8, w9, 7
+	mul	w9, w8, w0
+	add	w0, w9, 1
+_END_poly:
+	ret
+
+	.global	main
+main:
+	str	x30, [sp, -32]!
+	str	x19, [sp, 16]
+	mov	w0, 21
+	bl	put_int
+	mov	w0, 4
+	bl	poly
+	mov	w19, w0
+	mov	w0, 5
+	bl	poly
+	add	w0, w19, w0
+	bl	put_int
+	mov	w0, 372
+	bl	put_int
+	mov	w0, 2302
+	ldr	x19, [sp, 16]
+	ldr	x30, [sp], 32
+	b	put_int
+_END_main:
+	ldr	x19, [sp, 16]
+	ldr	x30, [sp], 32
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	stp	x29, x30, [sp, -32]!
+	mov	x29, sp
+	str	w0, [sp, 28]
+	ldr	w1, [sp, 28]
+	adrp	x0, .LC0
+	add	x0, x0, :lo12:.LC0
+	bl	printf
+	nop
+	ldp	x29, x30, [sp], 32
+	ret
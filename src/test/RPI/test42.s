@@ -0,0 +1,74 @@
+	.text
+	.global	tri
+tri:
+	cmp	w0, 0
+	cset	w8, gt
+	mul	w8, w0, w8
+	mul	w11, w0, w8
+	lsr	w10, w8, #1
+	add	w8, w8, w8
+	sub	w8, w8, 1
+	sub	w8, w8, w10
+	sub	w8, w8, w10
+	mul	w8, w10, w8
+	sub	w0, w11, w8
+.L0:
+.L1:
+_END_tri:
+	ret
+
+	.global	fact
+fact:
+	mov	w8, 1
+.L3:
+	cmp	w0, 2
+	b.ge	.L2
+	mov	w0, w8
+	b	_END_fact
+.L2:
+	mul	w8, w0, w8
+	sub	w9, w0, 1
+	mov	w0, w9
+	b	.L3
+_END_fact:
+	ret
+
+	.global	main
+main:
+	str	x30, [sp, -32]!
+	str	x19, [sp, 16]
+	mov	w0, 10
+	bl	tri
+	mov	w19, w0
+	bl	put_int
+	mov	w0, 1000
+	bl	tri
+	bl	put_int
+	mov	w0, 120
+	bl	put_int
+	mov	w0, 10
+	bl	fact
+	sub	w0, w0, w19
+	ldr	x19, [sp, 16]
+	ldr	x30, [sp], 32
+	b	put_int
+_END_main:
+	ldr	x19, [sp, 16]
+	ldr	x30, [sp], 32
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	stp	x29, x30, [sp, -32]!
+	mov	x29, sp
+	str	w0, [sp, 28]
+	ldr	w1, [sp, 28]
+	adrp	x0, .LC0
+	add	x0, x0, :lo12:.LC0
+	bl	printf
+	nop
+	ldp	x29, x30, [sp], 32
+	ret
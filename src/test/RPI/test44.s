@@ -0,0 +1,72 @@
+	.text
+	.global	leaf
+leaf:
+	mov	w8, w0
+	mov	w9, w1
+	mul	w10, w8, w9
+	add	w8, w10, w8
+	sub	w0, w8, w9
+_END_leaf:
+	ret
+
+	.global	outer
+outer:
+	str	x30, [sp, -48]!
+	str	x19, [sp, 16]
+	str	x21, [sp, 24]
+	str	x22, [sp, 32]
+	str	x23, [sp, 40]
+	mov	w19, w0
+	mov	w21, 0
+	mov	w22, 0
+.L0:
+	cmp	w22, w19
+	b.ge	.L1
+	mov	w0, w22
+	mov	w1, w19
+	bl	leaf
+	mov	w8, w0
+	add	w23, w8, w21
+	mov	w0, w23
+	bl	put_int
+	mov	w21, w23
+	add	w8, w22, 1
+	mov	w22, w8
+	b	.L0
+.L1:
+	mov	w0, w21
+_END_outer:
+	ldr	x19, [sp, 16]
+	ldr	x21, [sp, 24]
+	ldr	x22, [sp, 32]
+	ldr	x23, [sp, 40]
+	ldr	x30, [sp], 48
+	ret
+
+	.global	main
+main:
+	str	x30, [sp, -16]!
+	mov	w0, 4
+	bl	outer
+	mov	w8, w0
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	stp	x29, x30, [sp, -32]!
+	mov	x29, sp
+	str	w0, [sp, 28]
+	ldr	w1, [sp, 28]
+	adrp	x0, .LC0
+	add	x0, x0, :lo12:.LC0
+	bl	printf
+	nop
+	ldp	x29, x30, [sp], 32
+	ret
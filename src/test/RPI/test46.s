@@ -0,0 +1,56 @@
+	.text
+	.global	count
+count:
+	mov	w8, 0
+	mov	w9, 0
+	mov	w10, 0
+.L0:
+	cmp	w9, w0
+	b.ge	.L1
+	cmp	w9, 0
+	b.ne	.L3
+	add	w8, w8, 5
+	b	.L2
+.L3:
+	add	w8, w10, w8
+.L2:
+	add	w9, w9, 1
+	add	w10, w10, 3
+	b	.L0
+.L1:
+	mov	w0, w8
+	b	_END_count
+_END_count:
+	ret
+
+	.global	main
+main:
+	str	x30, [sp, -16]!
+	mov	w0, 6
+	bl	count
+	cmp	w0, 0
+	b.eq	.L4
+	bl	put_int
+.L4:
+	mov	w0, 0
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	stp	x29, x30, [sp, -32]!
+	mov	x29, sp
+	str	w0, [sp, 28]
+	ldr	w1, [sp, 28]
+	adrp	x0, .LC0
+	add	x0, x0, :lo12:.LC0
+	bl	printf
+	nop
+	ldp	x29, x30, [sp], 32
+	ret
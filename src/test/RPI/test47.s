@@ -0,0 +1,68 @@
+	.text
+	.global	acc
+acc:
+	mov	w11, 0
+	mov	w12, 1
+	mov	w15, 5
+	mov	w14, 1000
+	mov	w10, 0
+	mov	w13, 4
+	mov	w8, w12
+	mov	w9, w11
+.L0:
+	cmp	w9, w0
+	b.ge	.L1
+	add	w11, w10, w11
+	add	w11, w11, w1
+	mul	w8, w15, w8
+	sub	w8, w8, w11
+	cmp	w8, w14
+	b.le	.L3
+	sub	w8, w8, w14
+.L2:
+	add	w9, w12, w9
+	add	w10, w10, w13
+	b	.L0
+.L1:
+	mov	w9, 9
+	mul	w8, w9, w8
+	add	w0, w8, w11
+	b	_END_acc
+.L3:
+	b	.L2
+_END_acc:
+	ret
+
+	.global	main
+main:
+	str	x30, [sp, -16]!
+	mov	w0, 8
+	mov	w1, 3
+	bl	acc
+	bl	put_int
+	mov	w0, 3
+	mov	w1, 2
+	bl	acc
+	mov	w8, 10
+	mul	w0, w0, w8
+	ldr	x30, [sp], 16
+	b	put_int
+_END_main:
+	ldr	x30, [sp], 16
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	stp	x29, x30, [sp, -32]!
+	mov	x29, sp
+	str	w0, [sp, 28]
+	ldr	w1, [sp, 28]
+	adrp	x0, .LC0
+	add	x0, x0, :lo12:.LC0
+	bl	printf
+	nop
+	ldp	x29, x30, [sp], 32
+	ret
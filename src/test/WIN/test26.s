@@ -0,0 +1,75 @@
+	.text
+	.globl	f
+f:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	%ecx, -4(%rbp)
+	movl	%edx, -8(%rbp)
+	subq	$16, %rsp
+	movl	$4, %r10d
+	movl	%r10d, -8(%rbp)
+.L0:
+	movl	-4(%rbp), %eax
+	movl	$1, %r10d
+	addl	%r10d, %eax
+	movl	%eax, -4(%rbp)
+	movl	-8(%rbp), %eax
+	movl	$1, %r10d
+	addl	%r10d, %eax
+	movl	%eax, -8(%rbp)
+	movl	-8(%rbp), %eax
+	movl	$3, %r10d
+	cmpl	%r10d, %eax
+	jge	.L1
+	jmp	.L0
+.L1:
+	movl	-4(%rbp), %eax
+	jmp	_END_f
+_END_f:
+	leave
+	ret
+
+	.globl	main
+main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16, %rsp
+	subq	$16, %rsp
+	movl	%r10d, 4(%rsp)
+	movl	%r11d, 0(%rsp)
+	movl	$10, %eax
+	movl	%eax, %ecx
+	movl	$20, %eax
+	movl	%eax, %edx
+	call	f
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	addq	$16, %rsp
+	movl	%eax, -4(%rbp)
+	subq	$16, %rsp
+	movl	%r10d, 4(%rsp)
+	movl	%r11d, 0(%rsp)
+	movl	-4(%rbp), %eax
+	movl	%eax, %ecx
+	call	put_int
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	addq	$16, %rsp
+_END_main:
+	leave
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
@@ -0,0 +1,55 @@
+	.text
+	.globl	g
+g:
+	movl	%ecx, %eax
+	imull	%edx, %eax
+	addl	%ecx, %eax
+_END_g:
+	ret
+
+	.globl	f
+f:
+	subq	$8, %rsp
+	addl	$1, %ecx
+	leal	(%rdx,%rdx,2), %edx
+	addq	$8, %rsp
+	jmp	g
+_END_f:
+	addq	$8, %rsp
+	ret
+
+	.globl	main
+main:
+	subq	$8, %rsp
+	movl	$2, %ecx
+	movl	$5, %edx
+	call	f
+	movl	%eax, %ecx
+	call	put_int
+	movl	$1, %ecx
+	movl	$2, %edx
+	call	f
+	movl	%eax, %ecx
+	movl	$7, %edx
+	call	g
+	movl	%eax, %ecx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
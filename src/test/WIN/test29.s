@@ -0,0 +1,30 @@
+	.text
+	.globl	main
+main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	$1, %ecx
+	call	put_int
+	movl	$2, %ecx
+	call	put_int
+	movl	$25, %ecx
+	leave
+	jmp	put_int
+_END_main:
+	leave
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
@@ -0,0 +1,73 @@
+	.text
+	.globl	g
+g:
+	subq	$56, %rsp
+	movq	%rbx, 40(%rsp)
+	movq	%r12, 32(%rsp)
+	movq	%r13, 24(%rsp)
+	movq	%r14, 16(%rsp)
+	movq	%r15, 8(%rsp)
+	movl	%ecx, %ebx
+	movl	%edx, %r12d
+	movl	%r8d, %r13d
+	movl	%r9d, %r14d
+	movl	%edi, %r15d
+	movl	%esi, 52(%rsp)
+	movl	%ebx, %ecx
+	call	put_int
+	movl	%ebx, %r10d
+	imull	%r12d, %r10d
+	movl	%r13d, %eax
+	imull	%r14d, %eax
+	addl	%eax, %r10d
+	movl	%r15d, %eax
+	imull	52(%rsp), %eax
+	leal	(%r10,%rax), %ebx
+	movl	%ebx, %ecx
+	call	put_int
+	movl	52(%rsp), %ecx
+	call	put_int
+	movl	%ebx, %ecx
+	addl	52(%rsp), %ecx
+	call	put_int
+	movl	%ebx, %eax
+_END_g:
+	movq	40(%rsp), %rbx
+	movq	32(%rsp), %r12
+	movq	24(%rsp), %r13
+	movq	16(%rsp), %r14
+	movq	8(%rsp), %r15
+	addq	$56, %rsp
+	ret
+
+	.globl	main
+main:
+	subq	$8, %rsp
+	movl	$1, %ecx
+	movl	$2, %edx
+	movl	$3, %r8d
+	movl	$4, %r9d
+	movl	$5, %edi
+	movl	$6, %esi
+	call	g
+	movl	%eax, %ecx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
@@ -0,0 +1,86 @@
+	.text
+	.globl	g
+g:
+	subq	$56, %rsp
+	movq	%rbx, 48(%rsp)
+	movq	%r12, 40(%rsp)
+	movq	%r13, 32(%rsp)
+	movq	%r14, 24(%rsp)
+	movq	%r15, 16(%rsp)
+	movl	%ecx, %ebx
+	movl	%edx, %r12d
+	movl	%r8d, %r13d
+	movl	%r9d, %r14d
+	movl	%edi, %r15d
+	movl	%esi, %r10d
+	movl	%ebx, %eax
+	imull	%r12d, %eax
+	movl	%r13d, %r11d
+	imull	%r14d, %r11d
+	addl	%r11d, %eax
+	movl	%r15d, %r11d
+	imull	%r10d, %r11d
+	addl	%eax, %r11d
+	movl	%r10d, 4(%rsp)
+	movl	%r11d, 0(%rsp)
+	movl	%r11d, %ecx
+	call	put_int
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	movl	%r10d, %ecx
+	call	put_int
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	movl	%r15d, %ecx
+	call	put_int
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	leal	(%r11,%r10), %eax
+	addl	%r15d, %eax
+	movl	%eax, %ecx
+	call	put_int
+	movl	0(%rsp), %r11d
+	leal	(%r11,%rbx), %eax
+	addl	%r12d, %eax
+	addl	%r13d, %eax
+	addl	%r14d, %eax
+_END_g:
+	movq	48(%rsp), %rbx
+	movq	40(%rsp), %r12
+	movq	32(%rsp), %r13
+	movq	24(%rsp), %r14
+	movq	16(%rsp), %r15
+	addq	$56, %rsp
+	ret
+
+	.globl	main
+main:
+	subq	$8, %rsp
+	movl	$1, %ecx
+	movl	$2, %edx
+	movl	$3, %r8d
+	movl	$4, %r9d
+	movl	$5, %edi
+	movl	$6, %esi
+	call	g
+	movl	%eax, %ecx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
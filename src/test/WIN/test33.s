@@ -0,0 +1,77 @@
+	.text
+	.globl	leaf
+leaf:
+	subq	$8, %rsp
+	movq	%rbx, 0(%rsp)
+	movl	%ecx, %eax
+	movl	%edx, %r10d
+	leal	1(%rax), %r11d
+	leal	2(%r10), %ecx
+	movl	%eax, %edx
+	imull	%r10d, %edx
+	movl	%r11d, %r8d
+	imull	%ecx, %r8d
+	leal	(%rdx,%r8), %r9d
+	movl	%r11d, %edi
+	subl	%ecx, %edi
+	movl	%r9d, %esi
+	imull	%edi, %esi
+	movl	%edx, %ebx
+	subl	%r8d, %ebx
+	addl	%r10d, %eax
+	addl	%r11d, %eax
+	addl	%ecx, %eax
+	addl	%edx, %eax
+	addl	%r8d, %eax
+	addl	%r9d, %eax
+	addl	%edi, %eax
+	addl	%esi, %eax
+	addl	%ebx, %eax
+	movl	%edx, %r10d
+	imull	%r8d, %r10d
+	addl	%r10d, %eax
+	movl	%r8d, %r10d
+	imull	%r9d, %r10d
+	imull	%edi, %r10d
+	addl	%r10d, %eax
+	movl	%esi, %r10d
+	imull	%ebx, %r10d
+	addl	%r10d, %eax
+_END_leaf:
+	movq	0(%rsp), %rbx
+	addq	$8, %rsp
+	ret
+
+	.globl	main
+main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	$3, %ecx
+	movl	$4, %edx
+	call	leaf
+	movl	%eax, %ecx
+	call	put_int
+	movl	$5, %ecx
+	movl	$7, %edx
+	call	leaf
+	movl	%eax, %ecx
+	leave
+	jmp	put_int
+_END_main:
+	leave
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
@@ -0,0 +1,77 @@
+	.text
+	.globl	calc
+calc:
+	subq	$24, %rsp
+	movq	%rbx, 16(%rsp)
+	movq	%r12, 8(%rsp)
+	movl	%ecx, %ebx
+	movl	%edx, %r12d
+	movl	%ebx, %ecx
+	call	put_int
+	leal	1(%rbx), %edi
+	leal	2(%r12), %r9d
+	movl	%ebx, %r8d
+	imull	%r12d, %r8d
+	movl	%edi, %edx
+	imull	%r9d, %edx
+	leal	(%r8,%rdx), %ecx
+	movl	%edi, %r11d
+	subl	%r9d, %r11d
+	movl	%ecx, %r10d
+	imull	%r11d, %r10d
+	movl	%r8d, %eax
+	subl	%edx, %eax
+	leal	(%rbx,%r12), %esi
+	addl	%esi, %edi
+	addl	%edi, %r9d
+	addl	%r8d, %r9d
+	addl	%edx, %r9d
+	addl	%ecx, %r9d
+	addl	%r11d, %r9d
+	addl	%r10d, %r9d
+	addl	%eax, %r9d
+	imull	%edx, %r8d
+	addl	%r9d, %r8d
+	imull	%edx, %ecx
+	imull	%ecx, %r11d
+	addl	%r8d, %r11d
+	imull	%r10d, %eax
+	addl	%r11d, %eax
+_END_calc:
+	movq	16(%rsp), %rbx
+	movq	8(%rsp), %r12
+	addq	$24, %rsp
+	ret
+
+	.globl	main
+main:
+	subq	$8, %rsp
+	movl	$3, %ecx
+	movl	$4, %edx
+	call	calc
+	movl	%eax, %ecx
+	call	put_int
+	movl	$5, %ecx
+	movl	$7, %edx
+	call	calc
+	movl	%eax, %ecx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
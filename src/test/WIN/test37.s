@@ -0,0 +1,54 @@
+	.text
+	.globl	main
+main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32, %rsp
+	movq	%rbx, -8(%rbp)
+	movq	%r12, -16(%rbp)
+	movq	%r13, -24(%rbp)
+	movq	%r14, -32(%rbp)
+	xorl	%ebx, %ebx
+	xorl	%r10d, %r10d
+	movl	$1, %r12d
+.L5:
+	cmpl	$10, %ebx
+	jge	.L4
+	leal	(%r12,%r10), %r13d
+	leal	1(%rbx), %r14d
+	movl	%r14d, %ebx
+	movl	%r12d, %r10d
+	movl	%r13d, %r12d
+	jmp	.L5
+.L4:
+	movl	%r10d, %ecx
+	call	put_int
+	movl	$16, %ecx
+	movq	-8(%rbp), %rbx
+	movq	-16(%rbp), %r12
+	movq	-24(%rbp), %r13
+	movq	-32(%rbp), %r14
+	leave
+	jmp	put_int
+_END_main:
+	movq	-8(%rbp), %rbx
+	movq	-16(%rbp), %r12
+	movq	-24(%rbp), %r13
+	movq	-32(%rbp), %r14
+	leave
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
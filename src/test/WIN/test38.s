@@ -0,0 +1,45 @@
+	.text
+	.globl	main
+main:
+	subq	$8, %rsp
+	movl	$261, %ecx
+	call	put_int
+	movl	$36, %r10d
+	movl	$84, %ecx
+.L7:
+	testl	%r10d, %r10d
+	jne	.L4
+	jmp	.L5
+.L4:
+	cmpl	%r10d, %ecx
+	jge	.L6
+	movl	%r10d, %eax
+	movl	%ecx, %r10d
+	movl	%eax, %ecx
+	jmp	.L7
+.L6:
+	subl	%r10d, %ecx
+	jmp	.L7
+.L5:
+	call	put_int
+	movl	$81, %ecx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
@@ -0,0 +1,159 @@
+	.text
+	.globl	show
+show:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32, %rsp
+	movq	%rbx, -8(%rbp)
+	movq	%r14, -16(%rbp)
+	movq	%r15, -24(%rbp)
+	movl	%ecx, %ebx
+	leal	-2(%rbx), %r14d
+	cmpl	$-2147483646, %ebx
+	jge	.L6
+	xorl	%r15d, %r15d
+	jmp	.L7
+.L9:
+	cmpl	%r14d, %r10d
+	jge	.L8
+	movl	%r10d, 0(%rsp)
+	movl	%r10d, %eax
+	imull	%r10d, %eax
+	movl	%eax, %ecx
+	call	put_int
+	movl	0(%rsp), %r10d
+	leal	1(%r10), %r11d
+	movl	%r11d, 0(%rsp)
+	movl	%r11d, %eax
+	imull	%r11d, %eax
+	movl	%eax, %ecx
+	call	put_int
+	movl	0(%rsp), %r11d
+	addl	$1, %r11d
+	movl	%r11d, 0(%rsp)
+	movl	%r11d, %eax
+	imull	%r11d, %eax
+	movl	%eax, %ecx
+	call	put_int
+	movl	0(%rsp), %r11d
+	leal	1(%r11), %eax
+	movl	%eax, %r10d
+	jmp	.L9
+.L7:
+	movl	%r15d, %r11d
+.L0:
+	cmpl	%ebx, %r11d
+	jge	.L1
+	movl	%r11d, 0(%rsp)
+	movl	%r11d, %eax
+	imull	%r11d, %eax
+	movl	%eax, %ecx
+	call	put_int
+	movl	0(%rsp), %r11d
+	leal	1(%r11), %eax
+	movl	%eax, %r11d
+	jmp	.L0
+.L1:
+	jmp	_END_show
+.L8:
+	movl	%r10d, %r15d
+	jmp	.L7
+.L6:
+	xorl	%r10d, %r10d
+	jmp	.L9
+_END_show:
+	movq	-8(%rbp), %rbx
+	movq	-16(%rbp), %r14
+	movq	-24(%rbp), %r15
+	leave
+	ret
+
+	.globl	countdown
+countdown:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32, %rsp
+	movq	%r13, -8(%rbp)
+	movq	%r14, -16(%rbp)
+	movq	%r15, -24(%rbp)
+	movl	%ecx, %eax
+	movl	%eax, %r14d
+	xorl	%r15d, %r15d
+.L11:
+	cmpl	$1, %r14d
+	jle	.L10
+	movl	%r14d, %ecx
+	call	put_int
+	leal	(%r15,%r14), %r10d
+	leal	-1(%r14), %r11d
+	movl	%r10d, 4(%rsp)
+	movl	%r11d, 0(%rsp)
+	movl	%r11d, %ecx
+	call	put_int
+	movl	4(%rsp), %r10d
+	movl	0(%rsp), %r11d
+	leal	(%r10,%r11), %eax
+	leal	-1(%r11), %r10d
+	movl	%r10d, %r14d
+	movl	%eax, %r15d
+	jmp	.L11
+.L10:
+	movl	%r14d, %r13d
+	movl	%r15d, %r14d
+.L2:
+	testl	%r13d, %r13d
+	jle	.L3
+	movl	%r13d, %ecx
+	call	put_int
+	leal	(%r14,%r13), %eax
+	leal	-1(%r13), %r10d
+	movl	%r10d, %r13d
+	movl	%eax, %r14d
+	jmp	.L2
+.L3:
+	movl	%r14d, %eax
+_END_countdown:
+	movq	-8(%rbp), %r13
+	movq	-16(%rbp), %r14
+	movq	-24(%rbp), %r15
+	leave
+	ret
+
+	.globl	main
+main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	$7, %ecx
+	call	show
+	movl	$5, %ecx
+	call	countdown
+	movl	%eax, %ecx
+	call	put_int
+	movl	$10, %ecx
+	call	put_int
+	movl	$11, %ecx
+	call	put_int
+	movl	$12, %ecx
+	call	put_int
+	movl	$13, %ecx
+	call	put_int
+.L4:
+.L5:
+_END_main:
+	leave
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
@@ -0,0 +1,53 @@
+	.text
+	.globl	poly
+poly:
+	movl	%ecx, %r10d
+	imull	%ecx, %r10d
+	leal	(%r10,%r10,2), %r10d
+	leal	(%rcx,%rcx,4), %eax
+	addl	%eax, %r10d
+	leal	-7(%r10), %eax
+	movl	%eax, %r10d
+	imull	%ecx, %r10d
+	leal	1(%r10), %eax
+_END_poly:
+	ret
+
+	.globl	main
+main:
+	subq	$8, %rsp
+	movq	%rbx, 0(%rsp)
+	movl	$21, %ecx
+	call	put_int
+	movl	$4, %ecx
+	call	poly
+	movl	%eax, %ebx
+	movl	$5, %ecx
+	call	poly
+	leal	(%rbx,%rax), %ecx
+	call	put_int
+	movl	$372, %ecx
+	call	put_int
+	movl	$2302, %ecx
+	movq	0(%rsp), %rbx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	movq	0(%rsp), %rbx
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
@@ -0,0 +1,94 @@
+	.text
+	.globl	scale
+scale:
+	testl	%edx, %edx
+	setg	%al
+	movzbl	%al, %eax
+	imull	%edx, %eax
+	movl	%ecx, %r10d
+	imull	%edx, %r10d
+	movl	%r10d, %ecx
+	imull	%eax, %ecx
+	movl	%eax, %r11d
+	shrl	$1, %r11d
+	addl	%eax, %eax
+	subl	$1, %eax
+	subl	%r11d, %eax
+	subl	%r11d, %eax
+	imull	%r11d, %eax
+	addl	%ecx, %eax
+.L0:
+.L1:
+_END_scale:
+	ret
+
+	.globl	main
+main:
+	subq	$24, %rsp
+	movq	%rbx, 16(%rsp)
+	movq	%r12, 8(%rsp)
+	movq	%r13, 0(%rsp)
+	movl	$1, %ebx
+.L2:
+	cmpl	$3, %ebx
+	jge	.L3
+	movl	%ebx, %ecx
+	movl	$2, %edx
+	call	scale.constprop.1
+	movl	%eax, %r13d
+	leal	1(%rbx), %r12d
+	movl	%r12d, %ecx
+	movl	$2, %edx
+	call	scale.constprop.1
+	leal	(%r13,%rax), %ecx
+	call	put_int
+	movl	%ebx, %ecx
+	movl	$5, %edx
+	call	scale
+	movl	%eax, %ecx
+	call	put_int
+	movl	%r12d, %ebx
+	jmp	.L2
+.L3:
+	movl	$7, %ecx
+	movl	$9, %edx
+	call	scale
+	movl	%eax, %r12d
+	movl	%ebx, %ecx
+	movl	$9, %edx
+	call	scale
+	leal	(%r12,%rax), %ecx
+	movq	16(%rsp), %rbx
+	movq	8(%rsp), %r12
+	movq	0(%rsp), %r13
+	addq	$24, %rsp
+	jmp	put_int
+_END_main:
+	movq	16(%rsp), %rbx
+	movq	8(%rsp), %r12
+	movq	0(%rsp), %r13
+	addq	$24, %rsp
+	ret
+
+	.globl	scale.constprop.1
+scale.constprop.1:
+	leal	(%rcx,%rcx,1), %r10d
+	leal	(%r10,%r10,1), %r10d
+	leal	1(%r10), %eax
+_END_scale.constprop.1:
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
@@ -0,0 +1,78 @@
+	.text
+	.globl	tri
+tri:
+	testl	%ecx, %ecx
+	setg	%al
+	movzbl	%al, %eax
+	imull	%ecx, %eax
+	imull	%eax, %ecx
+	movl	%eax, %r11d
+	shrl	$1, %r11d
+	addl	%eax, %eax
+	subl	$1, %eax
+	subl	%r11d, %eax
+	subl	%r11d, %eax
+	imull	%r11d, %eax
+	negl	%eax
+	addl	%ecx, %eax
+.L0:
+.L1:
+_END_tri:
+	ret
+
+	.globl	fact
+fact:
+	movl	$1, %eax
+.L3:
+	cmpl	$2, %ecx
+	jge	.L2
+	jmp	_END_fact
+.L2:
+	imull	%ecx, %eax
+	leal	-1(%rcx), %r10d
+	movl	%r10d, %ecx
+	jmp	.L3
+_END_fact:
+	ret
+
+	.globl	main
+main:
+	subq	$8, %rsp
+	movq	%rbx, 0(%rsp)
+	movl	$10, %ecx
+	call	tri
+	movl	%eax, %ebx
+	movl	%ebx, %ecx
+	call	put_int
+	movl	$1000, %ecx
+	call	tri
+	movl	%eax, %ecx
+	call	put_int
+	movl	$120, %ecx
+	call	put_int
+	movl	$10, %ecx
+	call	fact
+	movl	%eax, %ecx
+	subl	%ebx, %ecx
+	movq	0(%rsp), %rbx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	movq	0(%rsp), %rbx
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
@@ -0,0 +1,71 @@
+	.text
+	.globl	leaf
+leaf:
+	movl	%ecx, %eax
+	movl	%edx, %r10d
+	movl	%eax, %r11d
+	imull	%r10d, %r11d
+	addl	%r11d, %eax
+	subl	%r10d, %eax
+_END_leaf:
+	ret
+
+	.globl	outer
+outer:
+	subq	$40, %rsp
+	movq	%rbx, 32(%rsp)
+	movq	%r13, 24(%rsp)
+	movq	%r14, 16(%rsp)
+	movq	%r15, 8(%rsp)
+	movl	%ecx, %ebx
+	xorl	%r13d, %r13d
+	xorl	%r14d, %r14d
+.L0:
+	cmpl	%ebx, %r14d
+	jge	.L1
+	movl	%r14d, %ecx
+	movl	%ebx, %edx
+	call	leaf
+	leal	(%rax,%r13), %r15d
+	movl	%r15d, %ecx
+	call	put_int
+	movl	%r15d, %r13d
+	leal	1(%r14), %eax
+	movl	%eax, %r14d
+	jmp	.L0
+.L1:
+	movl	%r13d, %eax
+_END_outer:
+	movq	32(%rsp), %rbx
+	movq	24(%rsp), %r13
+	movq	16(%rsp), %r14
+	movq	8(%rsp), %r15
+	addq	$40, %rsp
+	ret
+
+	.globl	main
+main:
+	subq	$8, %rsp
+	movl	$4, %ecx
+	call	outer
+	movl	%eax, %ecx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
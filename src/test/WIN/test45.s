@@ -0,0 +1,100 @@
+	.text
+	.globl	wide
+wide:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$16, %rsp
+	movq	%rbx, -8(%rbp)
+	movq	%r12, -16(%rbp)
+	leal	(%rcx,%rdx), %esi
+	leal	(%rdx,%r8), %ebx
+	movl	%ecx, %edi
+	imull	%r8d, %edi
+	movl	%esi, %r9d
+	imull	%ebx, %r9d
+	movl	%edi, %edx
+	subl	%r9d, %edx
+	leal	(%rsi,%rdx), %ecx
+	movl	%ebx, %r11d
+	imull	%ecx, %r11d
+	leal	(%rdi,%r11), %r10d
+	movl	%r9d, %eax
+	subl	%r10d, %eax
+	movl	%edx, %r12d
+	imull	%eax, %r12d
+	addl	%esi, %r8d
+	addl	%esi, %r8d
+	addl	%ebx, %r8d
+	addl	%edi, %r8d
+	addl	%r9d, %r8d
+	addl	%edx, %r8d
+	addl	%ecx, %r8d
+	addl	%r11d, %r8d
+	addl	%r10d, %r8d
+	addl	%eax, %r8d
+	addl	%r12d, %r8d
+	imull	%r9d, %edi
+	addl	%edi, %r8d
+	imull	%r9d, %edx
+	imull	%edx, %ecx
+	addl	%r8d, %ecx
+	imull	%r11d, %r10d
+	imull	%r10d, %eax
+	addl	%ecx, %eax
+_END_wide:
+	movq	-8(%rbp), %rbx
+	movq	-16(%rbp), %r12
+	leave
+	ret
+
+	.globl	sumto
+sumto:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	xorl	%eax, %eax
+.L1:
+	testl	%ecx, %ecx
+	jne	.L0
+	jmp	_END_sumto
+.L0:
+	addl	%ecx, %eax
+	leal	-1(%rcx), %r10d
+	movl	%r10d, %ecx
+	jmp	.L1
+_END_sumto:
+	leave
+	ret
+
+	.globl	main
+main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	movl	$1, %ecx
+	movl	$2, %edx
+	movl	$3, %r8d
+	call	wide
+	movl	%eax, %ecx
+	call	put_int
+	movl	$10, %ecx
+	call	sumto
+	movl	%eax, %ecx
+	leave
+	jmp	put_int
+_END_main:
+	leave
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
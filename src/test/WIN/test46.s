@@ -0,0 +1,55 @@
+	.text
+	.globl	count
+count:
+	movl	$0, %eax
+	movl	$0, %r10d
+	movl	$0, %r11d
+.L0:
+	cmpl	%ecx, %r10d
+	jge	.L1
+	cmpl	$0, %r10d
+	jne	.L3
+	addl	$5, %eax
+	jmp	.L2
+.L3:
+	addl	%r11d, %eax
+.L2:
+	addl	$1, %r10d
+	addl	$3, %r11d
+	jmp	.L0
+.L1:
+	jmp	_END_count
+_END_count:
+	ret
+
+	.globl	main
+main:
+	subq	$8, %rsp
+	movl	$6, %ecx
+	call	count
+	movl	%eax, %ecx
+	cmpl	$0, %ecx
+	je	.L4
+	call	put_int
+.L4:
+	movl	$0, %ecx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
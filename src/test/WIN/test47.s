@@ -0,0 +1,74 @@
+	.text
+	.globl	acc
+acc:
+	subq	$8, %rsp
+	movq	%rbx, 0(%rsp)
+	xorl	%r9d, %r9d
+	movl	$1, %edi
+	movl	$5, %ebx
+	movl	$1000, %r8d
+	xorl	%r11d, %r11d
+	movl	$4, %esi
+	movl	%edi, %eax
+	movl	%r9d, %r10d
+.L0:
+	cmpl	%ecx, %r10d
+	jge	.L1
+	addl	%r11d, %r9d
+	addl	%edx, %r9d
+	imull	%ebx, %eax
+	subl	%r9d, %eax
+	cmpl	%r8d, %eax
+	jle	.L3
+	subl	%r8d, %eax
+.L2:
+	addl	%edi, %r10d
+	addl	%esi, %r11d
+	jmp	.L0
+.L1:
+	movl	$9, %r10d
+	imull	%r10d, %eax
+	addl	%r9d, %eax
+	jmp	_END_acc
+.L3:
+	jmp	.L2
+_END_acc:
+	movq	0(%rsp), %rbx
+	addq	$8, %rsp
+	ret
+
+	.globl	main
+main:
+	subq	$8, %rsp
+	movl	$8, %ecx
+	movl	$3, %edx
+	call	acc
+	movl	%eax, %ecx
+	call	put_int
+	movl	$3, %ecx
+	movl	$2, %edx
+	call	acc
+	movl	%eax, %r10d
+	movl	$10, %eax
+	movl	%r10d, %ecx
+	imull	%eax, %ecx
+	addq	$8, %rsp
+	jmp	put_int
+_END_main:
+	addq	$8, %rsp
+	ret
+
+	.section	.rodata
+.LC0:
+	.string "%d\n"
+	.text
+put_int:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	subq	$32,%rsp
+	movl	%ecx, %edx
+	leaq	.LC0(%rip), %rcx
+	call	printf
+	addq	$32, %rsp
+	popq	%rbp
+	ret
@@ -0,0 +1,39 @@
+#! /bin/sh
+
+# 最適化したプログラムの出力を最適化しないものと比べる
+# Compare the output of optimized programs with unoptimized ones.
+# usage: difftest.sh [tlc options (default: -O1)]
+
+TLC=../tlc
+CC=gcc
+CFLAGS=
+TESTDIR=./
+TMP=tmp
+
+if [ $# -eq 0 ]; then
+    opts=-O1
+else
+    opts="$*"
+fi
+
+if [ ! -d $TMP ]; then
+    mkdir $TMP
+fi
+
+cd $TMP
+for f in ../${TESTDIR}/*.c
+do
+    base=`basename ${f} .c`
+    ../$TLC -O0 -o - $f 2> /dev/null | $CC $CFLAGS -x assembler -o ${base}.O0 -
+    ../$TLC $opts -o - $f 2> /dev/null | $CC $CFLAGS -x assembler -o ${base}.opt -
+    if [ ! -x ${base}.O0 ] || [ ! -x ${base}.opt ]; then
+	echo "${base}.c could not be compiled."
+	continue
+    fi
+    ./${base}.O0 > ${base}.O0.out 2>&1
+    ./${base}.opt > ${base}.opt.out 2>&1
+    if ! cmp -s ${base}.O0.out ${base}.opt.out; then
+	echo "The output of ${base}.c with ${opts} is something wrong."
+    fi
+    rm -f ${base}.O0 ${base}.opt ${base}.O0.out ${base}.opt.out
+done
@@ -27,8 +27,12 @@ do
     base=`basename ${f} .c`
     log=${base}.c.log
     asm=${base}.s
-    ../$TLC $f > ${log} 2>&1
-    $CC $CFLAGS  ${asm} -o ${base}
+    # test*.optがあればそのオプションで / options in test*.opt, if any
+    opts=
+    if [ -f ../${TESTDIR}/${base}.opt ]; then
+	opts=`cat ../${TESTDIR}/${base}.opt`
+    fi
+    ../$TLC $opts -o - $f 2> ${log} | tee ${asm} | $CC $CFLAGS -x assembler -o ${base} -
     diff ../${target}/$log $log > ${log}.diff 2>&1
     diff ../${target}/$asm $asm > ${asm}.diff 2>&1
     if [ -s ${log}.diff ]; then
@@ -0,0 +1,14 @@
+f(int p3, int p5)
+{
+    p5 = 4;
+    do {
+        p3 = p3+1;
+        p5 = p5+1;
+    } while (p5 < 3);
+    return p3;
+}
+
+main()
+{
+    put_int(f(10, 20));
+}
@@ -0,0 +1,14 @@
+main()
+{
+    int v1, p0;
+
+    p0 = 0;
+    for (v1 = 3; v1 <= 10; v1 = v1+1) {
+        p0 = v1*1000000000;
+    }
+    put_int(p0);
+    for (v1 = 3; v1 <= 10; v1 = v1+1) {
+        p0 = v1*-2147483647;
+    }
+    put_int(p0);
+}
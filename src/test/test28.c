@@ -0,0 +1,15 @@
+g(int a, int b)
+{
+    return a*b+a;
+}
+
+f(int x, int y)
+{
+    return g(x+1, y*3);
+}
+
+main()
+{
+    put_int(f(2, 5));
+    put_int(g(f(1, 2), 7));
+}
@@ -0,0 +1,13 @@
+f(int x)
+{
+    put_int(x);
+    return x;
+}
+
+main()
+{
+    int a;
+    a = 3;
+    a = ((16 - (-1)) * f(1)) + ((7 - a) * f(2));
+    put_int(a);
+}
@@ -0,0 +1,15 @@
+g(int a, int b, int c, int d, int e, int f)
+{
+    int x;
+    put_int(a);
+    x = a*b + c*d + e*f;
+    put_int(x);
+    put_int(f);
+    put_int(x+f);
+    return x;
+}
+
+main()
+{
+    put_int(g(1, 2, 3, 4, 5, 6));
+}
@@ -0,0 +1,16 @@
+h(int a, int b, int c, int d, int e)
+{
+    int i, s;
+    s = 0;
+    for (i = 0; i < 1000; i = i + 300) {
+        put_int(i);
+        s = s + a*b + c*d + e + 100;
+        put_int(s - 200);
+    }
+    return s + a + b + c + d + e;
+}
+
+main()
+{
+    put_int(h(1, 2, 3, 4, 5));
+}
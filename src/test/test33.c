@@ -0,0 +1,13 @@
+leaf(int a, int b)
+{
+    int c, d, e, f, g, h, i, j;
+    c = a + 1; d = b + 2; e = a * b; f = c * d;
+    g = e + f; h = c - d; i = g * h; j = e - f;
+    return a + b + c + d + e + f + g + h + i + j + c*d*e + f*g*h + i*j;
+}
+
+main()
+{
+    put_int(leaf(3, 4));
+    put_int(leaf(5, 7));
+}
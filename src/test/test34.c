@@ -0,0 +1,14 @@
+calc(int a, int b)
+{
+    int c, d, e, f, g, h, i, j;
+    put_int(a);
+    c = a + 1; d = b + 2; e = a * b; f = c * d;
+    g = e + f; h = c - d; i = g * h; j = e - f;
+    return a + b + c + d + e + f + g + h + i + j + c*d*e + f*g*h + i*j;
+}
+
+main()
+{
+    put_int(calc(3, 4));
+    put_int(calc(5, 7));
+}
@@ -0,0 +1,22 @@
+sq(int x)
+{
+    return x * x;
+}
+
+api(int a, int b)
+{
+    return sq(a) + sq(b);
+}
+
+dead(int a, int b, int c)
+{
+    int d, e;
+    d = a * b;
+    e = d + c;
+    return api(d, e) + dead(e, d, a);
+}
+
+main()
+{
+    put_int(api(3, 4));
+}
@@ -0,0 +1,20 @@
+sum(int n)
+{
+    int i, s;
+    s = 0;
+    i = 0;
+    while (i < n) {
+        if (i * 2 < n) {
+            s = s + i;
+        } else {
+            s = s - 1;
+        }
+        i = i + 1;
+    }
+    return s;
+}
+
+main()
+{
+    put_int(sum(10));
+}
@@ -0,0 +1,29 @@
+fib(int n)
+{
+    int a, b, t, i;
+    a = 0;
+    b = 1;
+    for (i = 0; i < n; i = i + 1) {
+        t = a + b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+pick(int x, int y)
+{
+    int m;
+    if (x < y) {
+        m = y;
+    } else {
+        m = x;
+    }
+    return m * 2;
+}
+
+main()
+{
+    put_int(fib(10));
+    put_int(pick(3, 8));
+}
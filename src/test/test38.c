@@ -0,0 +1,35 @@
+sq(int x)
+{
+    return x * x;
+}
+
+gcd(int a, int b)
+{
+    if (b == 0) {
+        return a;
+    }
+    if (a < b) {
+        return gcd(b, a);
+    }
+    return gcd(a - b, b);
+}
+
+work(int n, int k)
+{
+    int i, s, t, u;
+    s = 0;
+    u = 7;
+    for (i = 0; i < n; i = i + 1) {
+        t = k * 3 + 1;
+        s = s + t + i * 4;
+        u = s + 1;
+    }
+    return s + sq(k) + (k * 3 + 1);
+}
+
+main()
+{
+    put_int(work(10, 2));
+    put_int(gcd(84, 36));
+    put_int(sq(9));
+}
@@ -0,0 +1,30 @@
+show(int n)
+{
+    int i;
+    for (i = 0; i < n; i = i + 1) {
+        put_int(i * i);
+    }
+}
+
+countdown(int n)
+{
+    int s;
+    s = 0;
+#pragma unroll(2)
+    while (n > 0) {
+        put_int(n);
+        s = s + n;
+        n = n - 1;
+    }
+    return s;
+}
+
+main()
+{
+    int i;
+    show(7);
+    put_int(countdown(5));
+    for (i = 0; i < 4; i = i + 1) {
+        put_int(i + 10);
+    }
+}
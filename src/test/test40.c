@@ -0,0 +1,41 @@
+add3(int a, int b, int c)
+{
+    return a + b + c;
+}
+
+poly(int x)
+{
+    int y;
+    y = x * x * 3;
+    y = y + x * 5;
+    y = y - 7;
+    return y * x + 1;
+}
+
+inline mix(int a, int b)
+{
+    int s, t;
+    s = a * b + a;
+    t = s * s - b;
+    s = t + s * 2;
+    t = t * 3 - s;
+    return s + t;
+}
+
+once(int n)
+{
+    int s;
+    s = n * n;
+    s = s + n * 2;
+    s = s * s - n;
+    s = s + 4;
+    return s;
+}
+
+main()
+{
+    put_int(add3(1, 2, 3) + add3(4, 5, 6));
+    put_int(poly(4) + poly(5));
+    put_int(mix(2, 3) + mix(4, 1));
+    put_int(once(6));
+}
@@ -0,0 +1,19 @@
+scale(int x, int k)
+{
+    int i, s;
+    s = 0;
+    for (i = 0; i < k; i = i + 1) {
+        s = s + x * k + i;
+    }
+    return s;
+}
+
+main()
+{
+    int i;
+    for (i = 1; i < 3; i = i + 1) {
+        put_int(scale(i, 2) + scale(i + 1, 2));
+        put_int(scale(i, 5));
+    }
+    put_int(scale(7, 9) + scale(i, 9));
+}
@@ -0,0 +1,26 @@
+tri(int n)
+{
+    int s;
+    s = 0;
+    while (n > 0) {
+        s = s + n;
+        n = n - 1;
+    }
+    return s;
+}
+
+fact(int n)
+{
+    if (n < 2) {
+        return 1;
+    }
+    return n * fact(n - 1);
+}
+
+main()
+{
+    put_int(tri(10));
+    put_int(tri(1000));
+    put_int(fact(5));
+    put_int(fact(10) - tri(10));
+}
@@ -0,0 +1,16 @@
+twice(int x)
+{
+    return x + x;
+}
+
+unused(int a, int b)
+{
+    int c;
+    c = a * b;
+    return twice(c) - a;
+}
+
+main()
+{
+    put_int(twice(21));
+}
@@ -0,0 +1,20 @@
+leaf(int a, int b)
+{
+    return a * b + a - b;
+}
+
+outer(int n)
+{
+    int i, s;
+    s = 0;
+    for (i = 0; i < n; i = i + 1) {
+        s = s + leaf(i, n);
+        put_int(s);
+    }
+    return s;
+}
+
+main()
+{
+    put_int(outer(4));
+}
@@ -0,0 +1,22 @@
+wide(int a, int b, int c)
+{
+    int d, e, f, g, h, i, j, k, l, m;
+    d = a + b; e = b + c; f = a * c; g = d * e;
+    h = f - g; i = d + h; j = e * i; k = f + j;
+    l = g - k; m = h * l;
+    return a + b + c + d + e + f + g + h + i + j + k + l + m + d*e*f + g*h*i + j*k*l;
+}
+
+sumto(int n)
+{
+    if (n == 0) {
+        return 0;
+    }
+    return n + sumto(n - 1);
+}
+
+main()
+{
+    put_int(wide(1, 2, 3));
+    put_int(sumto(10));
+}
@@ -0,0 +1,23 @@
+count(int n)
+{
+    int i, z;
+    z = 0;
+    for (i = 0; i < n; i = i + 1) {
+        if (i == 0) {
+            z = z + 5;
+        } else {
+            z = z + i * 3;
+        }
+    }
+    return z;
+}
+
+main()
+{
+    int a;
+    a = count(6);
+    if (a != 0) {
+        put_int(a);
+    }
+    put_int(0);
+}
@@ -0,0 +1,20 @@
+acc(int n, int k)
+{
+    int i, s, t;
+    s = 0;
+    t = 1;
+    for (i = 0; i < n; i = i + 1) {
+        s = s + i * 4 + k;
+        t = t * 5 - s;
+        if (t > 1000) {
+            t = t - 1000;
+        }
+    }
+    return s + t * 9;
+}
+
+main()
+{
+    put_int(acc(8, 3));
+    put_int(acc(3, 2) * 10);
+}
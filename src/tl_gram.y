@@ -6,18 +6,17 @@
     2016年 木村啓二
 */
 
-/* 制限事項（バグ）/ Limitation, or bug
-   文法上は関数の実引数に関数呼び出しを持った式を記述できるが、
-   これを正しく処理するコードは生成できない。
-   これは、関数のスタック操作中に実引数の式に利用される別関数の
-   スタック操作が含まれるためである。
-   これを正しく処理するためにはどのような操作が必要か?
+/* 関数の実引数に関数呼び出しを持った式
+   文法上は関数の実引数に関数呼び出しを持った式を記述できる。
+   素直に実装すると関数のスタック操作中に実引数の式に利用される
+   別関数のスタック操作が含まれてしまうため、このような実引数は
+   呼び出し列の前に評価して一時変数に置く (ir_build.c)。
+   Function calls in actual parameters
    The grammar itself allows the function call as a parameter.
-   However, current implementation can't generate appropriate code
-   for this situation.
-   This is because the straight forward implementation requires
-   another stack operation within a stack operation of the function call.
-   How can we fix it?
+   The straight forward implementation would require another stack
+   operation within a stack operation of the function call, so such
+   parameters are evaluated into temporaries before the call
+   sequence (ir_build.c).
  */
 %{
 
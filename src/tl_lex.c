@@ -514,8 +514,13 @@ char *yytext;
 #include  <stdlib.h>
 
 #include  "ast.h"
+#include  "parse_action.h"
 #include  "tl_gram.h"
 
+/* #pragma行を取り除くため1行ずつ読む / read line by line to drop #pragma lines */
+#define  YY_INPUT(buf, result, max_size) \
+    ((result) = lex_read_line((buf), (max_size), yyin))
+
 #line 520 "tl_lex.c"
 #line 521 "tl_lex.c"
 
@@ -897,7 +902,7 @@ return  TOKEN_ELSE;
 case 19:
 YY_RULE_SETUP
 #line 40 "tl_lex.l"
-return  TOKEN_FOR;
+{ lex_loop_keyword(); return  TOKEN_FOR; }
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
@@ -917,12 +922,12 @@ return  TOKEN_RETURN;
 case 23:
 YY_RULE_SETUP
 #line 44 "tl_lex.l"
-return  TOKEN_WHILE;
+{ lex_loop_keyword(); return  TOKEN_WHILE; }
 	YY_BREAK
 case 24:
 YY_RULE_SETUP
 #line 45 "tl_lex.l"
-return  TOKEN_DO;
+{ lex_loop_keyword(); return  TOKEN_DO; }
 	YY_BREAK
 case 25:
 YY_RULE_SETUP
@@ -942,8 +947,10 @@ case 26:
 YY_RULE_SETUP
 #line 58 "tl_lex.l"
 {
-            yylval.y_str = yytext;
-            return  TOKEN_ID;
+            if (!lex_inline_keyword(yytext)) {
+                yylval.y_str = yytext;
+                return  TOKEN_ID;
+            }
         }
 	YY_BREAK
 case 27:
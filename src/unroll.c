@@ -0,0 +1,573 @@
+/*
+    Tiny Language Compiler (tlc)
+
+    ループ展開 / loop unrolling
+
+    対象は最内側の数え上げループ：ヘッダがphiと終了判定だけからなり、
+    判定が「帰納変数 < ループ不変な上限」（<=, >, >=も）で、帰納変数の
+    増分が定数、ループの出口がヘッダだけのもの。
+    初期値と上限が定数で繰り返し回数が分かり、展開後が小さければ本体を
+    回数分並べてループをなくす（完全展開）。それ以外は本体をU個並べた
+    ループを作り、残りの回数は元のループで回す（部分展開）。展開した
+    ループは「帰納変数+(U-1)*増分が上限を越えない」間だけ回るので、
+    U回に一度しか判定しない。上限-(U-1)*増分が桁あふれする場合は展開した
+    ループを飛ばす。
+    展開するのは -funroll-loops の指定か #pragma unroll(N) のあるループ。
+
+    Candidates are innermost counted loops: the header holds only phis
+    and the exit test, the test is "induction variable < invariant
+    bound" (or <=, >, >=), the variable steps by a constant, and the
+    header is the only exit.
+    When the start and the bound are constants, the trip count is known
+    and the result is small, the body is laid out that many times and
+    the loop disappears (full unrolling).  Otherwise a loop with U
+    copies of the body is made and the remaining iterations run in the
+    original loop (partial unrolling).  The unrolled loop runs only
+    while "variable + (U-1)*step" stays within the bound, so it tests
+    once every U iterations.  It is skipped when bound - (U-1)*step
+    would overflow.
+    Loops are unrolled with -funroll-loops or #pragma unroll(N).
+*/
+
+#include  <limits.h>
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  "ast.h"
+#include  "ir.h"
+#include  "opt.h"
+#include  "option.h"
+#include  "util.h"
+
+#define  FULL_UNROLL_MAX_TRIPS  16	/* 完全展開する回数の上限 / max trips to unroll fully */
+#define  FULL_UNROLL_MAX_SIZE   128	/* 完全展開後の命令数の上限 / max size after full unrolling */
+#define  PARTIAL_UNROLL_MAX_SIZE  256	/* 部分展開後の命令数の上限 / max size after partial unrolling */
+
+/* 数え上げループ / counted loop */
+typedef struct UR_Loop {
+    IR_Loop  *loop;
+    IR_Block *body;             /* ヘッダのループ内の後続 / successor in the loop */
+    IR_Block *exit;             /* ヘッダのループ外の後続 / successor outside */
+    IR_Block *latch;
+    IR_Insn  *iv;               /* 帰納変数のphi / phi of the induction variable */
+    int  cond;                  /* iv cond boundの間回る / loops while iv cond bound */
+    int  bound;
+    int  step;
+    int  size;                  /* 本体の命令数 / instructions in the body */
+} UR_Loop;
+
+static IR_Func *cur_func;
+static IR_Insn **def;
+static int  *vmap;		/* 本体の仮想レジスタ -> 複製 / body register -> copy */
+static IR_Block **bmap;		/* 本体のブロック -> 複製 / body block -> copy */
+
+static int  innermost(IR_Loop *loops, IR_Loop *l);
+static int  analyze(IR_Loop *l, UR_Loop *u);
+static int  const_value(int v, int *val);
+static int  trip_count(UR_Loop *u, int limit);
+static int  phi_slot(IR_Loop *l, IR_Insn *phi);
+static int  count_phis(IR_Block *b);
+static int  map_vreg(int v);
+static IR_Block *clone_body(UR_Loop *u, int *vals, IR_Block **pos,
+                            IR_Block **latch);
+static void unroll_fully(UR_Loop *u, int trips);
+static int  unroll_partially(UR_Loop *u, int factor);
+static IR_Insn *new_insn(int op, int dst, int a, int b);
+
+/* 展開したループの数を返す / returns the number of loops unrolled */
+int
+unroll_loops(IR_Func *f)
+{
+    int  n, factor, trips, done;
+    IR_Block *b;
+    IR_Insn *i;
+    IR_Loop *loops, *l;
+    UR_Loop u;
+
+    cur_func = f;
+    loops = find_loops(f);
+    n = 0;
+    for (l = loops; l != NULL; l = l->next) {
+        factor = l->header->unroll;
+        if (factor == 0 && flag_unroll_loops) {
+            factor = unroll_factor;
+        }
+        if (factor <= 1 || !innermost(loops, l)) {
+            continue;
+        }
+        def = xcalloc(f->nvregs+1, sizeof(IR_Insn*));
+        FOR_EACH_BLOCK(b, f) {
+            FOR_EACH_INSN(i, b) {
+                if (i->dst != 0) {
+                    def[i->dst] = i;
+                }
+            }
+        }
+        done = 0;
+        if (analyze(l, &u)) {
+            vmap = xcalloc(f->nvregs+1, sizeof(int));
+            bmap = xcalloc(f->nblocks, sizeof(IR_Block*));
+            trips = trip_count(&u, FULL_UNROLL_MAX_TRIPS);
+            if (trips >= 0 && (trips*u.size <= FULL_UNROLL_MAX_SIZE
+                               || trips <= l->header->unroll)) {
+                unroll_fully(&u, trips);
+                done = 1;
+            } else if (factor*u.size <= PARTIAL_UNROLL_MAX_SIZE
+                       || l->header->unroll > 0) {
+                done = unroll_partially(&u, factor);
+            }
+            free(vmap);
+            free(bmap);
+        }
+        free(def);
+        if (done) {
+            n++;
+            ir_build_cfg(f);
+        }
+    }
+    free_loops(loops);
+    if (n > 0) {
+        ir_remove_unreachable(f);
+    }
+    cur_func = NULL;
+    return n;
+}
+
+int
+innermost(IR_Loop *loops, IR_Loop *l)
+{
+    IR_Loop *m;
+
+    for (m = loops; m != NULL; m = m->next) {
+        if (m->parent == l) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* 展開できる数え上げループなら1 / 1 if l is a counted loop to unroll */
+int
+analyze(IR_Loop *l, UR_Loop *u)
+{
+    int  k, j, s, step, nlatch, ok;
+    IR_Block *b;
+    IR_Insn *i, *t, *d, *next;
+
+    u->loop = l;
+    t = ir_terminator(l->header);
+    if (t->op != IR_BR || t->cond == 0
+        || ir_terminator(l->preheader)->op != IR_JMP) {
+        return 0;
+    }
+    for (i = l->header->head; i != t; i = i->next) {
+        if (i->op != IR_PHI || i->nphi != 2) {
+            return 0;
+        }
+    }
+    if (loop_contains(l, t->target[0]) == loop_contains(l, t->target[1])) {
+        return 0;
+    }
+    s = loop_contains(l, t->target[0]) ? 0 : 1;
+    u->body = t->target[s];
+    u->exit = t->target[1-s];
+    if (u->body == l->header || u->body->npred != 1) {
+        return 0;
+    }
+
+    /* 後退辺が一つで、ヘッダ以外に出口がない
+       A single back edge and no exit other than the header */
+    nlatch = 0;
+    for (k = 0; k < l->header->npred; k++) {
+        if (loop_contains(l, l->header->pred[k])) {
+            u->latch = l->header->pred[k];
+            nlatch++;
+        }
+    }
+    if (nlatch != 1) {
+        return 0;
+    }
+    u->size = 0;
+    for (k = 0; k < l->nblocks; k++) {
+        b = l->blocks[k];
+        if (b == l->header) {
+            continue;
+        }
+        for (j = 0; j < b->nsucc; j++) {
+            if (!loop_contains(l, b->succ[j])) {
+                return 0;
+            }
+        }
+        FOR_EACH_INSN(i, b) {
+            u->size++;
+        }
+    }
+
+    /* 判定を「iv cond bound の間回る」の形にする
+       Put the test in the form "loop while iv cond bound" */
+    u->cond = (s == 0) ? t->cond : ir_negate_cond(t->cond);
+    for (k = 0; k < 2; k++) {
+        d = def[t->src[k]];
+        if (d != NULL && d->op == IR_PHI && d->block == l->header) {
+            break;
+        }
+    }
+    if (k == 2) {
+        return 0;
+    }
+    u->iv = def[t->src[k]];
+    u->bound = t->src[1-k];
+    if (k == 1) {
+        u->cond = ir_swap_cond(u->cond);
+    }
+    if (def[u->bound] == NULL || loop_contains(l, def[u->bound]->block)) {
+        return 0;
+    }
+
+    /* 定数の増分 / constant step */
+    next = def[u->iv->phi_src[1-phi_slot(l, u->iv)]];
+    if (next == NULL || (next->op != IR_ADD && next->op != IR_SUB)) {
+        return 0;
+    }
+    if (next->src[0] == u->iv->dst) {
+        ok = const_value(next->src[1], &step);
+    } else {
+        ok = next->op == IR_ADD && next->src[1] == u->iv->dst
+             && const_value(next->src[0], &step);
+    }
+    if (!ok) {
+        return 0;
+    }
+    if (next->op == IR_SUB) {
+        if (step == INT_MIN) {
+            return 0;
+        }
+        step = -step;
+    }
+    u->step = step;
+    switch (u->cond) {
+    case  AST_EXP_LT:
+    case  AST_EXP_LTE:
+        return step > 0;
+    case  AST_EXP_GT:
+    case  AST_EXP_GTE:
+        return step < 0;
+    default:
+        return 0;
+    }
+}
+
+int
+const_value(int v, int *val)
+{
+    if (def[v] != NULL && def[v]->op == IR_CONST) {
+        *val = def[v]->imm;
+        return 1;
+    }
+    return 0;
+}
+
+/* 繰り返し回数（分からないかlimitを越えれば-1）
+   Trip count (-1 if unknown or above limit) */
+int
+trip_count(UR_Loop *u, int limit)
+{
+    int  n, init, bound, val;
+    long long x;
+
+    if (!const_value(u->iv->phi_src[phi_slot(u->loop, u->iv)], &init)
+        || !const_value(u->bound, &bound)) {
+        return -1;
+    }
+    x = init;
+    for (n = 0; n <= limit; n++) {
+        fold_const(u->cond, (int)x, bound, &val);
+        if (!val) {
+            return n;
+        }
+        x += u->step;
+        if (x < INT_MIN || x > INT_MAX) {
+            return -1;
+        }
+    }
+    return -1;
+}
+
+int
+phi_slot(IR_Loop *l, IR_Insn *phi)
+{
+    return phi->phi_blk[0] == l->preheader ? 0 : 1;
+}
+
+int
+count_phis(IR_Block *b)
+{
+    int  n;
+    IR_Insn *i;
+
+    n = 0;
+    for (i = b->head; i != NULL && i->op == IR_PHI; i = i->next) {
+        n++;
+    }
+    return n;
+}
+
+int
+map_vreg(int v)
+{
+    return vmap[v] != 0 ? vmap[v] : v;
+}
+
+/*
+ * 本体を複製する。valsにはヘッダのphiの値を渡し、複製の末尾での値が
+ * 返る。複製はposの後に並べ、ヘッダへ戻る無条件分岐はそのまま残す
+ * Copy the body.  vals holds the values of the header's phis and
+ * receives their values at the end of the copy.  The copy is placed
+ * after pos; its jump back to the header is left as is.
+ */
+IR_Block*
+clone_body(UR_Loop *u, int *vals, IR_Block **pos, IR_Block **latch)
+{
+    int  k, j, n;
+    IR_Block *b, *nb;
+    IR_Insn *i, *c;
+    IR_Loop *l = u->loop;
+
+    n = 0;
+    for (i = l->header->head; i->op == IR_PHI; i = i->next) {
+        vmap[i->dst] = vals[n++];
+    }
+    for (k = 0; k < l->nblocks; k++) {
+        b = l->blocks[k];
+        if (b == l->header) {
+            continue;
+        }
+        bmap[b->id] = ir_new_block(cur_func);
+        FOR_EACH_INSN(i, b) {
+            if (i->dst != 0) {
+                vmap[i->dst] = ir_new_vreg(cur_func);
+            }
+        }
+    }
+
+    for (k = 0; k < l->nblocks; k++) {
+        b = l->blocks[k];
+        if (b == l->header) {
+            continue;
+        }
+        nb = bmap[b->id];
+        FOR_EACH_INSN(i, b) {
+            c = ir_new_insn(i->op);
+            *c = *i;
+            c->dst = map_vreg(i->dst);
+            for (j = 0; j < 2; j++) {
+                c->src[j] = map_vreg(i->src[j]);
+                if (i->target[j] != NULL && i->target[j] != l->header) {
+                    c->target[j] = bmap[i->target[j]->id];
+                }
+            }
+            if (i->op == IR_PHI) {
+                c->phi_src = xmalloc(i->nphi*sizeof(int));
+                c->phi_blk = xmalloc(i->nphi*sizeof(IR_Block*));
+                for (j = 0; j < i->nphi; j++) {
+                    c->phi_src[j] = map_vreg(i->phi_src[j]);
+                    c->phi_blk[j] = bmap[i->phi_blk[j]->id];
+                }
+            }
+            c->prev = c->next = NULL;
+            ir_append(nb, c);
+        }
+        ir_place_block_after(cur_func, *pos, nb);
+        *pos = nb;
+    }
+
+    n = 0;
+    for (i = l->header->head; i->op == IR_PHI; i = i->next) {
+        vals[n++] = map_vreg(i->phi_src[1-phi_slot(l, i)]);
+    }
+    *latch = bmap[u->latch->id];
+    return bmap[u->body->id];
+}
+
+/* 本体をtrips回並べ、ヘッダは出口への分岐にする
+   Lay out the body trips times and make the header jump to the exit */
+void
+unroll_fully(UR_Loop *u, int trips)
+{
+    int  k, n, *vals;
+    IR_Block *pos, *latch, *from;
+    IR_Insn *i, *jmp, *t;
+    IR_Loop *l = u->loop;
+
+    vals = xmalloc(count_phis(l->header)*sizeof(int));
+    n = 0;
+    for (i = l->header->head; i->op == IR_PHI; i = i->next) {
+        vals[n++] = i->phi_src[phi_slot(l, i)];
+    }
+    pos = l->preheader;
+    from = l->preheader;
+    jmp = ir_terminator(l->preheader);
+    for (k = 0; k < trips; k++) {
+        jmp->target[0] = clone_body(u, vals, &pos, &latch);
+        jmp = ir_terminator(latch);
+        from = latch;
+    }
+    n = 0;
+    for (i = l->header->head; i->op == IR_PHI; i = i->next) {
+        i->nphi = 1;
+        i->phi_src[0] = vals[n++];
+        i->phi_blk[0] = from;
+    }
+    t = ir_terminator(l->header);
+    t->op = IR_JMP;
+    t->cond = 0;
+    t->src[0] = t->src[1] = 0;
+    t->target[0] = u->exit;
+    t->target[1] = NULL;
+    free(vals);
+}
+
+/*
+ * 本体をfactor個並べたループを元のループの前に作る。作れなければ0
+ * Make a loop with factor copies of the body before the original one.
+ * Returns 0 if it cannot be made.
+ */
+int
+unroll_partially(UR_Loop *u, int factor)
+{
+    int  k, n, nphis, bound, guard, iv, *vals, *init, *mphi;
+    long long dist, limit;
+    IR_Block *ph, *mh, *rp, *pos, *latch, *entry;
+    IR_Insn *i, *p, *t, *jmp, *c_dist, *c_limit, *y;
+    IR_Loop *l = u->loop;
+
+    /* 展開したループは iv + dist cond bound、つまり iv cond bound-dist の間回る
+       The unrolled loop runs while iv + dist cond bound, i.e.
+       iv cond bound-dist */
+    dist = (long long)(factor-1)*u->step;
+    limit = (u->step > 0) ? (long long)INT_MIN + dist : (long long)INT_MAX + dist;
+    if (dist < INT_MIN || dist > INT_MAX || limit < INT_MIN || limit > INT_MAX) {
+        return 0;
+    }
+    guard = !const_value(u->bound, &bound);
+    if (!guard
+        && ((u->step > 0 && bound < limit) || (u->step < 0 && bound > limit))) {
+        return 0;
+    }
+
+    nphis = count_phis(l->header);
+    vals = xmalloc(nphis*sizeof(int));
+    init = xmalloc(nphis*sizeof(int));
+    mphi = xmalloc(nphis*sizeof(int));
+    ph = l->preheader;
+    mh = ir_new_block(cur_func);
+    rp = ir_new_block(cur_func);
+
+    /* プリヘッダ：bound-distを求め、桁あふれするなら元のループへ
+       Preheader: compute bound-dist, going to the original loop if it
+       would overflow */
+    t = ir_terminator(ph);
+    c_dist = new_insn(IR_CONST, ir_new_vreg(cur_func), 0, 0);
+    c_dist->imm = (int)dist;
+    y = new_insn(IR_SUB, ir_new_vreg(cur_func), u->bound, c_dist->dst);
+    ir_insert_before(t, c_dist);
+    ir_insert_before(t, y);
+    if (!guard) {
+        t->target[0] = mh;
+    } else {
+        c_limit = new_insn(IR_CONST, ir_new_vreg(cur_func), 0, 0);
+        c_limit->imm = (int)limit;
+        ir_insert_before(t, c_limit);
+        t->op = IR_BR;
+        t->cond = (u->step > 0) ? AST_EXP_LT : AST_EXP_GT;
+        t->src[0] = u->bound;
+        t->src[1] = c_limit->dst;
+        t->target[0] = rp;
+        t->target[1] = mh;
+    }
+
+    /* 展開したループのヘッダ / header of the unrolled loop */
+    n = 0;
+    iv = 0;
+    for (i = l->header->head; i->op == IR_PHI; i = i->next) {
+        init[n] = i->phi_src[phi_slot(l, i)];
+        p = ir_new_insn(IR_PHI);
+        p->dst = ir_new_vreg(cur_func);
+        p->sym = i->sym;
+        p->nphi = 2;
+        p->phi_src = xmalloc(2*sizeof(int));
+        p->phi_blk = xmalloc(2*sizeof(IR_Block*));
+        p->phi_src[0] = init[n];
+        p->phi_blk[0] = ph;
+        ir_append(mh, p);
+        if (i == u->iv) {
+            iv = p->dst;
+        }
+        vals[n] = mphi[n] = p->dst;
+        n++;
+    }
+    t = new_insn(IR_BR, 0, iv, y->dst);
+    t->cond = u->cond;
+    t->target[1] = rp;
+    ir_append(mh, t);
+    ir_place_block_after(cur_func, ph, mh);
+
+    pos = mh;
+    jmp = t;
+    for (k = 0; k < factor; k++) {
+        entry = clone_body(u, vals, &pos, &latch);
+        jmp->target[0] = entry;
+        jmp = ir_terminator(latch);
+    }
+    jmp->target[0] = mh;
+    n = 0;
+    for (p = mh->head; p->op == IR_PHI; p = p->next) {
+        p->phi_src[1] = vals[n++];
+        p->phi_blk[1] = latch;
+    }
+
+    /* 元のループのプリヘッダ / new preheader of the original loop */
+    n = 0;
+    for (i = l->header->head; i->op == IR_PHI; i = i->next) {
+        if (!guard) {
+            vals[n] = mphi[n];
+        } else {
+            p = ir_new_insn(IR_PHI);
+            p->dst = ir_new_vreg(cur_func);
+            p->sym = i->sym;
+            p->nphi = 2;
+            p->phi_src = xmalloc(2*sizeof(int));
+            p->phi_blk = xmalloc(2*sizeof(IR_Block*));
+            p->phi_src[0] = init[n];
+            p->phi_blk[0] = ph;
+            p->phi_src[1] = mphi[n];
+            p->phi_blk[1] = mh;
+            ir_append(rp, p);
+            vals[n] = p->dst;
+        }
+        k = phi_slot(l, i);
+        i->phi_src[k] = vals[n++];
+        i->phi_blk[k] = rp;
+    }
+    jmp = ir_new_insn(IR_JMP);
+    jmp->target[0] = l->header;
+    ir_append(rp, jmp);
+    ir_place_block_after(cur_func, pos, rp);
+    l->preheader = rp;
+
+    free(vals);
+    free(init);
+    free(mphi);
+    return 1;
+}
+
+IR_Insn*
+new_insn(int op, int dst, int a, int b)
+{
+    IR_Insn *i;
+
+    i = ir_new_insn(op);
+    i->dst = dst;
+    i->src[0] = a;
+    i->src[1] = b;
+    return i;
+}